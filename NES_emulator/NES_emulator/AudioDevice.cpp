@@ -20,6 +20,9 @@ static std::mutex AD_streamMutex;
 static uint16_t AD_sampleBuffer[AD__SAMPLE_COUNT + AD__SAMPLE_REDUNDANCY];
 static int16_t AD_samplesInBuffer;
 
+static uint8_t AD_decimation = 1;
+static uint8_t AD_decimationCounter = 0;
+
 void AD_streamLoader__loop();
 void AD_SDL__callback(void *userData, uint8_t *stream, int len);
 
@@ -38,6 +41,18 @@ namespace AD
 
 	void queueSample(uint16_t sample)
 	{
+		if (AD_decimation == 0)
+		{
+			return;
+		}
+
+		if (++AD_decimationCounter < AD_decimation)
+		{
+			return;
+		}
+
+		AD_decimationCounter = 0;
+
 		std::lock_guard<std::mutex> mutexGuard(AD_streamMutex);
 
 		if (AD_samplesInBuffer < (AD__SAMPLE_COUNT + AD__SAMPLE_REDUNDANCY))
@@ -47,6 +62,12 @@ namespace AD
 		}
 	}
 
+	void setDecimation(uint8_t factor)
+	{
+		AD_decimation = factor;
+		AD_decimationCounter = 0;
+	}
+
 	bool bufferFull()
 	{
 		if (AD_samplesInBuffer < (AD__SAMPLE_COUNT + AD__SAMPLE_REDUNDANCY))
@@ -6,6 +6,7 @@ namespace AD
 {
 	void init();
 	void queueSample(uint16_t sample);
+	void setDecimation(uint8_t factor); // keeps one sample out of every factor ... 0 drops them all
 	bool bufferFull();
 	void dispose();
 }
\ No newline at end of file
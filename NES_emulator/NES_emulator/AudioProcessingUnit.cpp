@@ -3,6 +3,7 @@
 #include "CartridgeReader.h"
 #include "AudioDevice.h"
 #include "CentralProcessingUnit.h"
+#include "ConsoleContext.h"
 #include "MemoryBus.h"
 
 #define APU__SEQUENCE_STEP1 (3728u)
@@ -96,8 +97,6 @@
 
 static const float APU_gaussFilterValuesNTSC[APU__GAUSS_VALUES_COUNT_NTSC] = { 0.000004f, 0.000036f, 0.000272f, 0.001585f, 0.007035f, 0.023798f, 0.061393f, 0.120795f, 0.181297f, 0.207571f, 0.181297f, 0.120795f, 0.061393f, 0.023798f, 0.007035f, 0.001585f, 0.000272f, 0.000036f, 0.000004 };
 static const float APU_gaussFilterValuesPAL[APU__GAUSS_VALUES_COUNT_PAL] = { 0.000005f, 0.000036f, 0.000289f, 0.002000f, 0.009577f, 0.033324f, 0.084523f, 0.156821f, 0.213425f, 0.213425f, 0.156821f, 0.084523f, 0.033324f, 0.009577f, 0.002000f, 0.000289f, 0.000036f, 0.000005f };
-static const float *APU_gaussFilterInUse;
-static uint8_t APU_gaussFilterLength;
 
 static constexpr uint8_t APU_lengthCounterLUT[APU__LENGTH_VALUES] = { 10, 254, 20, 2, 40, 4, 80, 6, 160, 8, 60, 10, 14, 12, 26, 14, 12, 16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30 };
 
@@ -107,113 +106,11 @@ static constexpr uint8_t APU_triangleSequence[APU__TRIANGLE_SEQUENCE_LENGTH] = {
 
 static const uint16_t APU_noisePeriodsNTSC[APU__NOISE_TIMER_PERIODS] = { 4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068 };
 static const uint16_t APU_noisePeriodsPAL[APU__NOISE_TIMER_PERIODS] = { 4, 8, 14, 30, 60, 88, 118, 148, 188, 236, 354, 472, 708,  944, 1890, 3778 };
-static const uint16_t *APU_noisePeriods;
 
 static const uint16_t APU_dmcRateNTSC[APU__DMC_RATE_VALUES_COUNT] = { 214, 190, 170, 160, 143, 127, 113, 107, 95, 80, 71, 64, 53, 42, 36, 27 };
 static const uint16_t APU_dmcRatePAL[APU__DMC_RATE_VALUES_COUNT] = { 199, 177, 158, 149, 138, 118, 105, 99, 88, 74, 66, 59, 49, 38, 33, 25 };
-static const uint16_t *APU_dmcRates;
-
-static uint16_t APU_cycleCount;
-static uint8_t APU_frameSteps;
-static bool APU_enableInterrupt;
-static bool APU_setInterruptRequest;
-
-static float APU_mixedSample;
-static uint8_t APU_mixingPosition;
-
-static bool APU_requestFrameIRQ;
-static bool APU_requetsDMCIRQ;
-
-static bool APU_channelPulse1Enable;
-static bool APU_channelPulse2Enable;
-static bool APU_channelTriangleEnable;
-static bool APU_channelNoiseEnable;
-static bool APU_channelDeltaSignaEnable;
-
-static uint8_t APU_Pulse1_dutyCyclePosition;
-static uint8_t APU_Pulse1_lengthCounter;
-static uint8_t APU_Pulse1_envelope;
-static uint8_t APU_Pulse1_envelopeDivider;
-static uint8_t APU_Pulse1_sweepDivider;
-static bool APU_Pulse1_resetEnvelope;
-static bool APU_Pulse1_resetSweep;
-static uint16_t APU_Pulse1_timerValue;
-static bool APU_Pulse1_outputHigh;
-
-static uint8_t APU_Pulse1_dutyCycle;
-static bool APU_Pulse1_lengthCounterHalt;
-static bool APU_Pulse1_constantVolume_envelopeFlag;
-static uint8_t APU_Pulse1_volume_envelopePeriod;
-static bool APU_Pulse1_sweepEnable;
-static uint8_t APU_Pulse1_sweepPeriod;
-static bool APU_Pulse1_sweepNegate;
-static uint8_t APU_Pulse1_sweepShiftCount;
-static uint16_t APU_Pulse1_timer;
-static uint8_t APU_Pulse1_lengthCounterLoad;
-
-static uint8_t APU_Pulse2_dutyCyclePosition;
-static uint8_t APU_Pulse2_lengthCounter;
-static uint8_t APU_Pulse2_envelope;
-static uint8_t APU_Pulse2_envelopeDivider;
-static uint8_t APU_Pulse2_sweepDivider;
-static bool APU_Pulse2_resetEnvelope;
-static bool APU_Pulse2_resetSweep;
-static uint16_t APU_Pulse2_timerValue;
-static bool APU_Pulse2_outputHigh;
-
-static uint8_t APU_Pulse2_dutyCycle;
-static bool APU_Pulse2_lengthCounterHalt;
-static bool APU_Pulse2_constantVolume_envelopeFlag;
-static uint8_t APU_Pulse2_volume_envelopePeriod;
-static bool APU_Pulse2_sweepEnable;
-static uint8_t APU_Pulse2_sweepPeriod;
-static bool APU_Pulse2_sweepNegate;
-static uint8_t APU_Pulse2_sweepShiftCount;
-static uint16_t APU_Pulse2_timer;
-static uint8_t APU_Pulse2_lengthCounterLoad;
-
-static uint8_t APU_Triangle_lengthCounter;
-static bool APU_Triangle_linearCounterHalt;
-static uint8_t APU_Triangle_linearCounter;
-static uint8_t APU_Triangle_currentSample;
-static uint16_t APU_Triangle_timerValue;
-static uint8_t APU_Triangle_sequencePosition;
-
-static bool APU_Triangle_linearCounterControl;
-static uint8_t APU_Triangle_linearCounterReload;
-static uint16_t APU_Triangle_timer;
-static uint8_t APU_Triangle_lengthCounterLoad;
-
-static uint8_t APU_Noise_lengthCounter;
-static uint16_t APU_Noise_shiftRegister;
-static uint8_t APU_Noise_envelope;
-static uint8_t APU_Noise_envelopeDivider;
-static bool APU_Noise_resetEnvelope;
-static uint8_t APU_Noise_currentSample;
-static uint16_t APU_Noise_timerValue;
-
-static bool APU_Noise_lengthCounterHalt;
-static bool APU_Noise_constantVolume_envelopeFlag;
-static uint8_t APU_Noise_volume_envelopePeriod;
-static bool APU_Noise_mode;
-static uint8_t APU_Noise_period;
-static uint8_t APU_Noise_lengthCounterLoad;
-
-static uint8_t APU_DMC_selectedRate;
-static bool APU_DMC_enableIRQ;
-static bool APU_DMC_loop;
-static uint16_t APU_DMC_addressStart;
-static uint16_t APU_DMC_sampleLength;
-
-static uint16_t APU_DMC_rateCounter;
-static uint16_t APU_DMC_currentAddress;
-static uint8_t APU_DMC_counter;
-static uint8_t APU_DMC_output;
-static uint16_t APU_DMC_samplesRemaining;
-static bool APU_DMC_stopped;
-static uint8_t APU_DMC_shift;
-static uint8_t APU_DMC_currentSample;
 
+inline void APU_cycle__step();
 void APU_envelope__step();
 void APU_triangle__step();
 void APU_length__step();
@@ -223,671 +120,465 @@ namespace APU
 {
 	void reset()
 	{
+		APU_state_t &apu = CC_console->apu;
+
 		if (CR::getSystemType() == SYSTEM_NTSC)
 		{
-			APU_gaussFilterLength = APU__GAUSS_VALUES_COUNT_NTSC;
-			APU_gaussFilterInUse = APU_gaussFilterValuesNTSC;
+			apu.gaussFilterLength = APU__GAUSS_VALUES_COUNT_NTSC;
+			apu.gaussFilterInUse = APU_gaussFilterValuesNTSC;
 
-			APU_noisePeriods = APU_noisePeriodsNTSC;
-			APU_dmcRates = APU_dmcRateNTSC;
+			apu.noisePeriods = APU_noisePeriodsNTSC;
+			apu.dmcRates = APU_dmcRateNTSC;
 		}
 		else
 		{
-			APU_gaussFilterLength = APU__GAUSS_VALUES_COUNT_PAL;
-			APU_gaussFilterInUse = APU_gaussFilterValuesPAL;
+			apu.gaussFilterLength = APU__GAUSS_VALUES_COUNT_PAL;
+			apu.gaussFilterInUse = APU_gaussFilterValuesPAL;
 
-			APU_noisePeriods = APU_noisePeriodsPAL;
-			APU_dmcRates = APU_dmcRatePAL;
+			apu.noisePeriods = APU_noisePeriodsPAL;
+			apu.dmcRates = APU_dmcRatePAL;
 		}
 
-		APU_cycleCount = 0;
-		APU_frameSteps = 4;
-		APU_enableInterrupt = true;
-		APU_setInterruptRequest = false;
+		apu.cycleCount = 0;
+		apu.frameSteps = 4;
+		apu.enableInterrupt = true;
+		apu.setInterruptRequest = false;
 
-		APU_mixedSample = 0.0f;
-		APU_mixingPosition = 0;
+		apu.mixedSample = 0.0f;
+		apu.mixingPosition = 0;
 
-		APU_requestFrameIRQ = false;
-		APU_requetsDMCIRQ = false;
+		apu.requestFrameIRQ = false;
+		apu.requetsDMCIRQ = false;
 
-		APU_channelPulse1Enable = false;
-		APU_channelPulse2Enable = false;
-		APU_channelTriangleEnable = false;
-		APU_channelNoiseEnable = false;
-		APU_channelDeltaSignaEnable = false;
+		apu.channelPulse1Enable = false;
+		apu.channelPulse2Enable = false;
+		apu.channelTriangleEnable = false;
+		apu.channelNoiseEnable = false;
+		apu.channelDeltaSignaEnable = false;
 
 		/* Pulse1 */
-		APU_Pulse1_dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
-		APU_Pulse1_lengthCounter = 0;
-		APU_Pulse1_envelope = 0;
-		APU_Pulse1_envelopeDivider = 0;
-		APU_Pulse1_sweepDivider = 0;
-		APU_Pulse1_resetEnvelope = true;
-		APU_Pulse1_resetSweep = true;
-		APU_Pulse1_timerValue = 0;
-		APU_Pulse1_outputHigh = false;
-
-		APU_Pulse1_dutyCycle = 0;
-		APU_Pulse1_lengthCounterHalt = false;
-		APU_Pulse1_constantVolume_envelopeFlag = false;
-		APU_Pulse1_volume_envelopePeriod = 0;
-		APU_Pulse1_sweepEnable = false;
-		APU_Pulse1_sweepPeriod = 0;
-		APU_Pulse1_sweepNegate = false;
-		APU_Pulse1_sweepShiftCount = 0;
-		APU_Pulse1_timer = 0;
-		APU_Pulse1_lengthCounterLoad = 0;
+		apu.pulse1.dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
+		apu.pulse1.lengthCounter = 0;
+		apu.pulse1.envelope = 0;
+		apu.pulse1.envelopeDivider = 0;
+		apu.pulse1.sweepDivider = 0;
+		apu.pulse1.resetEnvelope = true;
+		apu.pulse1.resetSweep = true;
+		apu.pulse1.timerValue = 0;
+		apu.pulse1.outputHigh = false;
+
+		apu.pulse1.dutyCycle = 0;
+		apu.pulse1.lengthCounterHalt = false;
+		apu.pulse1.constantVolume_envelopeFlag = false;
+		apu.pulse1.volume_envelopePeriod = 0;
+		apu.pulse1.sweepEnable = false;
+		apu.pulse1.sweepPeriod = 0;
+		apu.pulse1.sweepNegate = false;
+		apu.pulse1.sweepShiftCount = 0;
+		apu.pulse1.timer = 0;
+		apu.pulse1.lengthCounterLoad = 0;
 
 		/* Pulse2 */
-		APU_Pulse2_dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
-		APU_Pulse2_lengthCounter = 0;
-		APU_Pulse2_envelope = 0;
-		APU_Pulse2_envelopeDivider = 0;
-		APU_Pulse2_sweepDivider = 0;
-		APU_Pulse2_resetEnvelope = true;
-		APU_Pulse2_resetSweep = true;
-		APU_Pulse2_timerValue = 0;
-		APU_Pulse2_outputHigh = false;
-
-		APU_Pulse2_dutyCycle = 0;
-		APU_Pulse2_lengthCounterHalt = false;
-		APU_Pulse2_constantVolume_envelopeFlag = false;
-		APU_Pulse2_volume_envelopePeriod = 0;
-		APU_Pulse2_sweepEnable = false;
-		APU_Pulse2_sweepPeriod = 0;
-		APU_Pulse2_sweepNegate = false;
-		APU_Pulse2_sweepShiftCount = 0;
-		APU_Pulse2_timer = 0;
-		APU_Pulse2_lengthCounterLoad = 0;
+		apu.pulse2.dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
+		apu.pulse2.lengthCounter = 0;
+		apu.pulse2.envelope = 0;
+		apu.pulse2.envelopeDivider = 0;
+		apu.pulse2.sweepDivider = 0;
+		apu.pulse2.resetEnvelope = true;
+		apu.pulse2.resetSweep = true;
+		apu.pulse2.timerValue = 0;
+		apu.pulse2.outputHigh = false;
+
+		apu.pulse2.dutyCycle = 0;
+		apu.pulse2.lengthCounterHalt = false;
+		apu.pulse2.constantVolume_envelopeFlag = false;
+		apu.pulse2.volume_envelopePeriod = 0;
+		apu.pulse2.sweepEnable = false;
+		apu.pulse2.sweepPeriod = 0;
+		apu.pulse2.sweepNegate = false;
+		apu.pulse2.sweepShiftCount = 0;
+		apu.pulse2.timer = 0;
+		apu.pulse2.lengthCounterLoad = 0;
 
 		/* Triangle */
-		APU_Triangle_lengthCounter = 0;
-		APU_Triangle_linearCounterHalt = false;
-		APU_Triangle_linearCounter = 0;
-		APU_Triangle_currentSample = 0;
-		APU_Triangle_timerValue = 0;
-		APU_Triangle_sequencePosition = 0;
-
-		APU_Triangle_linearCounterControl = false;
-		APU_Triangle_linearCounterReload = 0;
-		APU_Triangle_timer = 0;
-		APU_Triangle_lengthCounterLoad = 0;
+		apu.triangle.lengthCounter = 0;
+		apu.triangle.linearCounterHalt = false;
+		apu.triangle.linearCounter = 0;
+		apu.triangle.currentSample = 0;
+		apu.triangle.timerValue = 0;
+		apu.triangle.sequencePosition = 0;
+
+		apu.triangle.linearCounterControl = false;
+		apu.triangle.linearCounterReload = 0;
+		apu.triangle.timer = 0;
+		apu.triangle.lengthCounterLoad = 0;
 
 		/* Noise */
-		APU_Noise_lengthCounter = 0;
-		APU_Noise_shiftRegister = 1;
-		APU_Noise_envelope = 0;
-		APU_Noise_envelopeDivider = 0;
-		APU_Noise_resetEnvelope = true;
-		APU_Noise_currentSample = 0;
-		APU_Noise_timerValue = 0;
-
-		APU_Noise_lengthCounterHalt = false;
-		APU_Noise_constantVolume_envelopeFlag = false;
-		APU_Noise_volume_envelopePeriod = 0;
-		APU_Noise_mode = false;
-		APU_Noise_period = 0;
-		APU_Noise_lengthCounterLoad = 0;
+		apu.noise.lengthCounter = 0;
+		apu.noise.shiftRegister = 1;
+		apu.noise.envelope = 0;
+		apu.noise.envelopeDivider = 0;
+		apu.noise.resetEnvelope = true;
+		apu.noise.currentSample = 0;
+		apu.noise.timerValue = 0;
+
+		apu.noise.lengthCounterHalt = false;
+		apu.noise.constantVolume_envelopeFlag = false;
+		apu.noise.volume_envelopePeriod = 0;
+		apu.noise.mode = false;
+		apu.noise.period = 0;
+		apu.noise.lengthCounterLoad = 0;
 
 		/* DMC */
-		APU_DMC_addressStart = 0xC000;
-		APU_DMC_currentAddress = 0xC000;
-		APU_DMC_counter = 8;
-		APU_DMC_selectedRate = 0;
-		APU_DMC_rateCounter = 1;
-		APU_DMC_sampleLength = 1;
-		APU_DMC_output = 0;
-		APU_DMC_samplesRemaining = 1;
-		APU_DMC_stopped = true;
-		APU_DMC_shift = 0x00;
+		apu.dmc.addressStart = 0xC000;
+		apu.dmc.currentAddress = 0xC000;
+		apu.dmc.counter = 8;
+		apu.dmc.selectedRate = 0;
+		apu.dmc.rateCounter = 1;
+		apu.dmc.sampleLength = 1;
+		apu.dmc.output = 0;
+		apu.dmc.samplesRemaining = 1;
+		apu.dmc.stopped = true;
+		apu.dmc.shift = 0x00;
 	}
 
-	void step()
+	void run(uint32_t cycles)
 	{
-		++APU_cycleCount;
-
-		if (APU_cycleCount == APU__SEQUENCE_STEP1)
-		{
-			APU_envelope__step();
-			APU_triangle__step();
-		}
-
-		if (APU_cycleCount == APU__SEQUENCE_STEP2)
-		{
-			APU_envelope__step();
-			APU_triangle__step();
-			APU_length__step();
-			APU_sweep__step();
-		}
-
-		if (APU_cycleCount == APU__SEQUENCE_STEP3)
-		{
-			APU_envelope__step();
-			APU_triangle__step();
-		}
-
-		if (APU_cycleCount == APU__SEQUENCE_STEP4)
-		{
-			if (APU_frameSteps == 4)
-			{
-				APU_envelope__step();
-				APU_triangle__step();
-				APU_length__step();
-				APU_sweep__step();
-
-				if (APU_enableInterrupt)
-				{
-					APU_requestFrameIRQ = true;
-					CPU::pullInterruptPin(INTERRUPT_SOURCE_APU);
-				}
-
-				APU_cycleCount = 0;
-			}
-		}
-
-		if (APU_cycleCount == APU__SEQUENCE_STEP5)
-		{
-			APU_envelope__step();
-			APU_triangle__step();
-			APU_length__step();
-			APU_sweep__step();
-
-			APU_cycleCount = 0;
-		}
-
-		/* Pulse 1 */
-		if (APU_Pulse1_timerValue == 0)
-		{
-			APU_Pulse1_outputHigh = (APU_pulseDutyCycles[APU_Pulse1_dutyCycle] & APU_Pulse1_dutyCyclePosition) ? true : false;
-			APU_Pulse1_dutyCyclePosition >>= 1;
-			if (APU_Pulse1_dutyCyclePosition == 0)
-			{
-				APU_Pulse1_dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
-			}
-		}
-
-		APU_Pulse1_timerValue += 1;
-		APU_Pulse1_timerValue %= (APU_Pulse1_timer + 1);
-
-		/* Pulse 2 */
-		if (APU_Pulse2_timerValue == 0)
+		while (cycles--)
 		{
-			APU_Pulse2_outputHigh = (APU_pulseDutyCycles[APU_Pulse2_dutyCycle] & APU_Pulse2_dutyCyclePosition) ? true : false;
-			APU_Pulse2_dutyCyclePosition >>= 1;
-			if (APU_Pulse2_dutyCyclePosition == 0)
-			{
-				APU_Pulse2_dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
-			}
-		}
-
-		APU_Pulse2_timerValue += 1;
-		APU_Pulse2_timerValue %= (APU_Pulse2_timer + 1);
-
-		/* Triangle */
-		for (int i = 0; i < 2; ++i) // because the timer for Triangle is 2 * APUclock
-		{
-			if ((APU_Triangle_timerValue == 0) && APU_Triangle_lengthCounter && APU_Triangle_linearCounter)
-			{
-				APU_Triangle_currentSample = APU_triangleSequence[APU_Triangle_sequencePosition];
-				APU_Triangle_sequencePosition = (APU_Triangle_sequencePosition + 1) % APU__TRIANGLE_SEQUENCE_LENGTH;
-			}
-
-			APU_Triangle_timerValue += 1;
-			APU_Triangle_timerValue %= (APU_Triangle_timer + 1);
-		}
-
-		/* Noise */
-		if (APU_Noise_timerValue == 0)
-		{
-			uint16_t newBit;
-			if (APU_Noise_mode)
-			{
-				newBit = (APU_Noise_shiftRegister ^ (APU_Noise_shiftRegister >> 6)) & 1;
-			}
-			else
-			{
-				newBit = (APU_Noise_shiftRegister ^ (APU_Noise_shiftRegister >> 1)) & 1;
-			}
-			newBit <<= 14;
-
-			APU_Noise_shiftRegister >>= 1;
-			APU_Noise_shiftRegister |= newBit;
-
-			APU_Noise_currentSample = APU_Noise_shiftRegister & 1;
+			APU_cycle__step();
 		}
+	}
 
-		APU_Noise_timerValue += 1;
-		APU_Noise_timerValue %= APU_noisePeriods[APU_Noise_period];
-
-		/* DMC */
-		if (APU_channelDeltaSignaEnable && !APU_DMC_stopped)
-		{
-			--APU_DMC_rateCounter;
-
-			if (APU_DMC_rateCounter == 0)
-			{
-				APU_DMC_rateCounter = APU_dmcRates[APU_DMC_selectedRate];
-
-				if (APU_DMC_shift == 0)
-				{
-					APU_DMC_currentSample = MB::readMainBus(APU_DMC_currentAddress);
-					CPU::skipCyclesForDMCFetch();
-
-					++APU_DMC_currentAddress;
-					--APU_DMC_samplesRemaining;
-
-					if (APU_DMC_samplesRemaining == 0)
-					{
-						if (APU_DMC_loop)
-						{
-							APU_DMC_samplesRemaining = APU_DMC_sampleLength;
-							APU_DMC_currentAddress = APU_DMC_addressStart;
-						}
-						else
-						{
-							APU_DMC_stopped = true;
-
-							if (APU_DMC_enableIRQ)
-							{
-								APU_requetsDMCIRQ = true;
-								CPU::pullInterruptPin(INTERRUPT_SOURCE_DMC);
-							}
-						}
-					}
-
-					APU_DMC_shift = 0x01;
-				}
-
-				if (APU_DMC_currentSample & APU_DMC_shift)
-				{
-					if (APU_DMC_counter < 126)
-					{
-						APU_DMC_counter += 2;
-					}
-				}
-				else
-				{
-					if (APU_DMC_counter > 1)
-					{
-						APU_DMC_counter -= 2;
-					}
-				}
-
-				APU_DMC_shift <<= 1;
-
-				APU_DMC_output = APU_DMC_counter;
-			}
-		}
+	void suppressOutput(bool suppress)
+	{
+		APU_state_t &apu = CC_console->apu;
 
-		/* Render */
-		float sample = 0.0f;
+		apu.outputSuppressed = suppress;
+	}
 
-		/* Pulse1 render */
-		uint8_t samplePulse1;
+	uint32_t getCyclesUntilEvent()
+	{ // counts the cycle that produces the event
+		APU_state_t &apu = CC_console->apu;
 
-		uint16_t period1 = (APU_Pulse1_timer + 1) >> APU_Pulse1_sweepShiftCount;
-		if (APU_Pulse1_sweepNegate)
-		{
-			period1 = -period1; // for pulse2 will be    period = -period + 1;
-		}
-		period1 += APU_Pulse1_timer + 1;
+		uint32_t cycles;
 
-		if ((APU_Pulse1_timer + 1 < 8) || (period1 > 0x07FF) || (APU_Pulse1_lengthCounter == 0) || (APU_Pulse1_outputHigh == false))
-		{
-			samplePulse1 = 0;
+		if (apu.frameSteps == 4)
+		{ // frame interrupt
+			cycles = (apu.cycleCount < APU__SEQUENCE_STEP4) ? (APU__SEQUENCE_STEP4 - apu.cycleCount) : 1u;
 		}
 		else
-		{
-			if (APU_Pulse1_constantVolume_envelopeFlag)
-			{
-				samplePulse1 = APU_Pulse1_volume_envelopePeriod;
-			}
-			else
-			{
-				samplePulse1 = APU_Pulse1_envelope;
-			}
-		}
-
-		if (APU_channelPulse1Enable)
-		{
-			sample += samplePulse1 * APU__WEIGHT_PULSE;
+		{ // no interrupt in the 5 step sequence, stopping when it restarts
+			cycles = (apu.cycleCount < APU__SEQUENCE_STEP5) ? (APU__SEQUENCE_STEP5 - apu.cycleCount) : 1u;
 		}
 
-		/* Pulse2 render */
-		uint8_t samplePulse2;
+		if (apu.channelDeltaSignaEnable && !apu.dmc.stopped)
+		{ // the DMC may fetch a sample (stealing CPU cycles) or request an interrupt when its rate counter expires
+			uint32_t cyclesDMC = apu.dmc.rateCounter ? apu.dmc.rateCounter : 1u;
 
-		uint16_t period2 = (APU_Pulse2_timer + 1) >> APU_Pulse2_sweepShiftCount;
-		if (APU_Pulse2_sweepNegate)
-		{
-			period2 = -period2 + 1;
-		}
-		period2 += APU_Pulse2_timer + 1;
-
-		if ((APU_Pulse2_timer + 1 < 8) || (period2 > 0x07FF) || (APU_Pulse2_lengthCounter == 0) || (APU_Pulse2_outputHigh == false))
-		{
-			samplePulse2 = 0;
-		}
-		else
-		{
-			if (APU_Pulse2_constantVolume_envelopeFlag)
+			if (cyclesDMC < cycles)
 			{
-				samplePulse2 = APU_Pulse2_volume_envelopePeriod;
+				cycles = cyclesDMC;
 			}
-			else
-			{
-				samplePulse2 = APU_Pulse2_envelope;
-			}
-		}
-
-		if (APU_channelPulse2Enable)
-		{
-			sample += samplePulse2 * APU__WEIGHT_PULSE;
 		}
 
-		/* Triangle render */
-		if (APU_channelTriangleEnable)
-		{
-			sample += APU_Triangle_currentSample * APU__WEIGHT_TRIANGLE;
-		}
-
-		/* Noise render */
-		uint8_t sampleNoise;
-
-		if ((APU_Noise_currentSample == 0) || (APU_Noise_lengthCounter == 0))
-		{
-			sampleNoise = 0;
-		}
-		else
-		{
-			if (APU_Noise_constantVolume_envelopeFlag)
-			{
-				sampleNoise = APU_Noise_volume_envelopePeriod;
-			}
-			else
-			{
-				sampleNoise = APU_Noise_envelope;
-			}
-		}
-
-		if (APU_channelNoiseEnable)
-		{
-			sample += sampleNoise * APU__WEIGHT_NOISE;
-		}
-
-		/*DMC render */
-		uint8_t sampleDMC = APU_DMC_output;
-
-		if (APU_channelDeltaSignaEnable)
-		{
-			sample += sampleDMC * APU__WEIGHT_DMC;
-		}
-
-		/* Mixing */
-		APU_mixedSample += sample * APU_gaussFilterInUse[APU_mixingPosition];
-
-		++APU_mixingPosition;
-		if (APU_mixingPosition == APU_gaussFilterLength)
-		{
-			AD::queueSample((uint16_t)(APU_mixedSample * APU__OUTPUT_VOLUME));
-
-			APU_mixingPosition = 0;
-			APU_mixedSample = 0.0f;
-		}
+		return (cycles);
 	}
 
 	void writeRegisterSQ1Volume(uint8_t value)
 	{
-		APU_Pulse1_dutyCycle = (value & APU__PULSE_DUTY_CYCLE_MASK) >> APU__PULSE_DUTY_CYCLE_SHIFT;
-		APU_Pulse1_lengthCounterHalt = (value & APU__PULSE_LENGTH_COUNTER_HALT_MASK) ? true : false;
-		APU_Pulse1_constantVolume_envelopeFlag = (value & APU__PULSE_CONSTANT_VOLUME_ENVELOPE_FLAG_MASK) ? true : false;
-		APU_Pulse1_volume_envelopePeriod = (value & APU__PULSE_VOLUME_ENVELOPE_PERIOD_MASK) >> APU__PULSE_VOLUME_ENVELOPE_PERIOD_SHIFT;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.pulse1.dutyCycle = (value & APU__PULSE_DUTY_CYCLE_MASK) >> APU__PULSE_DUTY_CYCLE_SHIFT;
+		apu.pulse1.lengthCounterHalt = (value & APU__PULSE_LENGTH_COUNTER_HALT_MASK) ? true : false;
+		apu.pulse1.constantVolume_envelopeFlag = (value & APU__PULSE_CONSTANT_VOLUME_ENVELOPE_FLAG_MASK) ? true : false;
+		apu.pulse1.volume_envelopePeriod = (value & APU__PULSE_VOLUME_ENVELOPE_PERIOD_MASK) >> APU__PULSE_VOLUME_ENVELOPE_PERIOD_SHIFT;
 	}
 
 	void writeRegisterSQ1Sweep(uint8_t value)
 	{
-		APU_Pulse1_sweepEnable = (value & APU__PULSE_SWEEP_ENABLE_MASK) ? true : false;
-		APU_Pulse1_sweepPeriod = (value & APU__PULSE_SWEEP_PERIOD_MASK) >> APU__PULSE_SWEEP_PERIOD_SHIFT;
-		APU_Pulse1_sweepNegate = (value & APU__PULSE_SWEEP_NEGATE_MASK) ? true : false;
-		APU_Pulse1_sweepShiftCount = (value & APU__PULSE_SWEEP_SHIFT_COUNT_MASK) >> APU__PULSE_SWEEP_SHIFT_COUNT_SHIFT;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.pulse1.sweepEnable = (value & APU__PULSE_SWEEP_ENABLE_MASK) ? true : false;
+		apu.pulse1.sweepPeriod = (value & APU__PULSE_SWEEP_PERIOD_MASK) >> APU__PULSE_SWEEP_PERIOD_SHIFT;
+		apu.pulse1.sweepNegate = (value & APU__PULSE_SWEEP_NEGATE_MASK) ? true : false;
+		apu.pulse1.sweepShiftCount = (value & APU__PULSE_SWEEP_SHIFT_COUNT_MASK) >> APU__PULSE_SWEEP_SHIFT_COUNT_SHIFT;
 	}
 
 	void writeRegisterSQ1PeriodLow(uint8_t value)
 	{
-		APU_Pulse1_timer &= ~APU__PULSE_TIMER_LOW_MASK;
-		APU_Pulse1_timer |= value;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.pulse1.timer &= ~APU__PULSE_TIMER_LOW_MASK;
+		apu.pulse1.timer |= value;
 	}
 
 	void writeRegisterSQ1PeriodHigh(uint8_t value)
 	{
-		APU_Pulse1_timer &= APU__PULSE_TIMER_LOW_MASK;
-		APU_Pulse1_timer |= (value & APU__PULSE_TIMER_HIGH_MASK) << (8 - APU__PULSE_TIMER_HIGH_SHIFT);
-		APU_Pulse1_lengthCounterLoad = (value & APU__PULSE_LENGTH_COUNTER_LOAD_MASK) >> APU__PULSE_LENGTH_COUNTER_LOAD_SHIFT;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.pulse1.timer &= APU__PULSE_TIMER_LOW_MASK;
+		apu.pulse1.timer |= (value & APU__PULSE_TIMER_HIGH_MASK) << (8 - APU__PULSE_TIMER_HIGH_SHIFT);
+		apu.pulse1.lengthCounterLoad = (value & APU__PULSE_LENGTH_COUNTER_LOAD_MASK) >> APU__PULSE_LENGTH_COUNTER_LOAD_SHIFT;
 
-		APU_Pulse1_lengthCounter = APU_lengthCounterLUT[APU_Pulse1_lengthCounterLoad];
-		APU_Pulse1_dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
-		APU_Pulse1_resetEnvelope = true;
+		apu.pulse1.lengthCounter = APU_lengthCounterLUT[apu.pulse1.lengthCounterLoad];
+		apu.pulse1.dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
+		apu.pulse1.resetEnvelope = true;
 	}
 
 	void writeRegisterSQ2Volume(uint8_t value)
 	{
-		APU_Pulse2_dutyCycle = (value & APU__PULSE_DUTY_CYCLE_MASK) >> APU__PULSE_DUTY_CYCLE_SHIFT;
-		APU_Pulse2_lengthCounterHalt = (value & APU__PULSE_LENGTH_COUNTER_HALT_MASK) ? true : false;
-		APU_Pulse2_constantVolume_envelopeFlag = (value & APU__PULSE_CONSTANT_VOLUME_ENVELOPE_FLAG_MASK) ? true : false;
-		APU_Pulse2_volume_envelopePeriod = (value & APU__PULSE_VOLUME_ENVELOPE_PERIOD_MASK) >> APU__PULSE_VOLUME_ENVELOPE_PERIOD_SHIFT;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.pulse2.dutyCycle = (value & APU__PULSE_DUTY_CYCLE_MASK) >> APU__PULSE_DUTY_CYCLE_SHIFT;
+		apu.pulse2.lengthCounterHalt = (value & APU__PULSE_LENGTH_COUNTER_HALT_MASK) ? true : false;
+		apu.pulse2.constantVolume_envelopeFlag = (value & APU__PULSE_CONSTANT_VOLUME_ENVELOPE_FLAG_MASK) ? true : false;
+		apu.pulse2.volume_envelopePeriod = (value & APU__PULSE_VOLUME_ENVELOPE_PERIOD_MASK) >> APU__PULSE_VOLUME_ENVELOPE_PERIOD_SHIFT;
 	}
 
 	void writeRegisterSQ2Sweep(uint8_t value)
 	{
-		APU_Pulse2_sweepEnable = (value & APU__PULSE_SWEEP_ENABLE_MASK) ? true : false;
-		APU_Pulse2_sweepPeriod = (value & APU__PULSE_SWEEP_PERIOD_MASK) >> APU__PULSE_SWEEP_PERIOD_SHIFT;
-		APU_Pulse2_sweepNegate = (value & APU__PULSE_SWEEP_NEGATE_MASK) ? true : false;
-		APU_Pulse2_sweepShiftCount = (value & APU__PULSE_SWEEP_SHIFT_COUNT_MASK) >> APU__PULSE_SWEEP_SHIFT_COUNT_SHIFT;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.pulse2.sweepEnable = (value & APU__PULSE_SWEEP_ENABLE_MASK) ? true : false;
+		apu.pulse2.sweepPeriod = (value & APU__PULSE_SWEEP_PERIOD_MASK) >> APU__PULSE_SWEEP_PERIOD_SHIFT;
+		apu.pulse2.sweepNegate = (value & APU__PULSE_SWEEP_NEGATE_MASK) ? true : false;
+		apu.pulse2.sweepShiftCount = (value & APU__PULSE_SWEEP_SHIFT_COUNT_MASK) >> APU__PULSE_SWEEP_SHIFT_COUNT_SHIFT;
 	}
 
 	void writeRegisterSQ2PeriodLow(uint8_t value)
 	{
-		APU_Pulse2_timer &= ~APU__PULSE_TIMER_LOW_MASK;
-		APU_Pulse2_timer |= value;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.pulse2.timer &= ~APU__PULSE_TIMER_LOW_MASK;
+		apu.pulse2.timer |= value;
 	}
 
 	void writeRegisterSQ2PeriodHigh(uint8_t value)
 	{
-		APU_Pulse2_timer &= APU__PULSE_TIMER_LOW_MASK;
-		APU_Pulse2_timer |= (value & APU__PULSE_TIMER_HIGH_MASK) << (8 - APU__PULSE_TIMER_HIGH_SHIFT);
-		APU_Pulse2_lengthCounterLoad = (value & APU__PULSE_LENGTH_COUNTER_LOAD_MASK) >> APU__PULSE_LENGTH_COUNTER_LOAD_SHIFT;
+		APU_state_t &apu = CC_console->apu;
 
-		APU_Pulse2_lengthCounter = APU_lengthCounterLUT[APU_Pulse2_lengthCounterLoad];
-		APU_Pulse2_dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
-		APU_Pulse2_resetEnvelope = true;
+		apu.pulse2.timer &= APU__PULSE_TIMER_LOW_MASK;
+		apu.pulse2.timer |= (value & APU__PULSE_TIMER_HIGH_MASK) << (8 - APU__PULSE_TIMER_HIGH_SHIFT);
+		apu.pulse2.lengthCounterLoad = (value & APU__PULSE_LENGTH_COUNTER_LOAD_MASK) >> APU__PULSE_LENGTH_COUNTER_LOAD_SHIFT;
+
+		apu.pulse2.lengthCounter = APU_lengthCounterLUT[apu.pulse2.lengthCounterLoad];
+		apu.pulse2.dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
+		apu.pulse2.resetEnvelope = true;
 	}
 
 	void writeRegisterTriangleLinearCounter(uint8_t value)
 	{
-		APU_Triangle_linearCounterControl = (value & APU__TRIANGLE_LINEAR_COUNTER_CONTROL_MASK) ? true : false;
-		APU_Triangle_linearCounterReload = (value & APU__TRIANGLE_LINEAR_COUNTER_RELOAD_MASK) >> APU__TRIANGLE_LINEAR_COUNTER_RELOAD_SHIFT;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.triangle.linearCounterControl = (value & APU__TRIANGLE_LINEAR_COUNTER_CONTROL_MASK) ? true : false;
+		apu.triangle.linearCounterReload = (value & APU__TRIANGLE_LINEAR_COUNTER_RELOAD_MASK) >> APU__TRIANGLE_LINEAR_COUNTER_RELOAD_SHIFT;
 	}
 
 	void writeRegisterTriangleTimerLow(uint8_t value)
 	{
-		APU_Triangle_timer &= ~APU__TRIANGLE_TIMER_LOW_MASK;
-		APU_Triangle_timer |= value;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.triangle.timer &= ~APU__TRIANGLE_TIMER_LOW_MASK;
+		apu.triangle.timer |= value;
 	}
 
 	void writeRegisterTriangleTimerHigh(uint8_t value)
 	{
-		APU_Triangle_timer &= APU__TRIANGLE_TIMER_LOW_MASK;
-		APU_Triangle_timer |= (value & APU__TRIANGLE_TIMER_HIGH_MASK) << (8 - APU__TRIANGLE_TIMER_HIGH_SHIFT);
-		APU_Triangle_lengthCounterLoad = (value & APU__TRIANGLE_LENGTH_COUNTER_LOAD_MASK) >> APU__TRIANGLE_LENGTH_COUNTER_LOAD_SHIFT;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.triangle.timer &= APU__TRIANGLE_TIMER_LOW_MASK;
+		apu.triangle.timer |= (value & APU__TRIANGLE_TIMER_HIGH_MASK) << (8 - APU__TRIANGLE_TIMER_HIGH_SHIFT);
+		apu.triangle.lengthCounterLoad = (value & APU__TRIANGLE_LENGTH_COUNTER_LOAD_MASK) >> APU__TRIANGLE_LENGTH_COUNTER_LOAD_SHIFT;
 
-		APU_Triangle_lengthCounter = APU_lengthCounterLUT[APU_Triangle_lengthCounterLoad];
-		APU_Triangle_linearCounterHalt = true;
+		apu.triangle.lengthCounter = APU_lengthCounterLUT[apu.triangle.lengthCounterLoad];
+		apu.triangle.linearCounterHalt = true;
 	}
 
 	void writeRegisterNoiseVolume(uint8_t value)
 	{
-		APU_Noise_lengthCounterHalt = (value & APU__NOISE_LENGTH_COUNTER_HALT_MASK) ? true : false;
-		APU_Noise_constantVolume_envelopeFlag = (value & APU__NOISE_CONSTANT_VOLUME_ENVELOPE_FLAG_MASK) ? true : false;
-		APU_Noise_volume_envelopePeriod = (value & APU__NOISE_VOLUME_ENVELOPE_PERIOD_MASK) >> APU__NOISE_VOLUME_ENVELOPE_PERIOD_SHIFT;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.noise.lengthCounterHalt = (value & APU__NOISE_LENGTH_COUNTER_HALT_MASK) ? true : false;
+		apu.noise.constantVolume_envelopeFlag = (value & APU__NOISE_CONSTANT_VOLUME_ENVELOPE_FLAG_MASK) ? true : false;
+		apu.noise.volume_envelopePeriod = (value & APU__NOISE_VOLUME_ENVELOPE_PERIOD_MASK) >> APU__NOISE_VOLUME_ENVELOPE_PERIOD_SHIFT;
 	}
 
 	void writeRegisterNoiseMode(uint8_t value)
 	{
-		APU_Noise_mode = (value & APU__NOISE_LOOP_MASK) ? true : false;
-		APU_Noise_period = (value & APU__NOISE_PERIOD_MASK) >> APU__NOISE_PERIOD_SHIFT;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.noise.mode = (value & APU__NOISE_LOOP_MASK) ? true : false;
+		apu.noise.period = (value & APU__NOISE_PERIOD_MASK) >> APU__NOISE_PERIOD_SHIFT;
 	}
 
 	void writeRegisterNoiseLength(uint8_t value)
 	{
-		APU_Noise_lengthCounterLoad = (value & APU__NOISE_LENGTH_COUNTER_LOAD_MASK) >> APU__NOISE_LENGTH_COUNTER_LOAD_SHIFT;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.noise.lengthCounterLoad = (value & APU__NOISE_LENGTH_COUNTER_LOAD_MASK) >> APU__NOISE_LENGTH_COUNTER_LOAD_SHIFT;
 
-		APU_Noise_lengthCounter = APU_lengthCounterLUT[APU_Noise_lengthCounterLoad];
-		APU_Noise_resetEnvelope = true;
+		apu.noise.lengthCounter = APU_lengthCounterLUT[apu.noise.lengthCounterLoad];
+		apu.noise.resetEnvelope = true;
 	}
 
 	void writeRegisterDMCFrequency(uint8_t value)
 	{
-		APU_DMC_enableIRQ = (value & APU__DMC_ENABLE_IRQ_MASK) ? true : false;
+		APU_state_t &apu = CC_console->apu;
 
-		if (APU_DMC_enableIRQ == false)
+		apu.dmc.enableIRQ = (value & APU__DMC_ENABLE_IRQ_MASK) ? true : false;
+
+		if (apu.dmc.enableIRQ == false)
 		{
-			APU_requetsDMCIRQ = false;
+			apu.requetsDMCIRQ = false;
 
 			CPU::releaseInterruptPin(INTERRUPT_SOURCE_DMC);
 		}
 
-		APU_DMC_loop = (value & APU__DMC_LOOP_MASK) ? true : false;
-		APU_DMC_selectedRate = (value & APU__DMC_RATE_MASK) >> APU__DMC_RATE_SHIFT;
+		apu.dmc.loop = (value & APU__DMC_LOOP_MASK) ? true : false;
+		apu.dmc.selectedRate = (value & APU__DMC_RATE_MASK) >> APU__DMC_RATE_SHIFT;
 	}
 
 	void writeRegisterDMCRaw(uint8_t value)
 	{
-		if (APU_channelDeltaSignaEnable)
+		APU_state_t &apu = CC_console->apu;
+
+		if (apu.channelDeltaSignaEnable)
 		{
-			APU_DMC_output = (value & APU__DMC_RAW_SAMPLE_MASK) >> APU__DMC_RAW_SAMPLE_SHIFT;
+			apu.dmc.output = (value & APU__DMC_RAW_SAMPLE_MASK) >> APU__DMC_RAW_SAMPLE_SHIFT;
 		}
 	}
 
 	void writeRegisterDMCAddress(uint8_t value)
 	{
-		APU_DMC_addressStart = 0xC000 | (value << APU__DMC_ADDRESS_SHIFT);
+		APU_state_t &apu = CC_console->apu;
+
+		apu.dmc.addressStart = 0xC000 | (value << APU__DMC_ADDRESS_SHIFT);
 	}
 
 	void writeRegisterDMCLength(uint8_t value)
 	{
-		APU_DMC_sampleLength = (value << APU__DMC_LENGTH_SHIFT) + 1;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.dmc.sampleLength = (value << APU__DMC_LENGTH_SHIFT) + 1;
 	}
 
 	void writeRegisterChannels(uint8_t value)
 	{
-		APU_channelPulse1Enable = (value & APU__CHANNEL_PULSE1) ? true : false;
-		APU_channelPulse2Enable = (value & APU__CHANNEL_PULSE2) ? true : false;
-		APU_channelTriangleEnable = (value & APU__CHANNEL_TRIANGLE) ? true : false;
-		APU_channelNoiseEnable = (value & APU__CHANNEL_NOISE) ? true : false;
-		APU_channelDeltaSignaEnable = (value & APU__CHANNEL_DMC) ? true : false;
+		APU_state_t &apu = CC_console->apu;
+
+		apu.channelPulse1Enable = (value & APU__CHANNEL_PULSE1) ? true : false;
+		apu.channelPulse2Enable = (value & APU__CHANNEL_PULSE2) ? true : false;
+		apu.channelTriangleEnable = (value & APU__CHANNEL_TRIANGLE) ? true : false;
+		apu.channelNoiseEnable = (value & APU__CHANNEL_NOISE) ? true : false;
+		apu.channelDeltaSignaEnable = (value & APU__CHANNEL_DMC) ? true : false;
 
-		APU_requetsDMCIRQ = false;
+		apu.requetsDMCIRQ = false;
 		CPU::releaseInterruptPin(INTERRUPT_SOURCE_DMC);
 
-		APU_Pulse1_lengthCounter = 0;
-		APU_Pulse2_lengthCounter = 0;
-		APU_Triangle_lengthCounter = 0;
-		APU_Noise_lengthCounter = 0;
+		apu.pulse1.lengthCounter = 0;
+		apu.pulse2.lengthCounter = 0;
+		apu.triangle.lengthCounter = 0;
+		apu.noise.lengthCounter = 0;
 
-		if (APU_channelDeltaSignaEnable == false)
+		if (apu.channelDeltaSignaEnable == false)
 		{
-			APU_DMC_stopped = true;
+			apu.dmc.stopped = true;
 		}
-		else if (APU_DMC_stopped)
+		else if (apu.dmc.stopped)
 		{
-			APU_DMC_stopped = false;
+			apu.dmc.stopped = false;
 
-			APU_DMC_samplesRemaining = APU_DMC_sampleLength;
-			APU_DMC_currentAddress = APU_DMC_addressStart;
-			APU_DMC_shift = 0x00;
+			apu.dmc.samplesRemaining = apu.dmc.sampleLength;
+			apu.dmc.currentAddress = apu.dmc.addressStart;
+			apu.dmc.shift = 0x00;
 		}
 	}
 
 	void writeRegisterFrameCounter(uint8_t value)
 	{
-		APU_frameSteps = (value & APU__5FRAME_SEQUENCE) ? 5 : 4;
-		APU_enableInterrupt = (value & APU__DISABLE_INTERRUPT) ? false : true;
+		APU_state_t &apu = CC_console->apu;
 
-		if (APU_enableInterrupt == false)
+		apu.frameSteps = (value & APU__5FRAME_SEQUENCE) ? 5 : 4;
+		apu.enableInterrupt = (value & APU__DISABLE_INTERRUPT) ? false : true;
+
+		if (apu.enableInterrupt == false)
 		{
-			APU_requestFrameIRQ = false;
+			apu.requestFrameIRQ = false;
 
 			CPU::releaseInterruptPin(INTERRUPT_SOURCE_APU);
 		}
 
-		if (APU__SEQUENCE_STEP4 < APU_cycleCount)
+		if (APU__SEQUENCE_STEP4 < apu.cycleCount)
 		{
-			APU_cycleCount = APU__SEQUENCE_STEP4;
+			apu.cycleCount = APU__SEQUENCE_STEP4;
 		}
-		else if (APU__SEQUENCE_STEP3 < APU_cycleCount)
+		else if (APU__SEQUENCE_STEP3 < apu.cycleCount)
 		{
-			APU_cycleCount = APU__SEQUENCE_STEP3;
+			apu.cycleCount = APU__SEQUENCE_STEP3;
 		}
-		else if (APU__SEQUENCE_STEP2 < APU_cycleCount)
+		else if (APU__SEQUENCE_STEP2 < apu.cycleCount)
 		{
-			APU_cycleCount = APU__SEQUENCE_STEP2;
+			apu.cycleCount = APU__SEQUENCE_STEP2;
 		}
-		else if (APU__SEQUENCE_STEP1 < APU_cycleCount)
+		else if (APU__SEQUENCE_STEP1 < apu.cycleCount)
 		{
-			APU_cycleCount = APU__SEQUENCE_STEP1;
+			apu.cycleCount = APU__SEQUENCE_STEP1;
 		}
 		else
 		{
-			APU_cycleCount = 0;
+			apu.cycleCount = 0;
 		}
 
-		if ((APU_frameSteps == 4) && (APU_cycleCount > APU__SEQUENCE_STEP3))
+		if ((apu.frameSteps == 4) && (apu.cycleCount > APU__SEQUENCE_STEP3))
 		{
-			APU_cycleCount = APU__SEQUENCE_STEP3;
+			apu.cycleCount = APU__SEQUENCE_STEP3;
 		}
 	}
 
 	uint8_t readRegisterStatus()
 	{
+		APU_state_t &apu = CC_console->apu;
+
 		uint8_t status = 0x00;
 
-		if (APU_requetsDMCIRQ)
+		if (apu.requetsDMCIRQ)
 		{
 			status |= APU__INTERRUPT_DMC;
 		}
 
-		if (APU_requestFrameIRQ)
+		if (apu.requestFrameIRQ)
 		{
 			status |= APU__INTERRUPT_FRAME;
 		}
 
-		APU_requetsDMCIRQ = false;
-		APU_requestFrameIRQ = false;
+		apu.requetsDMCIRQ = false;
+		apu.requestFrameIRQ = false;
 
 		CPU::releaseInterruptPin(INTERRUPT_SOURCE_APU);
 		CPU::releaseInterruptPin(INTERRUPT_SOURCE_DMC);
 
-		if (APU_Pulse1_lengthCounter)
+		if (apu.pulse1.lengthCounter)
 		{
 			status |= APU__CHANNEL_PULSE1;
 		}
 
-		if (APU_Pulse2_lengthCounter)
+		if (apu.pulse2.lengthCounter)
 		{
 			status |= APU__CHANNEL_PULSE2;
 		}
 
-		if (APU_Triangle_lengthCounter)
+		if (apu.triangle.lengthCounter)
 		{
 			status |= APU__CHANNEL_TRIANGLE;
 		}
 
-		if (APU_Noise_lengthCounter)
+		if (apu.noise.lengthCounter)
 		{
 			status |= APU__CHANNEL_NOISE;
 		}
 
-		if (APU_channelDeltaSignaEnable)
+		if (apu.channelDeltaSignaEnable)
 		{
 			status |= APU__CHANNEL_DMC;
 		}
@@ -896,200 +587,509 @@ namespace APU
 	}
 }
 
+/* Executes one APU cycle */
+inline void APU_cycle__step()
+{
+	APU_state_t &apu = CC_console->apu;
+
+	++apu.cycleCount;
+
+	if (apu.cycleCount == APU__SEQUENCE_STEP1)
+	{
+		APU_envelope__step();
+		APU_triangle__step();
+	}
+
+	if (apu.cycleCount == APU__SEQUENCE_STEP2)
+	{
+		APU_envelope__step();
+		APU_triangle__step();
+		APU_length__step();
+		APU_sweep__step();
+	}
+
+	if (apu.cycleCount == APU__SEQUENCE_STEP3)
+	{
+		APU_envelope__step();
+		APU_triangle__step();
+	}
+
+	if (apu.cycleCount == APU__SEQUENCE_STEP4)
+	{
+		if (apu.frameSteps == 4)
+		{
+			APU_envelope__step();
+			APU_triangle__step();
+			APU_length__step();
+			APU_sweep__step();
+
+			if (apu.enableInterrupt)
+			{
+				apu.requestFrameIRQ = true;
+				CPU::pullInterruptPin(INTERRUPT_SOURCE_APU);
+			}
+
+			apu.cycleCount = 0;
+		}
+	}
+
+	if (apu.cycleCount == APU__SEQUENCE_STEP5)
+	{
+		APU_envelope__step();
+		APU_triangle__step();
+		APU_length__step();
+		APU_sweep__step();
+
+		apu.cycleCount = 0;
+	}
+
+	/* Pulse 1 */
+	if (apu.pulse1.timerValue == 0)
+	{
+		apu.pulse1.outputHigh = (APU_pulseDutyCycles[apu.pulse1.dutyCycle] & apu.pulse1.dutyCyclePosition) ? true : false;
+		apu.pulse1.dutyCyclePosition >>= 1;
+		if (apu.pulse1.dutyCyclePosition == 0)
+		{
+			apu.pulse1.dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
+		}
+	}
+
+	apu.pulse1.timerValue += 1;
+	apu.pulse1.timerValue %= (apu.pulse1.timer + 1);
+
+	/* Pulse 2 */
+	if (apu.pulse2.timerValue == 0)
+	{
+		apu.pulse2.outputHigh = (APU_pulseDutyCycles[apu.pulse2.dutyCycle] & apu.pulse2.dutyCyclePosition) ? true : false;
+		apu.pulse2.dutyCyclePosition >>= 1;
+		if (apu.pulse2.dutyCyclePosition == 0)
+		{
+			apu.pulse2.dutyCyclePosition = APU__PULSE_DUTY_CYCLE_INITIAL_POSITION;
+		}
+	}
+
+	apu.pulse2.timerValue += 1;
+	apu.pulse2.timerValue %= (apu.pulse2.timer + 1);
+
+	/* Triangle */
+	for (int i = 0; i < 2; ++i) // because the timer for Triangle is 2 * APUclock
+	{
+		if ((apu.triangle.timerValue == 0) && apu.triangle.lengthCounter && apu.triangle.linearCounter)
+		{
+			apu.triangle.currentSample = APU_triangleSequence[apu.triangle.sequencePosition];
+			apu.triangle.sequencePosition = (apu.triangle.sequencePosition + 1) % APU__TRIANGLE_SEQUENCE_LENGTH;
+		}
+
+		apu.triangle.timerValue += 1;
+		apu.triangle.timerValue %= (apu.triangle.timer + 1);
+	}
+
+	/* Noise */
+	if (apu.noise.timerValue == 0)
+	{
+		uint16_t newBit;
+		if (apu.noise.mode)
+		{
+			newBit = (apu.noise.shiftRegister ^ (apu.noise.shiftRegister >> 6)) & 1;
+		}
+		else
+		{
+			newBit = (apu.noise.shiftRegister ^ (apu.noise.shiftRegister >> 1)) & 1;
+		}
+		newBit <<= 14;
+
+		apu.noise.shiftRegister >>= 1;
+		apu.noise.shiftRegister |= newBit;
+
+		apu.noise.currentSample = apu.noise.shiftRegister & 1;
+	}
+
+	apu.noise.timerValue += 1;
+	apu.noise.timerValue %= apu.noisePeriods[apu.noise.period];
+
+	/* DMC */
+	if (apu.channelDeltaSignaEnable && !apu.dmc.stopped)
+	{
+		--apu.dmc.rateCounter;
+
+		if (apu.dmc.rateCounter == 0)
+		{
+			apu.dmc.rateCounter = apu.dmcRates[apu.dmc.selectedRate];
+
+			if (apu.dmc.shift == 0)
+			{
+				apu.dmc.currentSample = MB::readMainBus(apu.dmc.currentAddress);
+				CPU::skipCyclesForDMCFetch();
+
+				++apu.dmc.currentAddress;
+				--apu.dmc.samplesRemaining;
+
+				if (apu.dmc.samplesRemaining == 0)
+				{
+					if (apu.dmc.loop)
+					{
+						apu.dmc.samplesRemaining = apu.dmc.sampleLength;
+						apu.dmc.currentAddress = apu.dmc.addressStart;
+					}
+					else
+					{
+						apu.dmc.stopped = true;
+
+						if (apu.dmc.enableIRQ)
+						{
+							apu.requetsDMCIRQ = true;
+							CPU::pullInterruptPin(INTERRUPT_SOURCE_DMC);
+						}
+					}
+				}
+
+				apu.dmc.shift = 0x01;
+			}
+
+			if (apu.dmc.currentSample & apu.dmc.shift)
+			{
+				if (apu.dmc.counter < 126)
+				{
+					apu.dmc.counter += 2;
+				}
+			}
+			else
+			{
+				if (apu.dmc.counter > 1)
+				{
+					apu.dmc.counter -= 2;
+				}
+			}
+
+			apu.dmc.shift <<= 1;
+
+			apu.dmc.output = apu.dmc.counter;
+		}
+	}
+
+	/* Render */
+	if (apu.outputSuppressed)
+	{
+		return;
+	}
+
+	float sample = 0.0f;
+
+	/* Pulse1 render */
+	uint8_t samplePulse1;
+
+	uint16_t period1 = (apu.pulse1.timer + 1) >> apu.pulse1.sweepShiftCount;
+	if (apu.pulse1.sweepNegate)
+	{
+		period1 = -period1; // for pulse2 will be    period = -period + 1;
+	}
+	period1 += apu.pulse1.timer + 1;
+
+	if ((apu.pulse1.timer + 1 < 8) || (period1 > 0x07FF) || (apu.pulse1.lengthCounter == 0) || (apu.pulse1.outputHigh == false))
+	{
+		samplePulse1 = 0;
+	}
+	else
+	{
+		if (apu.pulse1.constantVolume_envelopeFlag)
+		{
+			samplePulse1 = apu.pulse1.volume_envelopePeriod;
+		}
+		else
+		{
+			samplePulse1 = apu.pulse1.envelope;
+		}
+	}
+
+	if (apu.channelPulse1Enable)
+	{
+		sample += samplePulse1 * APU__WEIGHT_PULSE;
+	}
+
+	/* Pulse2 render */
+	uint8_t samplePulse2;
+
+	uint16_t period2 = (apu.pulse2.timer + 1) >> apu.pulse2.sweepShiftCount;
+	if (apu.pulse2.sweepNegate)
+	{
+		period2 = -period2 + 1;
+	}
+	period2 += apu.pulse2.timer + 1;
+
+	if ((apu.pulse2.timer + 1 < 8) || (period2 > 0x07FF) || (apu.pulse2.lengthCounter == 0) || (apu.pulse2.outputHigh == false))
+	{
+		samplePulse2 = 0;
+	}
+	else
+	{
+		if (apu.pulse2.constantVolume_envelopeFlag)
+		{
+			samplePulse2 = apu.pulse2.volume_envelopePeriod;
+		}
+		else
+		{
+			samplePulse2 = apu.pulse2.envelope;
+		}
+	}
+
+	if (apu.channelPulse2Enable)
+	{
+		sample += samplePulse2 * APU__WEIGHT_PULSE;
+	}
+
+	/* Triangle render */
+	if (apu.channelTriangleEnable)
+	{
+		sample += apu.triangle.currentSample * APU__WEIGHT_TRIANGLE;
+	}
+
+	/* Noise render */
+	uint8_t sampleNoise;
+
+	if ((apu.noise.currentSample == 0) || (apu.noise.lengthCounter == 0))
+	{
+		sampleNoise = 0;
+	}
+	else
+	{
+		if (apu.noise.constantVolume_envelopeFlag)
+		{
+			sampleNoise = apu.noise.volume_envelopePeriod;
+		}
+		else
+		{
+			sampleNoise = apu.noise.envelope;
+		}
+	}
+
+	if (apu.channelNoiseEnable)
+	{
+		sample += sampleNoise * APU__WEIGHT_NOISE;
+	}
+
+	/*DMC render */
+	uint8_t sampleDMC = apu.dmc.output;
+
+	if (apu.channelDeltaSignaEnable)
+	{
+		sample += sampleDMC * APU__WEIGHT_DMC;
+	}
+
+	/* Mixing */
+	apu.mixedSample += sample * apu.gaussFilterInUse[apu.mixingPosition];
+
+	++apu.mixingPosition;
+	if (apu.mixingPosition == apu.gaussFilterLength)
+	{
+		AD::queueSample((uint16_t)(apu.mixedSample * APU__OUTPUT_VOLUME));
+
+		apu.mixingPosition = 0;
+		apu.mixedSample = 0.0f;
+	}
+}
+
 void APU_envelope__step()
 {
+	APU_state_t &apu = CC_console->apu;
+
 	/* Pulse1 envelope */
-	if (APU_Pulse1_resetEnvelope)
+	if (apu.pulse1.resetEnvelope)
 	{
-		APU_Pulse1_envelope = 15;
-		APU_Pulse1_envelopeDivider = APU_Pulse1_volume_envelopePeriod + 1;
-		APU_Pulse1_resetEnvelope = false;
+		apu.pulse1.envelope = 15;
+		apu.pulse1.envelopeDivider = apu.pulse1.volume_envelopePeriod + 1;
+		apu.pulse1.resetEnvelope = false;
 	}
 	else
 	{
-		if (APU_Pulse1_envelopeDivider)
+		if (apu.pulse1.envelopeDivider)
 		{
-			--APU_Pulse1_envelopeDivider;
+			--apu.pulse1.envelopeDivider;
 		}
 		else
 		{
-			if (APU_Pulse1_envelope)
+			if (apu.pulse1.envelope)
 			{
-				--APU_Pulse1_envelope;
+				--apu.pulse1.envelope;
 			}
-			else if (APU_Pulse1_lengthCounterHalt == true)
+			else if (apu.pulse1.lengthCounterHalt == true)
 			{
-				APU_Pulse1_envelope = 15;
+				apu.pulse1.envelope = 15;
 			}
 
-			APU_Pulse1_envelopeDivider = APU_Pulse1_volume_envelopePeriod + 1;
+			apu.pulse1.envelopeDivider = apu.pulse1.volume_envelopePeriod + 1;
 		}
 	}
 
 	/* Pulse2 envelope */
-	if (APU_Pulse2_resetEnvelope)
+	if (apu.pulse2.resetEnvelope)
 	{
-		APU_Pulse2_envelope = 15;
-		APU_Pulse2_envelopeDivider = APU_Pulse2_volume_envelopePeriod + 1;
-		APU_Pulse2_resetEnvelope = false;
+		apu.pulse2.envelope = 15;
+		apu.pulse2.envelopeDivider = apu.pulse2.volume_envelopePeriod + 1;
+		apu.pulse2.resetEnvelope = false;
 	}
 	else
 	{
-		if (APU_Pulse2_envelopeDivider)
+		if (apu.pulse2.envelopeDivider)
 		{
-			--APU_Pulse2_envelopeDivider;
+			--apu.pulse2.envelopeDivider;
 		}
 		else
 		{
-			if (APU_Pulse2_envelope)
+			if (apu.pulse2.envelope)
 			{
-				--APU_Pulse2_envelope;
+				--apu.pulse2.envelope;
 			}
-			else if (APU_Pulse2_lengthCounterHalt == true)
+			else if (apu.pulse2.lengthCounterHalt == true)
 			{
-				APU_Pulse2_envelope = 15;
+				apu.pulse2.envelope = 15;
 			}
 
-			APU_Pulse2_envelopeDivider = APU_Pulse2_volume_envelopePeriod + 1;
+			apu.pulse2.envelopeDivider = apu.pulse2.volume_envelopePeriod + 1;
 		}
 	}
 
 	/* Noise envelope */
-	if (APU_Noise_resetEnvelope)
+	if (apu.noise.resetEnvelope)
 	{
-		APU_Noise_envelope = 15;
-		APU_Noise_envelopeDivider = APU_Noise_volume_envelopePeriod + 1;
-		APU_Noise_resetEnvelope = false;
+		apu.noise.envelope = 15;
+		apu.noise.envelopeDivider = apu.noise.volume_envelopePeriod + 1;
+		apu.noise.resetEnvelope = false;
 	}
 	else
 	{
-		if (APU_Noise_envelopeDivider)
+		if (apu.noise.envelopeDivider)
 		{
-			--APU_Noise_envelopeDivider;
+			--apu.noise.envelopeDivider;
 		}
 		else
 		{
-			if (APU_Noise_envelope)
+			if (apu.noise.envelope)
 			{
-				--APU_Noise_envelope;
+				--apu.noise.envelope;
 			}
-			else if (APU_Noise_lengthCounterHalt)
+			else if (apu.noise.lengthCounterHalt)
 			{
-				APU_Noise_envelope = 15;
+				apu.noise.envelope = 15;
 			}
 
-			APU_Noise_envelopeDivider = APU_Noise_volume_envelopePeriod + 1;
+			apu.noise.envelopeDivider = apu.noise.volume_envelopePeriod + 1;
 		}
 	}
 }
 
 void APU_triangle__step()
 {
-	if (APU_Triangle_linearCounterHalt)
+	APU_state_t &apu = CC_console->apu;
+
+	if (apu.triangle.linearCounterHalt)
 	{
-		APU_Triangle_linearCounter = APU_Triangle_linearCounterReload;
+		apu.triangle.linearCounter = apu.triangle.linearCounterReload;
 	}
-	else if (APU_Triangle_linearCounter)
+	else if (apu.triangle.linearCounter)
 	{
-		--APU_Triangle_linearCounter;
+		--apu.triangle.linearCounter;
 	}
 
-	if (APU_Triangle_linearCounterControl == false)
+	if (apu.triangle.linearCounterControl == false)
 	{
-		APU_Triangle_linearCounterHalt = false;
+		apu.triangle.linearCounterHalt = false;
 	}
 }
 
 void APU_length__step()
 {
+	APU_state_t &apu = CC_console->apu;
+
 	/* Pulse1 length */
-	if ((APU_Pulse1_lengthCounterHalt == false) && APU_Pulse1_lengthCounter)
+	if ((apu.pulse1.lengthCounterHalt == false) && apu.pulse1.lengthCounter)
 	{
-		--APU_Pulse1_lengthCounter;
+		--apu.pulse1.lengthCounter;
 	}
 
 	/* Pulse2 length */
-	if ((APU_Pulse2_lengthCounterHalt == false) && APU_Pulse2_lengthCounter)
+	if ((apu.pulse2.lengthCounterHalt == false) && apu.pulse2.lengthCounter)
 	{
-		--APU_Pulse2_lengthCounter;
+		--apu.pulse2.lengthCounter;
 	}
 
 	/* Triangle */
-	if ((APU_Triangle_linearCounterControl == false) && APU_Triangle_lengthCounter)
+	if ((apu.triangle.linearCounterControl == false) && apu.triangle.lengthCounter)
 	{
-		--APU_Triangle_lengthCounter;
+		--apu.triangle.lengthCounter;
 	}
 
 	/* Noise */
-	if ((APU_Noise_lengthCounterHalt == false) && APU_Noise_lengthCounter)
+	if ((apu.noise.lengthCounterHalt == false) && apu.noise.lengthCounter)
 	{
-		--APU_Noise_lengthCounter;
+		--apu.noise.lengthCounter;
 	}
 }
 
 void APU_sweep__step()
 {
+	APU_state_t &apu = CC_console->apu;
+
 	/* Pulse1 sweep */
-	if (APU_Pulse1_resetSweep)
+	if (apu.pulse1.resetSweep)
 	{
-		APU_Pulse1_sweepDivider = APU_Pulse1_sweepPeriod + 1;
-		APU_Pulse1_resetSweep = false;
+		apu.pulse1.sweepDivider = apu.pulse1.sweepPeriod + 1;
+		apu.pulse1.resetSweep = false;
 	}
 	else
 	{
-		if (APU_Pulse1_sweepDivider)
+		if (apu.pulse1.sweepDivider)
 		{
-			--APU_Pulse1_sweepDivider;
+			--apu.pulse1.sweepDivider;
 		}
 		else
 		{
-			if (APU_Pulse1_sweepEnable)
+			if (apu.pulse1.sweepEnable)
 			{
-				APU_Pulse1_sweepDivider = APU_Pulse1_sweepPeriod + 1;
+				apu.pulse1.sweepDivider = apu.pulse1.sweepPeriod + 1;
 
-				uint16_t period = (APU_Pulse1_timer + 1) >> APU_Pulse1_sweepShiftCount;
-				if (APU_Pulse1_sweepNegate)
+				uint16_t period = (apu.pulse1.timer + 1) >> apu.pulse1.sweepShiftCount;
+				if (apu.pulse1.sweepNegate)
 				{
 					period = -1 - period;
 				}
-				period += APU_Pulse1_timer + 1;
+				period += apu.pulse1.timer + 1;
 
-				if ((period <= 0x07FF) && (APU_Pulse1_timer + 1 >= 8))
+				if ((period <= 0x07FF) && (apu.pulse1.timer + 1 >= 8))
 				{
-					APU_Pulse1_timer = period;
+					apu.pulse1.timer = period;
 				}
 			}
 		}
 	}
 
 	/* Pulse2 sweep */
-	if (APU_Pulse2_resetSweep)
+	if (apu.pulse2.resetSweep)
 	{
-		APU_Pulse2_sweepDivider = APU_Pulse2_sweepPeriod + 1;
-		APU_Pulse2_resetSweep = false;
+		apu.pulse2.sweepDivider = apu.pulse2.sweepPeriod + 1;
+		apu.pulse2.resetSweep = false;
 	}
 	else
 	{
-		if (APU_Pulse2_sweepDivider)
+		if (apu.pulse2.sweepDivider)
 		{
-			--APU_Pulse2_sweepDivider;
+			--apu.pulse2.sweepDivider;
 		}
 		else
 		{
-			if (APU_Pulse2_sweepEnable)
+			if (apu.pulse2.sweepEnable)
 			{
-				APU_Pulse2_sweepDivider = APU_Pulse2_sweepPeriod + 1;
+				apu.pulse2.sweepDivider = apu.pulse2.sweepPeriod + 1;
 
-				uint16_t period = (APU_Pulse2_timer + 1) >> APU_Pulse2_sweepShiftCount;
-				if (APU_Pulse2_sweepNegate)
+				uint16_t period = (apu.pulse2.timer + 1) >> apu.pulse2.sweepShiftCount;
+				if (apu.pulse2.sweepNegate)
 				{
 					period = -period;
 				}
-				period += APU_Pulse2_timer + 1;
+				period += apu.pulse2.timer + 1;
 
-				if ((period <= 0x07FF) && (APU_Pulse2_timer + 1 >= 8))
+				if ((period <= 0x07FF) && (apu.pulse2.timer + 1 >= 8))
 				{
-					APU_Pulse2_timer = period;
+					apu.pulse2.timer = period;
 				}
 			}
 		}
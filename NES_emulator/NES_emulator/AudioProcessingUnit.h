@@ -5,7 +5,9 @@
 namespace APU
 {
 	void reset();
-	void step();
+	void run(uint32_t cycles);
+	uint32_t getCyclesUntilEvent(); // cycles until the next interrupt or DMC fetch
+	void suppressOutput(bool suppress); // stops rendering and queueing samples ... the channels keep running
 	void writeRegisterSQ1Volume(uint8_t value);
 	void writeRegisterSQ1Sweep(uint8_t value);
 	void writeRegisterSQ1PeriodLow(uint8_t value);
@@ -1,20 +1,15 @@
 #include "CartridgeReader.h"
 
-#include <fstream>
+#include "ConsoleContext.h"
 
-static uint8_t CR_mirroring = 0;
-static uint8_t CR_mapper = 0;
-static bool CR_hasBatteryBackedRAM = false;
-static uint8_t *CR_PRGROM = nullptr;
-static uint8_t *CR_CHRROM = nullptr;
-static uint8_t CR_PRGBankCount = 0;
-static uint8_t CR_CHRBankCount = 0;
-static uint8_t CR_systemType = 0;
+#include <fstream>
 
 namespace CR
 {
 	uint8_t loadFile(std::string file_name)
 	{
+		CR_state_t &cr = CC_console->cr;
+
 		std::ifstream nesRom(file_name, std::ios_base::in | std::ios_base::binary);
 		if (!nesRom)
 		{
@@ -32,13 +27,13 @@ namespace CR
 			return (STATUS_CR_LOAD_WRONG_FILE_FORMAT);
 		}
 
-		CR_PRGBankCount = romHeader[4]; // the number of 16KB brogram banks
-		if (!CR_PRGBankCount)
+		cr.PRGBankCount = romHeader[4]; // the number of 16KB brogram banks
+		if (!cr.PRGBankCount)
 		{
 			return (STATUS_CR_LOAD_NO_PROGRAM_ROM_BANKS);
 		}
 
-		CR_CHRBankCount = romHeader[5]; // the number of 8KB video-rom banks
+		cr.CHRBankCount = romHeader[5]; // the number of 8KB video-rom banks
 
 		if (romHeader[6] & 0x04) // has trainer at $7000-$71FF
 		{
@@ -47,33 +42,34 @@ namespace CR
 
 		if (romHeader[9] & 0x01)
 		{
-			CR_systemType = SYSTEM_PAL;
+			cr.systemType = SYSTEM_PAL;
 		}
 		else
 		{
-			CR_systemType = SYSTEM_NTSC;
+			cr.systemType = SYSTEM_NTSC;
 		}
 
-		CR_hasBatteryBackedRAM = (romHeader[6] & 0x02) ? true : false;
-		CR_mirroring = romHeader[6] & 0x09;
-		CR_mapper = ((romHeader[6] >> 4) & 0x0F) | (romHeader[7] & 0xF0);
+		cr.hasBatteryBackedRAM = (romHeader[6] & 0x02) ? true : false;
+		cr.cycleAccurate = std::ifstream(file_name + CR_CYCLE_ACCURATE_MARKER).good();
+		cr.mirroring = romHeader[6] & 0x09;
+		cr.mapper = ((romHeader[6] >> 4) & 0x0F) | (romHeader[7] & 0xF0);
 
-		CR_PRGROM = new uint8_t[CR_PRGBankCount * 0x4000];
-		CR_CHRROM = CR_CHRBankCount ? new uint8_t[CR_CHRBankCount * 0x2000] : nullptr;
+		cr.PRGROM = new uint8_t[cr.PRGBankCount * 0x4000];
+		cr.CHRROM = cr.CHRBankCount ? new uint8_t[cr.CHRBankCount * 0x2000] : nullptr;
 
-		if (!CR_PRGROM || (CR_CHRBankCount && !CR_CHRROM))
+		if (!cr.PRGROM || (cr.CHRBankCount && !cr.CHRROM))
 		{
 			return (STATUS_CR_LOAD_MEMORY_ALLOCATION_FAILURE);
 		}
 
-		if (!nesRom.read((char*)CR_PRGROM, CR_PRGBankCount * 0x4000))
+		if (!nesRom.read((char*)cr.PRGROM, cr.PRGBankCount * 0x4000))
 		{
 			return (STATUS_CR_LOAD_UNABLE_TO_READ_FROM_FILE);
 		}
 
-		if (CR_CHRBankCount)
+		if (cr.CHRBankCount)
 		{
-			if (!nesRom.read((char*)CR_CHRROM, CR_CHRBankCount * 0x2000))
+			if (!nesRom.read((char*)cr.CHRROM, cr.CHRBankCount * 0x2000))
 			{
 				return (STATUS_CR_LOAD_UNABLE_TO_READ_FROM_FILE);
 			}
@@ -84,54 +80,79 @@ namespace CR
 
 	uint8_t* getROM()
 	{
-		return (CR_PRGROM);
+		CR_state_t &cr = CC_console->cr;
+
+		return (cr.PRGROM);
 	}
 
 	uint8_t* getVideoROM()
 	{
-		return (CR_CHRROM);
+		CR_state_t &cr = CC_console->cr;
+
+		return (cr.CHRROM);
 	}
 
 	uint8_t getROMBankCount()
 	{
-		return (CR_PRGBankCount);
+		CR_state_t &cr = CC_console->cr;
+
+		return (cr.PRGBankCount);
 	}
 
 	uint8_t getVROMBankCount()
 	{
-		return (CR_CHRBankCount);
+		CR_state_t &cr = CC_console->cr;
+
+		return (cr.CHRBankCount);
 	}
 
 	uint8_t getNameTableMirroring()
 	{
-		return (CR_mirroring);
+		CR_state_t &cr = CC_console->cr;
+
+		return (cr.mirroring);
 	}
 
 	uint8_t getMapperType()
 	{
-		return (CR_mapper);
+		CR_state_t &cr = CC_console->cr;
+
+		return (cr.mapper);
 	}
 
 	uint8_t getSystemType()
 	{
-		return (CR_systemType);
+		CR_state_t &cr = CC_console->cr;
+
+		return (cr.systemType);
 	}
 
 	bool getBatteryBackedRAMAvailability()
 	{
-		return (CR_hasBatteryBackedRAM);
+		CR_state_t &cr = CC_console->cr;
+
+		return (cr.hasBatteryBackedRAM);
+	}
+
+	bool getCycleAccuracyRequirement()
+	{
+		CR_state_t &cr = CC_console->cr;
+
+		return (cr.cycleAccurate);
 	}
 
 	void clean()
 	{
-		if (CR_PRGROM)
+		CR_state_t &cr = CC_console->cr;
+
+		if (cr.PRGROM)
 		{
-			delete[] CR_PRGROM;
+			delete[] cr.PRGROM;
 		}
 
-		if (CR_CHRROM)
+		if (cr.CHRROM)
 		{
-			delete[] CR_CHRROM;
+			delete[] cr.CHRROM;
 		}
 	}
 }
\ No newline at end of file
@@ -14,6 +14,8 @@
 #define SYSTEM_NTSC (0u)
 #define SYSTEM_PAL (1u)
 
+#define CR_CYCLE_ACCURATE_MARKER (".accurate") // an empty file named after the ROM with this added selects the cycle accurate CPU for it
+
 namespace CR
 {
 	uint8_t loadFile(std::string file_name);
@@ -25,5 +27,6 @@ namespace CR
 	uint8_t getMapperType();
 	uint8_t getSystemType();
 	bool getBatteryBackedRAMAvailability();
+	bool getCycleAccuracyRequirement(); // the game depends on when inside an instruction the bus is accessed
 	void clean();
 }
\ No newline at end of file
@@ -1,6 +1,15 @@
 #include "CentralProcessingUnit.h"
 
+#include "CartridgeReader.h"
+#include "Debugger.h"
+#include "DynamicRecompiler.h"
+#include "MasterClock.h"
 #include "MemoryBus.h"
+#include "MemoryMapper.h"
+#include "PictureProcessingUnit.h"
+#include "Profiler.h"
+#include "Tracer.h"
+#include "ConsoleContext.h"
 
 #define CPU__VECTOR_NMI (0xFFFAu)
 #define CPU__VECTOR_RESET (0xFFFCu)
@@ -8,14 +17,12 @@
 
 #define CPU__DMA_DURATION (514u)
 
+#define CPU__REQUEST_NMI (0x80u) // kept with the IRQ sources, so a single test per instruction tells that nothing is waiting
+
 #define CPU__STACK_POINTER_INITIAL_VALUE (0xFDu) 
 
 #define CPU__PAGE_MASK (0xFF00u)
-#define CPU__BRANCK_MASK (0x1Fu)
-#define CPU__INSTRUCTION_TYPE_MASK (0x03u)
-#define CPU__ADDRESSING_MODE_MASK (0x1Cu)
-#define CPU__OPERATION_MASK (0xE0u)
-
+#define CPU__BLOCK_WINDOW (0x2000u) // no mapper switches smaller PRG banks, so a block is never split between two of them
 #define CPU__FLAG_DEFAULT_HIGH (0x20u)
 #define CPU__FLAG_NEGATIVE (0x80u)
 #define CPU__FLAG_OVERFLOW (0x40u)
@@ -25,90 +32,28 @@
 #define CPU__FLAG_ZERO (0x02u)
 #define CPU__FLAG_CARRY (0x01u)
 
-#define CPU__BRANCH_CONDITION_BIT (0x20u)
-#define CPU__BRANCH_CONDITION_MASK (0xC0u)
-
-#define CPU__BRANCH_FLAG_NEGATIVE (0x00u)
-#define CPU__BRANCH_FLAG_OVERFLOW (0x40u)
-#define CPU__BRANCH_FLAG_CARRY (0x80u)
-#define CPU__BRANCH_FLAG_ZERO (0xC0u)
-
-#define CPU__INSTRUCTION_TYPE_0 (0x00u)
-#define CPU__INSTRUCTION_TYPE_1 (0x01u)
-#define CPU__INSTRUCTION_TYPE_2 (0x02u)
-
-#define CPU__ADDRESSING_TYPE_0_IMMEDIATE (0x00u)
-#define CPU__ADDRESSING_TYPE_0_ZEROPAGE (0x04u)
-#define CPU__ADDRESSING_TYPE_0_ABSOLUTE (0x0Cu)
-#define CPU__ADDRESSING_TYPE_0_ZEROPAGE_X (0x14u)
-#define CPU__ADDRESSING_TYPE_0_ABSOLUTE_X (0x1Cu)
-#define CPU__ADDRESSING_TYPE_1_INDIRECT_X (0x00u)
-#define CPU__ADDRESSING_TYPE_1_ZEROPAGE (0x04u)
-#define CPU__ADDRESSING_TYPE_1_IMMEDIATE (0x08u)
-#define CPU__ADDRESSING_TYPE_1_ABSOLUTE (0x0Cu)
-#define CPU__ADDRESSING_TYPE_1_INDIRECT_Y (0x10u)
-#define CPU__ADDRESSING_TYPE_1_ZEROPAGE_X (0x14u)
-#define CPU__ADDRESSING_TYPE_1_ABSOLUTE_Y (0x18u)
-#define CPU__ADDRESSING_TYPE_1_ABSOLUTE_X (0x1Cu)
-#define CPU__ADDRESSING_TYPE_2_IMMEDIATE (0x00u)
-#define CPU__ADDRESSING_TYPE_2_ZEROPAGE (0x04u)
-#define CPU__ADDRESSING_TYPE_2_ACCUMULATOR (0x08u)
-#define CPU__ADDRESSING_TYPE_2_ABSOLUTE (0x0Cu)
-#define CPU__ADDRESSING_TYPE_2_ZEROPAGE_XY (0x14u)
-#define CPU__ADDRESSING_TYPE_2_ABSOLUTE_XY (0x1Cu)
-
-#define CPU__OPERATION_TYPE_0_BIT (0x20u)
-#define CPU__OPERATION_TYPE_0_STY (0x80u)
-#define CPU__OPERATION_TYPE_0_LDY (0xA0u)
-#define CPU__OPERATION_TYPE_0_CPY (0xC0u)
-#define CPU__OPERATION_TYPE_0_CPX (0xE0u)
-#define CPU__OPERATION_TYPE_1_ORA (0x00u)
-#define CPU__OPERATION_TYPE_1_AND (0x20u)
-#define CPU__OPERATION_TYPE_1_EOR (0x40u)
-#define CPU__OPERATION_TYPE_1_ADC (0x60u)
-#define CPU__OPERATION_TYPE_1_STA (0x80u)
-#define CPU__OPERATION_TYPE_1_LDA (0xA0u)
-#define CPU__OPERATION_TYPE_1_CMP (0xC0u)
-#define CPU__OPERATION_TYPE_1_SBC (0xE0u)
-#define CPU__OPERATION_TYPE_2_ASL (0x00u)
-#define CPU__OPERATION_TYPE_2_ROL (0x20u)
-#define CPU__OPERATION_TYPE_2_LSR (0x40u)
-#define CPU__OPERATION_TYPE_2_ROR (0x60u)
-#define CPU__OPERATION_TYPE_2_STX (0x80u)
-#define CPU__OPERATION_TYPE_2_LDX (0xA0u)
-#define	CPU__OPERATION_TYPE_2_DEC (0xC0u)
-#define CPU__OPERATION_TYPE_2_INC (0xE0u)
-
-#define CPU__OPCODE_IMPLIED_BRK (0x00u)
-#define CPU__OPCODE_IMPLIED_PHP (0x08u)
-#define CPU__OPCODE_IMPLIED_CLC (0x18u)
-#define CPU__OPCODE_IMPLIED_JSR (0x20u)
-#define CPU__OPCODE_IMPLIED_PLP (0x28u)
-#define CPU__OPCODE_IMPLIED_SEC (0x38u)
-#define CPU__OPCODE_IMPLIED_RTI (0x40u)
-#define CPU__OPCODE_IMPLIED_PHA (0x48u)
-#define CPU__OPCODE_IMPLIED_JMP (0x4Cu)
-#define CPU__OPCODE_IMPLIED_CLI (0x58u)
-#define CPU__OPCODE_IMPLIED_RTS (0x60u)
-#define CPU__OPCODE_IMPLIED_PLA (0x68u)
-#define CPU__OPCODE_IMPLIED_JMPI (0x6Cu)
-#define CPU__OPCODE_IMPLIED_SEI (0x78u)
-#define CPU__OPCODE_IMPLIED_DEY (0x88u)
-#define CPU__OPCODE_IMPLIED_TXA (0x8Au)
-#define CPU__OPCODE_IMPLIED_TYA (0x98u)
-#define CPU__OPCODE_IMPLIED_TXS (0x9Au)
-#define CPU__OPCODE_IMPLIED_TAY (0xA8u)
-#define CPU__OPCODE_IMPLIED_TAX (0xAAu)
-#define CPU__OPCODE_IMPLIED_CLV (0xB8u)
-#define CPU__OPCODE_IMPLIED_TSX (0xBAu)
-#define CPU__OPCODE_IMPLIED_INY (0xC8u)
-#define CPU__OPCODE_IMPLIED_DEX (0xCAu)
-#define CPU__OPCODE_IMPLIED_CLD (0xD8u)
-#define CPU__OPCODE_IMPLIED_INX (0xE8u)
-#define CPU__OPCODE_IMPLIED_NOP (0xEAu)
-#define CPU__OPCODE_IMPLIED_SED (0xF8u)
-
-#define CPU__INSTRUCTION_TYPE_BRANCH (0x10u)
+#define CPU__ADDRESSING_ACCUMULATOR (0u)
+#define CPU__ADDRESSING_IMMEDIATE (1u)
+#define CPU__ADDRESSING_ZEROPAGE (2u)
+#define CPU__ADDRESSING_ZEROPAGE_X (3u)
+#define CPU__ADDRESSING_ZEROPAGE_Y (4u)
+#define CPU__ADDRESSING_ABSOLUTE (5u)
+#define CPU__ADDRESSING_ABSOLUTE_X (6u)
+#define CPU__ADDRESSING_ABSOLUTE_Y (7u)
+#define CPU__ADDRESSING_INDIRECT_X (8u)
+#define CPU__ADDRESSING_INDIRECT_Y (9u)
+
+#define CPU__IDLE_LOOP_NONE (0u)
+#define CPU__IDLE_LOOP_POLL (1u) // reads RAM or ROM until an interrupt changes it
+#define CPU__IDLE_LOOP_STATUS (2u) // also reads the PPU status
+#define CPU__IDLE_LOOP_COUNTER (3u) // increments or decrements a RAM location until an interrupt comes
+
+#define CPU__FUSION_NONE (0u)
+#define CPU__FUSION_DEX_BNE (1u) // countdown loops
+#define CPU__FUSION_DEY_BNE (2u)
+#define CPU__FUSION_LDA_STA (3u) // copies, any addressing on both
+#define CPU__FUSION_LDA_CMP_BEQ (4u)
+#define CPU__FUSION_CLC_ADC (5u)
 
 static constexpr uint8_t CPU_operationDuration[] =
 { // invalid opcodes take one cycle
@@ -122,1040 +67,1763 @@ static constexpr uint8_t CPU_operationDuration[] =
 	2, 6, 1, 1, 3, 3, 5, 1, 2, 2, 2, 2, 4, 4, 6, 1,	2, 5, 1, 1, 1, 4, 6, 1, 2, 4, 1, 1, 1, 4, 7, 1
 };
 
-static uint16_t CPU_cyclesToSkip;
-
-static uint16_t CPU_registerPC;
-static uint8_t CPU_registerSP;
-static uint8_t CPU_registerA;
-static uint8_t CPU_registerX;
-static uint8_t CPU_registerY;
-static uint8_t CPU_flags;
-static uint8_t CPU_interruptRequests;
+static constexpr uint8_t CPU_operationLength[] =
+{ // opcode and operand bytes ... the unofficial NOPs do not skip their operands
+	1, 2, 1, 1, 1, 2, 2, 1, 1, 2, 1, 1, 1, 3, 3, 1, 2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,
+	3, 2, 1, 1, 2, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1, 2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,
+	1, 2, 1, 1, 1, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1, 2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,
+	1, 2, 1, 1, 1, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1, 2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,
+	1, 2, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 3, 3, 3, 1, 2, 2, 1, 1, 2, 2, 2, 1, 1, 3, 1, 1, 1, 3, 1, 1,
+	2, 2, 2, 1, 2, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1, 2, 2, 1, 1, 2, 2, 2, 1, 1, 3, 1, 1, 3, 3, 3, 1,
+	2, 2, 1, 1, 2, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1, 2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,
+	2, 2, 1, 1, 2, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1, 2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1
+};
 
-static bool CPU_doingDMA;
+/* Accuracy policies ... the core is compiled once for each, so the fast one does not pay for the other */
+struct CPU_fast_t
+{
+	static constexpr bool cycleAccurate = false; // the whole instruction is executed on its first cycle, bus accesses included
+	static constexpr bool instrumented = false;
+};
 
-#define CPU__stack_push(data) MB::writeMainBus(CPU_registerSP-- | 0x0100, (uint8_t)(data))
-#define CPU__stack_pop() MB::readMainBus(++CPU_registerSP | 0x0100)
+struct CPU_accurate_t
+{
+	static constexpr bool cycleAccurate = true; // the other units are brought up to the cycle of every access, dummy accesses are made and interrupts are polled where the 6502 polls them
+	static constexpr bool instrumented = false;
+};
 
-#define CPU__read_16_bits(address_of_lsb) ((uint16_t)MB::readMainBus(address_of_lsb) | ((uint16_t)(MB::readMainBus((address_of_lsb) + 1)) << 8))
+template <typename accuracy> struct CPU_instrumented_t : accuracy
+{
+	static constexpr bool instrumented = true; // every instruction is handed to PF, TR and DB, whichever are on, so none is skipped over or recompiled ... and every bus access to DB
+};
 
-#define CPU__set_flag_zero(value) CPU_flags = ((uint8_t)(value) & 0xFF) ? (CPU_flags & ~CPU__FLAG_ZERO) : (CPU_flags | CPU__FLAG_ZERO)
-#define CPU__set_flag_negative(value) CPU_flags = ((value) & 0x80) ? (CPU_flags | CPU__FLAG_NEGATIVE) : (CPU_flags & ~CPU__FLAG_NEGATIVE)
+#define CPU__stack_push(data) CPU_stack__push<policy>(cpu, (uint8_t)(data))
+#define CPU__stack_pop() CPU_stack__pop<policy>(cpu)
+
+#define CPU__read_16_bits(address_of_lsb) ((uint16_t)CPU_bus__read<policy>(cpu, address_of_lsb) | ((uint16_t)(CPU_bus__read<policy>(cpu, (address_of_lsb) + 1)) << 8))
+
+#define CPU__set_flags_NZ(value) cpu.resultNZ = (uint8_t)(value) // the flags are worked out from it only when needed
+
+template <typename policy> inline uint32_t CPU_core__run(uint32_t budget);
+template <typename policy> inline uint8_t CPU_bus__read(CPU_state_t &cpu, uint16_t address);
+template <typename policy> inline void CPU_bus__write(CPU_state_t &cpu, uint16_t address, uint8_t data);
+template <typename policy> inline void CPU_bus__writeBack(CPU_state_t &cpu, uint16_t address, uint8_t data);
+template <typename policy, uint8_t addressing> inline uint8_t CPU_memory__read(CPU_state_t &cpu, uint16_t address);
+template <typename policy, uint8_t addressing> inline void CPU_memory__write(CPU_state_t &cpu, uint16_t address, uint8_t data);
+template <typename policy> inline uint16_t CPU_memory__readPointer(CPU_state_t &cpu, uint8_t address);
+template <typename policy> inline void CPU_stack__push(CPU_state_t &cpu, uint8_t data);
+template <typename policy> inline uint8_t CPU_stack__pop(CPU_state_t &cpu);
+inline void CPU_access__begin(CPU_state_t &state);
+inline void CPU_access__end(CPU_state_t &cpu);
+template <typename policy> inline bool CPU_interrupt__pending(const CPU_state_t &cpu);
+template <typename policy> inline void CPU_interrupt__take(CPU_state_t &cpu);
+template <typename policy> inline void CPU_interrupt__enter(CPU_state_t &cpu, uint8_t interrupt);
+template <typename policy> inline void CPU_interrupt__poll(CPU_state_t &cpu, uint8_t opcode, uint8_t inhibit, bool nmi_due);
+inline uint8_t CPU_flags__pack(const CPU_state_t &cpu);
+inline void CPU_flags__store(CPU_state_t &cpu);
+inline void CPU_flags__load(CPU_state_t &cpu);
+inline void CPU_instruction__fetch(CPU_state_t &cpu, uint16_t address, CPU_instruction_t &instruction);
+inline bool CPU_instruction__endsBlock(uint8_t opcode);
+inline CPU_block_t& CPU_cache__block(uint16_t address);
+inline void CPU_idle__classify(CPU_block_t &block, uint16_t address);
+inline bool CPU_idle__skip(CPU_state_t &cpu, const CPU_block_t &block, uint32_t cycles_left);
+inline bool CPU_fusion__isGroupOne(uint8_t opcode, uint8_t operation);
+inline void CPU_fusion__classify(CPU_block_t &block);
+template <typename policy> inline bool CPU_fusion__next(CPU_state_t &cpu, const CPU_instruction_t *&instruction, uint16_t &instruction_address, uint32_t &cycles, uint32_t budget);
+template <typename policy> inline void CPU_fusion__execute(CPU_state_t &cpu, uint8_t fusion, const CPU_instruction_t *&instruction, uint16_t &instruction_address, uint32_t &cycles, uint32_t budget);
+template <typename policy, bool page_penalty> inline void CPU_address__index(CPU_state_t &cpu, uint16_t &address, uint8_t index);
+template <typename policy, uint8_t addressing, bool page_penalty> inline uint16_t CPU_address__fetch(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing, bool page_penalty> inline uint8_t CPU_operand__read(CPU_state_t &cpu);
+
+/* Handlers ... the addressing mode and the operation are put together by the compiler, once for every opcode, and inlined into CPU::run */
+template <typename policy> inline void CPU_operation__BRK(CPU_state_t &cpu);
+template <typename policy> inline void CPU_operation__PHP(CPU_state_t &cpu);
+template <typename policy> inline void CPU_operation__PLP(CPU_state_t &cpu);
+template <typename policy> inline void CPU_operation__PHA(CPU_state_t &cpu);
+template <typename policy> inline void CPU_operation__PLA(CPU_state_t &cpu);
+template <typename policy> inline void CPU_operation__JSR(CPU_state_t &cpu);
+template <typename policy> inline void CPU_operation__RTS(CPU_state_t &cpu);
+template <typename policy> inline void CPU_operation__RTI(CPU_state_t &cpu);
+inline void CPU_operation__JMP(CPU_state_t &cpu);
+template <typename policy> inline void CPU_operation__JMPI(CPU_state_t &cpu);
+inline void CPU_operation__TXS(CPU_state_t &cpu);
+template <uint8_t flag> inline void CPU_operation__setFlag(CPU_state_t &cpu);
+template <uint8_t flag> inline void CPU_operation__clearFlag(CPU_state_t &cpu);
+template <uint8_t CPU_state_t::*source, uint8_t CPU_state_t::*destination> inline void CPU_operation__transfer(CPU_state_t &cpu);
+template <uint8_t CPU_state_t::*target, uint8_t delta> inline void CPU_operation__incrementRegister(CPU_state_t &cpu);
+template <typename policy, uint8_t flag, bool set> inline void CPU_operation__branch(CPU_state_t &cpu);
+template <typename policy, uint8_t CPU_state_t::*target, uint8_t addressing> inline void CPU_operation__load(CPU_state_t &cpu);
+template <typename policy, uint8_t CPU_state_t::*source, uint8_t addressing, bool page_penalty = true> inline void CPU_operation__store(CPU_state_t &cpu);
+template <typename policy, uint8_t CPU_state_t::*source, uint8_t addressing> inline void CPU_operation__compare(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing> inline void CPU_operation__ORA(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing> inline void CPU_operation__AND(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing> inline void CPU_operation__EOR(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing> inline void CPU_operation__ADC(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing> inline void CPU_operation__SBC(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing> inline void CPU_operation__BIT(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing> inline void CPU_operation__ASL(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing> inline void CPU_operation__ROL(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing> inline void CPU_operation__LSR(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing> inline void CPU_operation__ROR(CPU_state_t &cpu);
+template <typename policy, uint8_t addressing, uint8_t delta> inline void CPU_operation__increment(CPU_state_t &cpu);
 
 namespace CPU
 {
 	void reset()
 	{
-		CPU_cyclesToSkip = 1;
+		CPU_state_t &cpu = CC_console->cpu;
+
+		cpu.pages = &CC_console->pages;
+		cpu.RAM = CC_console->mb.RAM;
+
+		cpu.cyclesToSkip = 1;
+
+		cpu.registerPC = (uint16_t)CPU_bus__read<CPU_fast_t>(cpu, CPU__VECTOR_RESET) | ((uint16_t)CPU_bus__read<CPU_fast_t>(cpu, CPU__VECTOR_RESET + 1) << 8); // outside of a run, so nothing is counted or watched
+		cpu.registerSP = CPU__STACK_POINTER_INITIAL_VALUE;
+		cpu.registerA = 0x00;
+		cpu.registerX = 0x00;
+		cpu.registerY = 0x00;
+
+		cpu.doingDMA = false;
+		cpu.runCycles = 0;
+		cpu.leaveRun = false;
+		cpu.operand = 0x0000;
+		cpu.idleLoopStart = 0x0000;
+		cpu.idleLoopEnd = 0x0000;
+		cpu.idleLoopRegisters = 0;
+
+		cpu.flags = CPU__FLAG_DEFAULT_HIGH | CPU__FLAG_INHIBIT;
+		CPU_flags__load(cpu);
+
+		cpu.interruptRequests = INTERRUPT_SOURCE_NONE;
+
+		cpu.cycleAccurate = CR::getCycleAccuracyRequirement();
+		cpu.busCycle = 0;
+		cpu.lateCycles = 1;
+		cpu.lateRequests = INTERRUPT_SOURCE_NONE;
+		cpu.lateNMI = false;
+		cpu.inhibitPolled = CPU__FLAG_INHIBIT;
+
+		for (uint32_t i = 0; i < CPU_BLOCK_CACHE_SIZE; ++i)
+		{ // the console may have been given another cartridge
+			CC_console->blockCache[i].key = 0;
+		}
+	}
+
+	uint32_t run(uint32_t budget)
+	{
+		CPU_state_t &cpu = CC_console->cpu;
 
-		CPU_registerPC = CPU__read_16_bits(CPU__VECTOR_RESET);
-		CPU_registerSP = CPU__STACK_POINTER_INITIAL_VALUE;
-		CPU_registerA = 0x00;
-		CPU_registerX = 0x00;
-		CPU_registerY = 0x00;
+		if (CC_console->profilerData || CC_console->tracerData || CC_console->debuggerData)
+		{
+			return (cpu.cycleAccurate ? CPU_core__run<CPU_instrumented_t<CPU_accurate_t>>(budget) : CPU_core__run<CPU_instrumented_t<CPU_fast_t>>(budget));
+		}
 
-		CPU_doingDMA = false;
+		return (cpu.cycleAccurate ? CPU_core__run<CPU_accurate_t>(budget) : CPU_core__run<CPU_fast_t>(budget));
+	}
 
-		CPU_flags = CPU__FLAG_DEFAULT_HIGH | CPU__FLAG_INHIBIT;
+	uint32_t getRunCycles()
+	{
+		CPU_state_t &cpu = CC_console->cpu;
 
-		CPU_interruptRequests = INTERRUPT_SOURCE_NONE;
+		return (cpu.runCycles);
 	}
 
-	void step()
+	void pullInterruptPin(uint8_t source)
 	{
-		if (CPU_interruptRequests != INTERRUPT_SOURCE_NONE)
-		{
-			CPU::causeInterrupt(INTERRUPT_IRQ);
+		CPU_state_t &cpu = CC_console->cpu;
+
+		if (cpu.cycleAccurate && !(cpu.interruptRequests & source) && (cpu.cyclesToSkip <= cpu.lateCycles))
+		{ // pulled after the current instruction polled
+			cpu.lateRequests |= source;
 		}
 
-		if (--CPU_cyclesToSkip)
+		cpu.interruptRequests |= source;
+	}
+
+	void releaseInterruptPin(uint8_t source)
+	{
+		CPU_state_t &cpu = CC_console->cpu;
+
+		cpu.interruptRequests &= ~source;
+	}
+
+	void causeInterrupt(uint8_t interrupt)
+	{
+		CPU_state_t &cpu = CC_console->cpu;
+
+		if ((interrupt == INTERRUPT_IRQ) && (cpu.flags & CPU__FLAG_INHIBIT))
 		{
 			return;
 		}
 
-		CPU_doingDMA = false;
+		if (interrupt == INTERRUPT_NMI)
+		{ // raised while the PPU catches up, in the middle of an instruction ... it is taken where the CPU polls for it
+			if (cpu.cycleAccurate && (cpu.cyclesToSkip <= cpu.lateCycles))
+			{ // after the current instruction polled
+				cpu.lateNMI = true;
+			}
+			else
+			{
+				cpu.interruptRequests |= CPU__REQUEST_NMI;
+			}
+
+			return;
+		}
+
+		CPU_interrupt__enter<CPU_fast_t>(cpu, interrupt);
+	}
+
+	void skipCyclesForDMA()
+	{
+		CPU_state_t &cpu = CC_console->cpu;
 
-		uint8_t opcode = MB::readMainBus(CPU_registerPC);
-		++CPU_registerPC;
+		cpu.cyclesToSkip += CPU__DMA_DURATION;
 
-		CPU_cyclesToSkip += CPU_operationDuration[opcode];
+		cpu.doingDMA = true;
+	}
 
-		if (CPU_cyclesToSkip == 1)
-		{ // invalid opcode detected
-			return;
+	void skipCyclesForDMCFetch()
+	{
+		CPU_state_t &cpu = CC_console->cpu;
+
+		if (cpu.doingDMA)
+		{
+			cpu.cyclesToSkip += 2;
 		}
+		else
+		{
+			cpu.cyclesToSkip += 4;
+		}
+	}
+}
 
-		switch (opcode)
-		{ // executing implied instructions
-			case CPU__OPCODE_IMPLIED_BRK:
-			{
-				causeInterrupt(INTERRUPT_BRK);
+/* The interpreter ... compiled once for each accuracy policy, CPU::run picks the one the cartridge needs */
+template <typename policy> inline uint32_t CPU_core__run(uint32_t budget)
+{
+	CPU_state_t &state = CC_console->cpu;
+	CPU_state_t cpu = state; // the handlers work on this copy, so the registers can be kept in host registers
+	CPU_flags__load(cpu);
 
-				break;
-			}
+	uint32_t cycles = 0;
 
-			case CPU__OPCODE_IMPLIED_PHP:
-			{
-				CPU__stack_push(CPU_flags | CPU__FLAG_BREAK);
+	/* Instructions of the block being executed ... the mapping of the cartridge can only change by leaving the run, so a block is followed until it ends or PC goes elsewhere */
+	const CPU_instruction_t *instruction = nullptr;
+	const CPU_instruction_t *blockEnd = nullptr;
+	uint16_t instructionAddress = 0;
+	CPU_instruction_t fetched;
 
-				break;
-			}
+	/* Compare mode ... instructions the interpreter still has to execute after a recompiled block, before the two can be compared */
+	uint32_t comparedInstructions = 0;
+	uint32_t comparedStart = 0;
 
-			case CPU__OPCODE_IMPLIED_CLC:
-			{
-				CPU_flags &= ~CPU__FLAG_CARRY;
+	bool profiling = policy::instrumented && CC_console->profilerData;
+	bool tracing = policy::instrumented && CC_console->tracerData;
+	bool debugging = policy::instrumented && CC_console->debuggerData;
 
-				break;
-			}
+	while (cycles < budget)
+	{
+		/* Cycles in which the CPU would only count down ... unless an interrupt is pending, the lines can only change while it executes an instruction or leaves the run */
+		bool interruptPending = CPU_interrupt__pending<policy>(cpu);
+		uint32_t idleCycles = interruptPending ? 0 : cpu.cyclesToSkip - 1u;
 
-			case CPU__OPCODE_IMPLIED_JSR:
-			{
-				CPU__stack_push((CPU_registerPC + 1) >> 8);
-				CPU__stack_push(CPU_registerPC + 1);
+		if (idleCycles >= budget - cycles)
+		{
+			cpu.cyclesToSkip -= (uint16_t)(budget - cycles);
+			cycles = budget;
 
-				CPU_registerPC = CPU__read_16_bits(CPU_registerPC);
+			break;
+		}
 
-				break;
-			}
+		cpu.cyclesToSkip -= (uint16_t)idleCycles;
+		cycles += idleCycles;
 
-			case CPU__OPCODE_IMPLIED_PLP:
-			{
-				CPU_flags = CPU__stack_pop();
+		cpu.runCycles = cycles;
 
-				break;
-			}
+		if (interruptPending)
+		{
+			CPU_interrupt__take<policy>(cpu);
+		}
 
-			case CPU__OPCODE_IMPLIED_SEC:
-			{
-				CPU_flags |= CPU__FLAG_CARRY;
+		++cycles;
 
-				break;
-			}
+		if (--cpu.cyclesToSkip)
+		{
+			continue;
+		}
 
-			case CPU__OPCODE_IMPLIED_RTI:
-			{
-				CPU_flags = CPU__stack_pop();
+		cpu.doingDMA = false;
 
-				CPU_registerPC = CPU__stack_pop();
-				CPU_registerPC |= CPU__stack_pop() << 8;
+		if (instruction == blockEnd || cpu.registerPC != instructionAddress)
+		{
+			instruction = blockEnd = nullptr;
 
-				break;
+			if ((uint16_t)(cpu.registerPC - cpu.idleLoopStart) >= (uint16_t)(cpu.idleLoopEnd - cpu.idleLoopStart))
+			{ // left the loop, by its exit or by an interrupt
+				cpu.idleLoopStart = cpu.idleLoopEnd = 0x0000;
 			}
 
-			case CPU__OPCODE_IMPLIED_PHA:
+			if (cpu.registerPC >= 0x8000)
 			{
-				CPU__stack_push(CPU_registerA);
+				CPU_block_t &block = CPU_cache__block(cpu.registerPC);
 
-				break;
-			}
+				if (!policy::cycleAccurate && !policy::instrumented && block.idleLoop && (cpu.registerPC == block.address) && CPU_idle__skip(cpu, block, budget - cycles))
+				{ // the passes that fit in the budget are counted down as if by a single instruction
+					continue;
+				}
 
-			case CPU__OPCODE_IMPLIED_JMP:
-			{
-				CPU_registerPC = CPU__read_16_bits(CPU_registerPC);
+				instruction = block.instructions;
+				blockEnd = instruction + block.length;
 
-				break;
-			}
+				if (!policy::cycleAccurate && !policy::instrumented && (CC_console->dr.mode != DR_MODE_OFF) && !comparedInstructions && !CPU_interrupt__pending<policy>(cpu))
+				{ // recompiled code does not look at the interrupt lines, so it only runs when they are ignored ... nor at the bus cycles
+					CPU_flags__store(cpu);
+					uint32_t executed = DR::execute(cpu, block, budget - cycles);
+					CPU_flags__load(cpu);
 
-			case CPU__OPCODE_IMPLIED_CLI:
-			{
-				CPU_flags &= ~CPU__FLAG_INHIBIT;
+					if (executed && (CC_console->dr.mode == DR_MODE_ON))
+					{ // the cycles are left in cyclesToSkip, to be counted down as if by the last instruction
+						instruction += executed;
+						instructionAddress = cpu.registerPC;
 
-				break;
+						continue;
+					}
+
+					comparedInstructions = executed;
+					comparedStart = cycles;
+				}
 			}
 
-			case CPU__OPCODE_IMPLIED_RTS:
-			{
-				CPU_registerPC = CPU__stack_pop();
-				CPU_registerPC |= CPU__stack_pop() << 8;
-				++CPU_registerPC;
+			if (instruction == blockEnd)
+			{ // code in RAM is not cached, it could be changed at any time
+				CPU_instruction__fetch(cpu, cpu.registerPC, fetched);
 
-				break;
+				instruction = &fetched;
+				blockEnd = instruction + 1;
 			}
 
-			case CPU__OPCODE_IMPLIED_PLA:
-			{
-				CPU_registerA = CPU__stack_pop();
+			instructionAddress = cpu.registerPC;
+		}
 
-				CPU__set_flag_zero(CPU_registerA);
-				CPU__set_flag_negative(CPU_registerA);
+		uint8_t opcode = instruction->opcode;
+		uint8_t fusion = instruction->fusion;
+		uint16_t address = instructionAddress;
 
-				break;
-			}
+		if (policy::instrumented && debugging && DB::execute(address))
+		{ // stopped before the instruction ... it starts on the first cycle of the next run
+			--cycles;
+			cpu.cyclesToSkip = 1;
 
-			case CPU__OPCODE_IMPLIED_JMPI:
-			{
-				uint16_t address = CPU__read_16_bits(CPU_registerPC);
-				uint16_t page = address & CPU__PAGE_MASK;
+			break;
+		}
 
-				CPU_registerPC = MB::readMainBus(address);
-				CPU_registerPC |= (MB::readMainBus(page | ((address + 1) & ~CPU__PAGE_MASK))) << 8;
+		instructionAddress += instruction->length;
+		cpu.registerPC = instructionAddress;
+		cpu.operand = instruction->operand;
+		cpu.cyclesToSkip += instruction->duration;
 
-				break;
-			}
+		if (policy::instrumented && tracing)
+		{
+			TR::instruction(address, opcode, CPU_flags__pack(cpu), cpu);
+		}
 
-			case CPU__OPCODE_IMPLIED_SEI:
-			{
-				CPU_flags |= CPU__FLAG_INHIBIT;
+		uint8_t inhibit = cpu.flags & CPU__FLAG_INHIBIT;
+		bool nmiDue = cpu.lateNMI;
 
-				break;
-			}
+		if (policy::cycleAccurate)
+		{ // the opcode and operand bytes take the first bus cycles
+			cpu.busCycle = instruction->length;
+			cpu.lateCycles = 1;
+			cpu.lateRequests = INTERRUPT_SOURCE_NONE;
+		}
 
-			case CPU__OPCODE_IMPLIED_DEY:
-			{
-				--CPU_registerY;
+		++instruction;
 
-				CPU__set_flag_zero(CPU_registerY);
-				CPU__set_flag_negative(CPU_registerY);
+		switch (opcode)
+		{ // compilers turn this into a single jump table ... invalid opcodes take one cycle and do nothing
+			case 0x00: CPU_operation__BRK<policy>(cpu); break;
+			case 0x01: CPU_operation__ORA<policy, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+			case 0x05: CPU_operation__ORA<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x06: CPU_operation__ASL<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x08: CPU_operation__PHP<policy>(cpu); break;
+			case 0x09: CPU_operation__ORA<policy, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0x0A: CPU_operation__ASL<policy, CPU__ADDRESSING_ACCUMULATOR>(cpu); break;
+			case 0x0D: CPU_operation__ORA<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x0E: CPU_operation__ASL<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x10: CPU_operation__branch<policy, CPU__FLAG_NEGATIVE, false>(cpu); break;
+			case 0x11: CPU_operation__ORA<policy, CPU__ADDRESSING_INDIRECT_Y>(cpu); break;
+			case 0x15: CPU_operation__ORA<policy, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0x16: CPU_operation__ASL<policy, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0x18: CPU_operation__clearFlag<CPU__FLAG_CARRY>(cpu); break;
+			case 0x19: CPU_operation__ORA<policy, CPU__ADDRESSING_ABSOLUTE_Y>(cpu); break;
+			case 0x1D: CPU_operation__ORA<policy, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0x1E: CPU_operation__ASL<policy, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0x20: CPU_operation__JSR<policy>(cpu); break;
+			case 0x21: CPU_operation__AND<policy, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+			case 0x24: CPU_operation__BIT<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x25: CPU_operation__AND<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x26: CPU_operation__ROL<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x28: CPU_operation__PLP<policy>(cpu); break;
+			case 0x29: CPU_operation__AND<policy, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0x2A: CPU_operation__ROL<policy, CPU__ADDRESSING_ACCUMULATOR>(cpu); break;
+			case 0x2C: CPU_operation__BIT<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x2D: CPU_operation__AND<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x2E: CPU_operation__ROL<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x30: CPU_operation__branch<policy, CPU__FLAG_NEGATIVE, true>(cpu); break;
+			case 0x31: CPU_operation__AND<policy, CPU__ADDRESSING_INDIRECT_Y>(cpu); break;
+			case 0x35: CPU_operation__AND<policy, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0x36: CPU_operation__ROL<policy, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0x38: CPU_operation__setFlag<CPU__FLAG_CARRY>(cpu); break;
+			case 0x39: CPU_operation__AND<policy, CPU__ADDRESSING_ABSOLUTE_Y>(cpu); break;
+			case 0x3D: CPU_operation__AND<policy, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0x3E: CPU_operation__ROL<policy, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0x40: CPU_operation__RTI<policy>(cpu); break;
+			case 0x41: CPU_operation__EOR<policy, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+			case 0x45: CPU_operation__EOR<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x46: CPU_operation__LSR<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x48: CPU_operation__PHA<policy>(cpu); break;
+			case 0x49: CPU_operation__EOR<policy, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0x4A: CPU_operation__LSR<policy, CPU__ADDRESSING_ACCUMULATOR>(cpu); break;
+			case 0x4C: CPU_operation__JMP(cpu); break;
+			case 0x4D: CPU_operation__EOR<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x4E: CPU_operation__LSR<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x50: CPU_operation__branch<policy, CPU__FLAG_OVERFLOW, false>(cpu); break;
+			case 0x51: CPU_operation__EOR<policy, CPU__ADDRESSING_INDIRECT_Y>(cpu); break;
+			case 0x55: CPU_operation__EOR<policy, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0x56: CPU_operation__LSR<policy, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0x58: CPU_operation__clearFlag<CPU__FLAG_INHIBIT>(cpu); break;
+			case 0x59: CPU_operation__EOR<policy, CPU__ADDRESSING_ABSOLUTE_Y>(cpu); break;
+			case 0x5D: CPU_operation__EOR<policy, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0x5E: CPU_operation__LSR<policy, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0x60: CPU_operation__RTS<policy>(cpu); break;
+			case 0x61: CPU_operation__ADC<policy, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+			case 0x65: CPU_operation__ADC<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x66: CPU_operation__ROR<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x68: CPU_operation__PLA<policy>(cpu); break;
+			case 0x69: CPU_operation__ADC<policy, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0x6A: CPU_operation__ROR<policy, CPU__ADDRESSING_ACCUMULATOR>(cpu); break;
+			case 0x6C: CPU_operation__JMPI<policy>(cpu); break;
+			case 0x6D: CPU_operation__ADC<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x6E: CPU_operation__ROR<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x70: CPU_operation__branch<policy, CPU__FLAG_OVERFLOW, true>(cpu); break;
+			case 0x71: CPU_operation__ADC<policy, CPU__ADDRESSING_INDIRECT_Y>(cpu); break;
+			case 0x75: CPU_operation__ADC<policy, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0x76: CPU_operation__ROR<policy, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0x78: CPU_operation__setFlag<CPU__FLAG_INHIBIT>(cpu); break;
+			case 0x79: CPU_operation__ADC<policy, CPU__ADDRESSING_ABSOLUTE_Y>(cpu); break;
+			case 0x7D: CPU_operation__ADC<policy, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0x7E: CPU_operation__ROR<policy, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0x81: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+			case 0x84: CPU_operation__store<policy, &CPU_state_t::registerY, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x85: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x86: CPU_operation__store<policy, &CPU_state_t::registerX, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0x88: CPU_operation__incrementRegister<&CPU_state_t::registerY, 0xFF>(cpu); break;
+			case 0x8A: CPU_operation__transfer<&CPU_state_t::registerX, &CPU_state_t::registerA>(cpu); break;
+			case 0x8C: CPU_operation__store<policy, &CPU_state_t::registerY, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x8D: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x8E: CPU_operation__store<policy, &CPU_state_t::registerX, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0x90: CPU_operation__branch<policy, CPU__FLAG_CARRY, false>(cpu); break;
+			case 0x91: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_INDIRECT_Y, !policy::cycleAccurate>(cpu); break;
+			case 0x94: CPU_operation__store<policy, &CPU_state_t::registerY, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0x95: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0x96: CPU_operation__store<policy, &CPU_state_t::registerX, CPU__ADDRESSING_ZEROPAGE_Y>(cpu); break;
+			case 0x98: CPU_operation__transfer<&CPU_state_t::registerY, &CPU_state_t::registerA>(cpu); break;
+			case 0x99: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE_Y, false>(cpu); break;
+			case 0x9A: CPU_operation__TXS(cpu); break;
+			case 0x9D: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE_X, false>(cpu); break;
+			case 0xA0: CPU_operation__load<policy, &CPU_state_t::registerY, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0xA1: CPU_operation__load<policy, &CPU_state_t::registerA, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+			case 0xA2: CPU_operation__load<policy, &CPU_state_t::registerX, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0xA4: CPU_operation__load<policy, &CPU_state_t::registerY, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0xA5: CPU_operation__load<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0xA6: CPU_operation__load<policy, &CPU_state_t::registerX, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0xA8: CPU_operation__transfer<&CPU_state_t::registerA, &CPU_state_t::registerY>(cpu); break;
+			case 0xA9: CPU_operation__load<policy, &CPU_state_t::registerA, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0xAA: CPU_operation__transfer<&CPU_state_t::registerA, &CPU_state_t::registerX>(cpu); break;
+			case 0xAC: CPU_operation__load<policy, &CPU_state_t::registerY, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0xAD: CPU_operation__load<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0xAE: CPU_operation__load<policy, &CPU_state_t::registerX, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0xB0: CPU_operation__branch<policy, CPU__FLAG_CARRY, true>(cpu); break;
+			case 0xB1: CPU_operation__load<policy, &CPU_state_t::registerA, CPU__ADDRESSING_INDIRECT_Y>(cpu); break;
+			case 0xB4: CPU_operation__load<policy, &CPU_state_t::registerY, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0xB5: CPU_operation__load<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0xB6: CPU_operation__load<policy, &CPU_state_t::registerX, CPU__ADDRESSING_ZEROPAGE_Y>(cpu); break;
+			case 0xB8: CPU_operation__clearFlag<CPU__FLAG_OVERFLOW>(cpu); break;
+			case 0xB9: CPU_operation__load<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE_Y>(cpu); break;
+			case 0xBA: CPU_operation__transfer<&CPU_state_t::registerSP, &CPU_state_t::registerX>(cpu); break;
+			case 0xBC: CPU_operation__load<policy, &CPU_state_t::registerY, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0xBD: CPU_operation__load<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0xBE: CPU_operation__load<policy, &CPU_state_t::registerX, CPU__ADDRESSING_ABSOLUTE_Y>(cpu); break;
+			case 0xC0: CPU_operation__compare<policy, &CPU_state_t::registerY, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0xC1: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+			case 0xC4: CPU_operation__compare<policy, &CPU_state_t::registerY, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0xC5: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0xC6: CPU_operation__increment<policy, CPU__ADDRESSING_ZEROPAGE, 0xFF>(cpu); break;
+			case 0xC8: CPU_operation__incrementRegister<&CPU_state_t::registerY, 0x01>(cpu); break;
+			case 0xC9: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0xCA: CPU_operation__incrementRegister<&CPU_state_t::registerX, 0xFF>(cpu); break;
+			case 0xCC: CPU_operation__compare<policy, &CPU_state_t::registerY, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0xCD: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0xCE: CPU_operation__increment<policy, CPU__ADDRESSING_ABSOLUTE, 0xFF>(cpu); break;
+			case 0xD0: CPU_operation__branch<policy, CPU__FLAG_ZERO, false>(cpu); break;
+			case 0xD1: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_INDIRECT_Y>(cpu); break;
+			case 0xD5: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0xD6: CPU_operation__increment<policy, CPU__ADDRESSING_ZEROPAGE_X, 0xFF>(cpu); break;
+			case 0xD8: CPU_operation__clearFlag<CPU__FLAG_DECIMAL>(cpu); break;
+			case 0xD9: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE_Y>(cpu); break;
+			case 0xDD: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0xDE: CPU_operation__increment<policy, CPU__ADDRESSING_ABSOLUTE_X, 0xFF>(cpu); break;
+			case 0xE0: CPU_operation__compare<policy, &CPU_state_t::registerX, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0xE1: CPU_operation__SBC<policy, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+			case 0xE4: CPU_operation__compare<policy, &CPU_state_t::registerX, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0xE5: CPU_operation__SBC<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+			case 0xE6: CPU_operation__increment<policy, CPU__ADDRESSING_ZEROPAGE, 0x01>(cpu); break;
+			case 0xE8: CPU_operation__incrementRegister<&CPU_state_t::registerX, 0x01>(cpu); break;
+			case 0xE9: CPU_operation__SBC<policy, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+			case 0xEA: break;
+			case 0xEB: break; // unofficial SBC, executed as a NOP
+			case 0xEC: CPU_operation__compare<policy, &CPU_state_t::registerX, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0xED: CPU_operation__SBC<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+			case 0xEE: CPU_operation__increment<policy, CPU__ADDRESSING_ABSOLUTE, 0x01>(cpu); break;
+			case 0xF0: CPU_operation__branch<policy, CPU__FLAG_ZERO, true>(cpu); break;
+			case 0xF1: CPU_operation__SBC<policy, CPU__ADDRESSING_INDIRECT_Y>(cpu); break;
+			case 0xF5: CPU_operation__SBC<policy, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+			case 0xF6: CPU_operation__increment<policy, CPU__ADDRESSING_ZEROPAGE_X, 0x01>(cpu); break;
+			case 0xF8: CPU_operation__setFlag<CPU__FLAG_DECIMAL>(cpu); break;
+			case 0xF9: CPU_operation__SBC<policy, CPU__ADDRESSING_ABSOLUTE_Y>(cpu); break;
+			case 0xFD: CPU_operation__SBC<policy, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			case 0xFE: CPU_operation__increment<policy, CPU__ADDRESSING_ABSOLUTE_X, 0x01>(cpu); break;
+			default: break;
+		}
 
-				break;
-			}
+		if (policy::instrumented && profiling)
+		{ // before a late NMI is taken, which is not part of the instruction
+			PF::instruction(address, opcode, cpu);
+		}
 
-			case CPU__OPCODE_IMPLIED_TXA:
-			{
-				CPU_registerA = CPU_registerX;
+		if (policy::cycleAccurate)
+		{
+			CPU_interrupt__poll<policy>(cpu, opcode, inhibit, nmiDue);
+		}
 
-				CPU__set_flag_zero(CPU_registerA);
-				CPU__set_flag_negative(CPU_registerA);
+		if (!policy::cycleAccurate && !policy::instrumented && (fusion != CPU__FUSION_NONE) && !comparedInstructions)
+		{ // the rest of the idiom is executed here instead of going around the loop for each instruction
+			CPU_fusion__execute<policy>(cpu, fusion, instruction, instructionAddress, cycles, budget);
+		}
 
-				break;
-			}
+		if (comparedInstructions && !--comparedInstructions)
+		{
+			CPU_flags__store(cpu);
+			DR::verify(cpu, cycles - comparedStart + cpu.cyclesToSkip);
+		}
 
-			case CPU__OPCODE_IMPLIED_TYA:
-			{
-				CPU_registerA = CPU_registerY;
+		if (cpu.leaveRun)
+		{ // the other units were accessed and may have new events scheduled
+			cpu.leaveRun = false;
 
-				CPU__set_flag_zero(CPU_registerA);
-				CPU__set_flag_negative(CPU_registerA);
+			break;
+		}
+	}
 
-				break;
-			}
+	CPU_flags__store(cpu);
 
-			case CPU__OPCODE_IMPLIED_TXS:
-			{
-				CPU_registerSP = CPU_registerX;
+	if (comparedInstructions)
+	{ // left before the interpreter caught up ... the difference is reported
+		DR::verify(cpu, cycles - comparedStart + cpu.cyclesToSkip);
+	}
 
-				break;
-			}
+	state = cpu;
 
-			case CPU__OPCODE_IMPLIED_TAY:
-			{
-				CPU_registerY = CPU_registerA;
+	return (cycles);
+}
 
-				CPU__set_flag_zero(CPU_registerY);
-				CPU__set_flag_negative(CPU_registerY);
+/* Only the other units can change the CPU state behind its back (NMI, DMA, DMC fetches, IRQ lines) ... and only while the CPU accesses them, so the state is handed over around those accesses */
+template <typename policy> inline uint8_t CPU_bus__read(CPU_state_t &cpu, uint16_t address)
+{
+	if (policy::cycleAccurate)
+	{
+		++cpu.busCycle;
+	}
 
-				break;
-			}
+	if (policy::instrumented && CC_console->debuggerData)
+	{
+		DB::read(cpu, address);
+	}
 
-			case CPU__OPCODE_IMPLIED_TAX:
-			{
-				CPU_registerX = CPU_registerA;
+	const uint8_t *page = cpu.pages->read[address >> 8];
+	if (page)
+	{ // RAM and mapped ROM
+		return (page[address & 0xFF]);
+	}
 
-				CPU__set_flag_zero(CPU_registerX);
-				CPU__set_flag_negative(CPU_registerX);
+	if (address < 0x2000 || address >= 0x5000)
+	{ // RAM and cartridge
+		return (MB::readMainBus(address));
+	}
 
-				break;
-			}
+	CPU_state_t &state = CC_console->cpu;
 
-			case CPU__OPCODE_IMPLIED_CLV:
-			{
-				CPU_flags &= ~CPU__FLAG_OVERFLOW;
+	state = cpu;
 
-				break;
-			}
+	if (policy::cycleAccurate)
+	{
+		CPU_access__begin(state);
+	}
 
-			case CPU__OPCODE_IMPLIED_TSX:
-			{
-				CPU_registerX = CPU_registerSP;
+	uint8_t data = MB::readMainBus(address);
+	cpu = state;
 
-				CPU__set_flag_zero(CPU_registerX);
-				CPU__set_flag_negative(CPU_registerX);
+	if (policy::cycleAccurate)
+	{
+		CPU_access__end(cpu);
+	}
 
-				break;
-			}
+	cpu.leaveRun = true;
 
-			case CPU__OPCODE_IMPLIED_INY:
-			{
-				++CPU_registerY;
+	return (data);
+}
 
-				CPU__set_flag_zero(CPU_registerY);
-				CPU__set_flag_negative(CPU_registerY);
+template <typename policy> inline void CPU_bus__write(CPU_state_t &cpu, uint16_t address, uint8_t data)
+{
+	if (policy::cycleAccurate)
+	{
+		++cpu.busCycle;
+	}
 
-				break;
-			}
+	if (policy::instrumented && CC_console->debuggerData)
+	{
+		DB::write(cpu, address, data);
+	}
 
-			case CPU__OPCODE_IMPLIED_DEX:
-			{
-				--CPU_registerX;
+	uint8_t *page = cpu.pages->write[address >> 8];
+	if (page)
+	{
+		page[address & 0xFF] = data;
 
-				CPU__set_flag_zero(CPU_registerX);
-				CPU__set_flag_negative(CPU_registerX);
+		return;
+	}
 
-				break;
-			}
+	if (address < 0x2000)
+	{ // writes to the cartridge can switch banks, so only RAM is safe
+		MB::writeMainBus(address, data);
 
-			case CPU__OPCODE_IMPLIED_CLD:
-			{
-				CPU_flags &= ~CPU__FLAG_DECIMAL;
+		return;
+	}
 
-				break;
-			}
+	CPU_state_t &state = CC_console->cpu;
 
-			case CPU__OPCODE_IMPLIED_INX:
-			{
-				++CPU_registerX;
+	state = cpu;
 
-				CPU__set_flag_zero(CPU_registerX);
-				CPU__set_flag_negative(CPU_registerX);
+	if (policy::cycleAccurate)
+	{
+		CPU_access__begin(state);
+	}
 
-				break;
-			}
+	MB::writeMainBus(address, data);
+	cpu = state;
 
-			case CPU__OPCODE_IMPLIED_NOP:
-			{
-				break;
-			}
+	if (policy::cycleAccurate)
+	{
+		CPU_access__end(cpu);
+	}
 
-			case CPU__OPCODE_IMPLIED_SED:
-			{
-				CPU_flags |= CPU__FLAG_DECIMAL;
+	cpu.leaveRun = true;
+}
 
-				break;
-			}
+/* Read-modify-write instructions write the value back unchanged before the result ... not to the cartridge: the mappers here would take both writes, while the MMC1 ignores the second */
+template <typename policy> inline void CPU_bus__writeBack(CPU_state_t &cpu, uint16_t address, uint8_t data)
+{
+	if (!policy::cycleAccurate)
+	{
+		return;
+	}
 
-			default:
-			{
-				if ((opcode & CPU__BRANCK_MASK) == CPU__INSTRUCTION_TYPE_BRANCH)
-				{ // executing branch instructions
-					bool willBranch = (opcode & CPU__BRANCH_CONDITION_BIT) ? true : false;
-
-					switch (opcode & CPU__BRANCH_CONDITION_MASK)
-					{ // using EQU operation
-						case CPU__BRANCH_FLAG_NEGATIVE:
-						{
-							willBranch = !(willBranch ^ ((CPU_flags & CPU__FLAG_NEGATIVE) ? true : false));
-							break;
-						}
-
-						case CPU__BRANCH_FLAG_OVERFLOW:
-						{
-							willBranch = !(willBranch ^ ((CPU_flags & CPU__FLAG_OVERFLOW) ? true : false));
-							break;
-						}
-
-						case CPU__BRANCH_FLAG_CARRY:
-						{
-							willBranch = !(willBranch ^ ((CPU_flags & CPU__FLAG_CARRY) ? true : false));
-							break;
-						}
-
-						case CPU__BRANCH_FLAG_ZERO:
-						{
-							willBranch = !(willBranch ^ ((CPU_flags & CPU__FLAG_ZERO) ? true : false));
-							break;
-						}
-					}
+	if (address < 0x8000)
+	{
+		CPU_bus__write<policy>(cpu, address, data);
+	}
+	else
+	{
+		++cpu.busCycle;
+	}
+}
 
-					if (willBranch)
-					{
-						CPU_cyclesToSkip += 1;
+/* Zero page addressing can only reach the internal RAM, so it skips the page table ... the other modes go through the bus, and all of them do in the instrumented core, for DB */
+template <typename policy, uint8_t addressing> inline uint8_t CPU_memory__read(CPU_state_t &cpu, uint16_t address)
+{
+	if (!policy::instrumented && (addressing == CPU__ADDRESSING_ZEROPAGE || addressing == CPU__ADDRESSING_ZEROPAGE_X || addressing == CPU__ADDRESSING_ZEROPAGE_Y))
+	{
+		if (policy::cycleAccurate)
+		{
+			++cpu.busCycle;
+		}
 
-						int8_t offset = MB::readMainBus(CPU_registerPC);
-						++CPU_registerPC;
+		return (cpu.RAM[address]);
+	}
 
-						uint16_t newPC = CPU_registerPC + offset;
+	return (CPU_bus__read<policy>(cpu, address));
+}
 
-						if ((CPU_registerPC & CPU__PAGE_MASK) != (newPC & CPU__PAGE_MASK))
-						{ // page crossed when updating PC
-							CPU_cyclesToSkip += 2;
-						}
+template <typename policy, uint8_t addressing> inline void CPU_memory__write(CPU_state_t &cpu, uint16_t address, uint8_t data)
+{
+	if (!policy::instrumented && (addressing == CPU__ADDRESSING_ZEROPAGE || addressing == CPU__ADDRESSING_ZEROPAGE_X || addressing == CPU__ADDRESSING_ZEROPAGE_Y))
+	{
+		if (policy::cycleAccurate)
+		{
+			++cpu.busCycle;
+		}
 
-						CPU_registerPC = newPC;
-					}
-					else
-					{
-						++CPU_registerPC;
-					}
-				}
-				else
-				{
-					if ((opcode & CPU__INSTRUCTION_TYPE_MASK) == CPU__INSTRUCTION_TYPE_0)
-					{
-						uint16_t address = 0;
+		cpu.RAM[address] = data;
 
-						switch (opcode & CPU__ADDRESSING_MODE_MASK)
-						{
-							case CPU__ADDRESSING_TYPE_0_IMMEDIATE:
-							{
-								address = CPU_registerPC;
-								CPU_registerPC += 1;
+		return;
+	}
 
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_0_ZEROPAGE:
-							{
-								address = MB::readMainBus(CPU_registerPC);
-								CPU_registerPC += 1;
-
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_0_ABSOLUTE:
-							{
-								address = CPU__read_16_bits(CPU_registerPC);
-								CPU_registerPC += 2;
-
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_0_ZEROPAGE_X:
-							{
-								address = (MB::readMainBus(CPU_registerPC) + CPU_registerX) & ~CPU__PAGE_MASK;
-								CPU_registerPC += 1;
-
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_0_ABSOLUTE_X:
-							{
-								address = CPU__read_16_bits(CPU_registerPC);
-								CPU_registerPC += 2;
-
-								if ((address & CPU__PAGE_MASK) != ((address + CPU_registerX) & CPU__PAGE_MASK))
-								{
-									CPU_cyclesToSkip += 1;
-								}
-
-								address += CPU_registerX;
-
-								break;
-							}
-						}
-
-						switch (opcode & CPU__OPERATION_MASK)
-						{
-							case CPU__OPERATION_TYPE_0_BIT:
-							{
-								uint8_t operand = MB::readMainBus(address);
-
-								CPU_flags &= ~0xC0;
-								CPU_flags |= operand & 0xC0;
-
-								CPU__set_flag_zero(CPU_registerA & operand);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_0_STY:
-							{
-								MB::writeMainBus(address, CPU_registerY);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_0_LDY:
-							{
-								CPU_registerY = MB::readMainBus(address);
-
-								CPU__set_flag_zero(CPU_registerY);
-								CPU__set_flag_negative(CPU_registerY);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_0_CPY:
-							{
-								uint16_t difference = CPU_registerY - MB::readMainBus(address);
-
-								if (difference & 0x0100)
-								{
-									CPU_flags &= ~CPU__FLAG_CARRY;
-								}
-								else
-								{
-									CPU_flags |= CPU__FLAG_CARRY;
-								}
-
-								CPU__set_flag_zero(difference);
-								CPU__set_flag_negative(difference);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_0_CPX:
-							{
-								uint16_t difference = CPU_registerX - MB::readMainBus(address);
-
-								if (difference & 0x0100)
-								{
-									CPU_flags &= ~CPU__FLAG_CARRY;
-								}
-								else
-								{
-									CPU_flags |= CPU__FLAG_CARRY;
-								}
+	CPU_bus__write<policy>(cpu, address, data);
+}
 
-								CPU__set_flag_zero(difference);
-								CPU__set_flag_negative(difference);
-
-								break;
-							}
-						}
-					}
-					else if ((opcode & CPU__INSTRUCTION_TYPE_MASK) == CPU__INSTRUCTION_TYPE_1)
-					{
-						uint16_t address = 0;
-
-						switch (opcode & CPU__ADDRESSING_MODE_MASK)
-						{
-							case CPU__ADDRESSING_TYPE_1_INDIRECT_X:
-							{
-								uint8_t baseAddress = MB::readMainBus(CPU_registerPC) + CPU_registerX; // uint8 because it is read from page 0
-								CPU_registerPC += 1;
+/* Pointer of the indirect modes, from page 0 ... its high byte wraps around to $00 instead of crossing to page 1 */
+template <typename policy> inline uint16_t CPU_memory__readPointer(CPU_state_t &cpu, uint8_t address)
+{
+	if (policy::instrumented)
+	{
+		return (CPU_bus__read<policy>(cpu, address) | ((uint16_t)CPU_bus__read<policy>(cpu, (uint8_t)(address + 1)) << 8));
+	}
+
+	if (policy::cycleAccurate)
+	{
+		cpu.busCycle += 2;
+	}
+
+	return (cpu.RAM[address] | ((uint16_t)cpu.RAM[(uint8_t)(address + 1)] << 8));
+}
+
+/* Page 1 is always RAM, nothing is mapped over it */
+template <typename policy> inline void CPU_stack__push(CPU_state_t &cpu, uint8_t data)
+{
+	uint16_t address = 0x0100 | cpu.registerSP--;
+
+	if (policy::instrumented && CC_console->debuggerData)
+	{
+		DB::write(cpu, address, data);
+	}
 
-								address = MB::readMainBus(baseAddress) | ((uint16_t)MB::readMainBus((baseAddress + 1) & ~CPU__PAGE_MASK) << 8);
-
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_1_ZEROPAGE:
-							{
-								address = MB::readMainBus(CPU_registerPC);
-								CPU_registerPC += 1;
+	cpu.RAM[address] = data;
+}
 
-								break;
-							}
+template <typename policy> inline uint8_t CPU_stack__pop(CPU_state_t &cpu)
+{
+	uint16_t address = 0x0100 | ++cpu.registerSP;
 
-							case CPU__ADDRESSING_TYPE_1_IMMEDIATE:
-							{
-								address = CPU_registerPC;
-								CPU_registerPC += 1;
+	if (policy::instrumented && CC_console->debuggerData)
+	{
+		DB::read(cpu, address);
+	}
 
-								break;
-							}
+	return (cpu.RAM[address]);
+}
 
-							case CPU__ADDRESSING_TYPE_1_ABSOLUTE:
-							{
-								address = CPU__read_16_bits(CPU_registerPC);
-								CPU_registerPC += 2;
+/* Moves the handed over state to the cycle of the access ... the instruction was started on its first cycle, so the other units are brought up to the one before the access and the cycle itself is counted down */
+inline void CPU_access__begin(CPU_state_t &state)
+{
+	uint32_t cycle = state.busCycle - 1u;
 
-								break;
-							}
+	state.runCycles += cycle;
+	state.cyclesToSkip -= (uint16_t)(cycle - 1u);
 
-							case CPU__ADDRESSING_TYPE_1_INDIRECT_Y:
-							{
-								uint8_t baseAddress = MB::readMainBus(CPU_registerPC);
-								CPU_registerPC += 1;
-
-								address = MB::readMainBus(baseAddress) | ((uint16_t)MB::readMainBus((baseAddress + 1) & ~CPU__PAGE_MASK) << 8);
-
-								if ((address & CPU__PAGE_MASK) != ((address + CPU_registerY) & CPU__PAGE_MASK))
-								{
-									CPU_cyclesToSkip += 1;
-								}
-
-								address += CPU_registerY;
-
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_1_ZEROPAGE_X:
-							{
-								address = (MB::readMainBus(CPU_registerPC) + CPU_registerX) & ~CPU__PAGE_MASK;
-								CPU_registerPC += 1;
-
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_1_ABSOLUTE_Y:
-							{
-								address = CPU__read_16_bits(CPU_registerPC);
-								CPU_registerPC += 2;
-
-								if ((opcode & CPU__OPERATION_MASK) != CPU__OPERATION_TYPE_1_STA)
-								{
-									if ((address & CPU__PAGE_MASK) != ((address + CPU_registerY) & CPU__PAGE_MASK))
-									{
-										CPU_cyclesToSkip += 1;
-									}
-								}
-
-								address += CPU_registerY;
-
-								break;
-							}
+	MC::synchronize();
 
-							case CPU__ADDRESSING_TYPE_1_ABSOLUTE_X:
-							{
-								address = CPU__read_16_bits(CPU_registerPC);
-								CPU_registerPC += 2;
-
-								if ((opcode & CPU__OPERATION_MASK) != CPU__OPERATION_TYPE_1_STA)
-								{
-									if ((address & CPU__PAGE_MASK) != ((address + CPU_registerX) & CPU__PAGE_MASK))
-									{
-										CPU_cyclesToSkip += 1;
-									}
-								}
-
-								address += CPU_registerX;
-
-								break;
-							}
-						}
-
-						switch (opcode & CPU__OPERATION_MASK)
-						{
-							case CPU__OPERATION_TYPE_1_ORA:
-							{
-								CPU_registerA |= MB::readMainBus(address);
-
-								CPU__set_flag_zero(CPU_registerA);
-								CPU__set_flag_negative(CPU_registerA);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_1_AND:
-							{
-								CPU_registerA &= MB::readMainBus(address);
-
-								CPU__set_flag_zero(CPU_registerA);
-								CPU__set_flag_negative(CPU_registerA);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_1_EOR:
-							{
-								CPU_registerA ^= MB::readMainBus(address);
-
-								CPU__set_flag_zero(CPU_registerA);
-								CPU__set_flag_negative(CPU_registerA);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_1_ADC:
-							{
-								uint8_t parameter = MB::readMainBus(address);
-								uint16_t sum = CPU_registerA + parameter + ((CPU_flags & CPU__FLAG_CARRY) ? 1 : 0);
-
-								if (sum & 0x0100)
-								{
-									CPU_flags |= CPU__FLAG_CARRY;
-								}
-								else
-								{
-									CPU_flags &= ~CPU__FLAG_CARRY;
-								}
-
-								if ((CPU_registerA ^ sum) & (parameter ^ sum) & 0x80)
-								{
-									CPU_flags |= CPU__FLAG_OVERFLOW;
-								}
-								else
-								{
-									CPU_flags &= ~CPU__FLAG_OVERFLOW;
-								}
-
-								CPU_registerA = (uint8_t)sum;
-
-								CPU__set_flag_zero(CPU_registerA);
-								CPU__set_flag_negative(CPU_registerA);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_1_STA:
-							{
-								MB::writeMainBus(address, CPU_registerA);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_1_LDA:
-							{
-								CPU_registerA = MB::readMainBus(address);
-
-								CPU__set_flag_zero(CPU_registerA);
-								CPU__set_flag_negative(CPU_registerA);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_1_CMP:
-							{
-								uint16_t difference = CPU_registerA - MB::readMainBus(address);
-
-								if (difference & 0x0100)
-								{
-									CPU_flags &= ~CPU__FLAG_CARRY;
-								}
-								else
-								{
-									CPU_flags |= CPU__FLAG_CARRY;
-								}
-
-								CPU__set_flag_zero(difference);
-								CPU__set_flag_negative(difference);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_1_SBC:
-							{
-								uint16_t parameter = MB::readMainBus(address);
-								uint16_t difference = CPU_registerA - parameter - ((CPU_flags & CPU__FLAG_CARRY) ? 0 : 1);
-
-								if (difference & 0x0100)
-								{
-									CPU_flags &= ~CPU__FLAG_CARRY;
-								}
-								else
-								{
-									CPU_flags |= CPU__FLAG_CARRY;
-								}
-
-								if ((CPU_registerA ^ difference) & (~parameter ^ difference) & 0x80)
-								{
-									CPU_flags |= CPU__FLAG_OVERFLOW;
-								}
-								else
-								{
-									CPU_flags &= ~CPU__FLAG_OVERFLOW;
-								}
-
-								CPU_registerA = (uint8_t)difference;
-
-								CPU__set_flag_zero(CPU_registerA);
-								CPU__set_flag_negative(CPU_registerA);
-
-								break;
-							}
-						}
-					}
-					else if ((opcode & CPU__INSTRUCTION_TYPE_MASK) == CPU__INSTRUCTION_TYPE_2)
-					{
-						uint16_t address = 0;
-
-						switch (opcode & CPU__ADDRESSING_MODE_MASK)
-						{
-							case CPU__ADDRESSING_TYPE_2_IMMEDIATE:
-							{
-								address = CPU_registerPC;
-								CPU_registerPC += 1;
-
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_2_ZEROPAGE:
-							{
-								address = MB::readMainBus(CPU_registerPC);
-								CPU_registerPC += 1;
-
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_2_ACCUMULATOR:
-							{
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_2_ABSOLUTE:
-							{
-								address = CPU__read_16_bits(CPU_registerPC);
-								CPU_registerPC += 2;
-
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_2_ZEROPAGE_XY:
-							{
-								address = MB::readMainBus(CPU_registerPC);
-								CPU_registerPC += 1;
-
-								uint8_t index = (((opcode & CPU__OPERATION_MASK) == CPU__OPERATION_TYPE_2_LDX) || ((opcode & CPU__OPERATION_MASK) == CPU__OPERATION_TYPE_2_STX)) ? CPU_registerY : CPU_registerX;
-
-								address += index;
-								address &= ~CPU__PAGE_MASK;
-
-								break;
-							}
-
-							case CPU__ADDRESSING_TYPE_2_ABSOLUTE_XY:
-							{
-								address = CPU__read_16_bits(CPU_registerPC);
-								CPU_registerPC += 2;
-
-								uint8_t index = (((opcode & CPU__OPERATION_MASK) == CPU__OPERATION_TYPE_2_LDX) || ((opcode & CPU__OPERATION_MASK) == CPU__OPERATION_TYPE_2_STX)) ? CPU_registerY : CPU_registerX;
-
-								if ((address & CPU__PAGE_MASK) != ((address + index) & CPU__PAGE_MASK))
-								{
-									CPU_cyclesToSkip += 1;
-								}
-
-								address += index;
-
-								break;
-							}
-						}
-
-						switch (opcode & CPU__OPERATION_MASK)
-						{
-							case CPU__OPERATION_TYPE_2_ASL:
-							{
-								uint8_t parameter = ((opcode & CPU__ADDRESSING_MODE_MASK) == CPU__ADDRESSING_TYPE_2_ACCUMULATOR) ? CPU_registerA : MB::readMainBus(address);
-
-								if (parameter & 0x80)
-								{
-									CPU_flags |= CPU__FLAG_CARRY;
-								}
-								else
-								{
-									CPU_flags &= ~CPU__FLAG_CARRY;
-								}
-
-								parameter <<= 1;
-
-								CPU__set_flag_zero(parameter);
-								CPU__set_flag_negative(parameter);
-
-								if ((opcode & CPU__ADDRESSING_MODE_MASK) == CPU__ADDRESSING_TYPE_2_ACCUMULATOR)
-								{
-									CPU_registerA = parameter;
-								}
-								else
-								{
-									MB::writeMainBus(address, parameter);
-								}
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_2_ROL:
-							{
-								uint8_t parameter = ((opcode & CPU__ADDRESSING_MODE_MASK) == CPU__ADDRESSING_TYPE_2_ACCUMULATOR) ? CPU_registerA : MB::readMainBus(address);
-
-								uint8_t oldCarry = CPU_flags & CPU__FLAG_CARRY;
-
-								if (parameter & 0x80)
-								{
-									CPU_flags |= CPU__FLAG_CARRY;
-								}
-								else
-								{
-									CPU_flags &= ~CPU__FLAG_CARRY;
-								}
-
-								parameter <<= 1;
-
-								if (oldCarry)
-								{
-									parameter |= 0x01;
-								}
-
-								CPU__set_flag_zero(parameter);
-								CPU__set_flag_negative(parameter);
-
-								if ((opcode & CPU__ADDRESSING_MODE_MASK) == CPU__ADDRESSING_TYPE_2_ACCUMULATOR)
-								{
-									CPU_registerA = parameter;
-								}
-								else
-								{
-									MB::writeMainBus(address, parameter);
-								}
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_2_LSR:
-							{
-								uint8_t parameter = ((opcode & CPU__ADDRESSING_MODE_MASK) == CPU__ADDRESSING_TYPE_2_ACCUMULATOR) ? CPU_registerA : MB::readMainBus(address);
-
-								if (parameter & 0x01)
-								{
-									CPU_flags |= CPU__FLAG_CARRY;
-								}
-								else
-								{
-									CPU_flags &= ~CPU__FLAG_CARRY;
-								}
-
-								parameter >>= 1;
-
-								CPU__set_flag_zero(parameter);
-
-								if ((opcode & CPU__ADDRESSING_MODE_MASK) == CPU__ADDRESSING_TYPE_2_ACCUMULATOR)
-								{
-									CPU_registerA = parameter;
-								}
-								else
-								{
-									MB::writeMainBus(address, parameter);
-								}
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_2_ROR:
-							{
-								uint8_t parameter = ((opcode & CPU__ADDRESSING_MODE_MASK) == CPU__ADDRESSING_TYPE_2_ACCUMULATOR) ? CPU_registerA : MB::readMainBus(address);
-
-								uint8_t oldCarry = CPU_flags & CPU__FLAG_CARRY;
-
-								if (parameter & 0x01)
-								{
-									CPU_flags |= CPU__FLAG_CARRY;
-								}
-								else
-								{
-									CPU_flags &= ~CPU__FLAG_CARRY;
-								}
-
-								parameter >>= 1;
-
-								if (oldCarry)
-								{
-									parameter |= 0x80;
-								}
-
-								CPU__set_flag_zero(parameter);
-								CPU__set_flag_negative(parameter);
-
-								if ((opcode & CPU__ADDRESSING_MODE_MASK) == CPU__ADDRESSING_TYPE_2_ACCUMULATOR)
-								{
-									CPU_registerA = parameter;
-								}
-								else
-								{
-									MB::writeMainBus(address, parameter);
-								}
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_2_STX:
-							{
-								MB::writeMainBus(address, CPU_registerX);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_2_LDX:
-							{
-								CPU_registerX = MB::readMainBus(address);
-
-								CPU__set_flag_zero(CPU_registerX);
-								CPU__set_flag_negative(CPU_registerX);
-
-								break;
-							}
-
-							case CPU__OPERATION_TYPE_2_DEC:
-							{
-								uint8_t parameter = MB::readMainBus(address);
-								--parameter;
-
-								CPU__set_flag_zero(parameter);
-								CPU__set_flag_negative(parameter);
-
-								MB::writeMainBus(address, parameter);
-
-								break;
-							}
+	--state.cyclesToSkip;
+}
 
-							case CPU__OPERATION_TYPE_2_INC:
-							{
-								uint8_t parameter = MB::readMainBus(address);
-								++parameter;
-
-								CPU__set_flag_zero(parameter);
-								CPU__set_flag_negative(parameter);
+/* Back to the first cycle of the instruction, keeping whatever the access added (DMA) */
+inline void CPU_access__end(CPU_state_t &cpu)
+{
+	uint32_t cycle = cpu.busCycle - 1u;
 
-								MB::writeMainBus(address, parameter);
-
-								break;
-							}
-						}
-					}
-				}
-			}
-		}
+	cpu.runCycles -= cycle;
+	cpu.cyclesToSkip += (uint16_t)cycle;
+}
+
+/* An NMI is always taken, an IRQ when the line is low and the inhibit flag clear ... the accurate core looks at both as they were when the last instruction polled them */
+template <typename policy> inline bool CPU_interrupt__pending(const CPU_state_t &cpu)
+{
+	uint8_t requests = policy::cycleAccurate ? (uint8_t)(cpu.interruptRequests & ~cpu.lateRequests) : cpu.interruptRequests;
+
+	if (requests == INTERRUPT_SOURCE_NONE)
+	{ // nearly always
+		return (false);
 	}
 
-	void pullInterruptPin(uint8_t source)
+	if (requests & CPU__REQUEST_NMI)
 	{
-		CPU_interruptRequests |= source;
+		return (true);
 	}
 
-	void releaseInterruptPin(uint8_t source)
+	return (policy::cycleAccurate ? !cpu.inhibitPolled : !(cpu.flags & CPU__FLAG_INHIBIT));
+}
+
+/* Between two instructions ... the NMI first, its handler is entered with the inhibit flag set */
+template <typename policy> inline void CPU_interrupt__take(CPU_state_t &cpu)
+{
+	uint8_t interrupt = (cpu.interruptRequests & CPU__REQUEST_NMI) ? INTERRUPT_NMI : INTERRUPT_IRQ;
+
+	cpu.interruptRequests &= ~CPU__REQUEST_NMI;
+
+	CPU_interrupt__enter<policy>(cpu, interrupt);
+}
+
+template <typename policy> inline void CPU_interrupt__enter(CPU_state_t &cpu, uint8_t interrupt)
+{
+	if (CC_console->tracerData && (interrupt != INTERRUPT_BRK))
+	{ // BRK is traced as an instruction
+		TR::interrupt(interrupt, CPU_flags__pack(cpu), cpu);
+	}
+
+	if (interrupt == INTERRUPT_BRK)
 	{
-		CPU_interruptRequests &= ~source;
+		++cpu.registerPC;
+		cpu.flags |= CPU__FLAG_BREAK;
+	}
+	else
+	{
+		cpu.flags &= ~CPU__FLAG_BREAK;
 	}
 
-	void causeInterrupt(uint8_t interrupt)
+	CPU__stack_push(cpu.registerPC >> 8);
+	CPU__stack_push(cpu.registerPC);
+	CPU__stack_push(CPU_flags__pack(cpu));
+
+	cpu.flags |= CPU__FLAG_INHIBIT;
+	cpu.inhibitPolled = CPU__FLAG_INHIBIT;
+
+	switch (interrupt)
 	{
-		if ((CPU_flags & CPU__FLAG_INHIBIT) && (interrupt == INTERRUPT_IRQ))
+		case INTERRUPT_IRQ:
+		case INTERRUPT_BRK:
 		{
-			return;
-		}
+			cpu.registerPC = CPU__read_16_bits(CPU__VECTOR_IRQ);
 
-		if (interrupt == INTERRUPT_BRK)
-		{
-			++CPU_registerPC;
-			CPU_flags |= CPU__FLAG_BREAK;
+			break;
 		}
-		else
+
+		case INTERRUPT_NMI:
 		{
-			CPU_flags &= ~CPU__FLAG_BREAK;
+			cpu.registerPC = CPU__read_16_bits(CPU__VECTOR_NMI);
+
+			break;
 		}
+	}
 
-		CPU__stack_push(CPU_registerPC >> 8);
-		CPU__stack_push(CPU_registerPC);
-		CPU__stack_push(CPU_flags);
+	cpu.cyclesToSkip += 7;
 
-		CPU_flags |= CPU__FLAG_INHIBIT;
+	if (CC_console->profilerData)
+	{
+		PF::interrupt(interrupt, cpu);
+	}
+}
 
-		switch (interrupt)
-		{
-			case INTERRUPT_IRQ:
-			case INTERRUPT_BRK:
-			{
-				CPU_registerPC = CPU__read_16_bits(CPU__VECTOR_IRQ);
+/* The 6502 polls the interrupts before the last cycle of an instruction ... so CLI, SEI and PLP are polled with the inhibit flag they found, and an NMI raised too late is taken after the next instruction */
+template <typename policy> inline void CPU_interrupt__poll(CPU_state_t &cpu, uint8_t opcode, uint8_t inhibit, bool nmi_due)
+{
+	cpu.inhibitPolled = (opcode == 0x58 || opcode == 0x78 || opcode == 0x28) ? inhibit : (uint8_t)(cpu.flags & CPU__FLAG_INHIBIT);
 
-				break;
-			}
+	if (nmi_due)
+	{
+		cpu.lateNMI = false;
 
-			case INTERRUPT_NMI:
-			{
-				CPU_registerPC = CPU__read_16_bits(CPU__VECTOR_NMI);
+		CPU_interrupt__enter<policy>(cpu, INTERRUPT_NMI);
+	}
+}
 
-				break;
-			}
-		}
+/* P register as the stack and the other units see it */
+inline uint8_t CPU_flags__pack(const CPU_state_t &cpu)
+{
+	uint8_t flags = cpu.flags & ~(CPU__FLAG_NEGATIVE | CPU__FLAG_OVERFLOW | CPU__FLAG_ZERO | CPU__FLAG_CARRY);
 
-		CPU_cyclesToSkip += 7;
-	}
+	flags |= (cpu.resultNZ & 0x0180) ? CPU__FLAG_NEGATIVE : 0;
+	flags |= (cpu.resultNZ & 0x00FF) ? 0 : CPU__FLAG_ZERO;
+	flags |= cpu.overflow | cpu.carry;
 
-	void skipCyclesForDMA()
+	return (flags);
+}
+
+inline void CPU_flags__store(CPU_state_t &cpu)
+{
+	cpu.flags = CPU_flags__pack(cpu);
+}
+
+/* The reverse of CPU_flags__pack, after the P register was replaced */
+inline void CPU_flags__load(CPU_state_t &cpu)
+{
+	cpu.resultNZ = ((cpu.flags & CPU__FLAG_ZERO) ? 0x0000 : 0x0001) | ((cpu.flags & CPU__FLAG_NEGATIVE) ? 0x0100 : 0x0000);
+	cpu.carry = cpu.flags & CPU__FLAG_CARRY;
+	cpu.overflow = cpu.flags & CPU__FLAG_OVERFLOW;
+}
+
+/* Reads an instruction through the bus, as it was always done before the cache ... the bus cycles of the accurate core are counted from after it, and DB sees it as an execution, not as reads */
+inline void CPU_instruction__fetch(CPU_state_t &cpu, uint16_t address, CPU_instruction_t &instruction)
+{
+	instruction.opcode = CPU_bus__read<CPU_fast_t>(cpu, address);
+	instruction.length = CPU_operationLength[instruction.opcode];
+	instruction.duration = CPU_operationDuration[instruction.opcode];
+	instruction.fusion = CPU__FUSION_NONE;
+	instruction.operand = 0x0000;
+
+	if (instruction.length > 1)
 	{
-		CPU_cyclesToSkip += CPU__DMA_DURATION;
+		instruction.operand = CPU_bus__read<CPU_fast_t>(cpu, (uint16_t)(address + 1));
+	}
 
-		CPU_doingDMA = true;
+	if (instruction.length > 2)
+	{
+		instruction.operand |= (uint16_t)CPU_bus__read<CPU_fast_t>(cpu, (uint16_t)(address + 2)) << 8;
 	}
+}
 
-	void skipCyclesForDMCFetch()
+/* Jumps, calls, returns, branches and BRK ... what follows them may never be executed */
+inline bool CPU_instruction__endsBlock(uint8_t opcode)
+{
+	switch (opcode)
 	{
-		if (CPU_doingDMA)
+		case 0x00: // BRK
+		case 0x20: // JSR
+		case 0x40: // RTI
+		case 0x4C: // JMP
+		case 0x60: // RTS
+		case 0x6C: // JMP (indirect)
 		{
-			CPU_cyclesToSkip += 2;
+			return (true);
 		}
-		else
-		{
-			CPU_cyclesToSkip += 4;
+
+		default:
+		{ // branches are xxx10000
+			return ((opcode & 0x1F) == 0x10);
 		}
 	}
+}
+
+/* Finds the block starting at an address of the cartridge, decoding it if needed ... blocks are keyed by where they are in PRG ROM, which never changes, so switching banks only changes which block is found */
+inline CPU_block_t& CPU_cache__block(uint16_t address)
+{
+	uint32_t offset = MM::mapPRG(address);
+
+	CPU_block_t &block = CC_console->blockCache[(offset ^ (offset >> 13)) & (CPU_BLOCK_CACHE_SIZE - 1)];
+	if (block.key == offset + 1)
+	{
+		return (block);
+	}
+
+	block.key = offset + 1;
+	block.address = address;
+	block.length = 0;
+	block.executions = 0;
+	block.recompiled = nullptr;
+
+	uint32_t position = address;
+	uint32_t windowEnd = (position & ~(CPU__BLOCK_WINDOW - 1)) + CPU__BLOCK_WINDOW;
+
+	while (block.length < CPU_BLOCK_MAXIMUM_LENGTH)
+	{
+		uint8_t opcode = MM::readPRG((uint16_t)position);
+		uint8_t length = CPU_operationLength[opcode];
+
+		if (position + length > windowEnd)
+		{ // the rest of the instruction may be in another bank ... it is read through the bus when it gets executed
+			break;
+		}
+
+		CPU_instruction_t &instruction = block.instructions[block.length++];
+		instruction.opcode = opcode;
+		instruction.length = length;
+		instruction.duration = CPU_operationDuration[opcode];
+		instruction.operand = 0x0000;
+
+		if (length > 1)
+		{
+			instruction.operand = MM::readPRG((uint16_t)(position + 1));
+		}
+
+		if (length > 2)
+		{
+			instruction.operand |= (uint16_t)MM::readPRG((uint16_t)(position + 2)) << 8;
+		}
+
+		position += length;
+
+		if (CPU_instruction__endsBlock(opcode))
+		{
+			break;
+		}
+	}
+
+	CPU_idle__classify(block, address);
+	CPU_fusion__classify(block);
+
+	return (block);
+}
+
+/* Recognizes a block that branches back to its own start and changes nothing but the registers while doing so ... or only counts a RAM location */
+inline void CPU_idle__classify(CPU_block_t &block, uint16_t address)
+{
+	block.idleLoop = CPU__IDLE_LOOP_NONE;
+	block.idleCycles = 0;
+
+	if (block.length == 0)
+	{
+		return;
+	}
+
+	uint16_t end = address;
+	uint32_t cycles = 0;
+
+	for (uint32_t i = 0; i < block.length; ++i)
+	{
+		end += block.instructions[i].length;
+		cycles += block.instructions[i].duration;
+	}
+
+	const CPU_instruction_t &last = block.instructions[block.length - 1];
+
+	if (last.opcode == 0x4C)
+	{ // JMP
+		if (last.operand != address)
+		{
+			return;
+		}
+	}
+	else if ((last.opcode & 0x1F) == 0x10)
+	{ // branches are xxx10000
+		uint16_t target = end + (int8_t)last.operand;
+		if (target != address)
+		{
+			return;
+		}
+
+		cycles += ((end & CPU__PAGE_MASK) != (target & CPU__PAGE_MASK)) ? 3 : 1;
+	}
+	else
+	{
+		return;
+	}
+
+	uint8_t idleLoop = CPU__IDLE_LOOP_POLL;
+
+	const CPU_instruction_t &first = block.instructions[0];
+
+	if (block.length == 2 && last.opcode == 0x4C && (first.opcode == 0xE6 || first.opcode == 0xC6 || ((first.opcode == 0xEE || first.opcode == 0xCE) && first.operand < 0x2000)))
+	{ // INC or DEC of RAM, then JMP
+		idleLoop = CPU__IDLE_LOOP_COUNTER;
+	}
+	else
+	{
+		for (uint32_t i = 0; i + 1 < block.length; ++i)
+		{
+			const CPU_instruction_t &instruction = block.instructions[i];
+
+			switch (instruction.opcode)
+			{
+				case 0x18: case 0x38: case 0xB8: case 0xD8: case 0xF8: // flags, except the interrupt inhibit
+				case 0xAA: case 0xA8: case 0x8A: case 0x98: case 0xBA: case 0x9A: // transfers
+				case 0xE8: case 0xC8: case 0xCA: case 0x88: case 0xEA: // INX, INY, DEX, DEY, NOP
+				case 0x0A: case 0x2A: case 0x4A: case 0x6A: // shifts of A
+				case 0xA9: case 0xA2: case 0xA0: case 0xC9: case 0xE0: case 0xC0: case 0x29: case 0x09: case 0x49: case 0x69: case 0xE9: // immediate
+				case 0xA5: case 0xA6: case 0xA4: case 0xC5: case 0xE4: case 0xC4: case 0x24: case 0x25: case 0x05: case 0x45: case 0x65: case 0xE5: // zero page
+				case 0xB5: case 0xB6: case 0xB4: case 0xD5: case 0x35: case 0x15: case 0x55: case 0x75: case 0xF5: // indexed zero page
+				{
+					break;
+				}
+
+				case 0xAD: case 0xAE: case 0xAC: case 0xCD: case 0xEC: case 0xCC: case 0x2C: case 0x2D: case 0x0D: case 0x4D: case 0x6D: case 0xED: // absolute
+				{
+					if (instruction.operand < 0x2000 || instruction.operand >= 0x8000)
+					{ // RAM and ROM only change when written
+						break;
+					}
+
+					if (instruction.operand < 0x4000 && (instruction.operand & 0x0007) == 0x0002)
+					{ // reading the status again has no other effect
+						idleLoop = CPU__IDLE_LOOP_STATUS;
+
+						break;
+					}
+
+					return;
+				}
+
+				default:
+				{ // writes, the stack, I/O and anything whose timing depends on the registers
+					return;
+				}
+			}
+		}
+	}
+
+	block.idleLoop = idleLoop;
+	block.idleCycles = (uint8_t)cycles;
+}
+
+/* PC is at the start of an idle loop ... skips the passes through it that fit in the cycles left, if nothing but an event can get the CPU out of it */
+inline bool CPU_idle__skip(CPU_state_t &cpu, const CPU_block_t &block, uint32_t cycles_left)
+{
+	uint32_t registers = (uint32_t)cpu.registerA | ((uint32_t)cpu.registerX << 8) | ((uint32_t)cpu.registerY << 16) | ((uint32_t)CPU_flags__pack(cpu) << 24);
+
+	if (block.idleLoop != CPU__IDLE_LOOP_COUNTER && (cpu.idleLoopStart != cpu.registerPC || cpu.idleLoopRegisters != registers))
+	{ // a pass that left the registers as it found them reads the same values every time ... so one has to be executed first
+		cpu.idleLoopStart = cpu.registerPC;
+		cpu.idleLoopEnd = cpu.registerPC;
+		cpu.idleLoopRegisters = registers;
+
+		for (uint32_t i = 0; i < block.length; ++i)
+		{
+			cpu.idleLoopEnd += block.instructions[i].length;
+		}
+
+		return (false);
+	}
+
+	if (CPU_interrupt__pending<CPU_fast_t>(cpu))
+	{ // would be taken between two instructions
+		return (false);
+	}
+
+	if (block.idleLoop == CPU__IDLE_LOOP_STATUS && !PPU::isStatusSteady())
+	{
+		return (false);
+	}
+
+	uint32_t passes = cycles_left / block.idleCycles; // every instruction of these starts within the budget
+	if (passes * block.idleCycles > 0xFFFFu)
+	{
+		passes = 0xFFFFu / block.idleCycles;
+	}
+
+	if (passes == 0)
+	{
+		return (false);
+	}
+
+	if (block.idleLoop == CPU__IDLE_LOOP_COUNTER)
+	{
+		const CPU_instruction_t &counter = block.instructions[0];
+		uint8_t value = MB::readMainBus(counter.operand);
+
+		value += (counter.opcode == 0xE6 || counter.opcode == 0xEE) ? (uint8_t)passes : (uint8_t)-(int32_t)passes;
+		MB::writeMainBus(counter.operand, value);
+
+		CPU__set_flags_NZ(value);
+	}
+
+	cpu.cyclesToSkip += (uint16_t)(passes * block.idleCycles);
+
+	return (true);
+}
+
+/* ORA, AND, EOR, ADC, STA, LDA, CMP and SBC share their addressing modes, in the low bits of the opcode ... 0x89 would be STA immediate, which does not exist */
+inline bool CPU_fusion__isGroupOne(uint8_t opcode, uint8_t operation)
+{
+	return (((opcode & 0xE3) == operation) && (opcode != 0x89));
+}
+
+/* Marks the instructions that start an idiom with the ones after them in the block */
+inline void CPU_fusion__classify(CPU_block_t &block)
+{
+	for (uint8_t i = 0; i < block.length; ++i)
+	{
+		CPU_instruction_t *instruction = block.instructions + i;
+		uint8_t following = block.length - i - 1;
+
+		instruction->fusion = CPU__FUSION_NONE;
+
+		if (following >= 1)
+		{
+			uint8_t next = instruction[1].opcode;
+
+			if (instruction->opcode == 0xCA && next == 0xD0)
+			{
+				instruction->fusion = CPU__FUSION_DEX_BNE;
+			}
+			else if (instruction->opcode == 0x88 && next == 0xD0)
+			{
+				instruction->fusion = CPU__FUSION_DEY_BNE;
+			}
+			else if (CPU_fusion__isGroupOne(instruction->opcode, 0xA1) && CPU_fusion__isGroupOne(next, 0x81))
+			{
+				instruction->fusion = CPU__FUSION_LDA_STA;
+			}
+			else if (CPU_fusion__isGroupOne(instruction->opcode, 0xA1) && CPU_fusion__isGroupOne(next, 0xC1) && following >= 2 && instruction[2].opcode == 0xF0)
+			{
+				instruction->fusion = CPU__FUSION_LDA_CMP_BEQ;
+			}
+			else if (instruction->opcode == 0x18 && CPU_fusion__isGroupOne(next, 0x61))
+			{
+				instruction->fusion = CPU__FUSION_CLC_ADC;
+			}
+		}
+	}
+}
+
+/* Starts the next instruction of an idiom on the cycle the loop would have ... as long as nothing could have happened before it: no other unit was accessed, no interrupt is waiting and the run does not end first */
+template <typename policy> inline bool CPU_fusion__next(CPU_state_t &cpu, const CPU_instruction_t *&instruction, uint16_t &instruction_address, uint32_t &cycles, uint32_t budget)
+{
+	uint32_t start = cycles - 1 + cpu.cyclesToSkip;
+
+	if (cpu.leaveRun || (start >= budget) || CPU_interrupt__pending<policy>(cpu))
+	{
+		return (false);
+	}
+
+	cycles = start + 1;
+	cpu.runCycles = start;
+	cpu.cyclesToSkip = instruction->duration;
+	cpu.doingDMA = false;
+
+	instruction_address += instruction->length;
+	cpu.registerPC = instruction_address;
+	cpu.operand = instruction->operand;
+
+	++instruction;
+
+	return (true);
+}
+
+/* The instructions after the first one of an idiom, with the same handlers the loop uses, so cycles and flags come out the same */
+template <typename policy> inline void CPU_fusion__execute(CPU_state_t &cpu, uint8_t fusion, const CPU_instruction_t *&instruction, uint16_t &instruction_address, uint32_t &cycles, uint32_t budget)
+{
+	uint8_t opcode = instruction->opcode;
+
+	if (!CPU_fusion__next<policy>(cpu, instruction, instruction_address, cycles, budget))
+	{
+		return;
+	}
+
+	switch (fusion)
+	{
+		case CPU__FUSION_DEX_BNE:
+		case CPU__FUSION_DEY_BNE:
+		{
+			CPU_operation__branch<policy, CPU__FLAG_ZERO, false>(cpu);
+
+			break;
+		}
+
+		case CPU__FUSION_LDA_STA:
+		{
+			switch (opcode)
+			{
+				case 0x81: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+				case 0x85: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+				case 0x8D: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+				case 0x91: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_INDIRECT_Y, !policy::cycleAccurate>(cpu); break;
+				case 0x95: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+				case 0x99: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE_Y, false>(cpu); break;
+				case 0x9D: CPU_operation__store<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE_X, false>(cpu); break;
+			}
+
+			break;
+		}
+
+		case CPU__FUSION_LDA_CMP_BEQ:
+		{
+			switch (opcode)
+			{
+				case 0xC1: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+				case 0xC5: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+				case 0xC9: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+				case 0xCD: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+				case 0xD1: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_INDIRECT_Y>(cpu); break;
+				case 0xD5: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+				case 0xD9: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE_Y>(cpu); break;
+				case 0xDD: CPU_operation__compare<policy, &CPU_state_t::registerA, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			}
+
+			if (CPU_fusion__next<policy>(cpu, instruction, instruction_address, cycles, budget))
+			{
+				CPU_operation__branch<policy, CPU__FLAG_ZERO, true>(cpu);
+			}
+
+			break;
+		}
+
+		case CPU__FUSION_CLC_ADC:
+		{
+			switch (opcode)
+			{
+				case 0x61: CPU_operation__ADC<policy, CPU__ADDRESSING_INDIRECT_X>(cpu); break;
+				case 0x65: CPU_operation__ADC<policy, CPU__ADDRESSING_ZEROPAGE>(cpu); break;
+				case 0x69: CPU_operation__ADC<policy, CPU__ADDRESSING_IMMEDIATE>(cpu); break;
+				case 0x6D: CPU_operation__ADC<policy, CPU__ADDRESSING_ABSOLUTE>(cpu); break;
+				case 0x71: CPU_operation__ADC<policy, CPU__ADDRESSING_INDIRECT_Y>(cpu); break;
+				case 0x75: CPU_operation__ADC<policy, CPU__ADDRESSING_ZEROPAGE_X>(cpu); break;
+				case 0x79: CPU_operation__ADC<policy, CPU__ADDRESSING_ABSOLUTE_Y>(cpu); break;
+				case 0x7D: CPU_operation__ADC<policy, CPU__ADDRESSING_ABSOLUTE_X>(cpu); break;
+			}
+
+			break;
+		}
+	}
+}
+
+/* Adds the index to an absolute address ... the accurate core also makes the read of the address with the unfixed high byte, which the writes and read-modify-writes always do */
+template <typename policy, bool page_penalty> inline void CPU_address__index(CPU_state_t &cpu, uint16_t &address, uint8_t index)
+{
+	bool crossed = (address & CPU__PAGE_MASK) != ((address + index) & CPU__PAGE_MASK);
+
+	if (page_penalty && crossed)
+	{
+		cpu.cyclesToSkip += 1;
+	}
+
+	if (policy::cycleAccurate && (crossed || !page_penalty))
+	{
+		CPU_bus__read<policy>(cpu, (address & CPU__PAGE_MASK) | ((address + index) & ~CPU__PAGE_MASK));
+	}
+
+	address += index;
+}
+
+/* Resolves the operand address ... PC is already past the instruction and the switch is on a constant, so only one case is compiled in */
+template <typename policy, uint8_t addressing, bool page_penalty> inline uint16_t CPU_address__fetch(CPU_state_t &cpu)
+{
+	uint16_t address = 0;
+
+	switch (addressing)
+	{
+		case CPU__ADDRESSING_ZEROPAGE:
+		{
+			address = cpu.operand;
+
+			break;
+		}
+
+		case CPU__ADDRESSING_ZEROPAGE_X:
+		{
+			address = (cpu.operand + cpu.registerX) & ~CPU__PAGE_MASK;
+
+			if (policy::cycleAccurate)
+			{ // the base address is read while indexing, from RAM, so only its cycle matters
+				++cpu.busCycle;
+			}
+
+			break;
+		}
+
+		case CPU__ADDRESSING_ZEROPAGE_Y:
+		{
+			address = (cpu.operand + cpu.registerY) & ~CPU__PAGE_MASK;
+
+			if (policy::cycleAccurate)
+			{ // the base address is read while indexing, from RAM, so only its cycle matters
+				++cpu.busCycle;
+			}
+
+			break;
+		}
+
+		case CPU__ADDRESSING_ABSOLUTE:
+		{
+			address = cpu.operand;
+
+			break;
+		}
+
+		case CPU__ADDRESSING_ABSOLUTE_X:
+		case CPU__ADDRESSING_ABSOLUTE_Y:
+		{
+			uint8_t index = (addressing == CPU__ADDRESSING_ABSOLUTE_X) ? cpu.registerX : cpu.registerY;
+
+			address = cpu.operand;
+
+			CPU_address__index<policy, page_penalty>(cpu, address, index);
+
+			break;
+		}
+
+		case CPU__ADDRESSING_INDIRECT_X:
+		{
+			uint8_t baseAddress = (uint8_t)cpu.operand + cpu.registerX; // uint8 because it is read from page 0
+
+			if (policy::cycleAccurate)
+			{ // same as zero page indexed
+				++cpu.busCycle;
+			}
+
+			address = CPU_memory__readPointer<policy>(cpu, baseAddress);
+
+			break;
+		}
+
+		case CPU__ADDRESSING_INDIRECT_Y:
+		{
+			uint8_t baseAddress = (uint8_t)cpu.operand;
+
+			address = CPU_memory__readPointer<policy>(cpu, baseAddress);
+
+			CPU_address__index<policy, page_penalty>(cpu, address, cpu.registerY);
+
+			break;
+		}
+	}
+
+	return (address);
+}
+
+/* Immediate operands are part of the instruction, the others are read from where they are addressed */
+template <typename policy, uint8_t addressing, bool page_penalty> inline uint8_t CPU_operand__read(CPU_state_t &cpu)
+{
+	if (addressing == CPU__ADDRESSING_IMMEDIATE)
+	{
+		return ((uint8_t)cpu.operand);
+	}
+
+	return (CPU_memory__read<policy, addressing>(cpu, CPU_address__fetch<policy, addressing, page_penalty>(cpu)));
+}
+
+template <typename policy> inline void CPU_operation__BRK(CPU_state_t &cpu)
+{
+	CPU_interrupt__enter<policy>(cpu, INTERRUPT_BRK);
+}
+
+template <typename policy> inline void CPU_operation__PHP(CPU_state_t &cpu)
+{
+	CPU__stack_push(CPU_flags__pack(cpu) | CPU__FLAG_BREAK);
+}
+
+template <typename policy> inline void CPU_operation__PLP(CPU_state_t &cpu)
+{
+	cpu.flags = CPU__stack_pop();
+
+	CPU_flags__load(cpu);
+}
+
+template <typename policy> inline void CPU_operation__PHA(CPU_state_t &cpu)
+{
+	CPU__stack_push(cpu.registerA);
+}
+
+template <typename policy> inline void CPU_operation__PLA(CPU_state_t &cpu)
+{
+	cpu.registerA = CPU__stack_pop();
+
+	CPU__set_flags_NZ(cpu.registerA);
+}
+
+template <typename policy> inline void CPU_operation__JSR(CPU_state_t &cpu)
+{ // pushes the address of its last byte
+	CPU__stack_push((cpu.registerPC - 1) >> 8);
+	CPU__stack_push(cpu.registerPC - 1);
+
+	if (cpu.registerPC < 0x2000)
+	{ // code in RAM can be overwritten by the return address, the target is read after it
+		cpu.operand = CPU__read_16_bits((uint16_t)(cpu.registerPC - 2));
+	}
+
+	cpu.registerPC = cpu.operand;
+}
+
+template <typename policy> inline void CPU_operation__RTS(CPU_state_t &cpu)
+{
+	cpu.registerPC = CPU__stack_pop();
+	cpu.registerPC |= CPU__stack_pop() << 8;
+	++cpu.registerPC;
+}
+
+template <typename policy> inline void CPU_operation__RTI(CPU_state_t &cpu)
+{
+	cpu.flags = CPU__stack_pop();
+	CPU_flags__load(cpu);
+
+	cpu.registerPC = CPU__stack_pop();
+	cpu.registerPC |= CPU__stack_pop() << 8;
+}
+
+inline void CPU_operation__JMP(CPU_state_t &cpu)
+{
+	cpu.registerPC = cpu.operand;
+}
+
+template <typename policy> inline void CPU_operation__JMPI(CPU_state_t &cpu)
+{
+	uint16_t address = cpu.operand;
+	uint16_t page = address & CPU__PAGE_MASK;
+
+	cpu.registerPC = CPU_bus__read<policy>(cpu, address);
+	cpu.registerPC |= (CPU_bus__read<policy>(cpu, page | ((address + 1) & ~CPU__PAGE_MASK))) << 8;
+}
+
+inline void CPU_operation__TXS(CPU_state_t &cpu)
+{
+	cpu.registerSP = cpu.registerX;
+}
+
+template <uint8_t flag> inline void CPU_operation__setFlag(CPU_state_t &cpu)
+{
+	if (flag == CPU__FLAG_CARRY)
+	{
+		cpu.carry = 1;
+	}
+	else
+	{
+		cpu.flags |= flag;
+	}
+}
+
+template <uint8_t flag> inline void CPU_operation__clearFlag(CPU_state_t &cpu)
+{
+	if (flag == CPU__FLAG_CARRY)
+	{
+		cpu.carry = 0;
+	}
+	else if (flag == CPU__FLAG_OVERFLOW)
+	{
+		cpu.overflow = 0;
+	}
+	else
+	{
+		cpu.flags &= ~flag;
+	}
+}
+
+template <uint8_t CPU_state_t::*source, uint8_t CPU_state_t::*destination> inline void CPU_operation__transfer(CPU_state_t &cpu)
+{
+	cpu.*destination = cpu.*source;
+
+	CPU__set_flags_NZ(cpu.*destination);
+}
+
+template <uint8_t CPU_state_t::*target, uint8_t delta> inline void CPU_operation__incrementRegister(CPU_state_t &cpu)
+{
+	cpu.*target += delta;
+
+	CPU__set_flags_NZ(cpu.*target);
+}
+
+template <typename policy, uint8_t flag, bool set> inline void CPU_operation__branch(CPU_state_t &cpu)
+{
+	bool flagSet = false;
+
+	switch (flag)
+	{
+		case CPU__FLAG_NEGATIVE: flagSet = (cpu.resultNZ & 0x0180) != 0; break;
+		case CPU__FLAG_ZERO: flagSet = (cpu.resultNZ & 0x00FF) == 0; break;
+		case CPU__FLAG_CARRY: flagSet = cpu.carry != 0; break;
+		case CPU__FLAG_OVERFLOW: flagSet = cpu.overflow != 0; break;
+	}
+
+	if (flagSet == set)
+	{
+		cpu.cyclesToSkip += 1;
+
+		uint16_t newPC = cpu.registerPC + (int8_t)cpu.operand;
+
+		if ((cpu.registerPC & CPU__PAGE_MASK) != (newPC & CPU__PAGE_MASK))
+		{ // page crossed when updating PC ... the fast core keeps the two cycles it always took here
+			cpu.cyclesToSkip += policy::cycleAccurate ? 1 : 2;
+		}
+		else if (policy::cycleAccurate)
+		{ // the interrupts are not polled again in the extra cycle
+			cpu.lateCycles = 2;
+		}
+
+		cpu.registerPC = newPC;
+	}
+}
+
+template <typename policy, uint8_t CPU_state_t::*target, uint8_t addressing> inline void CPU_operation__load(CPU_state_t &cpu)
+{
+	cpu.*target = CPU_operand__read<policy, addressing, true>(cpu);
+
+	CPU__set_flags_NZ(cpu.*target);
+}
+
+template <typename policy, uint8_t CPU_state_t::*source, uint8_t addressing, bool page_penalty> inline void CPU_operation__store(CPU_state_t &cpu)
+{
+	uint16_t address = CPU_address__fetch<policy, addressing, page_penalty>(cpu);
+
+	CPU_memory__write<policy, addressing>(cpu, address, cpu.*source);
+}
+
+template <typename policy, uint8_t CPU_state_t::*source, uint8_t addressing> inline void CPU_operation__compare(CPU_state_t &cpu)
+{
+	uint16_t difference = cpu.*source - CPU_operand__read<policy, addressing, true>(cpu);
+
+	cpu.carry = (uint8_t)(~difference >> 8) & 0x01; // no borrow
+	CPU__set_flags_NZ(difference);
+}
+
+template <typename policy, uint8_t addressing> inline void CPU_operation__ORA(CPU_state_t &cpu)
+{
+	cpu.registerA |= CPU_operand__read<policy, addressing, true>(cpu);
+
+	CPU__set_flags_NZ(cpu.registerA);
+}
+
+template <typename policy, uint8_t addressing> inline void CPU_operation__AND(CPU_state_t &cpu)
+{
+	cpu.registerA &= CPU_operand__read<policy, addressing, true>(cpu);
+
+	CPU__set_flags_NZ(cpu.registerA);
+}
+
+template <typename policy, uint8_t addressing> inline void CPU_operation__EOR(CPU_state_t &cpu)
+{
+	cpu.registerA ^= CPU_operand__read<policy, addressing, true>(cpu);
+
+	CPU__set_flags_NZ(cpu.registerA);
+}
+
+template <typename policy, uint8_t addressing> inline void CPU_operation__ADC(CPU_state_t &cpu)
+{
+	uint8_t parameter = CPU_operand__read<policy, addressing, true>(cpu);
+	uint16_t sum = cpu.registerA + parameter + cpu.carry;
+
+	cpu.carry = (uint8_t)(sum >> 8);
+	cpu.overflow = (uint8_t)(((cpu.registerA ^ sum) & (parameter ^ sum) & 0x80) >> 1);
+
+	cpu.registerA = (uint8_t)sum;
+
+	CPU__set_flags_NZ(cpu.registerA);
+}
+
+template <typename policy, uint8_t addressing> inline void CPU_operation__SBC(CPU_state_t &cpu)
+{
+	uint16_t parameter = CPU_operand__read<policy, addressing, true>(cpu);
+	uint16_t difference = cpu.registerA - parameter - (cpu.carry ^ 0x01);
+
+	cpu.carry = (uint8_t)(~difference >> 8) & 0x01;
+	cpu.overflow = (uint8_t)(((cpu.registerA ^ difference) & (~parameter ^ difference) & 0x80) >> 1);
+
+	cpu.registerA = (uint8_t)difference;
+
+	CPU__set_flags_NZ(cpu.registerA);
+}
+
+template <typename policy, uint8_t addressing> inline void CPU_operation__BIT(CPU_state_t &cpu)
+{
+	uint8_t operand = CPU_operand__read<policy, addressing, true>(cpu);
+
+	cpu.resultNZ = (uint8_t)(cpu.registerA & operand) | ((operand & 0x80) << 1); // negative from the operand, even if the result is zero
+	cpu.overflow = operand & CPU__FLAG_OVERFLOW;
+}
+
+/* Read-modify-write instructions work on the accumulator or on memory ... the fast core also takes the page crossing cycle on abs,X, as it always did here */
+template <typename policy, uint8_t addressing> inline void CPU_operation__ASL(CPU_state_t &cpu)
+{
+	uint16_t address = (addressing == CPU__ADDRESSING_ACCUMULATOR) ? 0 : CPU_address__fetch<policy, addressing, !policy::cycleAccurate>(cpu);
+	uint8_t parameter = (addressing == CPU__ADDRESSING_ACCUMULATOR) ? cpu.registerA : CPU_memory__read<policy, addressing>(cpu, address);
+
+	if (addressing != CPU__ADDRESSING_ACCUMULATOR)
+	{
+		CPU_bus__writeBack<policy>(cpu, address, parameter);
+	}
+
+	cpu.carry = parameter >> 7;
+
+	parameter <<= 1;
+
+	CPU__set_flags_NZ(parameter);
+
+	if (addressing == CPU__ADDRESSING_ACCUMULATOR)
+	{
+		cpu.registerA = parameter;
+	}
+	else
+	{
+		CPU_memory__write<policy, addressing>(cpu, address, parameter);
+	}
+}
+
+template <typename policy, uint8_t addressing> inline void CPU_operation__ROL(CPU_state_t &cpu)
+{
+	uint16_t address = (addressing == CPU__ADDRESSING_ACCUMULATOR) ? 0 : CPU_address__fetch<policy, addressing, !policy::cycleAccurate>(cpu);
+	uint8_t parameter = (addressing == CPU__ADDRESSING_ACCUMULATOR) ? cpu.registerA : CPU_memory__read<policy, addressing>(cpu, address);
+
+	if (addressing != CPU__ADDRESSING_ACCUMULATOR)
+	{
+		CPU_bus__writeBack<policy>(cpu, address, parameter);
+	}
+
+	uint8_t oldCarry = cpu.carry;
+
+	cpu.carry = parameter >> 7;
+
+	parameter = (uint8_t)(parameter << 1) | oldCarry;
+
+	CPU__set_flags_NZ(parameter);
+
+	if (addressing == CPU__ADDRESSING_ACCUMULATOR)
+	{
+		cpu.registerA = parameter;
+	}
+	else
+	{
+		CPU_memory__write<policy, addressing>(cpu, address, parameter);
+	}
+}
+
+template <typename policy, uint8_t addressing> inline void CPU_operation__LSR(CPU_state_t &cpu)
+{
+	uint16_t address = (addressing == CPU__ADDRESSING_ACCUMULATOR) ? 0 : CPU_address__fetch<policy, addressing, !policy::cycleAccurate>(cpu);
+	uint8_t parameter = (addressing == CPU__ADDRESSING_ACCUMULATOR) ? cpu.registerA : CPU_memory__read<policy, addressing>(cpu, address);
+
+	if (addressing != CPU__ADDRESSING_ACCUMULATOR)
+	{
+		CPU_bus__writeBack<policy>(cpu, address, parameter);
+	}
+
+	cpu.carry = parameter & 0x01;
+
+	parameter >>= 1;
+
+	cpu.resultNZ = parameter | ((cpu.resultNZ & 0x0180) ? 0x0100 : 0x0000); // the negative flag is left as it was
+
+	if (addressing == CPU__ADDRESSING_ACCUMULATOR)
+	{
+		cpu.registerA = parameter;
+	}
+	else
+	{
+		CPU_memory__write<policy, addressing>(cpu, address, parameter);
+	}
+}
+
+template <typename policy, uint8_t addressing> inline void CPU_operation__ROR(CPU_state_t &cpu)
+{
+	uint16_t address = (addressing == CPU__ADDRESSING_ACCUMULATOR) ? 0 : CPU_address__fetch<policy, addressing, !policy::cycleAccurate>(cpu);
+	uint8_t parameter = (addressing == CPU__ADDRESSING_ACCUMULATOR) ? cpu.registerA : CPU_memory__read<policy, addressing>(cpu, address);
+
+	if (addressing != CPU__ADDRESSING_ACCUMULATOR)
+	{
+		CPU_bus__writeBack<policy>(cpu, address, parameter);
+	}
+
+	uint8_t oldCarry = cpu.carry;
+
+	cpu.carry = parameter & 0x01;
+
+	parameter = (parameter >> 1) | (uint8_t)(oldCarry << 7);
+
+	CPU__set_flags_NZ(parameter);
+
+	if (addressing == CPU__ADDRESSING_ACCUMULATOR)
+	{
+		cpu.registerA = parameter;
+	}
+	else
+	{
+		CPU_memory__write<policy, addressing>(cpu, address, parameter);
+	}
+}
+
+template <typename policy, uint8_t addressing, uint8_t delta> inline void CPU_operation__increment(CPU_state_t &cpu)
+{
+	uint16_t address = CPU_address__fetch<policy, addressing, !policy::cycleAccurate>(cpu);
+
+	uint8_t parameter = CPU_memory__read<policy, addressing>(cpu, address);
+	CPU_bus__writeBack<policy>(cpu, address, parameter);
+
+	parameter += delta;
+
+	CPU__set_flags_NZ(parameter);
+
+	CPU_memory__write<policy, addressing>(cpu, address, parameter);
 }
\ No newline at end of file
@@ -14,10 +14,11 @@
 namespace CPU
 {
 	void reset(); // MemoryBus and MemoryMapper have to be already initialized
-	void step();
+	uint32_t run(uint32_t budget); // whole instructions until the cycle budget is used up or the other units were accessed ... returns the cycles used, with the fast or the cycle accurate core, as the cartridge needs, instrumented while PF or TR is on
+	uint32_t getRunCycles(); // cycles used by the current run before the instruction being executed
 	void pullInterruptPin(uint8_t source);
 	void releaseInterruptPin(uint8_t source);
-	void causeInterrupt(uint8_t interrupt);
+	void causeInterrupt(uint8_t interrupt); // an NMI is taken by CPU::run between two instructions, or when the accurate core polls
 	void skipCyclesForDMA();
 	void skipCyclesForDMCFetch();
 }
\ No newline at end of file
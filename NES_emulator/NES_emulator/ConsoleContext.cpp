@@ -0,0 +1,31 @@
+#include "ConsoleContext.h"
+
+thread_local CC_console_t *CC_console = nullptr;
+
+namespace CC
+{
+	CC_console_t* create()
+	{
+		return (new CC_console_t()); // zero initialized, as the module variables used to be
+	}
+
+	void select(CC_console_t *console)
+	{
+		CC_console = console;
+	}
+
+	CC_console_t* getSelected()
+	{
+		return (CC_console);
+	}
+
+	void destroy(CC_console_t *console)
+	{
+		if (CC_console == console)
+		{
+			CC_console = nullptr;
+		}
+
+		delete console;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* Everything a console needs to run ... each instance owns one, so any number of them can exist in a process */
+
+typedef struct
+{
+	uint8_t mirroring;
+	uint8_t mapper;
+	bool hasBatteryBackedRAM;
+	uint8_t *PRGROM;
+	uint8_t *CHRROM;
+	uint8_t PRGBankCount;
+	uint8_t CHRBankCount;
+	uint8_t systemType;
+	bool cycleAccurate;
+}CR_state_t;
+
+typedef struct
+{
+	const uint8_t *read[256]; // memory behind every 256 byte page of the CPU address space, nullptr where reading goes through the registers or the mapper
+	uint8_t *write[256]; // RAM only
+}MB_pages_t;
+
+typedef struct
+{
+	uint16_t cyclesToSkip;
+	uint16_t registerPC;
+	uint8_t registerSP;
+	uint8_t registerA;
+	uint8_t registerX;
+	uint8_t registerY;
+	uint8_t flags; // CPU::run keeps N, Z, C and V in the next three, and only copies them back here when it returns
+	uint16_t resultNZ; // zero if its low byte is, negative if bit 7 or 8 is set
+	uint8_t carry; // 0 or 1
+	uint8_t overflow; // 0 or the overflow bit of the flags
+	uint8_t interruptRequests; // IRQ sources holding the line low, and an NMI the CPU has not taken yet
+	bool doingDMA;
+	uint32_t runCycles; // cycles CPU::run had gone through when the current instruction started
+	bool leaveRun; // the instruction accessed the other units, CPU::run returns after it
+	uint16_t operand; // of the instruction being executed, already fetched
+	uint16_t idleLoopStart; // loop that only waits, being executed ... 0 if none
+	uint16_t idleLoopEnd;
+	uint32_t idleLoopRegisters; // A, X, Y and flags when the last pass through it started
+	bool cycleAccurate; // core CPU::run uses, chosen for the cartridge at reset
+	uint8_t busCycle; // cycle accurate core ... cycle of the instruction its next bus access happens on
+	uint8_t lateCycles; // an interrupt raised in the last ones of these cycles of the instruction is only polled after the next
+	uint8_t lateRequests; // interrupt sources raised too late for the current instruction
+	bool lateNMI;
+	uint8_t inhibitPolled; // interrupt inhibit flag as the last instruction polled it
+	MB_pages_t *pages; // of the console, kept at hand for every access
+	uint8_t *RAM; // of the console, for the zero page and stack accesses that cannot go anywhere else
+}CPU_state_t;
+
+#define CPU_BLOCK_CACHE_SIZE (2048u) // blocks ... a power of 2
+#define CPU_BLOCK_MAXIMUM_LENGTH (16u) // instructions
+
+typedef struct
+{
+	uint8_t opcode;
+	uint8_t length;
+	uint8_t duration; // without the page crossing and branch cycles
+	uint8_t fusion; // idiom the instruction starts with the ones after it, executed without going around the loop for each
+	uint16_t operand;
+}CPU_instruction_t;
+
+typedef struct
+{
+	uint32_t key; // offset in PRG ROM of the first instruction plus one, 0 while the entry is empty
+	uint16_t address; // CPU address it was decoded at ... the offset can be mapped at others too, and the recompiled code and the idle loop only hold at this one
+	uint8_t length;
+	CPU_instruction_t instructions[CPU_BLOCK_MAXIMUM_LENGTH];
+	uint16_t executions; // counted until the block is hot enough to be recompiled
+	uint8_t *recompiled; // native code of the block, nullptr while it is interpreted
+	uint8_t idleLoop; // what the block does if it is a loop the CPU only waits in
+	uint8_t idleCycles; // of one pass through the loop
+}CPU_block_t;
+
+typedef struct
+{
+	const uint32_t *paletteInUse;
+	uint8_t spriteMemory[256];
+	uint8_t scanlineSprites[8];
+	int8_t scanlineSpriteCount;
+	uint8_t pipelineStage;
+	uint16_t frameEnd;
+	uint16_t cycle;
+	uint16_t scanline;
+	uint32_t frameCount;
+	bool evenFrame;
+	bool verticalBlank;
+	bool spriteZeroHit;
+	bool statusChanged; // since the status register was last read
+	bool firstWrite;
+	uint16_t dataAddress; // internal registers
+	uint16_t temporaryAddress;
+	uint8_t fineVerticalScroll;
+	uint8_t dataBuffer;
+	uint8_t spriteDataAddress;
+	bool longSprites;
+	bool interruptEnabled;
+	bool grayscaleMode;
+	bool showSprites;
+	bool showBackground;
+	bool hideEdgeSprites;
+	bool hideEdgeBackground;
+	uint8_t spritePage;
+	uint8_t backgroundPage;
+	uint16_t dataAddressIncrement;
+	uint8_t frameSkip; // frames skipped after each rendered one
+	uint8_t framesSkipped;
+	bool skipFrame; // the current frame is not composed
+	bool outputSuppressed; // frames are not composed at all
+	void(*scanlineEndCallback)(bool vblank);
+}PPU_state_t;
+
+typedef struct
+{
+	uint8_t dutyCyclePosition;
+	uint8_t lengthCounter;
+	uint8_t envelope;
+	uint8_t envelopeDivider;
+	uint8_t sweepDivider;
+	bool resetEnvelope;
+	bool resetSweep;
+	uint16_t timerValue;
+	bool outputHigh;
+	uint8_t dutyCycle;
+	bool lengthCounterHalt;
+	bool constantVolume_envelopeFlag;
+	uint8_t volume_envelopePeriod;
+	bool sweepEnable;
+	uint8_t sweepPeriod;
+	bool sweepNegate;
+	uint8_t sweepShiftCount;
+	uint16_t timer;
+	uint8_t lengthCounterLoad;
+}APU_pulse_t;
+
+typedef struct
+{
+	uint8_t lengthCounter;
+	bool linearCounterHalt;
+	uint8_t linearCounter;
+	uint8_t currentSample;
+	uint16_t timerValue;
+	uint8_t sequencePosition;
+	bool linearCounterControl;
+	uint8_t linearCounterReload;
+	uint16_t timer;
+	uint8_t lengthCounterLoad;
+}APU_triangle_t;
+
+typedef struct
+{
+	uint8_t lengthCounter;
+	uint16_t shiftRegister;
+	uint8_t envelope;
+	uint8_t envelopeDivider;
+	bool resetEnvelope;
+	uint8_t currentSample;
+	uint16_t timerValue;
+	bool lengthCounterHalt;
+	bool constantVolume_envelopeFlag;
+	uint8_t volume_envelopePeriod;
+	bool mode;
+	uint8_t period;
+	uint8_t lengthCounterLoad;
+}APU_noise_t;
+
+typedef struct
+{
+	uint8_t selectedRate;
+	bool enableIRQ;
+	bool loop;
+	uint16_t addressStart;
+	uint16_t sampleLength;
+	uint16_t rateCounter;
+	uint16_t currentAddress;
+	uint8_t counter;
+	uint8_t output;
+	uint16_t samplesRemaining;
+	bool stopped;
+	uint8_t shift;
+	uint8_t currentSample;
+}APU_DMC_t;
+
+typedef struct
+{
+	const float *gaussFilterInUse;
+	uint8_t gaussFilterLength;
+	const uint16_t *noisePeriods;
+	const uint16_t *dmcRates;
+	uint16_t cycleCount;
+	uint8_t frameSteps;
+	bool enableInterrupt;
+	bool setInterruptRequest;
+	float mixedSample;
+	uint8_t mixingPosition;
+	bool requestFrameIRQ;
+	bool requetsDMCIRQ;
+	bool channelPulse1Enable;
+	bool channelPulse2Enable;
+	bool channelTriangleEnable;
+	bool channelNoiseEnable;
+	bool channelDeltaSignaEnable;
+	bool outputSuppressed; // no samples are rendered
+
+	APU_pulse_t pulse1;
+	APU_pulse_t pulse2;
+	APU_triangle_t triangle;
+	APU_noise_t noise;
+	APU_DMC_t dmc;
+}APU_state_t;
+
+typedef struct
+{
+	uint8_t RAM[0x0800]; // mirrored 4 times
+	uint8_t vRAM[0x0800];
+	uint8_t *externalRAM;
+	uint8_t palette[0x20];
+	bool enableRAM;
+	bool protectRAM;
+	uint32_t openBus; // generator state for reads from disabled external RAM
+	std::size_t nameTable[4];
+}MB_state_t;
+
+typedef struct
+{
+	void(*writePRG)(uint16_t address, uint8_t data);
+	uint8_t(*readPRG)(uint16_t address);
+	uint32_t(*mapPRG)(uint16_t address); // offset in PRG ROM of what readPRG returns
+	void(*writeCHR)(uint16_t address, uint8_t data);
+	uint8_t(*readCHR)(uint16_t address);
+}MM_busFunctions_t;
+
+typedef union
+{
+	struct
+	{
+		uint8_t bankCount;
+		uint8_t *characterRAM;
+	} MapperNone;
+
+	struct
+	{
+		uint8_t bankCount;
+		uint8_t *characterRAM;
+		uint8_t modePRG;
+		uint8_t modeCHR;
+		uint8_t temporaryRegister;
+		int8_t writeCounter;
+		uint8_t registerPRG;
+		uint8_t registerCHR0;
+		uint8_t registerCHR1;
+		uint8_t *firstBankPRG;
+		uint8_t *secondBankPRG;
+		uint8_t *firstBankCHR;
+		uint8_t *secondBankCHR;
+	} MapperMMC1;
+
+	struct
+	{
+		uint8_t bankCount;
+		uint8_t *characterRAM;
+		uint8_t *lastBank;
+		uint8_t selectedBank;
+	}MapperUNROM;
+
+	struct
+	{
+		uint8_t bankCount;
+		uint8_t selectedBank;
+	}MapperCNROM;
+
+	struct
+	{
+		uint8_t bankSelect;
+		uint8_t *PRGbankFixed0;
+		uint8_t *PRGbankFixed1;
+		uint8_t *PRGbank0;
+		uint8_t *PRGbank1;
+		uint8_t *CHR2k0;
+		uint8_t *CHR2k1;
+		uint8_t *CHR1k0;
+		uint8_t *CHR1k1;
+		uint8_t *CHR1k2;
+		uint8_t *CHR1k3;
+		bool invertPRG;
+		bool invertCHR;
+		bool enableIRQ;
+		bool causeIRQ;
+		uint8_t counterValue;
+		uint8_t counterReloadValue;
+		bool counterReload;
+	}MapperMMC3;
+}MM_parameters_t;
+
+typedef struct
+{
+	MM_busFunctions_t busFunctions;
+	MM_parameters_t parameters;
+	uint16_t currentMapper;
+	uint8_t nameTableMirroring;
+}MM_state_t;
+
+typedef struct
+{
+	uint64_t cycle; // every unit has been clocked up to (and including) this master cycle
+	uint64_t nextCycleCPU;
+	uint64_t nextCycleAPU;
+	uint64_t nextCyclePPU;
+	uint64_t runStartCycleCPU; // master cycle of the first cycle given to CPU::run, 0 outside a CPU run
+	bool eventsChanged;
+	uint8_t dividerCPU;
+	uint8_t dividerAPU;
+	uint8_t dividerPPU;
+}MC_state_t;
+
+typedef struct
+{
+	uint8_t mode;
+	uint8_t *code; // executable memory the blocks are recompiled into
+	std::size_t codeSize;
+	std::size_t codeUsed;
+	uint8_t flagsNZ[256]; // zero and negative flags of every value, looked up by the native code
+	CPU_state_t expectedCPU; // compare mode ... left by the last recompiled block, until the interpreter catches up
+	uint8_t expectedRAM[0x0800];
+	uint32_t expectedCycles;
+	uint16_t comparedBlock;
+	uint32_t mismatchCount;
+	uint16_t firstMismatchAddress;
+}DR_state_t;
+
+typedef struct
+{
+	CR_state_t cr;
+	CPU_state_t cpu;
+	PPU_state_t ppu;
+	APU_state_t apu;
+	MB_state_t mb;
+	MM_state_t mm;
+	MC_state_t mc;
+
+	MB_pages_t pages; // follows the mapping, so it is rebuilt instead of saved
+	CPU_block_t blockCache[CPU_BLOCK_CACHE_SIZE]; // decoded PRG ROM code ... can always be decoded again, so it is not saved with the state
+	DR_state_t dr; // not saved either
+	void *profilerData; // owned by PF while profiling, nullptr otherwise
+	void *tracerData; // owned by TR while tracing, nullptr otherwise
+	void *debuggerData; // owned by DB while debugging, nullptr otherwise
+	void *rewindData; // owned by RB once it was initialized, nullptr otherwise
+	void *movieData; // owned by IM once a movie was recorded or replayed, nullptr otherwise
+
+	void *frontendData; // owned by the front-end (window, sound, controllers)
+}CC_console_t;
+
+extern thread_local CC_console_t *CC_console; // console selected on the calling thread
+
+namespace CC
+{
+	CC_console_t* create(); // the console has to be selected before loading a ROM into it
+	void select(CC_console_t *console); // only for the calling thread ... a console must not be selected on two threads at once
+	CC_console_t* getSelected();
+	void destroy(CC_console_t *console); // CR, MB and MM have to be cleaned first
+}
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "Debugger.h"
+
+#include "PictureProcessingUnit.h"
+
+#include <algorithm>
+#include <vector>
+
+#define DB__MAIN_BUS_SIZE (0x10000u)
+#define DB__PICTURE_BUS_SIZE (0x4000u)
+
+typedef struct
+{
+	uint8_t watch[DB__MAIN_BUS_SIZE]; // DB_WATCH_* of every address, so an access is checked with a single look up
+	uint8_t pictureWatch[DB__PICTURE_BUS_SIZE];
+	std::vector<uint32_t> scanlineBreakpoints; // scanline and dot, sorted
+	uint16_t instruction; // address of the instruction being executed
+	DB_hit_t hit; // kind is DB_HIT_NONE while running
+	bool resuming; // the instruction stopped before is the next one, and is not stopped before again
+}DB_state_t;
+
+#define DB_state (*(DB_state_t*)CC_console->debuggerData)
+
+inline void DB_hit__record(DB_state_t &db, uint8_t kind, uint16_t address, uint8_t data);
+inline void DB_watch__set(uint8_t *watch, uint32_t address, uint8_t flags);
+
+namespace DB
+{
+	void init()
+	{
+		clean();
+
+		CC_console->debuggerData = new DB_state_t();
+	}
+
+	void addBreakpoint(uint16_t first, uint16_t last, uint8_t watch)
+	{
+		DB_state_t &db = DB_state;
+
+		for (uint32_t address = first; address <= last; ++address)
+		{
+			if (address < 0x2000)
+			{ // RAM is mirrored 4 times
+				for (uint32_t mirror = address & 0x07FF; mirror < 0x2000; mirror += 0x0800)
+				{
+					DB_watch__set(db.watch, mirror, watch);
+				}
+			}
+			else if (address < 0x4000)
+			{ // the 8 PPU registers, over and over
+				for (uint32_t mirror = 0x2000 | (address & 0x0007); mirror < 0x4000; mirror += 0x0008)
+				{
+					DB_watch__set(db.watch, mirror, watch);
+				}
+			}
+			else
+			{
+				DB_watch__set(db.watch, address, watch);
+			}
+		}
+	}
+
+	void addPictureBreakpoint(uint16_t first, uint16_t last, uint8_t watch)
+	{
+		DB_state_t &db = DB_state;
+
+		watch &= DB_WATCH_READ | DB_WATCH_WRITE;
+
+		for (uint32_t address = first; address <= last && address < DB__PICTURE_BUS_SIZE; ++address)
+		{
+			DB_watch__set(db.pictureWatch, address, watch);
+
+			if (address >= 0x2000 && address < 0x2F00)
+			{ // name tables, mirrored up to the palettes
+				DB_watch__set(db.pictureWatch, address + 0x1000, watch);
+			}
+			else if (address >= 0x3F00)
+			{ // 32 palette entries, mirrored to the end of the bus
+				for (uint32_t mirror = 0x3F00 | (address & 0x001F); mirror < DB__PICTURE_BUS_SIZE; mirror += 0x0020)
+				{
+					DB_watch__set(db.pictureWatch, mirror, watch);
+				}
+			}
+		}
+	}
+
+	bool addScanlineBreakpoint(uint16_t scanline, uint16_t dot)
+	{
+		DB_state_t &db = DB_state;
+
+		if (dot == 0 || dot > DB_DOT_LAST)
+		{
+			return (false);
+		}
+
+		uint32_t breakpoint = ((uint32_t)scanline << 16) | dot;
+		std::vector<uint32_t>::iterator place = std::lower_bound(db.scanlineBreakpoints.begin(), db.scanlineBreakpoints.end(), breakpoint);
+
+		if (place == db.scanlineBreakpoints.end() || *place != breakpoint)
+		{
+			db.scanlineBreakpoints.insert(place, breakpoint);
+		}
+
+		return (true);
+	}
+
+	void clearBreakpoints()
+	{
+		DB_state_t &db = DB_state;
+
+		std::fill(db.watch, db.watch + DB__MAIN_BUS_SIZE, 0);
+		std::fill(db.pictureWatch, db.pictureWatch + DB__PICTURE_BUS_SIZE, 0);
+		db.scanlineBreakpoints.clear();
+	}
+
+	bool isStopped()
+	{
+		DB_state_t &db = DB_state;
+
+		return (db.hit.kind != DB_HIT_NONE);
+	}
+
+	DB_hit_t getHit()
+	{
+		DB_state_t &db = DB_state;
+
+		DB_hit_t hit = db.hit;
+
+		if (hit.kind != DB_HIT_SCANLINE)
+		{ // the PPU only caught up to the CPU once the console stopped, at the start of the instruction
+			hit.scanline = PPU::getScanline();
+			hit.dot = PPU::getDot();
+			hit.frame = PPU::getFrameCount();
+		}
+
+		return (hit);
+	}
+
+	void resume()
+	{
+		DB_state_t &db = DB_state;
+
+		db.resuming = (db.hit.kind == DB_HIT_EXECUTE);
+		db.hit.kind = DB_HIT_NONE;
+	}
+
+	bool execute(uint16_t address)
+	{
+		DB_state_t &db = DB_state;
+
+		db.instruction = address;
+
+		if (db.resuming)
+		{ // unless an interrupt was taken first
+			db.resuming = false;
+
+			if (address == db.hit.address)
+			{
+				return (false);
+			}
+		}
+
+		if ((db.watch[address] & DB_WATCH_EXECUTE) && (db.hit.kind == DB_HIT_NONE))
+		{
+			DB_hit__record(db, DB_HIT_EXECUTE, address, 0x00);
+
+			return (true);
+		}
+
+		return (false);
+	}
+
+	void read(CPU_state_t &cpu, uint16_t address)
+	{
+		DB_state_t &db = DB_state;
+
+		if ((db.watch[address] & DB_WATCH_READ) && (db.hit.kind == DB_HIT_NONE))
+		{
+			DB_hit__record(db, DB_HIT_READ, address, 0x00);
+			cpu.leaveRun = true;
+		}
+	}
+
+	void write(CPU_state_t &cpu, uint16_t address, uint8_t data)
+	{
+		DB_state_t &db = DB_state;
+
+		if ((db.watch[address] & DB_WATCH_WRITE) && (db.hit.kind == DB_HIT_NONE))
+		{
+			DB_hit__record(db, DB_HIT_WRITE, address, data);
+			cpu.leaveRun = true;
+		}
+	}
+
+	void readPicture(uint16_t address, uint8_t data)
+	{
+		DB_state_t &db = DB_state;
+
+		address &= DB__PICTURE_BUS_SIZE - 1;
+
+		if ((db.pictureWatch[address] & DB_WATCH_READ) && (db.hit.kind == DB_HIT_NONE))
+		{ // a register access, so the CPU leaves the run anyway
+			DB_hit__record(db, DB_HIT_PICTURE_READ, address, data);
+		}
+	}
+
+	void writePicture(uint16_t address, uint8_t data)
+	{
+		DB_state_t &db = DB_state;
+
+		address &= DB__PICTURE_BUS_SIZE - 1;
+
+		if ((db.pictureWatch[address] & DB_WATCH_WRITE) && (db.hit.kind == DB_HIT_NONE))
+		{
+			DB_hit__record(db, DB_HIT_PICTURE_WRITE, address, data);
+		}
+	}
+
+	bool hasScanlineBreakpoints()
+	{
+		DB_state_t &db = DB_state;
+
+		return (!db.scanlineBreakpoints.empty());
+	}
+
+	uint16_t getScanlineBreak(uint16_t scanline, uint16_t dot)
+	{
+		DB_state_t &db = DB_state;
+
+		std::vector<uint32_t>::const_iterator next = std::lower_bound(db.scanlineBreakpoints.begin(), db.scanlineBreakpoints.end(), ((uint32_t)scanline << 16) | dot);
+
+		if (next == db.scanlineBreakpoints.end() || (*next >> 16) != scanline)
+		{
+			return (DB_DOT_NONE);
+		}
+
+		return ((uint16_t)*next);
+	}
+
+	void scanline(uint16_t scanline, uint16_t dot)
+	{
+		DB_state_t &db = DB_state;
+
+		if ((getScanlineBreak(scanline, dot) == dot) && (db.hit.kind == DB_HIT_NONE))
+		{
+			DB_hit__record(db, DB_HIT_SCANLINE, 0x0000, 0x00);
+
+			db.hit.scanline = scanline; // the PPU has not run the dot yet
+			db.hit.dot = dot;
+			db.hit.frame = PPU::getFrameCount();
+		}
+	}
+
+	void clean()
+	{
+		delete (DB_state_t*)CC_console->debuggerData;
+		CC_console->debuggerData = nullptr;
+	}
+}
+
+inline void DB_hit__record(DB_state_t &db, uint8_t kind, uint16_t address, uint8_t data)
+{
+	db.hit.kind = kind;
+	db.hit.address = address;
+	db.hit.data = data;
+	db.hit.instruction = db.instruction;
+	db.hit.scanline = 0; // filled in by DB::getHit, the PPU is behind the CPU while it runs
+	db.hit.dot = 0;
+	db.hit.frame = 0;
+}
+
+inline void DB_watch__set(uint8_t *watch, uint32_t address, uint8_t flags)
+{
+	watch[address] |= flags;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ConsoleContext.h"
+
+#include <cstdint>
+
+#define DB_WATCH_EXECUTE (0x01u) // main bus breakpoints, any combination
+#define DB_WATCH_READ (0x02u)
+#define DB_WATCH_WRITE (0x04u)
+
+#define DB_HIT_NONE (0u)
+#define DB_HIT_EXECUTE (1u) // stopped before the instruction
+#define DB_HIT_READ (2u) // stopped after the instruction that made the access
+#define DB_HIT_WRITE (3u)
+#define DB_HIT_PICTURE_READ (4u) // through PPUDATA
+#define DB_HIT_PICTURE_WRITE (5u)
+#define DB_HIT_SCANLINE (6u) // stopped right after the PPU ran the dot
+
+#define DB_DOT_LAST (340u) // dots are counted from 1, the idle dot 0 is run with the last one of the scanline before
+#define DB_DOT_NONE (0xFFFFu)
+
+typedef struct
+{
+	uint8_t kind;
+	uint16_t address; // of the access, or of the instruction for DB_HIT_EXECUTE
+	uint8_t data; // written ... reads are stopped before the value is known
+	uint16_t instruction; // address of the instruction being executed
+	uint16_t scanline; // where the PPU was ... at the start of the instruction for the main bus hits
+	uint16_t dot;
+	uint32_t frame;
+}DB_hit_t;
+
+/* Breakpoints on the main and PPU buses and on the PPU scanlines of the selected console ... CPU::run only uses its instrumented core while DB is initialized, so the normal one does not look at them */
+namespace DB
+{
+	void init(); // after the console was reset
+	void addBreakpoint(uint16_t first, uint16_t last, uint8_t watch); // mirrors of RAM and of the PPU registers included
+	void addPictureBreakpoint(uint16_t first, uint16_t last, uint8_t watch); // DB_WATCH_READ and DB_WATCH_WRITE, for the accesses the CPU makes through PPUDATA
+	bool addScanlineBreakpoint(uint16_t scanline, uint16_t dot); // as PPU::getScanline counts them ... false if the dot does not exist
+	void clearBreakpoints();
+	bool isStopped(); // MC::run and MC::runFrame return early once a breakpoint was hit
+	DB_hit_t getHit();
+	void resume(); // an instruction stopped before is executed without stopping again
+	bool execute(uint16_t address); // by the instrumented core, before each instruction ... true if it has to stop before it
+	void read(CPU_state_t &cpu, uint16_t address); // by the instrumented core, before each access ... the run is left after the instruction on a hit
+	void write(CPU_state_t &cpu, uint16_t address, uint8_t data);
+	void readPicture(uint16_t address, uint8_t data); // by the PPU, for PPUDATA
+	void writePicture(uint16_t address, uint8_t data);
+	bool hasScanlineBreakpoints();
+	uint16_t getScanlineBreak(uint16_t scanline, uint16_t dot); // first breakpoint on the scanline from the dot on, DB_DOT_NONE if there is none
+	void scanline(uint16_t scanline, uint16_t dot); // by the PPU, before it runs a dot it may have to stop after
+	void clean(); // must be called before destroying the console
+}
\ No newline at end of file
@@ -0,0 +1,891 @@
+#include "DynamicRecompiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DR__HOST_SUPPORTED (true)
+#else
+#define DR__HOST_SUPPORTED (false)
+#endif
+
+#define DR__CODE_SIZE (0x100000u) // per console ... thrown away and filled again when full
+#define DR__CODE_ALIGNMENT (16u)
+#define DR__MAXIMUM_BLOCK_CODE (0x1000u) // more than a block of the longest instructions needs
+#define DR__HOT_THRESHOLD (16u) // executions before a block is recompiled
+
+#define DR__FLAG_NEGATIVE (0x80u)
+#define DR__FLAG_OVERFLOW (0x40u)
+#define DR__FLAG_BREAK (0x10u)
+#define DR__FLAG_DECIMAL (0x08u)
+#define DR__FLAG_ZERO (0x02u)
+#define DR__FLAG_CARRY (0x01u)
+
+#define DR__ADDRESSING_ACCUMULATOR (0u)
+#define DR__ADDRESSING_IMMEDIATE (1u)
+#define DR__ADDRESSING_ZEROPAGE (2u)
+#define DR__ADDRESSING_ZEROPAGE_X (3u)
+#define DR__ADDRESSING_ZEROPAGE_Y (4u)
+#define DR__ADDRESSING_ABSOLUTE (5u)
+#define DR__ADDRESSING_ABSOLUTE_X (6u)
+#define DR__ADDRESSING_ABSOLUTE_Y (7u)
+
+/* 8 bit host registers ... rdi holds the CPU state, rsi the RAM, r9 the flag table, r8d the cycles used and r10d the cycle limit */
+#define DR__REGISTER_AL (0u)
+#define DR__REGISTER_CL (1u)
+#define DR__REGISTER_DL (2u)
+#define DR__REGISTER_AH (4u)
+
+#define DR__offset(field) ((uint8_t)offsetof(CPU_state_t, field))
+
+typedef uint32_t(*DR_function_t)(CPU_state_t *cpu, uint8_t *RAM, const uint8_t *flags_NZ, uint32_t cycle_limit); // returns the instructions executed, leaves the cycles they took in cyclesToSkip
+
+typedef struct
+{
+	uint8_t *start;
+	uint8_t *position;
+	uint8_t *exitJumps[2 * CPU_BLOCK_MAXIMUM_LENGTH + 1]; // to the epilogue
+	uint32_t exitJumpCount;
+	uint8_t *limitJumps[CPU_BLOCK_MAXIMUM_LENGTH]; // to the exit taken when the cycle limit is reached before an instruction
+	uint16_t limitAddresses[CPU_BLOCK_MAXIMUM_LENGTH];
+	uint32_t limitJumpCount;
+}DR_emitter_t;
+
+inline uint8_t* DR_code__allocate(std::size_t size);
+inline void DR_code__free(uint8_t *code, std::size_t size);
+inline void DR_code__flush();
+inline uint8_t* DR_compile__block(const CPU_block_t &block, uint16_t address);
+inline bool DR_compile__instruction(DR_emitter_t &emitter, const CPU_instruction_t &instruction, uint16_t address, uint32_t executed, bool &ends_block);
+inline bool DR_compile__address(DR_emitter_t &emitter, uint8_t addressing, uint16_t operand, bool page_penalty);
+inline bool DR_compile__operand(DR_emitter_t &emitter, uint8_t addressing, uint16_t operand);
+inline void DR_compile__exit(DR_emitter_t &emitter, uint16_t address, uint32_t executed);
+
+/* x86-64 encodings */
+inline void DR_x86__bytes(DR_emitter_t &emitter, std::initializer_list<uint8_t> bytes);
+inline void DR_x86__32(DR_emitter_t &emitter, uint32_t value);
+inline void DR_x86__patch(uint8_t *jump, uint8_t *target);
+inline void DR_x86__loadField(DR_emitter_t &emitter, uint8_t host_register, uint8_t field);
+inline void DR_x86__storeField(DR_emitter_t &emitter, uint8_t host_register, uint8_t field);
+inline void DR_x86__loadRAM(DR_emitter_t &emitter, uint8_t host_register);
+inline void DR_x86__storeRAM(DR_emitter_t &emitter, uint8_t host_register);
+inline void DR_x86__setFlagsNZ(DR_emitter_t &emitter, uint8_t host_register);
+inline void DR_x86__setFlagZ(DR_emitter_t &emitter, uint8_t host_register);
+inline void DR_x86__pushAddress(DR_emitter_t &emitter);
+
+namespace DR
+{
+	bool init(uint8_t mode)
+	{
+		DR_state_t &dr = CC_console->dr;
+
+		clean();
+
+		if (mode == DR_MODE_OFF || !DR__HOST_SUPPORTED)
+		{
+			return (mode == DR_MODE_OFF);
+		}
+
+		dr.code = DR_code__allocate(DR__CODE_SIZE);
+		if (!dr.code)
+		{
+			return (false);
+		}
+
+		dr.codeSize = DR__CODE_SIZE;
+		dr.codeUsed = 0;
+
+		for (uint32_t value = 0; value < 256; ++value)
+		{
+			dr.flagsNZ[value] = (uint8_t)((value ? 0 : DR__FLAG_ZERO) | (value & DR__FLAG_NEGATIVE));
+		}
+
+		dr.mismatchCount = 0;
+		dr.firstMismatchAddress = 0;
+
+		DR_code__flush(); // blocks decoded before were counted by nobody
+
+		dr.mode = mode;
+
+		return (true);
+	}
+
+	uint8_t getMode()
+	{
+		DR_state_t &dr = CC_console->dr;
+
+		return (dr.mode);
+	}
+
+	uint32_t execute(CPU_state_t &cpu, CPU_block_t &block, uint32_t cycle_limit)
+	{
+		DR_state_t &dr = CC_console->dr;
+
+		if (cpu.registerPC != block.address)
+		{ // the native code exits and branches to the addresses of the window the block was decoded in
+			return (0);
+		}
+
+		if (!block.recompiled)
+		{
+			if (block.executions >= DR__HOT_THRESHOLD)
+			{ // tried already, its first instruction can not be recompiled
+				return (0);
+			}
+
+			if (++block.executions < DR__HOT_THRESHOLD)
+			{
+				return (0);
+			}
+
+			block.recompiled = DR_compile__block(block, cpu.registerPC);
+			if (!block.recompiled)
+			{
+				return (0);
+			}
+		}
+
+		uint8_t *RAM = CC_console->mb.RAM;
+
+		if (dr.mode != DR_MODE_COMPARE)
+		{
+			return (((DR_function_t)block.recompiled)(&cpu, RAM, dr.flagsNZ, cycle_limit));
+		}
+
+		/* The console goes on from the state before the block ... the interpreter executes it again and DR::verify compares the two */
+		CPU_state_t before = cpu;
+		memcpy(dr.expectedRAM, RAM, sizeof(dr.expectedRAM));
+
+		uint32_t executed = ((DR_function_t)block.recompiled)(&cpu, RAM, dr.flagsNZ, cycle_limit);
+
+		std::swap_ranges(RAM, RAM + sizeof(dr.expectedRAM), dr.expectedRAM);
+
+		dr.expectedCPU = cpu;
+		dr.expectedCycles = cpu.cyclesToSkip;
+		dr.comparedBlock = before.registerPC;
+
+		cpu = before;
+
+		return (executed);
+	}
+
+	void verify(const CPU_state_t &cpu, uint32_t cycles)
+	{
+		DR_state_t &dr = CC_console->dr;
+
+		bool matching = (cpu.registerPC == dr.expectedCPU.registerPC) && (cpu.registerSP == dr.expectedCPU.registerSP) && (cpu.registerA == dr.expectedCPU.registerA)
+			&& (cpu.registerX == dr.expectedCPU.registerX) && (cpu.registerY == dr.expectedCPU.registerY) && (cpu.flags == dr.expectedCPU.flags)
+			&& (cycles == dr.expectedCycles) && (memcmp(CC_console->mb.RAM, dr.expectedRAM, sizeof(dr.expectedRAM)) == 0);
+
+		if (!matching)
+		{
+			if (dr.mismatchCount == 0)
+			{
+				dr.firstMismatchAddress = dr.comparedBlock;
+			}
+
+			++dr.mismatchCount;
+		}
+	}
+
+	uint32_t getMismatchCount()
+	{
+		DR_state_t &dr = CC_console->dr;
+
+		return (dr.mismatchCount);
+	}
+
+	uint16_t getFirstMismatchAddress()
+	{
+		DR_state_t &dr = CC_console->dr;
+
+		return (dr.firstMismatchAddress);
+	}
+
+	void clean()
+	{
+		DR_state_t &dr = CC_console->dr;
+
+		if (dr.code)
+		{
+			DR_code__flush();
+			DR_code__free(dr.code, dr.codeSize);
+		}
+
+		dr.code = nullptr;
+		dr.codeSize = 0;
+		dr.codeUsed = 0;
+		dr.mode = DR_MODE_OFF;
+	}
+}
+
+inline uint8_t* DR_code__allocate(std::size_t size)
+{
+#ifdef _WIN32
+	return ((uint8_t*)VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
+#else
+	void *code = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	return ((code == MAP_FAILED) ? nullptr : (uint8_t*)code);
+#endif
+}
+
+inline void DR_code__free(uint8_t *code, std::size_t size)
+{
+#ifdef _WIN32
+	VirtualFree(code, 0, MEM_RELEASE);
+#else
+	munmap(code, size);
+#endif
+}
+
+/* Every block goes back to being interpreted and counted */
+inline void DR_code__flush()
+{
+	DR_state_t &dr = CC_console->dr;
+
+	for (uint32_t i = 0; i < CPU_BLOCK_CACHE_SIZE; ++i)
+	{
+		CC_console->blockCache[i].executions = 0;
+		CC_console->blockCache[i].recompiled = nullptr;
+	}
+
+	dr.codeUsed = 0;
+}
+
+/* Recompiles the instructions of the block up to the first one that can not be ... nullptr if that is the first one */
+inline uint8_t* DR_compile__block(const CPU_block_t &block, uint16_t address)
+{
+	DR_state_t &dr = CC_console->dr;
+
+	uint8_t buffer[DR__MAXIMUM_BLOCK_CODE];
+
+	DR_emitter_t emitter;
+	emitter.start = buffer;
+	emitter.position = buffer;
+	emitter.exitJumpCount = 0;
+	emitter.limitJumpCount = 0;
+
+#ifdef _WIN32
+	DR_x86__bytes(emitter, { 0x57, 0x56 }); // push rdi, push rsi
+	DR_x86__bytes(emitter, { 0x48, 0x89, 0xCF, 0x48, 0x89, 0xD6 }); // mov rdi, rcx / mov rsi, rdx
+	DR_x86__bytes(emitter, { 0x45, 0x89, 0xCA, 0x4D, 0x89, 0xC1 }); // mov r10d, r9d / mov r9, r8
+#else
+	DR_x86__bytes(emitter, { 0x49, 0x89, 0xD1, 0x41, 0x89, 0xCA }); // mov r9, rdx / mov r10d, ecx
+#endif
+	DR_x86__bytes(emitter, { 0x45, 0x31, 0xC0 }); // xor r8d, r8d
+
+	uint32_t count = 0;
+	bool endsBlock = false;
+
+	for (; count < block.length && !endsBlock; ++count)
+	{
+		const CPU_instruction_t &instruction = block.instructions[count];
+
+		uint8_t *start = emitter.position;
+		uint32_t exitJumpCount = emitter.exitJumpCount;
+
+		if (count > 0)
+		{ // the interpreter would start it only if the cycles used so far still fit
+			DR_x86__bytes(emitter, { 0x45, 0x39, 0xD0, 0x0F, 0x87 }); // cmp r8d, r10d / ja
+			emitter.limitJumps[emitter.limitJumpCount] = emitter.position;
+			emitter.limitAddresses[emitter.limitJumpCount] = address;
+			++emitter.limitJumpCount;
+			DR_x86__32(emitter, 0);
+		}
+
+		DR_x86__bytes(emitter, { 0x41, 0x83, 0xC0, instruction.duration }); // add r8d, duration
+
+		if (!DR_compile__instruction(emitter, instruction, address, count + 1, endsBlock))
+		{
+			emitter.position = start;
+			emitter.exitJumpCount = exitJumpCount;
+			emitter.limitJumpCount -= (count > 0) ? 1 : 0;
+
+			break;
+		}
+
+		address += instruction.length;
+	}
+
+	if (count == 0)
+	{
+		return (nullptr);
+	}
+
+	if (!endsBlock)
+	{
+		DR_compile__exit(emitter, address, count);
+	}
+
+	for (uint32_t i = 0; i < emitter.limitJumpCount; ++i)
+	{ // the instruction at the limit is left to the interpreter, which counts its cycles
+		DR_x86__patch(emitter.limitJumps[i], emitter.position);
+		DR_compile__exit(emitter, emitter.limitAddresses[i], i + 1);
+	}
+
+	for (uint32_t i = 0; i < emitter.exitJumpCount; ++i)
+	{
+		DR_x86__patch(emitter.exitJumps[i], emitter.position);
+	}
+
+	DR_x86__bytes(emitter, { 0x66, 0x44, 0x89, 0x47, DR__offset(cyclesToSkip) }); // mov [cyclesToSkip], r8w
+#ifdef _WIN32
+	DR_x86__bytes(emitter, { 0x5E, 0x5F }); // pop rsi, pop rdi
+#endif
+	DR_x86__bytes(emitter, { 0xC3 }); // ret
+
+	std::size_t size = emitter.position - emitter.start;
+	std::size_t alignedSize = (size + DR__CODE_ALIGNMENT - 1) & ~(std::size_t)(DR__CODE_ALIGNMENT - 1);
+
+	if (dr.codeUsed + alignedSize > dr.codeSize)
+	{
+		DR_code__flush();
+	}
+
+	uint8_t *code = dr.code + dr.codeUsed;
+	memcpy(code, buffer, size); // the jumps are relative, so the code can be moved
+	dr.codeUsed += alignedSize;
+
+	return (code);
+}
+
+/* Emits one instruction, as the interpreter executes it ... false, with nothing emitted, if it may touch anything but the registers and RAM or change the interrupt flag */
+inline bool DR_compile__instruction(DR_emitter_t &emitter, const CPU_instruction_t &instruction, uint16_t address, uint32_t executed, bool &ends_block)
+{
+	uint16_t operand = instruction.operand;
+	uint16_t next = address + instruction.length;
+
+	uint8_t addressing = DR__ADDRESSING_ACCUMULATOR;
+	switch (instruction.opcode & 0x1F)
+	{ // the addressing mode of the ALU, load, store and shift instructions is in the low bits of the opcode
+		case 0x00: case 0x02: case 0x09: addressing = DR__ADDRESSING_IMMEDIATE; break;
+		case 0x04: case 0x05: case 0x06: addressing = DR__ADDRESSING_ZEROPAGE; break;
+		case 0x14: case 0x15: case 0x16: addressing = ((instruction.opcode & 0xC2) == 0x82) ? DR__ADDRESSING_ZEROPAGE_Y : DR__ADDRESSING_ZEROPAGE_X; break; // STX, LDX
+		case 0x0C: case 0x0D: case 0x0E: addressing = DR__ADDRESSING_ABSOLUTE; break;
+		case 0x1C: case 0x1D: case 0x1E: addressing = ((instruction.opcode & 0xC2) == 0x82) ? DR__ADDRESSING_ABSOLUTE_Y : DR__ADDRESSING_ABSOLUTE_X; break;
+		case 0x19: addressing = DR__ADDRESSING_ABSOLUTE_Y; break;
+	}
+
+	uint8_t registerField = DR__offset(registerA);
+	switch (instruction.opcode)
+	{
+		case 0xA2: case 0xA6: case 0xB6: case 0xAE: case 0xBE: // LDX
+		case 0x86: case 0x96: case 0x8E: // STX
+		case 0xE0: case 0xE4: case 0xEC: // CPX
+		{
+			registerField = DR__offset(registerX);
+
+			break;
+		}
+
+		case 0xA0: case 0xA4: case 0xB4: case 0xAC: case 0xBC: // LDY
+		case 0x84: case 0x94: case 0x8C: // STY
+		case 0xC0: case 0xC4: case 0xCC: // CPY
+		{
+			registerField = DR__offset(registerY);
+
+			break;
+		}
+	}
+
+	switch (instruction.opcode)
+	{
+		case 0xA9: case 0xA5: case 0xB5: case 0xAD: case 0xBD: case 0xB9: // LDA
+		case 0xA2: case 0xA6: case 0xB6: case 0xAE: case 0xBE: // LDX
+		case 0xA0: case 0xA4: case 0xB4: case 0xAC: case 0xBC: // LDY
+		{
+			if (!DR_compile__operand(emitter, addressing, operand))
+			{
+				return (false);
+			}
+
+			DR_x86__storeField(emitter, DR__REGISTER_CL, registerField);
+			DR_x86__setFlagsNZ(emitter, DR__REGISTER_CL);
+
+			return (true);
+		}
+
+		case 0x85: case 0x95: case 0x8D: case 0x9D: case 0x99: // STA ... indexed by absolute addresses without the page crossing cycle
+		case 0x86: case 0x96: case 0x8E: // STX
+		case 0x84: case 0x94: case 0x8C: // STY
+		{
+			if (!DR_compile__address(emitter, addressing, operand, false))
+			{
+				return (false);
+			}
+
+			DR_x86__loadField(emitter, DR__REGISTER_AL, registerField);
+			DR_x86__storeRAM(emitter, DR__REGISTER_AL);
+
+			return (true);
+		}
+
+		case 0xAA: case 0xA8: case 0x8A: case 0x98: case 0xBA: case 0x9A: // TAX, TAY, TXA, TYA, TSX, TXS
+		{
+			uint8_t source = DR__offset(registerA);
+			uint8_t destination = DR__offset(registerA);
+
+			switch (instruction.opcode)
+			{
+				case 0xAA: destination = DR__offset(registerX); break;
+				case 0xA8: destination = DR__offset(registerY); break;
+				case 0x8A: source = DR__offset(registerX); break;
+				case 0x98: source = DR__offset(registerY); break;
+				case 0xBA: source = DR__offset(registerSP); destination = DR__offset(registerX); break;
+				case 0x9A: source = DR__offset(registerX); destination = DR__offset(registerSP); break;
+			}
+
+			DR_x86__loadField(emitter, DR__REGISTER_AL, source);
+			DR_x86__storeField(emitter, DR__REGISTER_AL, destination);
+
+			if (instruction.opcode != 0x9A)
+			{ // TXS leaves the flags alone
+				DR_x86__setFlagsNZ(emitter, DR__REGISTER_AL);
+			}
+
+			return (true);
+		}
+
+		case 0xE8: case 0xC8: case 0xCA: case 0x88: // INX, INY, DEX, DEY
+		{
+			uint8_t field = (instruction.opcode == 0xE8 || instruction.opcode == 0xCA) ? DR__offset(registerX) : DR__offset(registerY);
+			uint8_t delta = (instruction.opcode == 0xE8 || instruction.opcode == 0xC8) ? 0x01 : 0xFF;
+
+			DR_x86__bytes(emitter, { 0x80, 0x47, field, delta }); // add byte [field], delta
+			DR_x86__loadField(emitter, DR__REGISTER_AL, field);
+			DR_x86__setFlagsNZ(emitter, DR__REGISTER_AL);
+
+			return (true);
+		}
+
+		case 0x18: case 0xD8: case 0xB8: // CLC, CLD, CLV
+		{
+			uint8_t flag = (instruction.opcode == 0x18) ? DR__FLAG_CARRY : ((instruction.opcode == 0xD8) ? DR__FLAG_DECIMAL : DR__FLAG_OVERFLOW);
+
+			DR_x86__bytes(emitter, { 0x80, 0x67, DR__offset(flags), (uint8_t)~flag }); // and byte [flags], ~flag
+
+			return (true);
+		}
+
+		case 0x38: case 0xF8: // SEC, SED
+		{
+			uint8_t flag = (instruction.opcode == 0x38) ? DR__FLAG_CARRY : DR__FLAG_DECIMAL;
+
+			DR_x86__bytes(emitter, { 0x80, 0x4F, DR__offset(flags), flag }); // or byte [flags], flag
+
+			return (true);
+		}
+
+		case 0xEA: case 0xEB: // NOP, and the unofficial SBC executed as one
+		{
+			return (true);
+		}
+
+		case 0x09: case 0x05: case 0x15: case 0x0D: case 0x1D: case 0x19: // ORA
+		case 0x29: case 0x25: case 0x35: case 0x2D: case 0x3D: case 0x39: // AND
+		case 0x49: case 0x45: case 0x55: case 0x4D: case 0x5D: case 0x59: // EOR
+		{
+			if (!DR_compile__operand(emitter, addressing, operand))
+			{
+				return (false);
+			}
+
+			uint8_t operation = (instruction.opcode < 0x20) ? 0x08 : ((instruction.opcode < 0x40) ? 0x20 : 0x30); // or, and, xor
+
+			DR_x86__loadField(emitter, DR__REGISTER_AL, DR__offset(registerA));
+			DR_x86__bytes(emitter, { operation, 0xC8 }); // op al, cl
+			DR_x86__storeField(emitter, DR__REGISTER_AL, DR__offset(registerA));
+			DR_x86__setFlagsNZ(emitter, DR__REGISTER_AL);
+
+			return (true);
+		}
+
+		case 0x69: case 0x65: case 0x75: case 0x6D: case 0x7D: case 0x79: // ADC
+		case 0xE9: case 0xE5: case 0xF5: case 0xED: case 0xFD: case 0xF9: // SBC ... x86 borrows where the 6502 does not carry
+		{
+			if (!DR_compile__operand(emitter, addressing, operand))
+			{
+				return (false);
+			}
+
+			bool subtract = (instruction.opcode >= 0xE0);
+
+			DR_x86__loadField(emitter, DR__REGISTER_AL, DR__offset(registerA));
+			DR_x86__loadField(emitter, DR__REGISTER_AH, DR__offset(flags));
+			DR_x86__bytes(emitter, { 0xD0, 0xEC }); // shr ah, 1 ... carry into CF
+
+			if (subtract)
+			{
+				DR_x86__bytes(emitter, { 0xF5, 0x18, 0xC8, 0x0F, 0x93, 0xC2 }); // cmc / sbb al, cl / setnc dl
+			}
+			else
+			{
+				DR_x86__bytes(emitter, { 0x10, 0xC8, 0x0F, 0x92, 0xC2 }); // adc al, cl / setc dl
+			}
+
+			DR_x86__bytes(emitter, { 0x0F, 0x90, 0xC6 }); // seto dh
+			DR_x86__storeField(emitter, DR__REGISTER_AL, DR__offset(registerA));
+			DR_x86__bytes(emitter, { 0x80, 0x67, DR__offset(flags), (uint8_t)~(DR__FLAG_CARRY | DR__FLAG_OVERFLOW) });
+			DR_x86__bytes(emitter, { 0xC0, 0xE6, 0x06, 0x08, 0xF2 }); // shl dh, 6 / or dl, dh
+			DR_x86__bytes(emitter, { 0x08, 0x57, DR__offset(flags) }); // or [flags], dl
+			DR_x86__setFlagsNZ(emitter, DR__REGISTER_AL);
+
+			return (true);
+		}
+
+		case 0xC9: case 0xC5: case 0xD5: case 0xCD: case 0xDD: case 0xD9: // CMP
+		case 0xE0: case 0xE4: case 0xEC: // CPX
+		case 0xC0: case 0xC4: case 0xCC: // CPY
+		{
+			if (!DR_compile__operand(emitter, addressing, operand))
+			{
+				return (false);
+			}
+
+			DR_x86__loadField(emitter, DR__REGISTER_AL, registerField);
+			DR_x86__bytes(emitter, { 0x38, 0xC8, 0x0F, 0x93, 0xC2, 0x28, 0xC8 }); // cmp al, cl / setnc dl / sub al, cl
+			DR_x86__bytes(emitter, { 0x80, 0x67, DR__offset(flags), (uint8_t)~DR__FLAG_CARRY });
+			DR_x86__bytes(emitter, { 0x08, 0x57, DR__offset(flags) }); // or [flags], dl
+			DR_x86__setFlagsNZ(emitter, DR__REGISTER_AL);
+
+			return (true);
+		}
+
+		case 0x24: case 0x2C: // BIT
+		{
+			if (!DR_compile__operand(emitter, addressing, operand))
+			{
+				return (false);
+			}
+
+			DR_x86__bytes(emitter, { 0x80, 0x67, DR__offset(flags), (uint8_t)~(DR__FLAG_NEGATIVE | DR__FLAG_OVERFLOW) });
+			DR_x86__bytes(emitter, { 0x88, 0xC8, 0x24, 0xC0 }); // mov al, cl / and al, 0xC0
+			DR_x86__bytes(emitter, { 0x08, 0x47, DR__offset(flags) }); // or [flags], al
+			DR_x86__loadField(emitter, DR__REGISTER_AL, DR__offset(registerA));
+			DR_x86__bytes(emitter, { 0x20, 0xC8 }); // and al, cl
+			DR_x86__setFlagZ(emitter, DR__REGISTER_AL);
+
+			return (true);
+		}
+
+		case 0xE6: case 0xF6: case 0xEE: case 0xFE: // INC
+		case 0xC6: case 0xD6: case 0xCE: case 0xDE: // DEC
+		{
+			if (!DR_compile__address(emitter, addressing, operand, true))
+			{
+				return (false);
+			}
+
+			DR_x86__bytes(emitter, { 0x80, 0x04, 0x16, (uint8_t)((instruction.opcode >= 0xE0) ? 0x01 : 0xFF) }); // add byte [rsi + rdx], delta
+			DR_x86__loadRAM(emitter, DR__REGISTER_AL);
+			DR_x86__setFlagsNZ(emitter, DR__REGISTER_AL);
+
+			return (true);
+		}
+
+		case 0x0A: case 0x06: case 0x16: case 0x0E: case 0x1E: // ASL
+		case 0x2A: case 0x26: case 0x36: case 0x2E: case 0x3E: // ROL
+		case 0x4A: case 0x46: case 0x56: case 0x4E: case 0x5E: // LSR
+		case 0x6A: case 0x66: case 0x76: case 0x6E: case 0x7E: // ROR
+		{
+			bool accumulator = ((instruction.opcode & 0x1F) == 0x0A);
+			uint8_t operation = instruction.opcode & 0xE0;
+
+			if (accumulator)
+			{
+				DR_x86__loadField(emitter, DR__REGISTER_CL, DR__offset(registerA));
+			}
+			else if (DR_compile__address(emitter, addressing, operand, true))
+			{ // abs,X takes the page crossing cycle here too
+				DR_x86__loadRAM(emitter, DR__REGISTER_CL);
+			}
+			else
+			{
+				return (false);
+			}
+
+			if (operation == 0x20 || operation == 0x60)
+			{ // rotations go through the carry
+				DR_x86__loadField(emitter, DR__REGISTER_AH, DR__offset(flags));
+				DR_x86__bytes(emitter, { 0xD0, 0xEC }); // shr ah, 1
+			}
+
+			switch (operation)
+			{
+				case 0x00: DR_x86__bytes(emitter, { 0xD0, 0xE1 }); break; // shl cl, 1
+				case 0x20: DR_x86__bytes(emitter, { 0xD0, 0xD1 }); break; // rcl cl, 1
+				case 0x40: DR_x86__bytes(emitter, { 0xD0, 0xE9 }); break; // shr cl, 1
+				case 0x60: DR_x86__bytes(emitter, { 0xD0, 0xD9 }); break; // rcr cl, 1
+			}
+
+			DR_x86__bytes(emitter, { 0x0F, 0x92, 0xC4 }); // setc ah
+
+			if (accumulator)
+			{
+				DR_x86__storeField(emitter, DR__REGISTER_CL, DR__offset(registerA));
+			}
+			else
+			{
+				DR_x86__storeRAM(emitter, DR__REGISTER_CL);
+			}
+
+			DR_x86__bytes(emitter, { 0x80, 0x67, DR__offset(flags), (uint8_t)~DR__FLAG_CARRY });
+			DR_x86__bytes(emitter, { 0x08, 0x67, DR__offset(flags) }); // or [flags], ah
+
+			if (operation == 0x40)
+			{ // LSR has always left the negative flag alone here
+				DR_x86__setFlagZ(emitter, DR__REGISTER_CL);
+			}
+			else
+			{
+				DR_x86__setFlagsNZ(emitter, DR__REGISTER_CL);
+			}
+
+			return (true);
+		}
+
+		case 0x48: case 0x08: // PHA, PHP
+		{
+			DR_x86__pushAddress(emitter);
+
+			if (instruction.opcode == 0x48)
+			{
+				DR_x86__loadField(emitter, DR__REGISTER_AL, DR__offset(registerA));
+			}
+			else
+			{
+				DR_x86__loadField(emitter, DR__REGISTER_AL, DR__offset(flags));
+				DR_x86__bytes(emitter, { 0x0C, DR__FLAG_BREAK }); // or al, break
+			}
+
+			DR_x86__storeRAM(emitter, DR__REGISTER_AL);
+			DR_x86__bytes(emitter, { 0xFE, 0x4F, DR__offset(registerSP) }); // dec byte [SP]
+
+			return (true);
+		}
+
+		case 0x68: // PLA
+		{
+			DR_x86__bytes(emitter, { 0xFE, 0x47, DR__offset(registerSP) }); // inc byte [SP]
+			DR_x86__pushAddress(emitter);
+			DR_x86__loadRAM(emitter, DR__REGISTER_AL);
+			DR_x86__storeField(emitter, DR__REGISTER_AL, DR__offset(registerA));
+			DR_x86__setFlagsNZ(emitter, DR__REGISTER_AL);
+
+			return (true);
+		}
+
+		case 0x10: case 0x30: case 0x50: case 0x70: case 0x90: case 0xB0: case 0xD0: case 0xF0: // branches
+		{
+			static constexpr uint8_t flags[] = { DR__FLAG_NEGATIVE, DR__FLAG_OVERFLOW, DR__FLAG_CARRY, DR__FLAG_ZERO };
+			uint8_t flag = flags[instruction.opcode >> 6];
+			bool set = (instruction.opcode & 0x20) != 0;
+
+			uint16_t target = next + (int8_t)operand;
+			uint8_t takenCycles = ((next & 0xFF00) != (target & 0xFF00)) ? 3 : 1;
+
+			DR_x86__bytes(emitter, { 0xF6, 0x47, DR__offset(flags), flag, 0x0F, (uint8_t)(set ? 0x84 : 0x85) }); // test byte [flags], flag / jz or jnz
+			uint8_t *notTaken = emitter.position;
+			DR_x86__32(emitter, 0);
+
+			DR_x86__bytes(emitter, { 0x41, 0x83, 0xC0, takenCycles }); // add r8d, cycles
+			DR_compile__exit(emitter, target, executed);
+
+			DR_x86__patch(notTaken, emitter.position);
+			DR_compile__exit(emitter, next, executed);
+
+			ends_block = true;
+
+			return (true);
+		}
+
+		case 0x4C: // JMP
+		{
+			DR_compile__exit(emitter, operand, executed);
+
+			ends_block = true;
+
+			return (true);
+		}
+
+		default:
+		{ // I/O, interrupts, the stack through JSR, RTS and RTI, indirect addressing and the invalid opcodes are left to the interpreter
+			return (false);
+		}
+	}
+}
+
+/* Leaves the address in rdx, as an offset in RAM ... false if it is not always in RAM */
+inline bool DR_compile__address(DR_emitter_t &emitter, uint8_t addressing, uint16_t operand, bool page_penalty)
+{
+	switch (addressing)
+	{
+		case DR__ADDRESSING_ZEROPAGE:
+		{
+			DR_x86__bytes(emitter, { 0xBA }); // mov edx, address
+			DR_x86__32(emitter, operand & 0xFF);
+
+			return (true);
+		}
+
+		case DR__ADDRESSING_ZEROPAGE_X:
+		case DR__ADDRESSING_ZEROPAGE_Y:
+		{
+			uint8_t index = (addressing == DR__ADDRESSING_ZEROPAGE_X) ? DR__offset(registerX) : DR__offset(registerY);
+
+			DR_x86__bytes(emitter, { 0x0F, 0xB6, 0x57, index, 0x80, 0xC2, (uint8_t)operand }); // movzx edx, byte [index] / add dl, address ... stays in page 0
+
+			return (true);
+		}
+
+		case DR__ADDRESSING_ABSOLUTE:
+		{
+			if (operand >= 0x2000)
+			{
+				return (false);
+			}
+
+			DR_x86__bytes(emitter, { 0xBA }); // mov edx, address
+			DR_x86__32(emitter, operand & 0x07FF);
+
+			return (true);
+		}
+
+		case DR__ADDRESSING_ABSOLUTE_X:
+		case DR__ADDRESSING_ABSOLUTE_Y:
+		{
+			if (operand + 0xFF >= 0x2000)
+			{
+				return (false);
+			}
+
+			uint8_t index = (addressing == DR__ADDRESSING_ABSOLUTE_X) ? DR__offset(registerX) : DR__offset(registerY);
+
+			DR_x86__bytes(emitter, { 0x0F, 0xB6, 0x57, index, 0x81, 0xC2 }); // movzx edx, byte [index] / add edx, address
+			DR_x86__32(emitter, operand);
+
+			if (page_penalty)
+			{
+				DR_x86__bytes(emitter, { 0x81, 0xFA }); // cmp edx, last address of the page
+				DR_x86__32(emitter, operand | 0xFF);
+				DR_x86__bytes(emitter, { 0x76, 0x03, 0x41, 0xFF, 0xC0 }); // jbe over / inc r8d
+			}
+
+			DR_x86__bytes(emitter, { 0x81, 0xE2 }); // and edx, mirror
+			DR_x86__32(emitter, 0x07FF);
+
+			return (true);
+		}
+
+		default:
+		{
+			return (false);
+		}
+	}
+}
+
+/* Leaves the operand in cl */
+inline bool DR_compile__operand(DR_emitter_t &emitter, uint8_t addressing, uint16_t operand)
+{
+	if (addressing == DR__ADDRESSING_IMMEDIATE)
+	{
+		DR_x86__bytes(emitter, { 0xB1, (uint8_t)operand }); // mov cl, operand
+
+		return (true);
+	}
+
+	if (!DR_compile__address(emitter, addressing, operand, true))
+	{
+		return (false);
+	}
+
+	DR_x86__loadRAM(emitter, DR__REGISTER_CL);
+
+	return (true);
+}
+
+/* Returns to the interpreter with PC at the given address */
+inline void DR_compile__exit(DR_emitter_t &emitter, uint16_t address, uint32_t executed)
+{
+	DR_x86__bytes(emitter, { 0x66, 0xC7, 0x47, DR__offset(registerPC), (uint8_t)address, (uint8_t)(address >> 8) }); // mov word [PC], address
+	DR_x86__bytes(emitter, { 0xB8 }); // mov eax, executed
+	DR_x86__32(emitter, executed);
+	DR_x86__bytes(emitter, { 0xE9 }); // jmp epilogue
+
+	emitter.exitJumps[emitter.exitJumpCount++] = emitter.position;
+	DR_x86__32(emitter, 0);
+}
+
+inline void DR_x86__bytes(DR_emitter_t &emitter, std::initializer_list<uint8_t> bytes)
+{
+	for (std::initializer_list<uint8_t>::const_iterator byte = bytes.begin(); byte != bytes.end(); ++byte)
+	{
+		*emitter.position++ = *byte;
+	}
+}
+
+inline void DR_x86__32(DR_emitter_t &emitter, uint32_t value)
+{
+	DR_x86__bytes(emitter, { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) });
+}
+
+/* Points the 32 bit displacement of a jump at the target */
+inline void DR_x86__patch(uint8_t *jump, uint8_t *target)
+{
+	int32_t displacement = (int32_t)(target - (jump + 4));
+
+	memcpy(jump, &displacement, 4);
+}
+
+inline void DR_x86__loadField(DR_emitter_t &emitter, uint8_t host_register, uint8_t field)
+{
+	DR_x86__bytes(emitter, { 0x8A, (uint8_t)(0x47 | (host_register << 3)), field }); // mov r8, [rdi + field]
+}
+
+inline void DR_x86__storeField(DR_emitter_t &emitter, uint8_t host_register, uint8_t field)
+{
+	DR_x86__bytes(emitter, { 0x88, (uint8_t)(0x47 | (host_register << 3)), field }); // mov [rdi + field], r8
+}
+
+inline void DR_x86__loadRAM(DR_emitter_t &emitter, uint8_t host_register)
+{
+	DR_x86__bytes(emitter, { 0x8A, (uint8_t)(0x04 | (host_register << 3)), 0x16 }); // mov r8, [rsi + rdx]
+}
+
+inline void DR_x86__storeRAM(DR_emitter_t &emitter, uint8_t host_register)
+{
+	DR_x86__bytes(emitter, { 0x88, (uint8_t)(0x04 | (host_register << 3)), 0x16 }); // mov [rsi + rdx], r8
+}
+
+/* Takes the flags from the table ... the register is lost */
+inline void DR_x86__setFlagsNZ(DR_emitter_t &emitter, uint8_t host_register)
+{
+	DR_x86__bytes(emitter, { 0x0F, 0xB6, (uint8_t)(0xC0 | (host_register << 3) | host_register) }); // movzx e?x, r8
+	DR_x86__bytes(emitter, { 0x41, 0x8A, (uint8_t)(0x04 | (host_register << 3)), (uint8_t)(0x01 | (host_register << 3)) }); // mov r8, [r9 + r?x]
+	DR_x86__bytes(emitter, { 0x80, 0x67, DR__offset(flags), (uint8_t)~(DR__FLAG_NEGATIVE | DR__FLAG_ZERO) });
+	DR_x86__bytes(emitter, { 0x08, (uint8_t)(0x47 | (host_register << 3)), DR__offset(flags) }); // or [flags], r8
+}
+
+/* Only the zero flag ... al is lost */
+inline void DR_x86__setFlagZ(DR_emitter_t &emitter, uint8_t host_register)
+{
+	DR_x86__bytes(emitter, { 0x80, 0x67, DR__offset(flags), (uint8_t)~DR__FLAG_ZERO });
+	DR_x86__bytes(emitter, { 0x84, (uint8_t)(0xC0 | (host_register << 3) | host_register) }); // test r8, r8
+	DR_x86__bytes(emitter, { 0x0F, 0x94, 0xC0, 0xD0, 0xE0 }); // setz al / shl al, 1
+	DR_x86__bytes(emitter, { 0x08, 0x47, DR__offset(flags) }); // or [flags], al
+}
+
+/* rdx = the RAM offset SP points to */
+inline void DR_x86__pushAddress(DR_emitter_t &emitter)
+{
+	DR_x86__bytes(emitter, { 0x0F, 0xB6, 0x57, DR__offset(registerSP), 0x81, 0xC2 }); // movzx edx, byte [SP] / add edx, stack page
+	DR_x86__32(emitter, 0x0100);
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ConsoleContext.h"
+
+#include <cstdint>
+
+#define DR_MODE_OFF (0u)
+#define DR_MODE_ON (1u)
+#define DR_MODE_COMPARE (2u) // every recompiled block is executed again by the interpreter, which is the one kept
+
+/* Translates the blocks of the selected console that run often into x86-64 code ... only blocks that touch nothing but the CPU registers and RAM, the rest stays interpreted */
+namespace DR
+{
+	bool init(uint8_t mode); // false if the host is not x86-64 or has no memory to execute from ... the console then stays interpreted
+	uint8_t getMode();
+	uint32_t execute(CPU_state_t &cpu, CPU_block_t &block, uint32_t cycle_limit); // PC has to be at the start of the block ... returns how many of its instructions were executed, 0 if it is not recompiled (yet) or PC reached it through another window than the one it was decoded in
+	void verify(const CPU_state_t &cpu, uint32_t cycles); // compare mode, after the interpreter executed the same instructions again
+	uint32_t getMismatchCount();
+	uint16_t getFirstMismatchAddress(); // start of the first block that did not match
+	void clean(); // must be called before destroying the console
+}
\ No newline at end of file
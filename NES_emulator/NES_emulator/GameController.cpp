@@ -1,5 +1,7 @@
 #include "GameController.h"
 
+#include "InputMovie.h"
+
 #include <SFML/Window.hpp>
 
 #define GC__BUTTON_A (0u)
@@ -32,6 +34,8 @@
 static sf::Keyboard::Key GC_controller1Keys[8];
 static sf::Keyboard::Key GC_controller2Keys[8];
 static uint8_t GC_strobe = 0;
+static uint8_t GC_latchedController1 = 0; // buttons at the last strobe, as recorded or replayed by IM
+static uint8_t GC_latchedController2 = 0;
 static uint8_t GC_buttonStatesController1 = 0;
 static uint8_t GC_buttonStatesController2 = 0;
 
@@ -62,16 +66,22 @@ namespace GC
 	void strobe(uint8_t s)
 	{
 		GC_strobe = s & 1;
+
+		GC_latchedController1 = 0;
+		GC_latchedController2 = 0;
+
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			GC_latchedController1 |= (sf::Keyboard::isKeyPressed(GC_controller1Keys[i])) << i;
+			GC_latchedController2 |= (sf::Keyboard::isKeyPressed(GC_controller2Keys[i])) << i;
+		}
+
+		IM::latch(GC_latchedController1, GC_latchedController2);
+
 		if (!GC_strobe)
 		{
-			GC_buttonStatesController1 = 0;
-			GC_buttonStatesController2 = 0;
-
-			for (std::size_t i = 0; i < 8; ++i)
-			{
-				GC_buttonStatesController1 |= (sf::Keyboard::isKeyPressed(GC_controller1Keys[i])) << i;
-				GC_buttonStatesController2 |= (sf::Keyboard::isKeyPressed(GC_controller2Keys[i])) << i;
-			}
+			GC_buttonStatesController1 = GC_latchedController1;
+			GC_buttonStatesController2 = GC_latchedController2;
 		}
 	}
 
@@ -79,7 +89,7 @@ namespace GC
 	{
 		if (GC_strobe)
 		{
-			return ((uint8_t)sf::Keyboard::isKeyPressed(GC_controller1Keys[GC__BUTTON_A]) | 0x40); // return the state of key A
+			return ((GC_latchedController1 & 0x01) | 0x40); // return the state of key A
 		}
 		else
 		{
@@ -94,7 +104,7 @@ namespace GC
 	{
 		if (GC_strobe)
 		{
-			return ((uint8_t)sf::Keyboard::isKeyPressed(GC_controller2Keys[GC__BUTTON_A]) | 0x40); // return the state of key A
+			return ((GC_latchedController2 & 0x01) | 0x40); // return the state of key A
 		}
 		else
 		{
@@ -0,0 +1,231 @@
+#include "Headless.h"
+
+#include "AudioDevice.h"
+#include "ConsoleContext.h"
+#include "GameController.h"
+#include "InputMovie.h"
+#include "RenderingWindow.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+typedef struct
+{
+	uint32_t frame;
+	uint8_t controller1;
+	uint8_t controller2;
+}HL_input_t;
+
+typedef struct
+{
+	uint32_t frameBuffer[HL_SCREEN_WIDTH * HL_SCREEN_HEIGHT];
+
+	std::vector<HL_input_t> inputScript;
+	std::size_t inputPosition;
+	uint8_t controller1;
+	uint8_t controller2;
+
+	uint8_t strobe;
+	uint8_t latchedController1; // scripted buttons at the last strobe, or the ones replayed by IM
+	uint8_t latchedController2;
+	uint8_t buttonStatesController1;
+	uint8_t buttonStatesController2;
+}HL_state_t;
+
+#define HL_state (*(HL_state_t*)CC_console->frontendData)
+
+namespace HL
+{
+	void init()
+	{
+		CC_console->frontendData = new HL_state_t();
+	}
+
+	uint8_t loadInput(std::string file_name)
+	{
+		std::ifstream file(file_name);
+		if (!file.is_open())
+		{
+			return (STATUS_HL_LOAD_FILE_PROTECTED_OR_NONEXISTENT);
+		}
+
+		HL_state.inputScript.clear();
+		HL_state.inputPosition = 0;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#')
+			{ // comments are allowed
+				continue;
+			}
+
+			std::istringstream fields(line);
+			uint32_t frame, controller1, controller2 = 0;
+
+			fields >> std::dec >> frame >> std::hex >> controller1;
+			if (fields.fail())
+			{
+				return (STATUS_HL_LOAD_WRONG_FILE_FORMAT);
+			}
+
+			fields >> controller2; // the second controller is optional
+
+			if (!HL_state.inputScript.empty() && HL_state.inputScript.back().frame > frame)
+			{ // entries have to be in frame order
+				return (STATUS_HL_LOAD_WRONG_FILE_FORMAT);
+			}
+
+			HL_input_t input;
+			input.frame = frame;
+			input.controller1 = (uint8_t)controller1;
+			input.controller2 = (uint8_t)controller2;
+
+			HL_state.inputScript.push_back(input);
+		}
+
+		return (STATUS_HL_LOAD_SUCCESS);
+	}
+
+	void setFrame(uint32_t frame)
+	{
+		if (HL_state.inputPosition > 0 && HL_state.inputScript[HL_state.inputPosition - 1].frame > frame)
+		{ // going back in time, after a state was loaded
+			HL_state.inputPosition = 0;
+			HL_state.controller1 = 0;
+			HL_state.controller2 = 0;
+		}
+
+		while (HL_state.inputPosition < HL_state.inputScript.size() && HL_state.inputScript[HL_state.inputPosition].frame <= frame)
+		{ // the buttons keep their state until the next entry
+			HL_state.controller1 = HL_state.inputScript[HL_state.inputPosition].controller1;
+			HL_state.controller2 = HL_state.inputScript[HL_state.inputPosition].controller2;
+
+			++HL_state.inputPosition;
+		}
+	}
+
+	const uint32_t* getFrameBuffer()
+	{
+		return (HL_state.frameBuffer);
+	}
+
+	void clean()
+	{
+		delete (HL_state_t*)CC_console->frontendData;
+		CC_console->frontendData = nullptr;
+	}
+}
+
+/* Null video sink */
+namespace RW
+{
+	void init()
+	{
+	}
+
+	void setPixel(std::size_t x_coordinate, std::size_t y_coordinate, uint32_t color)
+	{
+		if (x_coordinate < HL_SCREEN_WIDTH && y_coordinate < HL_SCREEN_HEIGHT)
+		{
+			HL_state.frameBuffer[y_coordinate * HL_SCREEN_WIDTH + x_coordinate] = color;
+		}
+	}
+
+	uint8_t pollWindowEvent()
+	{
+		return (EVENT_NONE);
+	}
+
+	void redraw(bool)
+	{
+	}
+
+	void dispose()
+	{
+	}
+}
+
+/* Null audio sink ... the emulation runs uncapped */
+namespace AD
+{
+	void init()
+	{
+	}
+
+	void queueSample(uint16_t)
+	{
+	}
+
+	void setDecimation(uint8_t)
+	{
+	}
+
+	bool bufferFull()
+	{
+		return (false);
+	}
+
+	void dispose()
+	{
+	}
+}
+
+/* Scripted controllers */
+namespace GC
+{
+	void init()
+	{
+		HL_state.strobe = 0;
+		HL_state.latchedController1 = 0;
+		HL_state.latchedController2 = 0;
+		HL_state.buttonStatesController1 = 0;
+		HL_state.buttonStatesController2 = 0;
+	}
+
+	void strobe(uint8_t s)
+	{
+		HL_state.strobe = s & 1;
+
+		HL_state.latchedController1 = HL_state.controller1;
+		HL_state.latchedController2 = HL_state.controller2;
+		IM::latch(HL_state.latchedController1, HL_state.latchedController2);
+
+		if (!HL_state.strobe)
+		{
+			HL_state.buttonStatesController1 = HL_state.latchedController1;
+			HL_state.buttonStatesController2 = HL_state.latchedController2;
+		}
+	}
+
+	uint8_t readController1()
+	{
+		if (HL_state.strobe)
+		{
+			return ((HL_state.latchedController1 & 0x01) | 0x40); // return the state of key A
+		}
+		else
+		{
+			uint8_t toReturn = (HL_state.buttonStatesController1 & 0x01) | 0x40;
+			HL_state.buttonStatesController1 >>= 1;
+
+			return (toReturn);
+		}
+	}
+
+	uint8_t readController2()
+	{
+		if (HL_state.strobe)
+		{
+			return ((HL_state.latchedController2 & 0x01) | 0x40); // return the state of key A
+		}
+		else
+		{
+			uint8_t toReturn = (HL_state.buttonStatesController2 & 0x01) | 0x40;
+			HL_state.buttonStatesController2 >>= 1;
+
+			return (toReturn);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#define STATUS_HL_LOAD_SUCCESS (0x00u)
+#define STATUS_HL_LOAD_FILE_PROTECTED_OR_NONEXISTENT (0x01u)
+#define STATUS_HL_LOAD_WRONG_FILE_FORMAT (0x02u)
+
+#define HL_SCREEN_WIDTH (256u)
+#define HL_SCREEN_HEIGHT (240u)
+
+/* Stand-in for the window, audio device and controllers on machines with no display or sound card ... every console gets its own */
+namespace HL
+{
+	void init(); // for the selected console, before anything else
+	uint8_t loadInput(std::string file_name); // one "<frame> <controller 1> <controller 2>" line per change, button states in hex (bit 0 = A, B, Select, Start, Up, Down, Left, bit 7 = Right)
+	void setFrame(uint32_t frame); // applies the scripted input for the given frame ... may go back after a state was loaded
+	const uint32_t* getFrameBuffer(); // HL_SCREEN_WIDTH x HL_SCREEN_HEIGHT, row by row
+	void clean();
+}
\ No newline at end of file
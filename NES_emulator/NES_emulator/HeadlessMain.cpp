@@ -0,0 +1,339 @@
+#include "AudioDevice.h"
+#include "AudioProcessingUnit.h"
+#include "CartridgeReader.h"
+#include "CentralProcessingUnit.h"
+#include "ConsoleContext.h"
+#include "Debugger.h"
+#include "GameController.h"
+#include "Headless.h"
+#include "InputMovie.h"
+#include "MasterClock.h"
+#include "MemoryBus.h"
+#include "MemoryMapper.h"
+#include "PictureProcessingUnit.h"
+#include "Profiler.h"
+#include "RenderingWindow.h"
+#include "Tracer.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#define RAM_SIZE (0x800u)
+#define PROFILE_OPTION ("--profile=")
+#define TRACE_OPTION ("--trace=")
+#define BREAK_OPTION ("--break=") // "<r, w and x>:<address>[-<address>]", "ppu:<r and w>:<address>[-<address>]" or "scanline:<scanline>:<dot>" ... hexadecimal addresses
+
+/* 64 bit FNV-1a */
+inline uint64_t hash(const void *data, std::size_t size)
+{
+	const uint8_t *bytes = (const uint8_t*)data;
+	uint64_t value = 0xCBF29CE484222325ull;
+
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		value ^= bytes[i];
+		value *= 0x00000100000001B3ull;
+	}
+
+	return (value);
+}
+
+/* Hands a breakpoint given on the command line to DB ... false if it does not make sense */
+inline bool addBreakpoint(const std::string &breakpoint)
+{
+	unsigned int scanline = 0;
+	unsigned int dot = 0;
+	if (sscanf(breakpoint.c_str(), "scanline:%u:%u", &scanline, &dot) == 2)
+	{
+		return ((scanline <= 0xFFFFu) && (dot <= 0xFFFFu) && DB::addScanlineBreakpoint((uint16_t)scanline, (uint16_t)dot));
+	}
+
+	bool picture = (breakpoint.compare(0, 4, "ppu:") == 0);
+	std::string rest = picture ? breakpoint.substr(4) : breakpoint;
+
+	std::size_t colon = rest.find(':');
+	if (colon == std::string::npos || colon == 0)
+	{
+		return (false);
+	}
+
+	uint8_t watch = 0;
+	for (std::size_t i = 0; i < colon; ++i)
+	{
+		switch (rest[i])
+		{
+			case 'r': watch |= DB_WATCH_READ; break;
+			case 'w': watch |= DB_WATCH_WRITE; break;
+			case 'x': if (picture) return (false); watch |= DB_WATCH_EXECUTE; break;
+			default: return (false);
+		}
+	}
+
+	unsigned int first = 0;
+	unsigned int last = 0;
+	int fields = sscanf(rest.c_str() + colon + 1, "%x-%x", &first, &last);
+	if (fields == 1)
+	{
+		last = first;
+	}
+
+	if (fields < 1 || first > last || last > 0xFFFFu)
+	{
+		return (false);
+	}
+
+	if (picture)
+	{
+		DB::addPictureBreakpoint((uint16_t)first, (uint16_t)last, watch);
+	}
+	else
+	{
+		DB::addBreakpoint((uint16_t)first, (uint16_t)last, watch);
+	}
+
+	return (true);
+}
+
+inline void reportBreak(const DB_hit_t &hit)
+{
+	static const char *kinds[] = { "", "execute", "read", "write", "PPU read", "PPU write", "scanline" };
+	const CPU_state_t &cpu = CC_console->cpu;
+
+	fprintf(stderr, "Break on %s", kinds[hit.kind]);
+
+	if (hit.kind == DB_HIT_WRITE || hit.kind == DB_HIT_PICTURE_WRITE)
+	{
+		fprintf(stderr, " $%04" PRIX16 " = $%02" PRIX8, hit.address, hit.data);
+	}
+	else if (hit.kind != DB_HIT_SCANLINE)
+	{
+		fprintf(stderr, " $%04" PRIX16, hit.address);
+	}
+
+	fprintf(stderr, " in frame %" PRIu32 " at scanline %" PRIu16 " dot %" PRIu16 ", instruction $%04" PRIX16 " ... PC:%04" PRIX16 " A:%02" PRIX8 " X:%02" PRIX8 " Y:%02" PRIX8 " SP:%02" PRIX8 "\n",
+		hit.frame, hit.scanline, hit.dot, hit.instruction, cpu.registerPC, cpu.registerA, cpu.registerX, cpu.registerY, cpu.registerSP);
+}
+
+int main(int argc, char** argv)
+{
+	std::string profile; // where the profiler report and folded stacks go, without their extension ... empty when not profiling
+	std::string trace; // instruction trace file, empty when not tracing
+	std::vector<std::string> breakpoints; // reported on the standard error as they are hit, then the run goes on
+
+	while (argc > 1)
+	{ // options come after the other arguments, in any order
+		std::string option = argv[argc - 1];
+
+		if (option.compare(0, strlen(PROFILE_OPTION), PROFILE_OPTION) == 0)
+		{
+			profile = option.substr(strlen(PROFILE_OPTION));
+		}
+		else if (option.compare(0, strlen(TRACE_OPTION), TRACE_OPTION) == 0)
+		{
+			trace = option.substr(strlen(TRACE_OPTION));
+		}
+		else if (option.compare(0, strlen(BREAK_OPTION), BREAK_OPTION) == 0)
+		{
+			breakpoints.push_back(option.substr(strlen(BREAK_OPTION)));
+		}
+		else
+		{
+			break;
+		}
+
+		--argc;
+	}
+
+	if (argc < 3 || argc > 5)
+	{
+		std::cout << "Usage: " << argv[0] << " <ROM file> <frame count> [input file or movie] [movie to record] [" << PROFILE_OPTION << "<output prefix>] [" << TRACE_OPTION << "<trace file>] [" << BREAK_OPTION << "<breakpoint>]..." << std::endl;
+
+		return (1);
+	}
+
+	CC_console_t *console = CC::create();
+	CC::select(console);
+
+	HL::init();
+
+	std::string path = argv[1];
+	uint8_t code = CR::loadFile(path);
+	if (code)
+	{
+		std::cout << "Error loading ROM file. Code: " << (int)code << std::endl;
+
+		return (1);
+	}
+
+	uint32_t frameCount = (uint32_t)strtoul(argv[2], nullptr, 10);
+
+	MM::init();
+	if (!MM::setMapper(CR::getMapperType()))
+	{
+		std::cout << "Mapper " << (int)CR::getMapperType() << " not supported" << std::endl;
+
+		return (1);
+	}
+
+	MB::init();
+	if (!MB::loadMapperInformation())
+	{
+		std::cout << "An error accured while loading mapper info" << std::endl;
+
+		return (1);
+	}
+
+	RW::init();
+	GC::init();
+	AD::init();
+
+	APU::reset();
+	CPU::reset();
+	PPU::reset();
+
+	MC::reset();
+
+	if (!profile.empty())
+	{
+		PF::init();
+	}
+
+	if (!trace.empty())
+	{
+		code = TR::start(trace);
+		if (code)
+		{
+			std::cout << "Error creating trace file. Code: " << (int)code << std::endl;
+
+			return (1);
+		}
+	}
+
+	if (!breakpoints.empty())
+	{
+		DB::init();
+
+		for (std::size_t i = 0; i < breakpoints.size(); ++i)
+		{
+			if (!addBreakpoint(breakpoints[i]))
+			{
+				std::cout << "Invalid breakpoint: " << breakpoints[i] << std::endl;
+
+				return (1);
+			}
+		}
+	}
+
+	if (argc >= 4)
+	{
+		code = IM::startPlayback(argv[3]);
+		if (code == STATUS_IM_WRONG_FILE_FORMAT)
+		{ // not a movie ... scripted input
+			code = HL::loadInput(argv[3]);
+		}
+
+		if (code)
+		{
+			std::cout << "Error loading input file. Code: " << (int)code << std::endl;
+
+			return (1);
+		}
+	}
+
+	if (argc == 5)
+	{
+		IM::startRecording();
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		HL::setFrame(frame);
+
+		uint32_t frameStart = PPU::getFrameCount();
+		MC::runFrame();
+
+		while (!breakpoints.empty() && DB::isStopped())
+		{ // the frame is finished after the report, unless the breakpoint was hit right at its end
+			reportBreak(DB::getHit());
+			DB::resume();
+
+			if (PPU::getFrameCount() == frameStart)
+			{
+				MC::runFrame();
+			}
+		}
+
+		uint8_t ram[RAM_SIZE];
+		for (uint16_t address = 0; address < RAM_SIZE; ++address)
+		{
+			ram[address] = MB::readMainBus(address);
+		}
+
+		printf("%" PRIu32 " %016" PRIx64 " %016" PRIx64 "\n", frame, hash(HL::getFrameBuffer(), HL_SCREEN_WIDTH * HL_SCREEN_HEIGHT * sizeof(uint32_t)), hash(ram, RAM_SIZE));
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	fprintf(stderr, "%" PRIu32 " frames in %.3f s, %.1f FPS\n", frameCount, elapsed.count(), elapsed.count() > 0.0 ? frameCount / elapsed.count() : 0.0);
+
+	int exitCode = 0;
+
+	if (!IM::inSync())
+	{
+		fprintf(stderr, "Movie out of sync from frame %" PRIu32 "\n", IM::getDesyncFrame());
+		exitCode = 2;
+	}
+
+	if (argc == 5)
+	{
+		code = IM::stopRecording(argv[4]);
+		if (code)
+		{
+			std::cout << "Error saving movie. Code: " << (int)code << std::endl;
+			exitCode = 1;
+		}
+	}
+
+	if (!trace.empty())
+	{
+		code = TR::stop();
+		if (code)
+		{
+			std::cout << "Error writing trace file. Code: " << (int)code << std::endl;
+			exitCode = 1;
+		}
+	}
+
+	if (!profile.empty())
+	{
+		if ((code = PF::writeReport(profile + ".txt")) || (code = PF::writeFoldedStacks(profile + ".folded")))
+		{
+			std::cout << "Error saving profile. Code: " << (int)code << std::endl;
+			exitCode = 1;
+		}
+
+		PF::clean();
+	}
+
+	DB::clean();
+	IM::clean();
+
+	RW::dispose();
+	AD::dispose();
+
+	CR::clean();
+	MB::clean();
+	MM::clean();
+	HL::clean();
+
+	CC::destroy(console);
+
+	return (exitCode);
+}
\ No newline at end of file
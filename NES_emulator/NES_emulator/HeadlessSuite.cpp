@@ -0,0 +1,524 @@
+#include "AudioDevice.h"
+#include "AudioProcessingUnit.h"
+#include "CartridgeReader.h"
+#include "CentralProcessingUnit.h"
+#include "ConsoleContext.h"
+#include "DynamicRecompiler.h"
+#include "GameController.h"
+#include "Headless.h"
+#include "InputMovie.h"
+#include "MasterClock.h"
+#include "MemoryBus.h"
+#include "MemoryMapper.h"
+#include "PictureProcessingUnit.h"
+#include "RenderingWindow.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#define RAM_SIZE (0x800u)
+
+#define ROM_EXTENSION ".nes"
+#define MOVIE_EXTENSION ".nesm" // same name as the one recorded by the emulator
+#define INPUT_EXTENSION ".input" // scripted input, as read by HL::loadInput
+#define GOLDEN_EXTENSION ".golden" // same lines as printed by NES_headless
+
+#define RESULT_PASSED (0u)
+#define RESULT_NEW_GOLDEN (1u) // written by this run
+#define RESULT_NO_GOLDEN (2u)
+#define RESULT_FRAME_MISMATCH (3u)
+#define RESULT_RAM_MISMATCH (4u)
+#define RESULT_DESYNC (5u) // the movie did not replay as recorded
+#define RESULT_ERROR (6u) // ROM, mapper or input could not be loaded
+#define RESULT_RECOMPILER_MISMATCH (7u) // compare mode ... a recompiled block did not do what the interpreter did
+
+typedef struct
+{
+	uint64_t frameHash;
+	uint64_t ramHash;
+}frame_hashes_t;
+
+typedef struct
+{
+	std::string path;
+	std::string name;
+	uint8_t mapper;
+	uint8_t result;
+	uint32_t mismatchFrame;
+	uint16_t mismatchAddress;
+	double seconds; // emulation only, loading and comparing are not counted
+	std::string message;
+}game_t;
+
+/* 64 bit FNV-1a */
+inline uint64_t hash(const void *data, std::size_t size)
+{
+	const uint8_t *bytes = (const uint8_t*)data;
+	uint64_t value = 0xCBF29CE484222325ull;
+
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		value ^= bytes[i];
+		value *= 0x00000100000001B3ull;
+	}
+
+	return (value);
+}
+
+inline bool endsWith(const std::string &text, const std::string &suffix)
+{
+	return (text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+inline bool fileExists(const std::string &file_name)
+{
+	std::ifstream file(file_name);
+
+	return (file.is_open());
+}
+
+inline std::vector<std::string> listROMs(const std::string &directory)
+{
+	std::vector<std::string> names;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA entry;
+	HANDLE search = FindFirstFileA((directory + "\\*" ROM_EXTENSION).c_str(), &entry);
+	if (search != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			names.push_back(entry.cFileName);
+		} while (FindNextFileA(search, &entry));
+
+		FindClose(search);
+	}
+#else
+	DIR *folder = opendir(directory.c_str());
+	if (folder)
+	{
+		while (dirent *entry = readdir(folder))
+		{
+			std::string name = entry->d_name;
+			if (endsWith(name, ROM_EXTENSION))
+			{
+				names.push_back(name);
+			}
+		}
+
+		closedir(folder);
+	}
+#endif
+
+	std::sort(names.begin(), names.end());
+
+	return (names);
+}
+
+inline std::string mapperName(uint8_t mapper)
+{
+	switch (mapper)
+	{
+		case 0:
+			return ("NROM");
+
+		case 1:
+			return ("MMC1");
+
+		case 2:
+			return ("UxROM");
+
+		case 3:
+			return ("CNROM");
+
+		case 4:
+			return ("MMC3");
+
+		default:
+			return ("mapper " + std::to_string(mapper));
+	}
+}
+
+/* Golden files are the output of NES_headless ... one "<frame> <frame buffer hash> <RAM hash>" line per frame */
+inline bool readGolden(const std::string &file_name, std::vector<frame_hashes_t> &hashes)
+{
+	std::ifstream file(file_name);
+	if (!file.is_open())
+	{
+		return (false);
+	}
+
+	hashes.clear();
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+
+		uint32_t frame;
+		frame_hashes_t frameHashes;
+
+		if (fields >> std::dec >> frame >> std::hex >> frameHashes.frameHash >> frameHashes.ramHash)
+		{
+			hashes.push_back(frameHashes);
+		}
+	}
+
+	return (true);
+}
+
+inline bool writeGolden(const std::string &file_name, const std::vector<frame_hashes_t> &hashes)
+{
+	FILE *file = fopen(file_name.c_str(), "w");
+	if (!file)
+	{
+		return (false);
+	}
+
+	for (uint32_t frame = 0; frame < hashes.size(); ++frame)
+	{
+		fprintf(file, "%" PRIu32 " %016" PRIx64 " %016" PRIx64 "\n", frame, hashes[frame].frameHash, hashes[frame].ramHash);
+	}
+
+	return (fclose(file) == 0);
+}
+
+/* Loads the ROM into the selected console and resets it, the same way NES_headless does ... returns what went wrong, if anything */
+inline std::string powerOn(const std::string &rom_file)
+{
+	uint8_t code = CR::loadFile(rom_file);
+	if (code)
+	{
+		return ("error loading ROM file, code " + std::to_string(code));
+	}
+
+	MM::init();
+	if (!MM::setMapper(CR::getMapperType()))
+	{
+		return ("mapper " + std::to_string(CR::getMapperType()) + " not supported");
+	}
+
+	MB::init();
+	if (!MB::loadMapperInformation())
+	{
+		return ("error loading mapper info");
+	}
+
+	RW::init();
+	GC::init();
+	AD::init();
+
+	APU::reset();
+	CPU::reset();
+	PPU::reset();
+
+	MC::reset();
+
+	return ("");
+}
+
+/* Runs one game on its own console, selected on the calling thread */
+inline void runGame(game_t &game, uint32_t frame_count, bool update_golden, uint8_t recompiler_mode)
+{
+	CC_console_t *console = CC::create();
+	CC::select(console);
+
+	HL::init();
+
+	std::vector<frame_hashes_t> hashes;
+	bool movie = false; // the game is replayed from a movie, so it can go out of sync
+
+	game.message = powerOn(game.path);
+	bool loaded = game.message.empty();
+
+	if (loaded)
+	{
+		game.mapper = CR::getMapperType();
+
+		if (!DR::init(recompiler_mode))
+		{
+			game.message = "the recompiler can not run on this machine";
+			loaded = false;
+		}
+
+		uint8_t code = 0;
+		if (fileExists(game.path + MOVIE_EXTENSION))
+		{
+			code = IM::startPlayback(game.path + MOVIE_EXTENSION);
+			movie = (code == STATUS_IM_SUCCESS);
+		}
+		else if (fileExists(game.path + INPUT_EXTENSION))
+		{
+			code = HL::loadInput(game.path + INPUT_EXTENSION);
+		}
+
+		if (code)
+		{
+			game.message = "error loading input, code " + std::to_string(code);
+			loaded = false;
+		}
+	}
+
+	if (loaded)
+	{
+		hashes.resize(frame_count);
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t frame = 0; frame < frame_count; ++frame)
+		{
+			HL::setFrame(frame);
+			MC::runFrame();
+
+			uint8_t ram[RAM_SIZE];
+			for (uint16_t address = 0; address < RAM_SIZE; ++address)
+			{
+				ram[address] = MB::readMainBus(address);
+			}
+
+			hashes[frame].frameHash = hash(HL::getFrameBuffer(), HL_SCREEN_WIDTH * HL_SCREEN_HEIGHT * sizeof(uint32_t));
+			hashes[frame].ramHash = hash(ram, RAM_SIZE);
+		}
+
+		std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+		game.seconds = elapsed.count();
+	}
+
+	if (!loaded)
+	{
+		game.result = RESULT_ERROR;
+	}
+	else if (movie && !IM::inSync())
+	{
+		game.result = RESULT_DESYNC;
+		game.mismatchFrame = IM::getDesyncFrame();
+	}
+	else if (DR::getMismatchCount())
+	{
+		game.result = RESULT_RECOMPILER_MISMATCH;
+		game.mismatchAddress = DR::getFirstMismatchAddress();
+	}
+	else if (update_golden)
+	{
+		game.result = RESULT_NEW_GOLDEN;
+
+		if (!writeGolden(game.path + GOLDEN_EXTENSION, hashes))
+		{
+			game.result = RESULT_ERROR;
+			game.message = "error writing golden file";
+		}
+	}
+	else
+	{
+		std::vector<frame_hashes_t> golden;
+
+		if (!readGolden(game.path + GOLDEN_EXTENSION, golden))
+		{
+			game.result = RESULT_NO_GOLDEN;
+		}
+		else
+		{
+			game.result = RESULT_PASSED;
+
+			for (uint32_t frame = 0; frame < frame_count; ++frame)
+			{
+				if (frame >= golden.size() || golden[frame].frameHash != hashes[frame].frameHash)
+				{ // a short golden file counts as a mismatch, the run has to be recorded again
+					game.result = RESULT_FRAME_MISMATCH;
+					game.mismatchFrame = frame;
+
+					break;
+				}
+				else if (golden[frame].ramHash != hashes[frame].ramHash)
+				{
+					game.result = RESULT_RAM_MISMATCH;
+					game.mismatchFrame = frame;
+
+					break;
+				}
+			}
+		}
+	}
+
+	IM::clean();
+	DR::clean();
+
+	RW::dispose();
+	AD::dispose();
+
+	CR::clean();
+	MB::clean();
+	MM::clean();
+	HL::clean();
+
+	CC::destroy(console);
+}
+
+int main(int argc, char** argv)
+{
+	std::string option = (argc == 5) ? argv[4] : "";
+
+	if (argc < 3 || argc > 5 || (argc == 5 && option != "update" && option != "recompile" && option != "compare"))
+	{
+		std::cout << "Usage: " << argv[0] << " <ROM directory> <frame count> [jobs, 0 for one per core] [update | recompile | compare]" << std::endl;
+		std::cout << "Every <game>" ROM_EXTENSION " is run with <game>" ROM_EXTENSION MOVIE_EXTENSION " or <game>" ROM_EXTENSION INPUT_EXTENSION " as input, if there is one, and compared to <game>" ROM_EXTENSION GOLDEN_EXTENSION << std::endl;
+
+		return (1);
+	}
+
+	std::string directory = argv[1];
+	uint32_t frameCount = (uint32_t)strtoul(argv[2], nullptr, 10);
+	uint32_t jobs = (argc >= 4) ? (uint32_t)strtoul(argv[3], nullptr, 10) : 0;
+	bool updateGolden = (option == "update");
+	uint8_t recompilerMode = (option == "recompile") ? DR_MODE_ON : ((option == "compare") ? DR_MODE_COMPARE : DR_MODE_OFF); // checked against the same golden files as the interpreter
+
+	if (jobs == 0)
+	{
+		jobs = std::thread::hardware_concurrency();
+		jobs = jobs ? jobs : 1;
+	}
+
+	std::vector<std::string> names = listROMs(directory);
+	if (names.empty())
+	{
+		std::cout << "No " ROM_EXTENSION " files in " << directory << std::endl;
+
+		return (1);
+	}
+
+	std::vector<game_t> games(names.size());
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		games[i].path = directory + "/" + names[i];
+		games[i].name = names[i];
+		games[i].mapper = 0;
+		games[i].result = RESULT_ERROR;
+		games[i].mismatchFrame = 0;
+		games[i].mismatchAddress = 0;
+		games[i].seconds = 0.0;
+	}
+
+	/* Every thread takes the next game in the list until none are left ... the consoles share nothing */
+	std::atomic<std::size_t> nextGame(0);
+	std::vector<std::thread> workers;
+
+	for (uint32_t job = 0; job < jobs && job < games.size(); ++job)
+	{
+		workers.push_back(std::thread([&games, &nextGame, frameCount, updateGolden, recompilerMode]()
+		{
+			for (std::size_t game = nextGame++; game < games.size(); game = nextGame++)
+			{
+				runGame(games[game], frameCount, updateGolden, recompilerMode);
+			}
+		}));
+	}
+
+	for (std::size_t job = 0; job < workers.size(); ++job)
+	{
+		workers[job].join();
+	}
+
+	/* Report */
+	std::map<uint8_t, std::pair<uint32_t, double>> mappers; // games and seconds, for frames per second of every mapper
+	uint32_t failures = 0;
+
+	std::size_t nameWidth = 4;
+	for (std::size_t i = 0; i < games.size(); ++i)
+	{
+		nameWidth = std::max(nameWidth, games[i].name.size());
+	}
+
+	printf("%-*s %-10s %10s  %s\n", (int)nameWidth, "game", "mapper", "FPS", "result");
+
+	for (std::size_t i = 0; i < games.size(); ++i)
+	{
+		game_t &game = games[i];
+
+		std::string result;
+		switch (game.result)
+		{
+			case RESULT_PASSED:
+				result = "passed";
+				break;
+
+			case RESULT_NEW_GOLDEN:
+				result = "golden written";
+				break;
+
+			case RESULT_NO_GOLDEN:
+				result = "no golden file";
+				break;
+
+			case RESULT_FRAME_MISMATCH:
+				result = "FRAME MISMATCH at frame " + std::to_string(game.mismatchFrame);
+				++failures;
+				break;
+
+			case RESULT_RAM_MISMATCH:
+				result = "RAM MISMATCH at frame " + std::to_string(game.mismatchFrame);
+				++failures;
+				break;
+
+			case RESULT_DESYNC:
+				result = "MOVIE DESYNC at frame " + std::to_string(game.mismatchFrame);
+				++failures;
+				break;
+
+			case RESULT_RECOMPILER_MISMATCH:
+			{
+				char address[8];
+				snprintf(address, sizeof(address), "$%04X", game.mismatchAddress);
+
+				result = "RECOMPILER MISMATCH at " + std::string(address);
+				++failures;
+				break;
+			}
+
+			default:
+				result = "ERROR: " + game.message;
+				++failures;
+				break;
+		}
+
+		if (game.result == RESULT_ERROR)
+		{
+			printf("%-*s %-10s %10s  %s\n", (int)nameWidth, game.name.c_str(), "-", "-", result.c_str());
+		}
+		else
+		{
+			printf("%-*s %-10s %10.1f  %s\n", (int)nameWidth, game.name.c_str(), mapperName(game.mapper).c_str(), game.seconds > 0.0 ? frameCount / game.seconds : 0.0, result.c_str());
+
+			mappers[game.mapper].first += 1;
+			mappers[game.mapper].second += game.seconds;
+		}
+	}
+
+	printf("\n%-10s %6s %10s\n", "mapper", "games", "FPS");
+
+	for (std::map<uint8_t, std::pair<uint32_t, double>>::iterator mapper = mappers.begin(); mapper != mappers.end(); ++mapper)
+	{
+		double seconds = mapper->second.second;
+		printf("%-10s %6" PRIu32 " %10.1f\n", mapperName(mapper->first).c_str(), mapper->second.first, seconds > 0.0 ? mapper->second.first * frameCount / seconds : 0.0);
+	}
+
+	printf("\n%zu games, %" PRIu32 " failed, %" PRIu32 " jobs\n", games.size(), failures, (uint32_t)workers.size());
+
+	return (failures ? 2 : 0);
+}
\ No newline at end of file
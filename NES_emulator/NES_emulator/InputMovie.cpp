@@ -0,0 +1,320 @@
+#include "InputMovie.h"
+
+#include "ConsoleContext.h"
+#include "PictureProcessingUnit.h"
+#include "SaveState.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#define IM__MAGIC (0x4D53454Eu) // "NESM"
+#define IM__VERSION (1u)
+
+#define IM__HEADER_SIZE (16u) // magic, version, reserved, state size, entry count
+#define IM__ENTRY_SIZE (14u) // frame, controller 1, controller 2, checksum
+
+#define IM__NO_FRAME (0xFFFFFFFFu)
+
+typedef struct
+{
+	uint32_t frame; // counted from the start of the movie
+	uint8_t controller1;
+	uint8_t controller2;
+	uint64_t checksum; // of the RAM, when the frame first strobed the controllers
+}IM_entry_t;
+
+typedef struct
+{
+	uint8_t mode;
+	std::vector<uint8_t> startState;
+	std::vector<IM_entry_t> entries;
+	std::size_t position; // entry being replayed
+	uint32_t latchedFrame;
+	uint32_t startFrame;
+	bool inSync;
+	uint32_t desyncFrame;
+}IM_state_t;
+
+#define IM_state (*(IM_state_t*)CC_console->movieData)
+
+inline IM_state_t& IM_state__create();
+inline uint64_t IM_RAM__checksum();
+
+namespace IM
+{
+	void startRecording()
+	{
+		IM_state_t &im = IM_state__create();
+
+		im.startState.resize(SS::getStateSize());
+		SS::saveState(im.startState.data());
+
+		im.entries.clear();
+		im.startFrame = PPU::getFrameCount();
+		im.mode = IM_MODE_RECORDING;
+	}
+
+	uint8_t stopRecording(std::string file_name)
+	{
+		if (getMode() != IM_MODE_RECORDING)
+		{
+			return (STATUS_IM_NOT_RECORDING);
+		}
+
+		IM_state_t &im = IM_state;
+
+		im.mode = IM_MODE_NONE;
+
+		std::ofstream movie(file_name, std::ios_base::out | std::ios_base::binary);
+		if (!movie)
+		{
+			return (STATUS_IM_FILE_PROTECTED_OR_NONEXISTENT);
+		}
+
+		std::vector<uint8_t> data(IM__HEADER_SIZE + im.startState.size() + im.entries.size() * IM__ENTRY_SIZE, 0);
+		uint8_t *position = data.data();
+
+		uint32_t magic = IM__MAGIC;
+		uint16_t version = IM__VERSION;
+		uint32_t stateSize = (uint32_t)im.startState.size();
+		uint32_t entryCount = (uint32_t)im.entries.size();
+
+		memcpy(position, &magic, 4);
+		memcpy(position + 4, &version, 2);
+		memcpy(position + 8, &stateSize, 4);
+		memcpy(position + 12, &entryCount, 4);
+		position += IM__HEADER_SIZE;
+
+		memcpy(position, im.startState.data(), im.startState.size());
+		position += im.startState.size();
+
+		for (std::size_t i = 0; i < im.entries.size(); ++i)
+		{
+			memcpy(position, &im.entries[i].frame, 4);
+			position[4] = im.entries[i].controller1;
+			position[5] = im.entries[i].controller2;
+			memcpy(position + 6, &im.entries[i].checksum, 8);
+			position += IM__ENTRY_SIZE;
+		}
+
+		if (!movie.write((const char*)data.data(), data.size()))
+		{
+			return (STATUS_IM_UNABLE_TO_ACCESS_FILE);
+		}
+
+		return (STATUS_IM_SUCCESS);
+	}
+
+	uint8_t startPlayback(std::string file_name)
+	{
+		std::ifstream movie(file_name, std::ios_base::in | std::ios_base::binary);
+		if (!movie)
+		{
+			return (STATUS_IM_FILE_PROTECTED_OR_NONEXISTENT);
+		}
+
+		uint8_t header[IM__HEADER_SIZE];
+		if (!movie.read((char*)header, IM__HEADER_SIZE))
+		{
+			return (STATUS_IM_WRONG_FILE_FORMAT);
+		}
+
+		uint32_t magic;
+		uint16_t version;
+		uint32_t stateSize;
+		uint32_t entryCount;
+
+		memcpy(&magic, header, 4);
+		memcpy(&version, header + 4, 2);
+		memcpy(&stateSize, header + 8, 4);
+		memcpy(&entryCount, header + 12, 4);
+
+		if (magic != IM__MAGIC || version != IM__VERSION)
+		{
+			return (STATUS_IM_WRONG_FILE_FORMAT);
+		}
+
+		if (stateSize != SS::getStateSize())
+		{
+			return (STATUS_IM_DIFFERENT_CARTRIDGE);
+		}
+
+		std::vector<uint8_t> state(stateSize);
+		std::vector<uint8_t> entries((std::size_t)entryCount * IM__ENTRY_SIZE);
+		if (!movie.read((char*)state.data(), stateSize) || !movie.read((char*)entries.data(), entries.size()))
+		{
+			return (STATUS_IM_WRONG_FILE_FORMAT);
+		}
+
+		if (SS::loadState(state.data()) != STATUS_SS_LOAD_SUCCESS)
+		{
+			return (STATUS_IM_DIFFERENT_CARTRIDGE);
+		}
+
+		IM_state_t &im = IM_state__create();
+
+		im.startState.swap(state);
+		im.entries.resize(entryCount);
+
+		const uint8_t *position = entries.data();
+		for (std::size_t i = 0; i < im.entries.size(); ++i)
+		{
+			memcpy(&im.entries[i].frame, position, 4);
+			im.entries[i].controller1 = position[4];
+			im.entries[i].controller2 = position[5];
+			memcpy(&im.entries[i].checksum, position + 6, 8);
+			position += IM__ENTRY_SIZE;
+		}
+
+		im.startFrame = PPU::getFrameCount();
+		im.mode = im.entries.empty() ? IM_MODE_NONE : IM_MODE_PLAYBACK;
+
+		return (STATUS_IM_SUCCESS);
+	}
+
+	void stopPlayback()
+	{
+		if (getMode() == IM_MODE_PLAYBACK)
+		{
+			IM_state.mode = IM_MODE_NONE;
+		}
+	}
+
+	void latch(uint8_t &controller1, uint8_t &controller2)
+	{
+		if (getMode() == IM_MODE_NONE)
+		{
+			return;
+		}
+
+		IM_state_t &im = IM_state;
+
+		uint32_t frame = PPU::getFrameCount() - im.startFrame;
+
+		if (im.mode == IM_MODE_RECORDING)
+		{
+			while (!im.entries.empty() && im.entries.back().frame > frame)
+			{ // the console went back in time (rewind, run-ahead) ... what was recorded after it is recorded again
+				im.entries.pop_back();
+			}
+
+			if (im.entries.empty() || im.entries.back().frame != frame)
+			{ // the buttons are sampled once per frame, so every strobe in it sees the same ones
+				IM_entry_t entry;
+				entry.frame = frame;
+				entry.controller1 = controller1;
+				entry.controller2 = controller2;
+				entry.checksum = IM_RAM__checksum();
+
+				im.entries.push_back(entry);
+			}
+
+			controller1 = im.entries.back().controller1;
+			controller2 = im.entries.back().controller2;
+
+			return;
+		}
+
+		if (frame != im.latchedFrame)
+		{ // first strobe of the frame ... the entries are sorted by frame and the console can also go back in time
+			im.latchedFrame = frame;
+
+			while (im.position > 0 && im.entries[im.position].frame > frame)
+			{
+				--im.position;
+			}
+
+			while (im.position < im.entries.size() && im.entries[im.position].frame < frame)
+			{
+				++im.position;
+			}
+
+			if (im.position >= im.entries.size())
+			{ // past the end of the movie
+				im.mode = IM_MODE_NONE;
+
+				return;
+			}
+
+			if (im.inSync && (im.entries[im.position].frame != frame || im.entries[im.position].checksum != IM_RAM__checksum()))
+			{ // the replay strobed in a frame the recording did not, or reached it with a different RAM
+				im.inSync = false;
+				im.desyncFrame = frame;
+			}
+		}
+
+		controller1 = im.entries[im.position].controller1;
+		controller2 = im.entries[im.position].controller2;
+	}
+
+	uint8_t getMode()
+	{
+		if (!CC_console->movieData)
+		{
+			return (IM_MODE_NONE);
+		}
+
+		return (IM_state.mode);
+	}
+
+	bool inSync()
+	{
+		if (!CC_console->movieData)
+		{
+			return (true);
+		}
+
+		return (IM_state.inSync);
+	}
+
+	uint32_t getDesyncFrame()
+	{
+		if (!CC_console->movieData)
+		{
+			return (0);
+		}
+
+		return (IM_state.desyncFrame);
+	}
+
+	void clean()
+	{
+		delete (IM_state_t*)CC_console->movieData;
+		CC_console->movieData = nullptr;
+	}
+}
+
+/* A new movie starts from a clean state ... the one of the movie before is dropped */
+inline IM_state_t& IM_state__create()
+{
+	IM::clean();
+
+	IM_state_t *im = new IM_state_t();
+	im->mode = IM_MODE_NONE;
+	im->position = 0;
+	im->latchedFrame = IM__NO_FRAME;
+	im->startFrame = 0;
+	im->inSync = true;
+	im->desyncFrame = 0;
+
+	CC_console->movieData = im;
+
+	return (*im);
+}
+
+/* 64 bit FNV-1a of the console RAM */
+inline uint64_t IM_RAM__checksum()
+{
+	MB_state_t &mb = CC_console->mb;
+
+	uint64_t value = 0xCBF29CE484222325ull;
+
+	for (std::size_t i = 0; i < sizeof(mb.RAM); ++i)
+	{
+		value ^= mb.RAM[i];
+		value *= 0x00000100000001B3ull;
+	}
+
+	return (value);
+}
\ No newline at end of file
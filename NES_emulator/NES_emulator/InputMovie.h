@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#define STATUS_IM_SUCCESS (0x00u)
+#define STATUS_IM_FILE_PROTECTED_OR_NONEXISTENT (0x01u)
+#define STATUS_IM_UNABLE_TO_ACCESS_FILE (0x02u)
+#define STATUS_IM_WRONG_FILE_FORMAT (0x04u)
+#define STATUS_IM_DIFFERENT_CARTRIDGE (0x08u)
+#define STATUS_IM_NOT_RECORDING (0x10u)
+
+#define IM_MODE_NONE (0u)
+#define IM_MODE_RECORDING (1u)
+#define IM_MODE_PLAYBACK (2u)
+
+/* Controller input of the selected console, one entry per frame in which the game strobes the controllers ... a movie starts from a saved state, one movie per console */
+namespace IM
+{
+	void startRecording(); // from the current state
+	uint8_t stopRecording(std::string file_name);
+	uint8_t startPlayback(std::string file_name); // loads the state the movie starts from
+	void stopPlayback();
+	void latch(uint8_t &controller1, uint8_t &controller2); // called by GC on every strobe ... records the buttons or replaces them with the recorded ones
+	uint8_t getMode(); // playback stops by itself after the last entry
+	bool inSync(); // false once a replayed frame did not start with the RAM of the recording
+	uint32_t getDesyncFrame(); // first frame out of sync, counted from the start of the movie
+	void clean(); // forgets the movie ... must be called before destroying the console
+}
\ No newline at end of file
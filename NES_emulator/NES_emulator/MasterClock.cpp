@@ -0,0 +1,175 @@
+#include "MasterClock.h"
+
+#include "AudioProcessingUnit.h"
+#include "CartridgeReader.h"
+#include "CentralProcessingUnit.h"
+#include "ConsoleContext.h"
+#include "Debugger.h"
+#include "PictureProcessingUnit.h"
+
+#define MC__CLOCK_DIVIDER_CPU_NTSC (12u)
+#define MC__CLOCK_DIVIDER_APU_NTSC (24u)
+#define MC__CLOCK_DIVIDER_PPU_NTSC (4u)
+
+#define MC__CLOCK_DIVIDER_CPU_PAL (16u)
+#define MC__CLOCK_DIVIDER_APU_PAL (32u)
+#define MC__CLOCK_DIVIDER_PPU_PAL (5u)
+
+inline void MC_slice__run(uint64_t target);
+inline uint64_t MC_horizon__compute(uint64_t limit);
+inline void MC_catchUp(uint64_t cycle);
+inline bool MC_debugger__stopped();
+
+namespace MC
+{
+	void reset()
+	{
+		MC_state_t &mc = CC_console->mc;
+
+		if (CR::getSystemType() == SYSTEM_NTSC)
+		{
+			mc.dividerCPU = MC__CLOCK_DIVIDER_CPU_NTSC;
+			mc.dividerAPU = MC__CLOCK_DIVIDER_APU_NTSC;
+			mc.dividerPPU = MC__CLOCK_DIVIDER_PPU_NTSC;
+		}
+		else
+		{ // PAL system
+			mc.dividerCPU = MC__CLOCK_DIVIDER_CPU_PAL;
+			mc.dividerAPU = MC__CLOCK_DIVIDER_APU_PAL;
+			mc.dividerPPU = MC__CLOCK_DIVIDER_PPU_PAL;
+		}
+
+		mc.cycle = 0;
+		mc.nextCycleCPU = mc.dividerCPU;
+		mc.nextCycleAPU = mc.dividerAPU;
+		mc.nextCyclePPU = mc.dividerPPU;
+		mc.runStartCycleCPU = 0;
+		mc.eventsChanged = false;
+	}
+
+	void run(uint64_t cycles)
+	{
+		MC_state_t &mc = CC_console->mc;
+
+		uint64_t target = mc.cycle + cycles;
+
+		while (mc.cycle < target && !MC_debugger__stopped())
+		{
+			MC_slice__run(target);
+		}
+	}
+
+	void runFrame()
+	{
+		uint32_t frame = PPU::getFrameCount();
+
+		while (PPU::getFrameCount() == frame && !MC_debugger__stopped())
+		{ // the end of the frame is one of the PPU events, so the last slice stops right on it
+			MC_slice__run(UINT64_MAX);
+		}
+	}
+
+	void synchronize()
+	{
+		MC_state_t &mc = CC_console->mc;
+
+		if (mc.runStartCycleCPU == 0)
+		{ // not called from the CPU
+			return;
+		}
+
+		uint64_t currentCycleCPU = mc.runStartCycleCPU + (uint64_t)CPU::getRunCycles() * mc.dividerCPU;
+
+		MC_catchUp(currentCycleCPU - 1); // units clocked on the same master cycle come after the CPU
+		mc.eventsChanged = true;
+	}
+}
+
+/* Runs all units up to the next event (or the target, if it comes first) */
+inline void MC_slice__run(uint64_t target)
+{
+	MC_state_t &mc = CC_console->mc;
+
+	/* Nothing the APU or PPU does before the horizon can affect the CPU */
+	uint64_t horizon = MC_horizon__compute(target);
+
+	while (mc.nextCycleCPU <= horizon)
+	{
+		uint32_t budget = (uint32_t)((horizon - mc.nextCycleCPU) / mc.dividerCPU + 1);
+
+		uint64_t runStart = mc.nextCycleCPU;
+
+		mc.runStartCycleCPU = runStart;
+		uint32_t cycles = CPU::run(budget);
+		mc.runStartCycleCPU = 0;
+
+		mc.nextCycleCPU += (uint64_t)cycles * mc.dividerCPU;
+
+		if (MC_debugger__stopped())
+		{ // the other units are only brought up to the start of the instruction the CPU stopped at ... before it, or on its first cycle after an access
+			horizon = runStart + (uint64_t)CPU::getRunCycles() * mc.dividerCPU - 1;
+
+			break;
+		}
+
+		if (mc.eventsChanged)
+		{ // registers were accessed, the units may have new events scheduled
+			mc.eventsChanged = false;
+			horizon = MC_horizon__compute(target);
+		}
+	}
+
+	/* The APU is clocked before the PPU when they tick on the same master cycle */
+	MC_catchUp(horizon);
+	mc.cycle = horizon;
+}
+
+/* Master cycle up to which the units can run without looking at each other */
+inline uint64_t MC_horizon__compute(uint64_t limit)
+{
+	MC_state_t &mc = CC_console->mc;
+
+	uint64_t horizon = limit;
+	uint64_t eventAPU = mc.nextCycleAPU + (uint64_t)(APU::getCyclesUntilEvent() - 1) * mc.dividerAPU;
+	uint64_t eventPPU = mc.nextCyclePPU + (uint64_t)(PPU::getCyclesUntilEvent() - 1) * mc.dividerPPU;
+
+	if (eventAPU < horizon)
+	{
+		horizon = eventAPU;
+	}
+
+	if (eventPPU < horizon)
+	{
+		horizon = eventPPU;
+	}
+
+	return (horizon);
+}
+
+/* Clocks the APU and PPU for every tick up to (and including) the given master cycle */
+inline void MC_catchUp(uint64_t cycle)
+{
+	MC_state_t &mc = CC_console->mc;
+
+	if (mc.nextCycleAPU <= cycle)
+	{
+		uint32_t count = (uint32_t)((cycle - mc.nextCycleAPU) / mc.dividerAPU + 1);
+
+		APU::run(count);
+		mc.nextCycleAPU += (uint64_t)count * mc.dividerAPU;
+	}
+
+	if (mc.nextCyclePPU <= cycle)
+	{
+		uint32_t count = (uint32_t)((cycle - mc.nextCyclePPU) / mc.dividerPPU + 1);
+
+		PPU::run(count);
+		mc.nextCyclePPU += (uint64_t)count * mc.dividerPPU;
+	}
+}
+
+/* A breakpoint was hit ... the console stays where it stopped until DB resumes it */
+inline bool MC_debugger__stopped()
+{
+	return (CC_console->debuggerData && DB::isStopped());
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+namespace MC
+{
+	void reset(); // the processing units have to be already reset
+	void run(uint64_t cycles); // runs the given number of master clock cycles
+	void runFrame(); // runs until the PPU finishes the current frame
+	void synchronize(); // brings the APU and PPU up to the CPU cycle being executed
+}
\ No newline at end of file
@@ -2,75 +2,147 @@
 
 #include "MemoryMapper.h"
 #include "CartridgeReader.h"
+#include "ConsoleContext.h"
 #include "GameController.h"
 #include "AudioProcessingUnit.h"
 #include "CentralProcessingUnit.h"
+#include "MasterClock.h"
 #include "PictureProcessingUnit.h"
 
-#include <stdlib.h>
-#include <time.h>
+#include <cstring>
 
 #define MB__NAME_TABLE_HORIZONTAL (0x00u)
 #define MB__NAME_TABLE_VERTICAL (0x01u)
 #define MB__NAME_TABLE_ONE_SCREEN_HIGHER (0x08u)
 #define MB__NAME_TABLE_ONE_SCREEN_LOWER (0x09u)
 
-#define MB__REGISTER_PPU_CONTROL (0x2000u) 
-#define MB__REGISTER_PPU_MASK (0x2001u)
-#define MB__REGISTER_PPU_STATUS (0x2002u)
-#define MB__REGISTER_PPU_SPRITE_ADDRESS (0x2003u)
-#define MB__REGISTER_PPU_SPRITE_DATA (0x2004u)
-#define MB__REGISTER_PPU_SCROLL (0x2005u)
-#define MB__REGISTER_PPU_ADDRESS (0x2006u)
-#define MB__REGISTER_PPU_DATA (0x2007u)
-#define MB__REGISTER_APU_SQ1_VOLUME (0x4000u)
-#define MB__REGISTER_APU_SQ1_SWEEP (0x4001u)
-#define MB__REGISTER_APU_SQ1_PERIOD_LO (0x4002u)
-#define MB__REGISTER_APU_SQ1_PERIOD_HI (0x4003u)
-#define MB__REGISTER_APU_SQ2_VOLUME (0x4004u)
-#define MB__REGISTER_APU_SQ2_SWEEP (0x4005u)
-#define MB__REGISTER_APU_SQ2_PERIOD_LO (0x4006u)
-#define MB__REGISTER_APU_SQ2_PERIOD_HI (0x4007u)
-#define MB__REGISTER_APU_TRIANGLE_LINEAR_COUNTER (0x4008u)
-#define MB__REGISTER_APU_TRIANGLE_PERIOD_LO (0x400Au)
-#define MB__REGISTER_APU_TRIANGLE_PERIOD_HI (0x400Bu)
-#define MB__REGISTER_APU_NOISE_VOLUME (0x400Cu)
-#define MB__REGISTER_APU_NOISE_LOOP (0x400Eu)
-#define MB__REGISTER_APU_NOISE_LENGTH (0x400Fu)
-#define MB__REGISTER_APU_DMC_FREQUENCY (0x4010u)
-#define MB__REGISTER_APU_DMC_RAW (0x4011u)
-#define MB__REGISTER_APU_DMC_START (0x4012u)
-#define MB__REGISTER_APU_DMC_LENGTH (0x4013u)
-#define MB__REGISTER_PPU_SPRITE_DMA (0x4014u)
-#define MB__REGISTER_APU_CHANNELS (0x4015u)
-#define MB__REGISTER_JOY1 (0x4016u) // R
-#define MB__REGISTER_JOY2 (0x4017u) // R
-#define MB__REGISTER_JOY_STROBE (0x4016u) // W
-#define MB__REGISTER_APU_FRAME_COUNTER_CONTROL (0x4017u) // W
-
-static uint8_t MB_RAM[0x0800]; // mirrored 4 times
-static uint8_t MB_vRAM[0x0800];
-static uint8_t *MB_externalRAM = nullptr;
-static uint8_t MB_palette[0x20];
-
-static bool MB_enableRAM = true;
-static bool MB_protectRAM = false;
-
-static std::size_t MB_nameTable[4];
+#define MB__OPEN_BUS_SEED (0x2545F491u) // fixed, so that runs with the same input are identical
+
+#define MB__PAGE_SIZE (0x0100u)
+#define MB__PRG_WINDOW (0x2000u) // no mapper switches smaller PRG banks
+
+#define MB__REGISTER_COUNT (0x28u) // the 8 PPU registers, then $4000-$401F
+
+typedef void(*MB_registerWrite_t)(uint8_t data);
+typedef uint8_t(*MB_registerRead_t)();
+
+inline uint8_t MB_openBus__read();
+inline void MB_pages__updatePRG();
+inline uint8_t MB_register__index(uint16_t address);
+void MB_register__writeNothing(uint8_t data);
+void MB_register__writeSpriteDMA(uint8_t data);
+uint8_t MB_register__readNothing();
+uint8_t MB_register__readChannels();
+
+/* Handlers of the I/O registers, by MB_register__index ... an access to them is a single indirect call */
+static const MB_registerWrite_t MB_registerWrite[MB__REGISTER_COUNT] =
+{
+	PPU::writeRegisterControl, // $2000
+	PPU::writeRegisterMask,
+	MB_register__writeNothing, // status is read-only
+	PPU::writeRegisterSpriteAddress,
+	PPU::writeRegisterSpriteData,
+	PPU::writeRegisterScroll,
+	PPU::writeRegisterAddress,
+	PPU::writeRegisterData,
+	APU::writeRegisterSQ1Volume, // $4000
+	APU::writeRegisterSQ1Sweep,
+	APU::writeRegisterSQ1PeriodLow,
+	APU::writeRegisterSQ1PeriodHigh,
+	APU::writeRegisterSQ2Volume,
+	APU::writeRegisterSQ2Sweep,
+	APU::writeRegisterSQ2PeriodLow,
+	APU::writeRegisterSQ2PeriodHigh,
+	APU::writeRegisterTriangleLinearCounter, // $4008
+	MB_register__writeNothing,
+	APU::writeRegisterTriangleTimerLow,
+	APU::writeRegisterTriangleTimerHigh,
+	APU::writeRegisterNoiseVolume,
+	MB_register__writeNothing,
+	APU::writeRegisterNoiseMode,
+	APU::writeRegisterNoiseLength,
+	APU::writeRegisterDMCFrequency, // $4010
+	APU::writeRegisterDMCRaw,
+	APU::writeRegisterDMCAddress,
+	APU::writeRegisterDMCLength,
+	MB_register__writeSpriteDMA,
+	APU::writeRegisterChannels,
+	GC::strobe,
+	APU::writeRegisterFrameCounter,
+	MB_register__writeNothing, // $4018 ... the rest have no function
+	MB_register__writeNothing,
+	MB_register__writeNothing,
+	MB_register__writeNothing,
+	MB_register__writeNothing,
+	MB_register__writeNothing,
+	MB_register__writeNothing,
+	MB_register__writeNothing
+};
+
+static const MB_registerRead_t MB_registerRead[MB__REGISTER_COUNT] =
+{
+	PPU::readRegisterControl, // $2000
+	PPU::readRegisterMask,
+	PPU::readRegisterStatus,
+	MB_register__readNothing, // write-only
+	PPU::readRegisterSpriteData,
+	MB_register__readNothing, // write-only
+	MB_register__readNothing,
+	PPU::readRegisterData,
+	MB_register__readNothing, // $4000 ... the sound registers are write-only
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing, // $4008
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing, // $4010
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing, // sprite DMA is write-only
+	MB_register__readChannels,
+	GC::readController1,
+	GC::readController2,
+	MB_register__readNothing, // $4018 ... unused memory
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing,
+	MB_register__readNothing
+};
 
 namespace MB
 {
 	void init()
 	{
-		srand(clock());
+		MB_state_t &mb = CC_console->mb;
+
+		mb.enableRAM = true;
+		mb.protectRAM = false;
+
+		mb.openBus = MB__OPEN_BUS_SEED;
 	}
 
 	bool loadMapperInformation()
 	{
+		MB_state_t &mb = CC_console->mb;
+
 		if (CR::getBatteryBackedRAMAvailability())
 		{
-			MB_externalRAM = new uint8_t[0x2000];
-			if (!MB_externalRAM)
+			mb.externalRAM = new uint8_t[0x2000](); // zeroed like the character RAM, so every run starts the same
+			if (!mb.externalRAM)
 			{
 				return (false);
 			}
@@ -80,40 +152,40 @@ namespace MB
 		{
 			case MB__NAME_TABLE_HORIZONTAL:
 			{
-				MB_nameTable[0] = 0;
-				MB_nameTable[1] = 0;
-				MB_nameTable[2] = 0x400;
-				MB_nameTable[3] = 0x400;
+				mb.nameTable[0] = 0;
+				mb.nameTable[1] = 0;
+				mb.nameTable[2] = 0x400;
+				mb.nameTable[3] = 0x400;
 
 				break;
 			}
 
 			case MB__NAME_TABLE_VERTICAL:
 			{
-				MB_nameTable[0] = 0;
-				MB_nameTable[1] = 0x400;
-				MB_nameTable[2] = 0;
-				MB_nameTable[3] = 0x400;
+				mb.nameTable[0] = 0;
+				mb.nameTable[1] = 0x400;
+				mb.nameTable[2] = 0;
+				mb.nameTable[3] = 0x400;
 
 				break;
 			}
 
 			case MB__NAME_TABLE_ONE_SCREEN_HIGHER:
 			{
-				MB_nameTable[0] = 0x400;
-				MB_nameTable[1] = 0x400;
-				MB_nameTable[2] = 0x400;
-				MB_nameTable[3] = 0x400;
+				mb.nameTable[0] = 0x400;
+				mb.nameTable[1] = 0x400;
+				mb.nameTable[2] = 0x400;
+				mb.nameTable[3] = 0x400;
 
 				break;
 			}
 
 			case MB__NAME_TABLE_ONE_SCREEN_LOWER:
 			{
-				MB_nameTable[0] = 0;
-				MB_nameTable[1] = 0;
-				MB_nameTable[2] = 0;
-				MB_nameTable[3] = 0;
+				mb.nameTable[0] = 0;
+				mb.nameTable[1] = 0;
+				mb.nameTable[2] = 0;
+				mb.nameTable[3] = 0;
 
 				break;
 			}
@@ -124,49 +196,53 @@ namespace MB
 			}
 		}
 
+		updatePages();
+
 		return (true);
 	}
 
 	void changeMirroring(uint8_t mirroring)
 	{
+		MB_state_t &mb = CC_console->mb;
+
 		switch (mirroring)
 		{
 			case MB__NAME_TABLE_HORIZONTAL:
 			{
-				MB_nameTable[0] = 0;
-				MB_nameTable[1] = 0;
-				MB_nameTable[2] = 0x400;
-				MB_nameTable[3] = 0x400;
+				mb.nameTable[0] = 0;
+				mb.nameTable[1] = 0;
+				mb.nameTable[2] = 0x400;
+				mb.nameTable[3] = 0x400;
 
 				break;
 			}
 
 			case MB__NAME_TABLE_VERTICAL:
 			{
-				MB_nameTable[0] = 0;
-				MB_nameTable[1] = 0x400;
-				MB_nameTable[2] = 0;
-				MB_nameTable[3] = 0x400;
+				mb.nameTable[0] = 0;
+				mb.nameTable[1] = 0x400;
+				mb.nameTable[2] = 0;
+				mb.nameTable[3] = 0x400;
 
 				break;
 			}
 
 			case MB__NAME_TABLE_ONE_SCREEN_HIGHER:
 			{
-				MB_nameTable[0] = 0x400;
-				MB_nameTable[1] = 0x400;
-				MB_nameTable[2] = 0x400;
-				MB_nameTable[3] = 0x400;
+				mb.nameTable[0] = 0x400;
+				mb.nameTable[1] = 0x400;
+				mb.nameTable[2] = 0x400;
+				mb.nameTable[3] = 0x400;
 
 				break;
 			}
 
 			case MB__NAME_TABLE_ONE_SCREEN_LOWER:
 			{
-				MB_nameTable[0] = 0;
-				MB_nameTable[1] = 0;
-				MB_nameTable[2] = 0;
-				MB_nameTable[3] = 0;
+				mb.nameTable[0] = 0;
+				mb.nameTable[1] = 0;
+				mb.nameTable[2] = 0;
+				mb.nameTable[3] = 0;
 
 				break;
 			}
@@ -175,271 +251,62 @@ namespace MB
 
 	void configureMemory(bool enable_external_RAM, bool protect_external_RAM)
 	{
-		MB_enableRAM = enable_external_RAM;
-		MB_protectRAM = protect_external_RAM;
+		MB_state_t &mb = CC_console->mb;
+
+		mb.enableRAM = enable_external_RAM;
+		mb.protectRAM = protect_external_RAM;
+
+		updatePages();
 	}
 
-	void writeMainBus(uint16_t address, uint8_t data)
+	void updatePages()
 	{
-		if (address < 0x2000)
+		MB_state_t &mb = CC_console->mb;
+		MB_pages_t &pages = CC_console->pages;
+
+		for (uint32_t page = 0x00; page < 0x20; ++page)
 		{
-			MB_RAM[address & 0x07FF] = data;
+			pages.read[page] = pages.write[page] = &mb.RAM[(page * MB__PAGE_SIZE) & 0x07FF];
 		}
-		else if (address < 0x4000)
-		{ // PPU registers mirrored
-			switch (address & 0x2007)
-			{
-				case MB__REGISTER_PPU_CONTROL:
-				{
-					PPU::writeRegisterControl(data);
-
-					break;
-				}
-
-				case MB__REGISTER_PPU_MASK:
-				{
-					PPU::writeRegisterMask(data);
-
-					break;
-				}
-
-				case MB__REGISTER_PPU_STATUS:
-				{
-					break; // read-only register ... writing to it has no effect
-				}
-
-				case MB__REGISTER_PPU_SPRITE_ADDRESS:
-				{
-					PPU::writeRegisterSpriteAddress(data);
-
-					break;
-				}
-
-				case MB__REGISTER_PPU_SPRITE_DATA:
-				{
-					PPU::writeRegisterSpriteData(data);
 
-					break;
-				}
+		for (uint32_t page = 0x20; page < 0x60; ++page)
+		{ // registers and expansion
+			pages.read[page] = pages.write[page] = nullptr;
+		}
 
-				case MB__REGISTER_PPU_SCROLL:
-				{
-					PPU::writeRegisterScroll(data);
+		for (uint32_t page = 0x60; page < 0x80; ++page)
+		{ // reading disabled external RAM changes the open bus generator
+			uint8_t *memory = (mb.externalRAM && mb.enableRAM) ? &mb.externalRAM[(page - 0x60) * MB__PAGE_SIZE] : nullptr;
 
-					break;
-				}
+			pages.read[page] = memory;
+			pages.write[page] = mb.protectRAM ? nullptr : memory;
+		}
 
-				case MB__REGISTER_PPU_ADDRESS:
-				{
-					PPU::writeRegisterAddress(data);
+		MB_pages__updatePRG();
+	}
 
-					break;
-				}
+	void writeMainBus(uint16_t address, uint8_t data)
+	{
+		MB_state_t &mb = CC_console->mb;
 
-				case MB__REGISTER_PPU_DATA:
-				{
-					PPU::writeRegisterData(data);
+		uint8_t *page = CC_console->pages.write[address >> 8];
+		if (page)
+		{
+			page[address & 0xFF] = data;
+		}
+		else if (address < 0x2000)
+		{
+			mb.RAM[address & 0x07FF] = data;
+		}
+		else if (address < 0x4020)
+		{ // PPU registers mirrored, then the APU and controller ones
+			MC::synchronize();
 
-					break;
-				}
-			}
+			MB_registerWrite[MB_register__index(address)](data);
 		}
 		else if (address < 0x5000)
 		{
-			switch (address)
-			{
-				case MB__REGISTER_APU_SQ1_VOLUME:
-				{
-					APU::writeRegisterSQ1Volume(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_SQ1_SWEEP:
-				{
-					APU::writeRegisterSQ1Sweep(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_SQ1_PERIOD_LO:
-				{
-					APU::writeRegisterSQ1PeriodLow(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_SQ1_PERIOD_HI:
-				{
-					APU::writeRegisterSQ1PeriodHigh(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_SQ2_VOLUME:
-				{
-					APU::writeRegisterSQ2Volume(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_SQ2_SWEEP:
-				{
-					APU::writeRegisterSQ2Sweep(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_SQ2_PERIOD_LO:
-				{
-					APU::writeRegisterSQ2PeriodLow(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_SQ2_PERIOD_HI:
-				{
-					APU::writeRegisterSQ2PeriodHigh(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_TRIANGLE_LINEAR_COUNTER:
-				{
-					APU::writeRegisterTriangleLinearCounter(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_TRIANGLE_PERIOD_LO:
-				{
-					APU::writeRegisterTriangleTimerLow(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_TRIANGLE_PERIOD_HI:
-				{
-					APU::writeRegisterTriangleTimerHigh(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_NOISE_VOLUME:
-				{
-					APU::writeRegisterNoiseVolume(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_NOISE_LOOP:
-				{
-					APU::writeRegisterNoiseMode(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_NOISE_LENGTH:
-				{
-					APU::writeRegisterNoiseLength(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_DMC_FREQUENCY:
-				{
-					APU::writeRegisterDMCFrequency(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_DMC_RAW:
-				{
-					APU::writeRegisterDMCRaw(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_DMC_START:
-				{
-					APU::writeRegisterDMCAddress(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_DMC_LENGTH:
-				{
-					APU::writeRegisterDMCLength(data);
-
-					break;
-				}
-
-				case MB__REGISTER_PPU_SPRITE_DMA:
-				{
-					CPU::skipCyclesForDMA();
-
-					uint16_t address = (uint16_t)data << 8;
-					uint8_t *pagePointer = nullptr;
-
-					if (address < 0x2000)
-					{
-						pagePointer = &MB_RAM[address & 0x07FF];
-					}
-					else if (address < 0x5000)
-					{
-						pagePointer = nullptr; // register access is not permitted
-					}
-					else if (address < 0x6000)
-					{
-						pagePointer = nullptr; // extended ROM access is not allowed
-					}
-					else if (address < 0x8000)
-					{
-						if (MB_externalRAM)
-						{
-							pagePointer = &MB_externalRAM[address - 0x6000];
-						}
-						else
-						{
-							pagePointer = nullptr;
-						}
-					}
-					else
-					{
-						pagePointer = nullptr;
-					}
-
-					PPU::executeDMA(pagePointer);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_CHANNELS:
-				{
-					APU::writeRegisterChannels(data);
-
-					break;
-				}
-
-				case MB__REGISTER_JOY_STROBE:
-				{
-					GC::strobe(data);
-
-					break;
-				}
-
-				case MB__REGISTER_APU_FRAME_COUNTER_CONTROL:
-				{
-					APU::writeRegisterFrameCounter(data);
-
-					break;
-				}
-
-				default:
-				{
-					break; // other registers have no function
-				}
-			}
+			return; // nothing is mapped there
 		}
 		else if (address < 0x6000)
 		{
@@ -447,111 +314,45 @@ namespace MB
 		}
 		else if (address < 0x8000)
 		{
-			if (MB_externalRAM && MB_enableRAM && !MB_protectRAM)
+			if (mb.externalRAM && mb.enableRAM && !mb.protectRAM)
 			{
-				MB_externalRAM[address - 0x6000] = data;
+				mb.externalRAM[address - 0x6000] = data;
 			}
 		}
 		else
 		{
+			MC::synchronize(); // bank switching and mirroring changes have to be seen by the PPU at the right time
+
 			MM::writePRG(address, data);
+			MB_pages__updatePRG();
 		}
 	}
 
 	uint8_t readMainBus(uint16_t address)
 	{
-		if (address < 0x2000)
+		MB_state_t &mb = CC_console->mb;
+
+		const uint8_t *page = CC_console->pages.read[address >> 8];
+		if (page)
 		{
-			return (MB_RAM[address & 0x07FF]);
+			return (page[address & 0xFF]);
 		}
-		else if (address < 0x4000)
+		else if (address < 0x2000)
 		{
-			switch (address & 0x2007)
+			return (mb.RAM[address & 0x07FF]);
+		}
+		else if (address < 0x4020)
+		{ // only reading the PPU registers depends on where the PPU is ... the APU status brings it up to date itself
+			if (address < 0x4000)
 			{
-				case MB__REGISTER_PPU_CONTROL:
-				{
-					return (PPU::readRegisterControl());
-				}
-
-				case MB__REGISTER_PPU_MASK:
-				{
-					return (PPU::readRegisterMask());
-				}
-
-				case MB__REGISTER_PPU_STATUS:
-				{
-					return (PPU::readRegisterStatus());
-				}
-
-				case MB__REGISTER_PPU_SPRITE_ADDRESS:
-				{
-					return (0x00); // write-only register
-				}
-
-				case MB__REGISTER_PPU_SPRITE_DATA:
-				{
-					return (PPU::readRegisterSpriteData());
-				}
-
-				case MB__REGISTER_PPU_SCROLL:
-				case MB__REGISTER_PPU_ADDRESS:
-				{
-					return (0x00); // write-only register
-				}
-
-				case MB__REGISTER_PPU_DATA:
-				{
-					return (PPU::readRegisterData());
-				}
+				MC::synchronize();
 			}
+
+			return (MB_registerRead[MB_register__index(address)]());
 		}
 		else if (address < 0x5000)
 		{
-			switch (address)
-			{
-				case MB__REGISTER_APU_SQ1_VOLUME:
-				case MB__REGISTER_APU_SQ1_SWEEP:
-				case MB__REGISTER_APU_SQ1_PERIOD_LO:
-				case MB__REGISTER_APU_SQ1_PERIOD_HI:
-				case MB__REGISTER_APU_SQ2_VOLUME:
-				case MB__REGISTER_APU_SQ2_SWEEP:
-				case MB__REGISTER_APU_SQ2_PERIOD_LO:
-				case MB__REGISTER_APU_SQ2_PERIOD_HI:
-				case MB__REGISTER_APU_TRIANGLE_LINEAR_COUNTER:
-				case MB__REGISTER_APU_TRIANGLE_PERIOD_LO:
-				case MB__REGISTER_APU_TRIANGLE_PERIOD_HI:
-				case MB__REGISTER_APU_NOISE_VOLUME:
-				case MB__REGISTER_APU_NOISE_LOOP:
-				case MB__REGISTER_APU_NOISE_LENGTH:
-				case MB__REGISTER_APU_DMC_FREQUENCY:
-				case MB__REGISTER_APU_DMC_RAW:
-				case MB__REGISTER_APU_DMC_START:
-				case MB__REGISTER_APU_DMC_LENGTH:
-				case MB__REGISTER_PPU_SPRITE_DMA:
-				{
-					return (0x00); // write-only registers
-				}
-
-				case MB__REGISTER_APU_CHANNELS:
-				{ // sound registers ... TBD
-					return (APU::readRegisterStatus());
-				}
-
-				case MB__REGISTER_JOY1:
-				{
-					return (GC::readController1());
-				}
-
-				case MB__REGISTER_JOY2:
-				{
-					return (GC::readController2());
-				}
-
-				default:
-				{
-					return (0x00); // unused memory
-				}
-			}
+			return (0x00); // unused memory
 		}
 		else if (address < 0x6000)
 		{
@@ -559,15 +360,15 @@ namespace MB
 		}
 		else if (address < 0x8000)
 		{
-			if (MB_externalRAM)
+			if (mb.externalRAM)
 			{
-				if (MB_enableRAM)
+				if (mb.enableRAM)
 				{
-					return (MB_externalRAM[address - 0x6000]);
+					return (mb.externalRAM[address - 0x6000]);
 				}
 				else
 				{
-					return ((uint8_t)rand());
+					return (MB_openBus__read());
 					// open bus behaviour
 					// used by some games to generate seeds for pseudorandom
 				}
@@ -587,6 +388,8 @@ namespace MB
 
 	void writePictureBus(uint16_t address, uint8_t data)
 	{
+		MB_state_t &mb = CC_console->mb;
+
 		if (address < 0x2000)
 		{
 			MM::writeCHR(address, data);
@@ -596,23 +399,25 @@ namespace MB
 			uint8_t index = (address - 0x2000) / 0x0400;
 			index %= 4;
 
-			MB_vRAM[MB_nameTable[index] + (address & 0x03FF)] = data;
+			mb.vRAM[mb.nameTable[index] + (address & 0x03FF)] = data;
 		}
 		else if (address < 0x4000) // here
 		{
 			if (address == 0x3F10)
 			{
-				MB_palette[0] = data;
+				mb.palette[0] = data;
 			}
 			else
 			{
-				MB_palette[address & 0x1F] = data;
+				mb.palette[address & 0x1F] = data;
 			}
 		}
 	}
 
 	uint8_t readPictureBus(uint16_t address)
 	{
+		MB_state_t &mb = CC_console->mb;
+
 		if (address < 0x2000)
 		{
 			return (MM::readCHR(address));
@@ -622,11 +427,11 @@ namespace MB
 			uint8_t index = (address - 0x2000) / 0x0400;
 			index %= 4;
 
-			return (MB_vRAM[MB_nameTable[index] + (address & 0x03FF)]);
+			return (mb.vRAM[mb.nameTable[index] + (address & 0x03FF)]);
 		}
 		else if (address < 0x4000) // here
 		{
-			return (MB_palette[address & 0x1F]);
+			return (mb.palette[address & 0x1F]);
 		}
 		else
 		{
@@ -636,9 +441,108 @@ namespace MB
 
 	void clean()
 	{
-		if (MB_externalRAM)
+		MB_state_t &mb = CC_console->mb;
+
+		if (mb.externalRAM)
 		{
-			delete[] MB_externalRAM;
+			delete[] mb.externalRAM;
 		}
+
+		memset(&CC_console->pages, 0, sizeof(MB_pages_t));
 	}
+}
+
+/* Xorshift generator standing in for the floating bus */
+inline uint8_t MB_openBus__read()
+{
+	MB_state_t &mb = CC_console->mb;
+
+	mb.openBus ^= mb.openBus << 13;
+	mb.openBus ^= mb.openBus >> 17;
+	mb.openBus ^= mb.openBus << 5;
+
+	return ((uint8_t)mb.openBus);
+}
+
+/* Points the cartridge pages at the PRG ROM banks the mapper selected */
+inline void MB_pages__updatePRG()
+{
+	MB_pages_t &pages = CC_console->pages;
+
+	uint32_t size = (uint32_t)CR::getROMBankCount() * 0x4000;
+
+	for (uint32_t window = 0x8000; window < 0x10000; window += MB__PRG_WINDOW)
+	{
+		uint32_t offset = MM::mapPRG((uint16_t)window);
+		const uint8_t *bank = (offset + MB__PRG_WINDOW <= size) ? CR::getROM() + offset : nullptr; // banks selected past the end of the ROM are left to the mapper
+
+		for (uint32_t page = 0; page < MB__PRG_WINDOW / MB__PAGE_SIZE; ++page)
+		{
+			pages.read[window / MB__PAGE_SIZE + page] = bank ? bank + page * MB__PAGE_SIZE : nullptr;
+			pages.write[window / MB__PAGE_SIZE + page] = nullptr;
+		}
+	}
+}
+
+/* $2000-$3FFF mirror the 8 PPU registers, $4000-$401F follow them */
+inline uint8_t MB_register__index(uint16_t address)
+{
+	return ((address < 0x4000) ? (uint8_t)(address & 0x0007) : (uint8_t)(0x08 + (address & 0x001F)));
+}
+
+void MB_register__writeNothing(uint8_t)
+{
+}
+
+/* Copies a page to the sprite memory of the PPU ... the CPU is halted while it does */
+void MB_register__writeSpriteDMA(uint8_t data)
+{
+	MB_state_t &mb = CC_console->mb;
+
+	CPU::skipCyclesForDMA();
+
+	uint16_t address = (uint16_t)data << 8;
+	uint8_t *pagePointer = nullptr;
+
+	if (address < 0x2000)
+	{
+		pagePointer = &mb.RAM[address & 0x07FF];
+	}
+	else if (address < 0x5000)
+	{
+		pagePointer = nullptr; // register access is not permitted
+	}
+	else if (address < 0x6000)
+	{
+		pagePointer = nullptr; // extended ROM access is not allowed
+	}
+	else if (address < 0x8000)
+	{
+		if (mb.externalRAM)
+		{
+			pagePointer = &mb.externalRAM[address - 0x6000];
+		}
+		else
+		{
+			pagePointer = nullptr;
+		}
+	}
+	else
+	{
+		pagePointer = nullptr;
+	}
+
+	PPU::executeDMA(pagePointer);
+}
+
+uint8_t MB_register__readNothing()
+{
+	return (0x00);
+}
+
+uint8_t MB_register__readChannels()
+{
+	MC::synchronize();
+
+	return (APU::readRegisterStatus());
 }
\ No newline at end of file
@@ -8,6 +8,7 @@ namespace MB
 	bool loadMapperInformation(); // mapper and cartridge must be already initialized
 	void changeMirroring(uint8_t mirroring);
 	void configureMemory(bool enable_external_RAM, bool protect_external_RAM);
+	void updatePages(); // after the mapping changed without a write to the cartridge, as when a state is loaded
 	void writeMainBus(uint16_t address, uint8_t data);
 	uint8_t readMainBus(uint16_t address);
 	void writePictureBus(uint16_t address, uint8_t data);
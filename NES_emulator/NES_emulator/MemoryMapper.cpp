@@ -4,6 +4,7 @@
 #include "MemoryBus.h"
 #include "PictureProcessingUnit.h"
 #include "CentralProcessingUnit.h"
+#include "ConsoleContext.h"
 
 #define MM__NO_MAPPER_SELECTED (0xFFFFu)
 
@@ -14,106 +15,38 @@
 
 #define MM__CHARACTER_RAM_SIZE (0x2000u)
 
-static struct
-{
-	void(*writePRG)(uint16_t address, uint8_t data);
-	uint8_t(*readPRG)(uint16_t address);
-	void(*writeCHR)(uint16_t address, uint8_t data);
-	uint8_t(*readCHR)(uint16_t address);
-} MM_busFunctions;
-
-static union
-{
-	struct
-	{
-		uint8_t bankCount;
-		uint8_t *characterRAM;
-	} MapperNone;
-
-	struct
-	{
-		uint8_t bankCount;
-		uint8_t *characterRAM;
-		uint8_t modePRG;
-		uint8_t modeCHR;
-		uint8_t temporaryRegister;
-		int8_t writeCounter;
-		uint8_t registerPRG;
-		uint8_t registerCHR0;
-		uint8_t registerCHR1;
-		uint8_t *firstBankPRG;
-		uint8_t *secondBankPRG;
-		uint8_t *firstBankCHR;
-		uint8_t *secondBankCHR;
-	} MapperMMC1;
-
-	struct
-	{
-		uint8_t bankCount;
-		uint8_t *characterRAM;
-		uint8_t *lastBank;
-		uint8_t selectedBank;
-	}MapperUNROM;
-
-	struct
-	{
-		uint8_t bankCount;
-		uint8_t selectedBank;
-	}MapperCNROM;
-
-	struct
-	{
-		uint8_t bankSelect;
-		uint8_t *PRGbankFixed0;
-		uint8_t *PRGbankFixed1;
-		uint8_t *PRGbank0;
-		uint8_t *PRGbank1;
-		uint8_t *CHR2k0;
-		uint8_t *CHR2k1;
-		uint8_t *CHR1k0;
-		uint8_t *CHR1k1;
-		uint8_t *CHR1k2;
-		uint8_t *CHR1k3;
-		bool invertPRG;
-		bool invertCHR;
-		bool enableIRQ;
-		bool causeIRQ;
-		uint8_t counterValue;
-		uint8_t counterReloadValue;
-		bool counterReload;
-	}MapperMMC3;
-} MM_parameters;
-
-static uint16_t MM_currentMapper = MM__NO_MAPPER_SELECTED;
-static uint8_t MM_nameTableMirroring;
-
 /* MAPPER_NONE functions */
 void Mapper_None__writePRG(uint16_t address, uint8_t data);
 uint8_t Mapper_None__readPRG(uint16_t address);
+uint32_t Mapper_None__mapPRG(uint16_t address);
 void Mapper_None__writeCHR(uint16_t address, uint8_t data);
 uint8_t Mapper_None__readCHR(uint16_t address);
 
 /* MAPPER_MMC1 functions */
 void Mapper_MMC1__writePRG(uint16_t address, uint8_t data);
 uint8_t Mapper_MMC1__readPRG(uint16_t address);
+uint32_t Mapper_MMC1__mapPRG(uint16_t address);
 void Mapper_MMC1__writeCHR(uint16_t address, uint8_t data);
 uint8_t Mapper_MMC1__readCHR(uint16_t address);
 
 /* MAPPER_UNROM functions */
 void Mapper_UNROM__writePRG(uint16_t address, uint8_t data);
 uint8_t Mapper_UNROM__readPRG(uint16_t address);
+uint32_t Mapper_UNROM__mapPRG(uint16_t address);
 void Mapper_UNROM__writeCHR(uint16_t address, uint8_t data);
 uint8_t Mapper_UNROM__readCHR(uint16_t address);
 
 /* MAPPER_CNROM functions */
 void Mapper_CNROM__writePRG(uint16_t address, uint8_t data);
 uint8_t Mapper_CNROM__readPRG(uint16_t address);
+uint32_t Mapper_CNROM__mapPRG(uint16_t address);
 void Mapper_CNROM__writeCHR(uint16_t address, uint8_t data);
 uint8_t Mapper_CNROM__readCHR(uint16_t address);
 
 /* MAPPER_MMC3 functions */
 void Mapper_MMC3__writePRG(uint16_t address, uint8_t data);
 uint8_t Mapper_MMC3__readPRG(uint16_t address);
+uint32_t Mapper_MMC3__mapPRG(uint16_t address);
 void Mapper_MMC3__writeCHR(uint16_t address, uint8_t data);
 uint8_t Mapper_MMC3__readCHR(uint16_t address);
 
@@ -121,39 +54,47 @@ namespace MM
 {
 	void init()
 	{
-		MM_busFunctions.writePRG = nullptr;
-		MM_busFunctions.readPRG = nullptr;
-		MM_busFunctions.writeCHR = nullptr;
-		MM_busFunctions.readCHR = nullptr;
+		MM_state_t &mm = CC_console->mm;
+
+		mm.currentMapper = MM__NO_MAPPER_SELECTED;
+
+		mm.busFunctions.writePRG = nullptr;
+		mm.busFunctions.readPRG = nullptr;
+		mm.busFunctions.mapPRG = nullptr;
+		mm.busFunctions.writeCHR = nullptr;
+		mm.busFunctions.readCHR = nullptr;
 	}
 
 	bool setMapper(uint8_t mapper_type)
 	{
+		MM_state_t &mm = CC_console->mm;
+
 		switch (mapper_type)
 		{
 			case MAPPER_NONE:
 			{
-				MM_busFunctions.writePRG = Mapper_None__writePRG;
-				MM_busFunctions.readPRG = Mapper_None__readPRG;
-				MM_busFunctions.writeCHR = Mapper_None__writeCHR;
-				MM_busFunctions.readCHR = Mapper_None__readCHR;
+				mm.busFunctions.writePRG = Mapper_None__writePRG;
+				mm.busFunctions.readPRG = Mapper_None__readPRG;
+				mm.busFunctions.mapPRG = Mapper_None__mapPRG;
+				mm.busFunctions.writeCHR = Mapper_None__writeCHR;
+				mm.busFunctions.readCHR = Mapper_None__readCHR;
 
-				MM_nameTableMirroring = CR::getNameTableMirroring();
+				mm.nameTableMirroring = CR::getNameTableMirroring();
 
-				MM_parameters.MapperNone.bankCount = CR::getROMBankCount();
-				if (MM_parameters.MapperNone.bankCount > 2)
+				mm.parameters.MapperNone.bankCount = CR::getROMBankCount();
+				if (mm.parameters.MapperNone.bankCount > 2)
 				{
 					return (false);
 				}
 
 				if (CR::getVROMBankCount())
 				{
-					MM_parameters.MapperNone.characterRAM = nullptr;
+					mm.parameters.MapperNone.characterRAM = nullptr;
 				}
 				else
 				{ // will use character RAM
-					MM_parameters.MapperNone.characterRAM = new uint8_t[MM__CHARACTER_RAM_SIZE];
-					if (!MM_parameters.MapperNone.characterRAM)
+					mm.parameters.MapperNone.characterRAM = new uint8_t[MM__CHARACTER_RAM_SIZE](); // zeroed, so every run starts from the same pattern tables
+					if (!mm.parameters.MapperNone.characterRAM)
 					{
 						return (false);
 					}
@@ -164,88 +105,91 @@ namespace MM
 
 			case MAPPER_MMC1:
 			{
-				MM_busFunctions.writePRG = Mapper_MMC1__writePRG;
-				MM_busFunctions.readPRG = Mapper_MMC1__readPRG;
-				MM_busFunctions.writeCHR = Mapper_MMC1__writeCHR;
-				MM_busFunctions.readCHR = Mapper_MMC1__readCHR;
+				mm.busFunctions.writePRG = Mapper_MMC1__writePRG;
+				mm.busFunctions.readPRG = Mapper_MMC1__readPRG;
+				mm.busFunctions.mapPRG = Mapper_MMC1__mapPRG;
+				mm.busFunctions.writeCHR = Mapper_MMC1__writeCHR;
+				mm.busFunctions.readCHR = Mapper_MMC1__readCHR;
 
-				MM_parameters.MapperMMC1.bankCount = CR::getROMBankCount();
+				mm.parameters.MapperMMC1.bankCount = CR::getROMBankCount();
 
 				if (CR::getVROMBankCount())
 				{
-					MM_parameters.MapperMMC1.characterRAM = nullptr;
-					MM_parameters.MapperMMC1.firstBankCHR = CR::getVideoROM();
-					MM_parameters.MapperMMC1.secondBankCHR = MM_parameters.MapperMMC1.firstBankCHR;
+					mm.parameters.MapperMMC1.characterRAM = nullptr;
+					mm.parameters.MapperMMC1.firstBankCHR = CR::getVideoROM();
+					mm.parameters.MapperMMC1.secondBankCHR = mm.parameters.MapperMMC1.firstBankCHR;
 				}
 				else
 				{
-					MM_parameters.MapperMMC1.characterRAM = new uint8_t[MM__CHARACTER_RAM_SIZE];
-					if (!MM_parameters.MapperMMC1.characterRAM)
+					mm.parameters.MapperMMC1.characterRAM = new uint8_t[MM__CHARACTER_RAM_SIZE]();
+					if (!mm.parameters.MapperMMC1.characterRAM)
 					{
 						return (false);
 					}
 				}
 
-				MM_parameters.MapperMMC1.firstBankPRG = CR::getROM();
-				MM_parameters.MapperMMC1.secondBankPRG = &MM_parameters.MapperMMC1.firstBankPRG[(MM_parameters.MapperMMC1.bankCount - 1) * 0x4000];
+				mm.parameters.MapperMMC1.firstBankPRG = CR::getROM();
+				mm.parameters.MapperMMC1.secondBankPRG = &mm.parameters.MapperMMC1.firstBankPRG[(mm.parameters.MapperMMC1.bankCount - 1) * 0x4000];
 
-				MM_nameTableMirroring = MM__NAME_TABLE_HORIZONTAL;
-				MB::changeMirroring(MM_nameTableMirroring);
+				mm.nameTableMirroring = MM__NAME_TABLE_HORIZONTAL;
+				MB::changeMirroring(mm.nameTableMirroring);
 
-				MM_parameters.MapperMMC1.modePRG = 0x03;
-				MM_parameters.MapperMMC1.modeCHR = 0x00;
+				mm.parameters.MapperMMC1.modePRG = 0x03;
+				mm.parameters.MapperMMC1.modeCHR = 0x00;
 
-				MM_parameters.MapperMMC1.registerPRG = 0x00;
-				MM_parameters.MapperMMC1.registerCHR0 = 0x00;
-				MM_parameters.MapperMMC1.registerCHR1 = 0x00;
+				mm.parameters.MapperMMC1.registerPRG = 0x00;
+				mm.parameters.MapperMMC1.registerCHR0 = 0x00;
+				mm.parameters.MapperMMC1.registerCHR1 = 0x00;
 
-				MM_parameters.MapperMMC1.temporaryRegister = 0x00;
-				MM_parameters.MapperMMC1.writeCounter = 0;
+				mm.parameters.MapperMMC1.temporaryRegister = 0x00;
+				mm.parameters.MapperMMC1.writeCounter = 0;
 
 				break;
 			}
 
 			case MAPPER_UNROM:
 			{
-				MM_busFunctions.writePRG = Mapper_UNROM__writePRG;
-				MM_busFunctions.readPRG = Mapper_UNROM__readPRG;
-				MM_busFunctions.writeCHR = Mapper_UNROM__writeCHR;
-				MM_busFunctions.readCHR = Mapper_UNROM__readCHR;
+				mm.busFunctions.writePRG = Mapper_UNROM__writePRG;
+				mm.busFunctions.readPRG = Mapper_UNROM__readPRG;
+				mm.busFunctions.mapPRG = Mapper_UNROM__mapPRG;
+				mm.busFunctions.writeCHR = Mapper_UNROM__writeCHR;
+				mm.busFunctions.readCHR = Mapper_UNROM__readCHR;
 
-				MM_nameTableMirroring = CR::getNameTableMirroring();
+				mm.nameTableMirroring = CR::getNameTableMirroring();
 
-				MM_parameters.MapperUNROM.bankCount = CR::getROMBankCount();
+				mm.parameters.MapperUNROM.bankCount = CR::getROMBankCount();
 
 				if (CR::getVROMBankCount())
 				{
-					MM_parameters.MapperUNROM.characterRAM = nullptr;
+					mm.parameters.MapperUNROM.characterRAM = nullptr;
 				}
 				else
 				{
-					MM_parameters.MapperUNROM.characterRAM = new uint8_t[MM__CHARACTER_RAM_SIZE];
-					if (!MM_parameters.MapperUNROM.characterRAM)
+					mm.parameters.MapperUNROM.characterRAM = new uint8_t[MM__CHARACTER_RAM_SIZE]();
+					if (!mm.parameters.MapperUNROM.characterRAM)
 					{
 						return (false);
 					}
 				}
 
-				MM_parameters.MapperUNROM.lastBank = &CR::getROM()[(MM_parameters.MapperUNROM.bankCount - 1) * 0x4000];
-				MM_parameters.MapperUNROM.selectedBank = 0;
+				mm.parameters.MapperUNROM.lastBank = &CR::getROM()[(mm.parameters.MapperUNROM.bankCount - 1) * 0x4000];
+				mm.parameters.MapperUNROM.selectedBank = 0;
 
 				break;
 			}
 
 			case MAPPER_CNROM:
 			{
-				MM_busFunctions.writePRG = Mapper_CNROM__writePRG;
-				MM_busFunctions.readPRG = Mapper_CNROM__readPRG;
-				MM_busFunctions.writeCHR = Mapper_CNROM__writeCHR;
-				MM_busFunctions.readCHR = Mapper_CNROM__readCHR;
+				mm.busFunctions.writePRG = Mapper_CNROM__writePRG;
+				mm.busFunctions.readPRG = Mapper_CNROM__readPRG;
+				mm.busFunctions.mapPRG = Mapper_CNROM__mapPRG;
+				mm.busFunctions.writeCHR = Mapper_CNROM__writeCHR;
+				mm.busFunctions.readCHR = Mapper_CNROM__readCHR;
 
-				MM_nameTableMirroring = CR::getNameTableMirroring();
+				mm.nameTableMirroring = CR::getNameTableMirroring();
 
-				MM_parameters.MapperCNROM.bankCount = CR::getROMBankCount();
-				MM_parameters.MapperCNROM.selectedBank = 0;
+				mm.parameters.MapperCNROM.bankCount = CR::getROMBankCount();
+				mm.parameters.MapperCNROM.selectedBank = 0;
 
 				break;
 			}
@@ -254,53 +198,56 @@ namespace MM
 			{
 				return (false); // no longer supported
 
-				MM_busFunctions.writePRG = Mapper_MMC3__writePRG;
-				MM_busFunctions.readPRG = Mapper_MMC3__readPRG;
-				MM_busFunctions.writeCHR = Mapper_MMC3__writeCHR;
-				MM_busFunctions.readCHR = Mapper_MMC3__readCHR;
+				mm.busFunctions.writePRG = Mapper_MMC3__writePRG;
+				mm.busFunctions.readPRG = Mapper_MMC3__readPRG;
+				mm.busFunctions.mapPRG = Mapper_MMC3__mapPRG;
+				mm.busFunctions.writeCHR = Mapper_MMC3__writeCHR;
+				mm.busFunctions.readCHR = Mapper_MMC3__readCHR;
 
-				MM_nameTableMirroring = CR::getNameTableMirroring();
+				mm.nameTableMirroring = CR::getNameTableMirroring();
 
-				MM_parameters.MapperMMC3.PRGbankFixed0 = &CR::getROM()[(CR::getROMBankCount() - 1) * 0x4000];
-				MM_parameters.MapperMMC3.PRGbankFixed1 = &MM_parameters.MapperMMC3.PRGbankFixed0[0x2000];
-				MM_parameters.MapperMMC3.PRGbank0 = MM_parameters.MapperMMC3.PRGbankFixed0;
-				MM_parameters.MapperMMC3.PRGbank1 = MM_parameters.MapperMMC3.PRGbankFixed1;
+				mm.parameters.MapperMMC3.PRGbankFixed0 = &CR::getROM()[(CR::getROMBankCount() - 1) * 0x4000];
+				mm.parameters.MapperMMC3.PRGbankFixed1 = &mm.parameters.MapperMMC3.PRGbankFixed0[0x2000];
+				mm.parameters.MapperMMC3.PRGbank0 = mm.parameters.MapperMMC3.PRGbankFixed0;
+				mm.parameters.MapperMMC3.PRGbank1 = mm.parameters.MapperMMC3.PRGbankFixed1;
 
-				MM_parameters.MapperMMC3.CHR2k0 = CR::getVideoROM();
-				MM_parameters.MapperMMC3.CHR2k1 = &CR::getVideoROM()[0x0800];
-				MM_parameters.MapperMMC3.CHR1k0 = &CR::getVideoROM()[0x1000];
-				MM_parameters.MapperMMC3.CHR1k1 = &CR::getVideoROM()[0x1400];
-				MM_parameters.MapperMMC3.CHR1k2 = &CR::getVideoROM()[0x1800];
-				MM_parameters.MapperMMC3.CHR1k3 = &CR::getVideoROM()[0x1C00];
+				mm.parameters.MapperMMC3.CHR2k0 = CR::getVideoROM();
+				mm.parameters.MapperMMC3.CHR2k1 = &CR::getVideoROM()[0x0800];
+				mm.parameters.MapperMMC3.CHR1k0 = &CR::getVideoROM()[0x1000];
+				mm.parameters.MapperMMC3.CHR1k1 = &CR::getVideoROM()[0x1400];
+				mm.parameters.MapperMMC3.CHR1k2 = &CR::getVideoROM()[0x1800];
+				mm.parameters.MapperMMC3.CHR1k3 = &CR::getVideoROM()[0x1C00];
 
-				MM_parameters.MapperMMC3.counterReloadValue = 0xFF;
-				MM_parameters.MapperMMC3.enableIRQ = false;
-				MM_parameters.MapperMMC3.causeIRQ = false;
+				mm.parameters.MapperMMC3.counterReloadValue = 0xFF;
+				mm.parameters.MapperMMC3.enableIRQ = false;
+				mm.parameters.MapperMMC3.causeIRQ = false;
 
-				MM_parameters.MapperMMC3.invertPRG = false;
-				MM_parameters.MapperMMC3.invertCHR = false;
+				mm.parameters.MapperMMC3.invertPRG = false;
+				mm.parameters.MapperMMC3.invertCHR = false;
 
 				void(*callback)(bool vblank) = [](bool vblank) -> void
 				{
+					MM_state_t &mm = CC_console->mm;
+
 					if (vblank)
 					{
 						return;
 					}
 
-					if (MM_parameters.MapperMMC3.counterReload)
+					if (mm.parameters.MapperMMC3.counterReload)
 					{
-						MM_parameters.MapperMMC3.counterValue = MM_parameters.MapperMMC3.counterReloadValue;
-						MM_parameters.MapperMMC3.counterReload = false;
+						mm.parameters.MapperMMC3.counterValue = mm.parameters.MapperMMC3.counterReloadValue;
+						mm.parameters.MapperMMC3.counterReload = false;
 					}
-					else if (MM_parameters.MapperMMC3.counterValue > 0)
+					else if (mm.parameters.MapperMMC3.counterValue > 0)
 					{
-						--MM_parameters.MapperMMC3.counterValue;
+						--mm.parameters.MapperMMC3.counterValue;
 
-						if (!MM_parameters.MapperMMC3.counterValue)
+						if (!mm.parameters.MapperMMC3.counterValue)
 						{
-							MM_parameters.MapperMMC3.counterReload = true;
+							mm.parameters.MapperMMC3.counterReload = true;
 
-							if (MM_parameters.MapperMMC3.enableIRQ)
+							if (mm.parameters.MapperMMC3.enableIRQ)
 							{
 								CPU::pullInterruptPin(INTERRUPT_SOURCE_MM);
 							}
@@ -577,44 +524,63 @@ namespace MM
 			}
 		}
 
-		MM_currentMapper = mapper_type;
+		mm.currentMapper = mapper_type;
 		return (true);
 	}
 
 	void writePRG(uint16_t address, uint8_t data)
 	{
-		MM_busFunctions.writePRG(address, data);
+		MM_state_t &mm = CC_console->mm;
+
+		mm.busFunctions.writePRG(address, data);
 	}
 
 	uint8_t readPRG(uint16_t address)
 	{
-		return (MM_busFunctions.readPRG(address));
+		MM_state_t &mm = CC_console->mm;
+
+		return (mm.busFunctions.readPRG(address));
+	}
+
+	uint32_t mapPRG(uint16_t address)
+	{
+		MM_state_t &mm = CC_console->mm;
+
+		return (mm.busFunctions.mapPRG(address));
 	}
 
 	void writeCHR(uint16_t address, uint8_t data)
 	{
-		MM_busFunctions.writeCHR(address, data);
+		MM_state_t &mm = CC_console->mm;
+
+		mm.busFunctions.writeCHR(address, data);
 	}
 
 	uint8_t readCHR(uint16_t address)
 	{
-		return (MM_busFunctions.readCHR(address));
+		MM_state_t &mm = CC_console->mm;
+
+		return (mm.busFunctions.readCHR(address));
 	}
 
 	uint8_t getNameTableMirroring()
 	{
-		return (MM_nameTableMirroring);
+		MM_state_t &mm = CC_console->mm;
+
+		return (mm.nameTableMirroring);
 	}
 
 	void clean()
 	{
-		switch (MM_currentMapper)
+		MM_state_t &mm = CC_console->mm;
+
+		switch (mm.currentMapper)
 		{
 			case MAPPER_NONE:
 			{
-				if (MM_parameters.MapperNone.characterRAM)
+				if (mm.parameters.MapperNone.characterRAM)
 				{
-					delete[] MM_parameters.MapperNone.characterRAM;
+					delete[] mm.parameters.MapperNone.characterRAM;
 				}
 
 				break;
@@ -622,9 +588,9 @@ namespace MM
 
 			case MAPPER_MMC1:
 			{
-				if (MM_parameters.MapperMMC1.characterRAM)
+				if (mm.parameters.MapperMMC1.characterRAM)
 				{
-					delete[] MM_parameters.MapperMMC1.characterRAM;
+					delete[] mm.parameters.MapperMMC1.characterRAM;
 				}
 
 				break;
@@ -632,9 +598,9 @@ namespace MM
 
 			case MAPPER_UNROM:
 			{
-				if (MM_parameters.MapperUNROM.characterRAM)
+				if (mm.parameters.MapperUNROM.characterRAM)
 				{
-					delete[] MM_parameters.MapperUNROM.characterRAM;
+					delete[] mm.parameters.MapperUNROM.characterRAM;
 				}
 
 				break;
@@ -661,7 +627,9 @@ void Mapper_None__writePRG(uint16_t address, uint8_t data)
 
 uint8_t Mapper_None__readPRG(uint16_t address)
 {
-	if (MM_parameters.MapperNone.bankCount == 1)
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperNone.bankCount == 1)
 	{ // uses mirroring
 		return (CR::getROM()[(address - 0x8000) & 0x3FFF]);
 	}
@@ -671,20 +639,39 @@ uint8_t Mapper_None__readPRG(uint16_t address)
 	}
 }
 
+uint32_t Mapper_None__mapPRG(uint16_t address)
+{
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperNone.bankCount == 1)
+	{ // uses mirroring
+		return ((address - 0x8000) & 0x3FFF);
+	}
+	else
+	{
+		return (address - 0x8000);
+	}
+}
+
+
 void Mapper_None__writeCHR(uint16_t address, uint8_t data)
 {
-	if (MM_parameters.MapperNone.characterRAM)
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperNone.characterRAM)
 	{
-		MM_parameters.MapperNone.characterRAM[address] = data;
+		mm.parameters.MapperNone.characterRAM[address] = data;
 	}
 	// else ... writing to CHR-ROM is not allowed in this mapper
 }
 
 uint8_t Mapper_None__readCHR(uint16_t address)
 {
-	if (MM_parameters.MapperNone.characterRAM)
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperNone.characterRAM)
 	{
-		return (MM_parameters.MapperNone.characterRAM[address]);
+		return (mm.parameters.MapperNone.characterRAM[address]);
 	}
 	else
 	{
@@ -695,196 +682,242 @@ uint8_t Mapper_None__readCHR(uint16_t address)
 /* MAPPER_MMC1 function definitions */
 void Mapper_MMC1__writePRG(uint16_t address, uint8_t data)
 {
+	MM_state_t &mm = CC_console->mm;
+
 	if (!(data & 0x80))
 	{
-		MM_parameters.MapperMMC1.temporaryRegister = (MM_parameters.MapperMMC1.temporaryRegister >> 1) | ((data & 0x01) << 4);
-		++MM_parameters.MapperMMC1.writeCounter;
+		mm.parameters.MapperMMC1.temporaryRegister = (mm.parameters.MapperMMC1.temporaryRegister >> 1) | ((data & 0x01) << 4);
+		++mm.parameters.MapperMMC1.writeCounter;
 
-		if (MM_parameters.MapperMMC1.writeCounter == 5)
+		if (mm.parameters.MapperMMC1.writeCounter == 5)
 		{
 			if (address < 0xA000)
 			{ // control register
-				switch (MM_parameters.MapperMMC1.temporaryRegister & 0x03)
+				switch (mm.parameters.MapperMMC1.temporaryRegister & 0x03)
 				{
 					case 0:
 					{
-						MM_nameTableMirroring = MM__NAME_TABLE_ONE_SCREEN_LOWER;
+						mm.nameTableMirroring = MM__NAME_TABLE_ONE_SCREEN_LOWER;
 						break;
 					}
 
 					case 1:
 					{
-						MM_nameTableMirroring = MM__NAME_TABLE_ONE_SCREEN_HIGHER;
+						mm.nameTableMirroring = MM__NAME_TABLE_ONE_SCREEN_HIGHER;
 						break;
 					}
 
 					case 2:
 					{
-						MM_nameTableMirroring = MM__NAME_TABLE_VERTICAL;
+						mm.nameTableMirroring = MM__NAME_TABLE_VERTICAL;
 						break;
 					}
 
 					case 3:
 					{
-						MM_nameTableMirroring = MM__NAME_TABLE_HORIZONTAL;
+						mm.nameTableMirroring = MM__NAME_TABLE_HORIZONTAL;
 						break;
 					}
 				}
-				MB::changeMirroring(MM_nameTableMirroring);
+				MB::changeMirroring(mm.nameTableMirroring);
 
-				MM_parameters.MapperMMC1.modePRG = (MM_parameters.MapperMMC1.temporaryRegister & 0x0C) >> 2;
-				MM_parameters.MapperMMC1.modeCHR = (MM_parameters.MapperMMC1.temporaryRegister & 0x10) >> 4;
+				mm.parameters.MapperMMC1.modePRG = (mm.parameters.MapperMMC1.temporaryRegister & 0x0C) >> 2;
+				mm.parameters.MapperMMC1.modeCHR = (mm.parameters.MapperMMC1.temporaryRegister & 0x10) >> 4;
 
-				if (MM_parameters.MapperMMC1.modePRG < 2)
+				if (mm.parameters.MapperMMC1.modePRG < 2)
 				{
-					MM_parameters.MapperMMC1.firstBankPRG = &CR::getROM()[(MM_parameters.MapperMMC1.registerPRG & ~0x01) * 0x4000];
-					MM_parameters.MapperMMC1.secondBankPRG = &MM_parameters.MapperMMC1.firstBankPRG[0x4000];
+					mm.parameters.MapperMMC1.firstBankPRG = &CR::getROM()[(mm.parameters.MapperMMC1.registerPRG & ~0x01) * 0x4000];
+					mm.parameters.MapperMMC1.secondBankPRG = &mm.parameters.MapperMMC1.firstBankPRG[0x4000];
 				}
-				else if (MM_parameters.MapperMMC1.modePRG == 2)
+				else if (mm.parameters.MapperMMC1.modePRG == 2)
 				{
-					MM_parameters.MapperMMC1.firstBankPRG = CR::getROM();
-					MM_parameters.MapperMMC1.secondBankPRG = &MM_parameters.MapperMMC1.firstBankPRG[MM_parameters.MapperMMC1.registerPRG * 0x4000];
+					mm.parameters.MapperMMC1.firstBankPRG = CR::getROM();
+					mm.parameters.MapperMMC1.secondBankPRG = &mm.parameters.MapperMMC1.firstBankPRG[mm.parameters.MapperMMC1.registerPRG * 0x4000];
 				}
 				else
 				{
-					MM_parameters.MapperMMC1.firstBankPRG = &CR::getROM()[MM_parameters.MapperMMC1.registerPRG * 0x4000];
-					MM_parameters.MapperMMC1.secondBankPRG = &CR::getROM()[(MM_parameters.MapperMMC1.bankCount - 1) * 0x4000];
+					mm.parameters.MapperMMC1.firstBankPRG = &CR::getROM()[mm.parameters.MapperMMC1.registerPRG * 0x4000];
+					mm.parameters.MapperMMC1.secondBankPRG = &CR::getROM()[(mm.parameters.MapperMMC1.bankCount - 1) * 0x4000];
 				}
 
-				if (MM_parameters.MapperMMC1.modeCHR)
+				if (mm.parameters.MapperMMC1.modeCHR)
 				{
-					MM_parameters.MapperMMC1.firstBankCHR = &CR::getVideoROM()[MM_parameters.MapperMMC1.registerCHR0 * 0x1000];
-					MM_parameters.MapperMMC1.secondBankCHR = &CR::getVideoROM()[MM_parameters.MapperMMC1.registerCHR1 * 0x1000];
+					mm.parameters.MapperMMC1.firstBankCHR = &CR::getVideoROM()[mm.parameters.MapperMMC1.registerCHR0 * 0x1000];
+					mm.parameters.MapperMMC1.secondBankCHR = &CR::getVideoROM()[mm.parameters.MapperMMC1.registerCHR1 * 0x1000];
 				}
 				else
 				{
-					MM_parameters.MapperMMC1.firstBankCHR = &CR::getVideoROM()[(MM_parameters.MapperMMC1.registerCHR0 | 0x01) * 0x1000];
-					MM_parameters.MapperMMC1.secondBankCHR = &MM_parameters.MapperMMC1.firstBankCHR[0x1000];
+					mm.parameters.MapperMMC1.firstBankCHR = &CR::getVideoROM()[(mm.parameters.MapperMMC1.registerCHR0 | 0x01) * 0x1000];
+					mm.parameters.MapperMMC1.secondBankCHR = &mm.parameters.MapperMMC1.firstBankCHR[0x1000];
 				}
 			}
 			else if (address < 0xC000)
 			{ // CHR0 register
-				MM_parameters.MapperMMC1.registerCHR0 = MM_parameters.MapperMMC1.temporaryRegister;
-				MM_parameters.MapperMMC1.firstBankCHR = &CR::getVideoROM()[(MM_parameters.MapperMMC1.registerCHR0 | (MM_parameters.MapperMMC1.modeCHR ? 0x00 : 0x01)) * 0x1000];
+				mm.parameters.MapperMMC1.registerCHR0 = mm.parameters.MapperMMC1.temporaryRegister;
+				mm.parameters.MapperMMC1.firstBankCHR = &CR::getVideoROM()[(mm.parameters.MapperMMC1.registerCHR0 | (mm.parameters.MapperMMC1.modeCHR ? 0x00 : 0x01)) * 0x1000];
 
-				if (!MM_parameters.MapperMMC1.modeCHR)
+				if (!mm.parameters.MapperMMC1.modeCHR)
 				{
-					MM_parameters.MapperMMC1.secondBankCHR = &MM_parameters.MapperMMC1.firstBankCHR[0x1000];
+					mm.parameters.MapperMMC1.secondBankCHR = &mm.parameters.MapperMMC1.firstBankCHR[0x1000];
 				}
 			}
 			else if (address < 0xE000)
 			{ // CHR1 register
-				MM_parameters.MapperMMC1.registerCHR1 = MM_parameters.MapperMMC1.temporaryRegister;
+				mm.parameters.MapperMMC1.registerCHR1 = mm.parameters.MapperMMC1.temporaryRegister;
 
-				if (MM_parameters.MapperMMC1.modeCHR)
+				if (mm.parameters.MapperMMC1.modeCHR)
 				{
-					MM_parameters.MapperMMC1.secondBankCHR = &CR::getVideoROM()[MM_parameters.MapperMMC1.registerCHR1 * 0x1000];
+					mm.parameters.MapperMMC1.secondBankCHR = &CR::getVideoROM()[mm.parameters.MapperMMC1.registerCHR1 * 0x1000];
 				}
 			}
 			else
 			{ // PRG register
-				MM_parameters.MapperMMC1.temporaryRegister &= 0x0F;
-				MM_parameters.MapperMMC1.registerPRG = MM_parameters.MapperMMC1.temporaryRegister;
+				mm.parameters.MapperMMC1.temporaryRegister &= 0x0F;
+				mm.parameters.MapperMMC1.registerPRG = mm.parameters.MapperMMC1.temporaryRegister;
 
-				if (MM_parameters.MapperMMC1.modePRG < 2)
+				if (mm.parameters.MapperMMC1.modePRG < 2)
 				{
-					MM_parameters.MapperMMC1.firstBankPRG = &CR::getROM()[(MM_parameters.MapperMMC1.registerPRG & ~0x01) * 0x4000];
-					MM_parameters.MapperMMC1.secondBankPRG = &MM_parameters.MapperMMC1.firstBankPRG[0x4000];
+					mm.parameters.MapperMMC1.firstBankPRG = &CR::getROM()[(mm.parameters.MapperMMC1.registerPRG & ~0x01) * 0x4000];
+					mm.parameters.MapperMMC1.secondBankPRG = &mm.parameters.MapperMMC1.firstBankPRG[0x4000];
 				}
-				else if (MM_parameters.MapperMMC1.modePRG == 2)
+				else if (mm.parameters.MapperMMC1.modePRG == 2)
 				{
-					MM_parameters.MapperMMC1.firstBankPRG = CR::getROM();
-					MM_parameters.MapperMMC1.secondBankPRG = &MM_parameters.MapperMMC1.firstBankPRG[MM_parameters.MapperMMC1.registerPRG * 0x4000];
+					mm.parameters.MapperMMC1.firstBankPRG = CR::getROM();
+					mm.parameters.MapperMMC1.secondBankPRG = &mm.parameters.MapperMMC1.firstBankPRG[mm.parameters.MapperMMC1.registerPRG * 0x4000];
 				}
 				else
 				{
-					MM_parameters.MapperMMC1.firstBankPRG = &CR::getROM()[MM_parameters.MapperMMC1.registerPRG * 0x4000];
-					MM_parameters.MapperMMC1.secondBankPRG = &CR::getROM()[(MM_parameters.MapperMMC1.bankCount - 1) * 0x4000];
+					mm.parameters.MapperMMC1.firstBankPRG = &CR::getROM()[mm.parameters.MapperMMC1.registerPRG * 0x4000];
+					mm.parameters.MapperMMC1.secondBankPRG = &CR::getROM()[(mm.parameters.MapperMMC1.bankCount - 1) * 0x4000];
 				}
 			}
 
-			MM_parameters.MapperMMC1.temporaryRegister = 0;
-			MM_parameters.MapperMMC1.writeCounter = 0;
+			mm.parameters.MapperMMC1.temporaryRegister = 0;
+			mm.parameters.MapperMMC1.writeCounter = 0;
 		}
 	}
 	else
 	{
-		MM_parameters.MapperMMC1.temporaryRegister = 0x00;
-		MM_parameters.MapperMMC1.writeCounter = 0;
-		MM_parameters.MapperMMC1.modePRG = 3;
+		mm.parameters.MapperMMC1.temporaryRegister = 0x00;
+		mm.parameters.MapperMMC1.writeCounter = 0;
+		mm.parameters.MapperMMC1.modePRG = 3;
 
-		MM_parameters.MapperMMC1.firstBankPRG = &CR::getROM()[MM_parameters.MapperMMC1.registerPRG * 0x4000];
-		MM_parameters.MapperMMC1.secondBankPRG = &CR::getROM()[(MM_parameters.MapperMMC1.bankCount - 1) * 0x4000];
+		mm.parameters.MapperMMC1.firstBankPRG = &CR::getROM()[mm.parameters.MapperMMC1.registerPRG * 0x4000];
+		mm.parameters.MapperMMC1.secondBankPRG = &CR::getROM()[(mm.parameters.MapperMMC1.bankCount - 1) * 0x4000];
 	}
 }
 
 uint8_t Mapper_MMC1__readPRG(uint16_t address)
 {
+	MM_state_t &mm = CC_console->mm;
+
 	if (address < 0xC000)
 	{
-		return (MM_parameters.MapperMMC1.firstBankPRG[address & 0x3FFF]);
+		return (mm.parameters.MapperMMC1.firstBankPRG[address & 0x3FFF]);
 	}
 	else
 	{
-		return (MM_parameters.MapperMMC1.secondBankPRG[address & 0x3FFF]);
+		return (mm.parameters.MapperMMC1.secondBankPRG[address & 0x3FFF]);
 	}
 }
 
+uint32_t Mapper_MMC1__mapPRG(uint16_t address)
+{
+	MM_state_t &mm = CC_console->mm;
+
+	if (address < 0xC000)
+	{
+		return ((uint32_t)(mm.parameters.MapperMMC1.firstBankPRG - CR::getROM()) + (address & 0x3FFF));
+	}
+	else
+	{
+		return ((uint32_t)(mm.parameters.MapperMMC1.secondBankPRG - CR::getROM()) + (address & 0x3FFF));
+	}
+}
+
+
 void Mapper_MMC1__writeCHR(uint16_t address, uint8_t data)
 {
-	if (MM_parameters.MapperMMC1.characterRAM)
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperMMC1.characterRAM)
 	{
-		MM_parameters.MapperMMC1.characterRAM[address] = data;
+		mm.parameters.MapperMMC1.characterRAM[address] = data;
 	}
 }
 
 uint8_t Mapper_MMC1__readCHR(uint16_t address)
 {
-	if (MM_parameters.MapperMMC1.characterRAM)
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperMMC1.characterRAM)
 	{
-		return (MM_parameters.MapperMMC1.characterRAM[address]);
+		return (mm.parameters.MapperMMC1.characterRAM[address]);
 	}
 	else if (address < 0x1000)
 	{
-		return (MM_parameters.MapperMMC1.firstBankCHR[address & 0x0FFF]);
+		return (mm.parameters.MapperMMC1.firstBankCHR[address & 0x0FFF]);
 	}
 	else
 	{
-		return (MM_parameters.MapperMMC1.secondBankCHR[address & 0x0FFF]);
+		return (mm.parameters.MapperMMC1.secondBankCHR[address & 0x0FFF]);
 	}
 }
 
 /* MAPPER_UNROM function definitions */
 void Mapper_UNROM__writePRG(uint16_t address, uint8_t data)
 {
-	MM_parameters.MapperUNROM.selectedBank = data;
+	MM_state_t &mm = CC_console->mm;
+
+	mm.parameters.MapperUNROM.selectedBank = data;
 }
 
 uint8_t Mapper_UNROM__readPRG(uint16_t address)
 {
+	MM_state_t &mm = CC_console->mm;
+
+	if (address < 0xC000)
+	{
+		return (CR::getROM()[(address & 0x3FFF) | (mm.parameters.MapperUNROM.selectedBank << 14)]);
+	}
+	else
+	{
+		return (mm.parameters.MapperUNROM.lastBank[address & 0x3FFF]);
+	}
+}
+
+uint32_t Mapper_UNROM__mapPRG(uint16_t address)
+{
+	MM_state_t &mm = CC_console->mm;
+
 	if (address < 0xC000)
 	{
-		return (CR::getROM()[(address & 0x3FFF) | (MM_parameters.MapperUNROM.selectedBank << 14)]);
+		return ((address & 0x3FFF) | (mm.parameters.MapperUNROM.selectedBank << 14));
 	}
 	else
 	{
-		return (MM_parameters.MapperUNROM.lastBank[address & 0x3FFF]);
+		return ((uint32_t)(mm.parameters.MapperUNROM.lastBank - CR::getROM()) + (address & 0x3FFF));
 	}
 }
 
+
 void Mapper_UNROM__writeCHR(uint16_t address, uint8_t data)
 {
-	if (MM_parameters.MapperUNROM.characterRAM)
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperUNROM.characterRAM)
 	{
-		MM_parameters.MapperUNROM.characterRAM[address] = data;
+		mm.parameters.MapperUNROM.characterRAM[address] = data;
 	}
 }
 
 uint8_t Mapper_UNROM__readCHR(uint16_t address)
 {
-	if (MM_parameters.MapperUNROM.characterRAM)
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperUNROM.characterRAM)
 	{
-		return (MM_parameters.MapperUNROM.characterRAM[address]);
+		return (mm.parameters.MapperUNROM.characterRAM[address]);
 	}
 	else
 	{
@@ -895,12 +928,16 @@ uint8_t Mapper_UNROM__readCHR(uint16_t address)
 /* MAPPER_CNROM function definitions */
 void Mapper_CNROM__writePRG(uint16_t address, uint8_t data)
 {
-	MM_parameters.MapperCNROM.selectedBank = data & 0x3;
+	MM_state_t &mm = CC_console->mm;
+
+	mm.parameters.MapperCNROM.selectedBank = data & 0x3;
 }
 
 uint8_t Mapper_CNROM__readPRG(uint16_t address)
 {
-	if (MM_parameters.MapperCNROM.bankCount == 1)
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperCNROM.bankCount == 1)
 	{
 		return (CR::getROM()[(address - 0x8000) & 0x3FFF]);
 	}
@@ -910,6 +947,21 @@ uint8_t Mapper_CNROM__readPRG(uint16_t address)
 	}
 }
 
+uint32_t Mapper_CNROM__mapPRG(uint16_t address)
+{
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperCNROM.bankCount == 1)
+	{
+		return ((address - 0x8000) & 0x3FFF);
+	}
+	else
+	{
+		return (address - 0x8000);
+	}
+}
+
+
 void Mapper_CNROM__writeCHR(uint16_t address, uint8_t data)
 {
 	return; // this mapper does not allow writing to CHR-ROM
@@ -917,63 +969,67 @@ void Mapper_CNROM__writeCHR(uint16_t address, uint8_t data)
 
 uint8_t Mapper_CNROM__readCHR(uint16_t address)
 {
-	return (CR::getVideoROM()[address | (MM_parameters.MapperCNROM.selectedBank << 13)]);
+	MM_state_t &mm = CC_console->mm;
+
+	return (CR::getVideoROM()[address | (mm.parameters.MapperCNROM.selectedBank << 13)]);
 }
 
 /* MAPPER_MMC3 function definitions */
 void Mapper_MMC3__writePRG(uint16_t address, uint8_t data)
 {
+	MM_state_t &mm = CC_console->mm;
+
 	if (address < 0xA000)
 	{
 		if (address & 1)
 		{ // Bank data register
-			switch (MM_parameters.MapperMMC3.bankSelect)
+			switch (mm.parameters.MapperMMC3.bankSelect)
 			{
 				case 0: // CHR 2K bank 0
 				{
-					MM_parameters.MapperMMC3.CHR2k0 = &CR::getVideoROM()[data * 0x0400];
+					mm.parameters.MapperMMC3.CHR2k0 = &CR::getVideoROM()[data * 0x0400];
 
 					break;
 				}
 
 				case 1: // CHR 2K bank 1
 				{
-					MM_parameters.MapperMMC3.CHR2k1 = &CR::getVideoROM()[data * 0x0400];
+					mm.parameters.MapperMMC3.CHR2k1 = &CR::getVideoROM()[data * 0x0400];
 
 					break;
 				}
 
 				case 2: // CHR 1K bank 0
 				{
-					MM_parameters.MapperMMC3.CHR1k0 = &CR::getVideoROM()[data * 0x0400];
+					mm.parameters.MapperMMC3.CHR1k0 = &CR::getVideoROM()[data * 0x0400];
 
 					break;
 				}
 
 				case 3: // CHR 1K bank 1
 				{
-					MM_parameters.MapperMMC3.CHR1k1 = &CR::getVideoROM()[data * 0x0400];
+					mm.parameters.MapperMMC3.CHR1k1 = &CR::getVideoROM()[data * 0x0400];
 
 					break;
 				}
 
 				case 4: // CHR 1K bank 2
 				{
-					MM_parameters.MapperMMC3.CHR1k2 = &CR::getVideoROM()[data * 0x0400];
+					mm.parameters.MapperMMC3.CHR1k2 = &CR::getVideoROM()[data * 0x0400];
 
 					break;
 				}
 
 				case 5: // CHR 1K bank 3
 				{
-					MM_parameters.MapperMMC3.CHR1k3 = &CR::getVideoROM()[data * 0x0400];
+					mm.parameters.MapperMMC3.CHR1k3 = &CR::getVideoROM()[data * 0x0400];
 
 					break;
 				}
 
 				case 6: // PRG bank 0
 				{
-					MM_parameters.MapperMMC3.PRGbank0 = &CR::getROM()[data * 0x2000];
+					mm.parameters.MapperMMC3.PRGbank0 = &CR::getROM()[data * 0x2000];
 					//debug("6  " << std::hex << (int)address << "  " << (int)data, DEBUG_LEVEL_INFO);
 
 					break;
@@ -981,7 +1037,7 @@ void Mapper_MMC3__writePRG(uint16_t address, uint8_t data)
 
 				case 7: // PRG bank 1
 				{
-					MM_parameters.MapperMMC3.PRGbank1 = &CR::getROM()[data * 0x2000];
+					mm.parameters.MapperMMC3.PRGbank1 = &CR::getROM()[data * 0x2000];
 					//debug("7  " << std::hex << (int)address << "  " << (int)data, DEBUG_LEVEL_INFO);
 
 					break;
@@ -990,9 +1046,9 @@ void Mapper_MMC3__writePRG(uint16_t address, uint8_t data)
 		}
 		else
 		{ // Bank select register
-			MM_parameters.MapperMMC3.bankSelect = data & 0x07;
-			MM_parameters.MapperMMC3.invertPRG = (data & 0x40) ? true : false;
-			MM_parameters.MapperMMC3.invertCHR = (data & 0x80) ? true : false;
+			mm.parameters.MapperMMC3.bankSelect = data & 0x07;
+			mm.parameters.MapperMMC3.invertPRG = (data & 0x40) ? true : false;
+			mm.parameters.MapperMMC3.invertCHR = (data & 0x80) ? true : false;
 			//debug(std::hex << (int)address << "  " << (int)data, DEBUG_LEVEL_INFO);
 		}
 	}
@@ -1004,31 +1060,31 @@ void Mapper_MMC3__writePRG(uint16_t address, uint8_t data)
 		}
 		else
 		{ // Mirroring register
-			MM_nameTableMirroring = (data & 1) ^ 1;
-			MB::changeMirroring(MM_nameTableMirroring);
+			mm.nameTableMirroring = (data & 1) ^ 1;
+			MB::changeMirroring(mm.nameTableMirroring);
 		}
 	}
 	else if (address < 0xE000)
 	{
 		if (address & 1)
 		{ // IRQ reload request register
-			MM_parameters.MapperMMC3.counterReload = true;
+			mm.parameters.MapperMMC3.counterReload = true;
 			CPU::releaseInterruptPin(INTERRUPT_SOURCE_MM);
 		}
 		else
 		{ // IRQ reset counter value register
-			MM_parameters.MapperMMC3.counterReloadValue = data;
+			mm.parameters.MapperMMC3.counterReloadValue = data;
 		}
 	}
 	else
 	{
 		if (address & 1)
 		{ // IRQ enable register
-			MM_parameters.MapperMMC3.enableIRQ = true;
+			mm.parameters.MapperMMC3.enableIRQ = true;
 		}
 		else
 		{ // IRQ disable register
-			MM_parameters.MapperMMC3.enableIRQ = false;
+			mm.parameters.MapperMMC3.enableIRQ = false;
 			CPU::releaseInterruptPin(INTERRUPT_SOURCE_MM);
 		}
 	}
@@ -1036,46 +1092,74 @@ void Mapper_MMC3__writePRG(uint16_t address, uint8_t data)
 
 uint8_t Mapper_MMC3__readPRG(uint16_t address)
 {
-	if (MM_parameters.MapperMMC3.invertPRG)
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperMMC3.invertPRG)
 	{
 		if (address < 0xA000)
 		{
-			return (MM_parameters.MapperMMC3.PRGbankFixed0[address - 0x8000]);
+			return (mm.parameters.MapperMMC3.PRGbankFixed0[address - 0x8000]);
 		}
 		else if (address < 0xC000)
 		{
-			return (MM_parameters.MapperMMC3.PRGbank1[address - 0xA000]);
+			return (mm.parameters.MapperMMC3.PRGbank1[address - 0xA000]);
 		}
 		else if (address < 0xE000)
 		{
-			return (MM_parameters.MapperMMC3.PRGbank0[address - 0xC000]);
+			return (mm.parameters.MapperMMC3.PRGbank0[address - 0xC000]);
 		}
 		else
 		{
-			return (MM_parameters.MapperMMC3.PRGbankFixed1[address - 0xE000]);
+			return (mm.parameters.MapperMMC3.PRGbankFixed1[address - 0xE000]);
 		}
 	}
 	else
 	{
 		if (address < 0xA000)
 		{
-			return (MM_parameters.MapperMMC3.PRGbank0[address - 0x8000]);
+			return (mm.parameters.MapperMMC3.PRGbank0[address - 0x8000]);
 		}
 		else if (address < 0xC000)
 		{
-			return (MM_parameters.MapperMMC3.PRGbank1[address - 0xA000]);
+			return (mm.parameters.MapperMMC3.PRGbank1[address - 0xA000]);
 		}
 		else if (address < 0xE000)
 		{
-			return (MM_parameters.MapperMMC3.PRGbankFixed0[address - 0xC000]);
+			return (mm.parameters.MapperMMC3.PRGbankFixed0[address - 0xC000]);
 		}
 		else
 		{
-			return (MM_parameters.MapperMMC3.PRGbankFixed1[address - 0xE000]);
+			return (mm.parameters.MapperMMC3.PRGbankFixed1[address - 0xE000]);
 		}
 	}
 }
 
+uint32_t Mapper_MMC3__mapPRG(uint16_t address)
+{
+	MM_state_t &mm = CC_console->mm;
+
+	const uint8_t *bank;
+	if (address < 0xA000)
+	{
+		bank = mm.parameters.MapperMMC3.invertPRG ? mm.parameters.MapperMMC3.PRGbankFixed0 : mm.parameters.MapperMMC3.PRGbank0;
+	}
+	else if (address < 0xC000)
+	{
+		bank = mm.parameters.MapperMMC3.PRGbank1;
+	}
+	else if (address < 0xE000)
+	{
+		bank = mm.parameters.MapperMMC3.invertPRG ? mm.parameters.MapperMMC3.PRGbank0 : mm.parameters.MapperMMC3.PRGbankFixed0;
+	}
+	else
+	{
+		bank = mm.parameters.MapperMMC3.PRGbankFixed1;
+	}
+
+	return ((uint32_t)(bank - CR::getROM()) + (address & 0x1FFF));
+}
+
+
 void Mapper_MMC3__writeCHR(uint16_t address, uint8_t data)
 {
 	return; // this mapper does not allow writing to CHR-ROM
@@ -1083,58 +1167,60 @@ void Mapper_MMC3__writeCHR(uint16_t address, uint8_t data)
 
 uint8_t Mapper_MMC3__readCHR(uint16_t address)
 {
-	if (MM_parameters.MapperMMC3.invertCHR)
+	MM_state_t &mm = CC_console->mm;
+
+	if (mm.parameters.MapperMMC3.invertCHR)
 	{
 		if (address < 0x0400)
 		{
-			return (MM_parameters.MapperMMC3.CHR1k0[address]);
+			return (mm.parameters.MapperMMC3.CHR1k0[address]);
 		}
 		else if (address < 0x0800)
 		{
-			return (MM_parameters.MapperMMC3.CHR1k1[address - 0x0400]);
+			return (mm.parameters.MapperMMC3.CHR1k1[address - 0x0400]);
 		}
 		else if (address < 0x0C00)
 		{
-			return (MM_parameters.MapperMMC3.CHR1k2[address - 0x0800]);
+			return (mm.parameters.MapperMMC3.CHR1k2[address - 0x0800]);
 		}
 		else if (address < 0x1000)
 		{
-			return (MM_parameters.MapperMMC3.CHR1k3[address - 0x0C00]);
+			return (mm.parameters.MapperMMC3.CHR1k3[address - 0x0C00]);
 		}
 		else if (address < 0x1800)
 		{
-			return (MM_parameters.MapperMMC3.CHR2k0[address - 0x1000]);
+			return (mm.parameters.MapperMMC3.CHR2k0[address - 0x1000]);
 		}
 		else
 		{
-			return (MM_parameters.MapperMMC3.CHR2k1[address - 0x1800]);
+			return (mm.parameters.MapperMMC3.CHR2k1[address - 0x1800]);
 		}
 	}
 	else
 	{
 		if (address < 0x0800)
 		{
-			return (MM_parameters.MapperMMC3.CHR2k0[address]);
+			return (mm.parameters.MapperMMC3.CHR2k0[address]);
 		}
 		else if (address < 0x1000)
 		{
-			return (MM_parameters.MapperMMC3.CHR2k1[address - 0x0800]);
+			return (mm.parameters.MapperMMC3.CHR2k1[address - 0x0800]);
 		}
 		else if (address < 0x1400)
 		{
-			return (MM_parameters.MapperMMC3.CHR1k0[address - 0x1000]);
+			return (mm.parameters.MapperMMC3.CHR1k0[address - 0x1000]);
 		}
 		else if (address < 0x1800)
 		{
-			return (MM_parameters.MapperMMC3.CHR1k1[address - 0x1400]);
+			return (mm.parameters.MapperMMC3.CHR1k1[address - 0x1400]);
 		}
 		else if (address < 0x1C00)
 		{
-			return (MM_parameters.MapperMMC3.CHR1k2[address - 0x1800]);
+			return (mm.parameters.MapperMMC3.CHR1k2[address - 0x1800]);
 		}
 		else
 		{
-			return (MM_parameters.MapperMMC3.CHR1k3[address - 0x1C00]);
+			return (mm.parameters.MapperMMC3.CHR1k3[address - 0x1C00]);
 		}
 	}
 }
\ No newline at end of file
@@ -265,6 +265,7 @@ namespace MM
 	bool setMapper(uint8_t mapper_type);
 	void writePRG(uint16_t address, uint8_t data);
 	uint8_t readPRG(uint16_t address);
+	uint32_t mapPRG(uint16_t address); // offset in PRG ROM the address is mapped to ... changes only when the CPU writes to the cartridge
 	void writeCHR(uint16_t address, uint8_t data);
 	uint8_t readCHR(uint16_t address);
 	uint8_t getNameTableMirroring();
@@ -3,8 +3,11 @@
 #include "CartridgeReader.h"
 #include "MemoryBus.h"
 #include "CentralProcessingUnit.h"
+#include "ConsoleContext.h"
+#include "Debugger.h"
 #include "RenderingWindow.h"
 
+#include <cstring>
 #include <string>
 
 #define PPU__SCANLINE_CYCLE_LENGTH (341u)
@@ -25,6 +28,15 @@
 #define PPU__BITS_HORIZONTAL (0x041Fu)
 #define PPU__BITS_VERTICAL (0x7BE0u)
 
+inline void PPU_pipeline__step();
+inline void PPU_pipeline__skipDot();
+inline uint8_t PPU_background__fetchPattern(uint16_t x_fine);
+inline uint8_t PPU_sprite__fetchPattern(uint8_t sprite, uint16_t x, uint16_t y);
+inline uint32_t PPU_scanline__cyclesLeft(uint16_t scanline_end);
+inline uint32_t PPU_event__cyclesLeft();
+inline uint16_t PPU_position__scanline();
+inline uint32_t PPU_debug__cyclesLeft(bool &breakpoint);
+inline void PPU_debug__run(uint32_t cycles);
 inline uint32_t PPU_color__convertToGrayScale(uint32_t color);
 
 static const uint32_t PPU_colorsNTSC[] = // to RGBA
@@ -51,506 +63,823 @@ static const uint32_t PPU_colorsPAL[] = // to RGBA
 	0xFFF0A8FFu, 0xE0FAAAFFu, 0xBFFCBCFFu, 0xADFEDDFFu, 0xACFAFFFFu, 0xC6C6C6FFu, 0x000000FFu, 0x000000FFu
 };
 
-static const uint32_t *PPU_paletteInUse;
+namespace PPU
+{
+	void reset()
+	{
+		PPU_state_t &ppu = CC_console->ppu;
 
-static uint8_t PPU_spriteMemory[256];
-static uint8_t PPU_scanlineSprites[8];
-static int8_t PPU_scanlineSpriteCount = 0;
+		ppu.longSprites = false;
+		ppu.interruptEnabled = false;
+		ppu.grayscaleMode = false;
+		ppu.verticalBlank = false;
+		ppu.statusChanged = true;
+		ppu.showSprites = true;
+		ppu.showBackground = true;
+		ppu.frameCount = 0;
+		ppu.evenFrame = true;
+		ppu.firstWrite = true;
 
-static uint8_t PPU_pipelineStage;
-static uint16_t PPU_frameEnd;
+		ppu.spritePage = PPU__CHARACTER_PAGE_LOW;
+		ppu.backgroundPage = PPU__CHARACTER_PAGE_LOW;
 
-static uint16_t PPU_cycle;
-static uint16_t PPU_scanline;
+		ppu.dataAddressIncrement = 0x0001;
 
-static bool PPU_evenFrame;
-static bool PPU_verticalBlank;
-static bool PPU_spriteZeroHit;
-static bool PPU_firstWrite;
+		ppu.pipelineStage = PPU__PIPELINE_PRERENDER;
+		ppu.scanlineSpriteCount = 0;
 
-static uint16_t PPU_dataAddress; // internal registers
-static uint16_t PPU_temporaryAddress;
-static uint8_t PPU_fineVerticalScroll;
-static uint8_t PPU_dataBuffer;
-static uint8_t PPU_spriteDataAddress;
+		ppu.framesSkipped = 0;
+		ppu.skipFrame = false;
 
-static bool PPU_longSprites;
-static bool PPU_interruptEnabled;
-static bool PPU_grayscaleMode;
-static bool PPU_showSprites;
-static bool PPU_showBackground;
-static bool PPU_hideEdgeSprites;
-static bool PPU_hideEdgeBackground;
+		ppu.cycle = 0;
+		ppu.scanline = 0;
 
-static uint8_t PPU_spritePage;
-static uint8_t PPU_backgroundPage;
+		ppu.dataAddress = 0;
+		ppu.temporaryAddress = 0;
+		ppu.fineVerticalScroll = 0;
+		ppu.dataBuffer = 0;
+		ppu.spriteDataAddress = 0;
 
-static uint16_t PPU_dataAddressIncrement;
+		if (CR::getSystemType() == SYSTEM_NTSC)
+		{
+			ppu.paletteInUse = PPU_colorsNTSC;
+			ppu.frameEnd = PPU__SCANLINE_FRAME_END_NTSC;
+		}
+		else
+		{
+			ppu.paletteInUse = PPU_colorsPAL;
+			ppu.frameEnd = PPU__SCANLINE_FRAME_END_PAL;
+		}
+	}
 
-static void(*PPU_scanlineEndCallback)(bool vblank) = nullptr;
+	void registerScanlineCallback(void(*callback)(bool vblank))
+	{
+		PPU_state_t &ppu = CC_console->ppu;
 
-namespace PPU
-{
-	void reset()
+		ppu.scanlineEndCallback = callback;
+	}
+
+	void run(uint32_t cycles)
 	{
-		PPU_longSprites = false;
-		PPU_interruptEnabled = false;
-		PPU_grayscaleMode = false;
-		PPU_verticalBlank = false;
-		PPU_showSprites = true;
-		PPU_showBackground = true;
-		PPU_evenFrame = true;
-		PPU_firstWrite = true;
+		if (CC_console->debuggerData && DB::hasScanlineBreakpoints())
+		{
+			PPU_debug__run(cycles);
 
-		PPU_spritePage = PPU__CHARACTER_PAGE_LOW;
-		PPU_backgroundPage = PPU__CHARACTER_PAGE_LOW;
+			return;
+		}
 
-		PPU_dataAddressIncrement = 0x0001;
+		while (cycles--)
+		{
+			PPU_pipeline__step();
+		}
+	}
 
-		PPU_pipelineStage = PPU__PIPELINE_PRERENDER;
-		PPU_scanlineSpriteCount = 0;
+	uint32_t getFrameCount()
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		return (ppu.frameCount);
+	}
 
-		PPU_cycle = 0;
-		PPU_scanline = 0;
+	void setFrameSkip(uint8_t frames)
+	{
+		PPU_state_t &ppu = CC_console->ppu;
 
-		PPU_dataAddress = 0;
-		PPU_temporaryAddress = 0;
-		PPU_fineVerticalScroll = 0;
-		PPU_dataBuffer = 0;
-		PPU_spriteDataAddress = 0;
+		ppu.frameSkip = frames;
+	}
 
-		if (CR::getSystemType() == SYSTEM_NTSC)
+	uint8_t getFrameSkip()
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		return (ppu.frameSkip);
+	}
+
+	void suppressOutput(bool suppress)
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		ppu.outputSuppressed = suppress;
+	}
+
+	uint32_t getCyclesUntilEvent()
+	{
+		uint32_t cycles = PPU_event__cyclesLeft();
+
+		if (CC_console->debuggerData && DB::hasScanlineBreakpoints())
+		{ // the slice also ends on the scanline breakpoints, so the PPU can stop right after their dot
+			bool breakpoint = false;
+			uint32_t cyclesToBreak = PPU_debug__cyclesLeft(breakpoint);
+
+			if (cyclesToBreak < cycles)
+			{
+				cycles = cyclesToBreak;
+			}
+		}
+
+		return (cycles);
+	}
+
+	uint16_t getScanline()
+	{
+		return (PPU_position__scanline());
+	}
+
+	uint16_t getDot()
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		return (ppu.cycle);
+	}
+
+	bool isStatusSteady()
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		if (ppu.statusChanged)
+		{ // a read now would not give what the last one did
+			return (false);
+		}
+
+		switch (ppu.pipelineStage)
+		{
+			case PPU__PIPELINE_RENDER:
+			{ // the sprite zero hit is the only flag that can change while rendering
+				return (ppu.spriteZeroHit || !ppu.showBackground || !ppu.showSprites);
+			}
+
+			case PPU__PIPELINE_POSTRENDER:
+			case PPU__PIPELINE_VERTICAL_BLANK:
+			{ // the vertical blank flag is set by an event
+				return (true);
+			}
+
+			default:
+			{ // both flags are cleared by the first cycle of the pre-render scanline
+				return (ppu.cycle > 1);
+			}
+		}
+	}
+
+	void writeRegisterControl(uint8_t value)
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		ppu.interruptEnabled = value & 0x80 ? true : false;
+		ppu.longSprites = value & 0x20 ? true : false;
+		ppu.spritePage = value & 0x08 ? PPU__CHARACTER_PAGE_HIGH : PPU__CHARACTER_PAGE_LOW;
+		ppu.backgroundPage = value & 0x10 ? PPU__CHARACTER_PAGE_HIGH : PPU__CHARACTER_PAGE_LOW;
+		ppu.dataAddressIncrement = value & 0x04 ? 0x20 : 0x01;
+
+		ppu.temporaryAddress &= ~0x0C00;
+		ppu.temporaryAddress |= (value & 0x03) << 10;
+	}
+
+	void writeRegisterMask(uint8_t value)
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		ppu.grayscaleMode = value & 0x01 ? true : false;
+		ppu.hideEdgeBackground = value & 0x02 ? false : true;
+		ppu.hideEdgeSprites = value & 0x04 ? false : true;
+		ppu.showBackground = value & 0x08 ? true : false;
+		ppu.showSprites = value & 0x10 ? true : false;
+	}
+
+	void writeRegisterSpriteAddress(uint8_t value)
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		ppu.spriteDataAddress = value;
+	}
+
+	void writeRegisterSpriteData(uint8_t value)
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		ppu.spriteMemory[ppu.spriteDataAddress++] = value;
+	}
+
+	void writeRegisterScroll(uint8_t value)
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		if (ppu.firstWrite)
 		{
-			PPU_paletteInUse = PPU_colorsNTSC;
-			PPU_frameEnd = PPU__SCANLINE_FRAME_END_NTSC;
+			ppu.temporaryAddress &= ~0x001F;
+			ppu.temporaryAddress |= (value >> 3) & 0x001F;
+			ppu.fineVerticalScroll = value & 0x07;
+			ppu.firstWrite = false;
 		}
 		else
 		{
-			PPU_paletteInUse = PPU_colorsPAL;
-			PPU_frameEnd = PPU__SCANLINE_FRAME_END_PAL;
+			ppu.temporaryAddress &= ~0x73E0;
+			ppu.temporaryAddress |= ((value & 0x07) << 12) | ((value & 0xF8) << 2);
+			ppu.firstWrite = true;
 		}
 	}
 
-	void registerScanlineCallback(void(*callback)(bool vblank))
+	void writeRegisterAddress(uint8_t value)
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		if (ppu.firstWrite)
+		{
+			ppu.temporaryAddress &= ~0xFF00;
+			ppu.temporaryAddress |= (value & 0x3F) << 8;
+			ppu.firstWrite = false;
+		}
+		else
+		{
+			ppu.temporaryAddress &= ~0x00FF;
+			ppu.temporaryAddress |= value;
+			ppu.dataAddress = ppu.temporaryAddress;
+			ppu.firstWrite = true;
+		}
+	}
+
+	void writeRegisterData(uint8_t value)
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		if (CC_console->debuggerData)
+		{
+			DB::writePicture(ppu.dataAddress, value);
+		}
+
+		MB::writePictureBus(ppu.dataAddress, value);
+		ppu.dataAddress += ppu.dataAddressIncrement;
+	}
+
+	uint8_t readRegisterControl()
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		uint8_t control = (ppu.interruptEnabled ? 0x80 : 0x00) | (ppu.longSprites ? 0x20 : 0x00) | (ppu.dataAddressIncrement == 1 ? 0x00 : 0x04) | (ppu.spritePage == PPU__CHARACTER_PAGE_HIGH ? 0x08 : 0x00) | (ppu.backgroundPage == PPU__CHARACTER_PAGE_HIGH ? 0x10 : 0x00) | ((ppu.temporaryAddress >> 10) & 0x03);
+		return (control);
+	}
+
+	uint8_t readRegisterMask()
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		uint8_t mask = (ppu.grayscaleMode ? 0x01 : 0x00) | (ppu.hideEdgeBackground ? 0x00 : 0x02) | (ppu.hideEdgeSprites ? 0x00 : 0x04) | (ppu.showBackground ? 0x08 : 0x00) | (ppu.showSprites ? 0x10 : 0x00);
+		return (mask);
+	}
+
+	uint8_t readRegisterStatus()
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		uint8_t status = (ppu.verticalBlank ? 0x80 : 0x00) | (ppu.spriteZeroHit ? 0x40 : 0x00);
+
+		ppu.firstWrite = true;
+		ppu.verticalBlank = false;
+		ppu.statusChanged = false;
+
+		return (status);
+	}
+
+	uint8_t readRegisterSpriteData()
+	{
+		PPU_state_t &ppu = CC_console->ppu;
+
+		return (ppu.spriteMemory[ppu.spriteDataAddress]);
+	}
+
+	uint8_t readRegisterData()
 	{
-		PPU_scanlineEndCallback = callback;
+		PPU_state_t &ppu = CC_console->ppu;
+
+		uint8_t data = MB::readPictureBus(ppu.dataAddress);
+
+		if (CC_console->debuggerData)
+		{
+			DB::readPicture(ppu.dataAddress, data);
+		}
+
+		ppu.dataAddress += ppu.dataAddressIncrement;
+
+		if (ppu.dataAddress < 0x3F00)
+		{ // reads are delayed in this address space
+			ppu.dataBuffer ^= data;
+			data ^= ppu.dataBuffer;
+			ppu.dataBuffer ^= data;
+		}
+
+		return (data);
 	}
 
-	void step()
+	void executeDMA(uint8_t *page_pointer)
 	{
-		switch (PPU_pipelineStage)
+		PPU_state_t &ppu = CC_console->ppu;
+
+		if (page_pointer)
 		{
-			case PPU__PIPELINE_PRERENDER:
+			memcpy(ppu.spriteMemory + ppu.spriteDataAddress, page_pointer, 256u - ppu.spriteDataAddress);
+			if (ppu.spriteDataAddress)
 			{
-				if (PPU_cycle == 1)
+				memcpy(ppu.spriteMemory, page_pointer + (256u - ppu.spriteDataAddress), ppu.spriteDataAddress);
+			}
+		}
+	}
+}
+
+/* Executes one PPU cycle */
+inline void PPU_pipeline__step()
+{
+	PPU_state_t &ppu = CC_console->ppu;
+
+	switch (ppu.pipelineStage)
+	{
+		case PPU__PIPELINE_PRERENDER:
+		{
+			if (ppu.cycle == 1)
+			{
+				ppu.verticalBlank = false;
+				ppu.spriteZeroHit = false;
+				ppu.statusChanged = true;
+			}
+			else if (ppu.cycle == PPU__SCANLINE_DOTS + 2 && ppu.showSprites && ppu.showBackground)
+			{ // switch to horizontal
+				ppu.dataAddress &= ~PPU__BITS_HORIZONTAL;
+				ppu.dataAddress |= ppu.temporaryAddress & PPU__BITS_HORIZONTAL;
+			}
+			else if (ppu.cycle > 280 && ppu.cycle < 305 && ppu.showSprites && ppu.showBackground)
+			{ // switch to vertical
+				ppu.dataAddress &= ~PPU__BITS_VERTICAL;
+				ppu.dataAddress |= ppu.temporaryAddress & PPU__BITS_VERTICAL;
+			}
+
+			if (ppu.cycle >= (PPU__SCANLINE_CYCLE_END - ((!ppu.evenFrame && ppu.showSprites && ppu.showBackground) ? 1u : 0u)))
+			{ // every other frame is one cycle shorter if rendering is active
+				ppu.pipelineStage = PPU__PIPELINE_RENDER;
+				ppu.cycle = 0;
+				ppu.scanline = 0;
+
+				if (ppu.outputSuppressed)
 				{
-					PPU_verticalBlank = false;
-					PPU_spriteZeroHit = false;
+					ppu.skipFrame = true;
 				}
-				else if (PPU_cycle == PPU__SCANLINE_DOTS + 2 && PPU_showSprites && PPU_showBackground)
-				{ // switch to horizontal
-					PPU_dataAddress &= ~PPU__BITS_HORIZONTAL;
-					PPU_dataAddress |= PPU_temporaryAddress & PPU__BITS_HORIZONTAL;
+				else if (ppu.framesSkipped < ppu.frameSkip)
+				{
+					++ppu.framesSkipped;
+					ppu.skipFrame = true;
 				}
-				else if (PPU_cycle > 280 && PPU_cycle < 305 && PPU_showSprites && PPU_showBackground)
-				{ // switch to vertical
-					PPU_dataAddress &= ~PPU__BITS_VERTICAL;
-					PPU_dataAddress |= PPU_temporaryAddress & PPU__BITS_VERTICAL;
+				else
+				{
+					ppu.framesSkipped = 0;
+					ppu.skipFrame = false;
 				}
 
-				if (PPU_cycle >= (PPU__SCANLINE_CYCLE_END - ((!PPU_evenFrame && PPU_showSprites && PPU_showBackground) ? 1u : 0u)))
-				{ // every other frame is one cycle shorter if rendering is active
-					PPU_pipelineStage = PPU__PIPELINE_RENDER;
-					PPU_cycle = 0;
-					PPU_scanline = 0;
-
-					if (PPU_scanlineEndCallback)
-					{
-						PPU_scanlineEndCallback(false);
-					}
+				if (ppu.scanlineEndCallback)
+				{
+					ppu.scanlineEndCallback(false);
 				}
-
-				break;
 			}
 
-			case PPU__PIPELINE_RENDER:
+			break;
+		}
+
+		case PPU__PIPELINE_RENDER:
+		{
+			if (ppu.cycle > 0 && ppu.cycle <= PPU__SCANLINE_DOTS && ppu.skipFrame)
 			{
-				if (PPU_cycle > 0 && PPU_cycle <= PPU__SCANLINE_DOTS)
-				{
-					uint8_t colorSprite = 0;
-					uint8_t colorBackground = 0;
-					bool opaqueSprite = true;
-					bool opaqueBackground = false;
-					bool spriteForeground = false;
+				PPU_pipeline__skipDot();
+			}
+			else if (ppu.cycle > 0 && ppu.cycle <= PPU__SCANLINE_DOTS)
+			{
+				uint8_t colorSprite = 0;
+				uint8_t colorBackground = 0;
+				bool opaqueSprite = true;
+				bool opaqueBackground = false;
+				bool spriteForeground = false;
 
-					uint16_t x = PPU_cycle - 1;
-					uint16_t y = PPU_scanline;
+				uint16_t x = ppu.cycle - 1;
+				uint16_t y = ppu.scanline;
 
-					if (PPU_showBackground)
+				if (ppu.showBackground)
+				{
+					uint16_t xFine = (ppu.fineVerticalScroll + x) % 8;
+					if (!ppu.hideEdgeBackground || x >= 8)
 					{
-						uint16_t xFine = (PPU_fineVerticalScroll + x) % 8;
-						if (!PPU_hideEdgeBackground || x >= 8)
-						{
-							uint8_t tile = MB::readPictureBus((PPU_dataAddress & 0x0FFF) | 0x2000);
-							uint16_t address = ((tile << 4) + ((PPU_dataAddress >> 12) & 0x0007)) | (PPU_backgroundPage << 12);
-
-							colorBackground = (MB::readPictureBus(address) >> (xFine ^ 0x7)) & 0x01; // bit 0
-							colorBackground |= ((MB::readPictureBus(address + 8) >> (xFine ^ 0x7)) & 0x01) << 1; // bit 1
+						colorBackground = PPU_background__fetchPattern(xFine); // bits 0 and 1
 
-							opaqueBackground = colorBackground ? true : false;
+						opaqueBackground = colorBackground ? true : false;
 
-							address = (PPU_dataAddress & 0x0C00) | ((PPU_dataAddress >> 2) & 0x0007) | ((PPU_dataAddress >> 4) & 0x0038) | 0x23C0;
-							uint8_t attribute = MB::readPictureBus(address);
-							uint8_t shamt = (PPU_dataAddress & 0x02) | ((PPU_dataAddress >> 4) & 0x04);
+						uint16_t address = (ppu.dataAddress & 0x0C00) | ((ppu.dataAddress >> 2) & 0x0007) | ((ppu.dataAddress >> 4) & 0x0038) | 0x23C0;
+						uint8_t attribute = MB::readPictureBus(address);
+						uint8_t shamt = (ppu.dataAddress & 0x02) | ((ppu.dataAddress >> 4) & 0x04);
 
-							colorBackground |= ((attribute >> shamt) & 0x03) << 2; // bits 2 and 3
-						}
-
-						if (xFine == 7)
-						{
-							if ((PPU_dataAddress & 0x001F) == 31) // reached end of nametable
-							{
-								PPU_dataAddress &= ~0x001F; // reset pointer to the beginning of the nametable
-								PPU_dataAddress ^= 0x0400; // change nametable
-							}
-							else
-							{
-								++PPU_dataAddress;
-							}
-						}
+						colorBackground |= ((attribute >> shamt) & 0x03) << 2; // bits 2 and 3
 					}
 
-					if (PPU_showSprites && (!PPU_hideEdgeSprites || x >= 8))
+					if (xFine == 7)
 					{
-						for (int8_t i = 0; i < PPU_scanlineSpriteCount; ++i)
+						if ((ppu.dataAddress & 0x001F) == 31) // reached end of nametable
 						{
-							uint8_t sprite = PPU_scanlineSprites[i];
-
-							uint8_t xSpr = PPU_spriteMemory[4 * sprite + 3];
-							uint8_t ySpr = PPU_spriteMemory[4 * sprite + 0] + 1;
-
-							if ((int)x - (int)xSpr < 0 || (int)x - (int)xSpr >= 8)
-							{
-								continue;
-							}
-
-							uint8_t tile = PPU_spriteMemory[4 * sprite + 1];
-							uint8_t attribute = PPU_spriteMemory[4 * sprite + 2];
-
-							uint8_t length = PPU_longSprites ? 16 : 8;
-
-							uint8_t xShift = (x - xSpr) % 8;
-							uint8_t yOffset = (y - ySpr) % length;
-
-							if ((attribute & 0x40) == 0) // if not flipping horizontally
-							{
-								xShift ^= 0x07;
-							}
-							if (attribute & 0x80) // if flipping vertically
-							{
-								yOffset ^= (length - 1);
-							}
-
-							uint16_t address = 0;
-							if (PPU_longSprites)
-							{
-								yOffset = (yOffset & 0x07) | ((yOffset & 0x08) << 1);
-								address = (((tile & 0xFE) << 4) + yOffset) | ((uint16_t)(tile & 0x01) << 12);
-							}
-							else
-							{
-								address = ((tile << 4) + yOffset) | ((PPU_spritePage == PPU__CHARACTER_PAGE_HIGH) ? 0x1000 : 0x0000);
-							}
-
-							colorSprite = (MB::readPictureBus(address) >> xShift) & 0x01; // bit 0
-							colorSprite |= ((MB::readPictureBus(address + 8) >> xShift) & 0x01) << 1; // bit 1
-
-							opaqueSprite = colorSprite ? true : false;
-							if (!opaqueSprite)
-							{
-								colorSprite = 0;
-								continue;
-							}
-
-							colorSprite |= ((attribute & 0x03) << 2) | 0x10; // bits 2, 3 and 4
-							spriteForeground = (attribute & 0x20) ? false : true;
-
-							if (!PPU_spriteZeroHit && PPU_showBackground && sprite == 0 && opaqueSprite && opaqueBackground)
-							{
-								PPU_spriteZeroHit = true;
-							}
-
-							break; // highest priority sprite has been found
+							ppu.dataAddress &= ~0x001F; // reset pointer to the beginning of the nametable
+							ppu.dataAddress ^= 0x0400; // change nametable
+						}
+						else
+						{
+							++ppu.dataAddress;
 						}
 					}
-
-					uint8_t paletteAddress = colorBackground;
-					if ((!opaqueBackground && opaqueSprite) || (opaqueBackground && opaqueSprite && spriteForeground))
-					{
-						paletteAddress = colorSprite;
-					}
-					else if (!opaqueBackground && !opaqueSprite)
-					{
-						paletteAddress = 0;
-					}
-
-					uint32_t colorToDisplay = PPU_paletteInUse[MB::readPictureBus((uint16_t)paletteAddress | 0x3F20)];
-					if (PPU_grayscaleMode)
-					{
-						colorToDisplay = PPU_color__convertToGrayScale(colorToDisplay);
-					}
-
-					RW::setPixel(x, y, colorToDisplay);
 				}
-				else if (PPU_cycle == PPU__SCANLINE_DOTS + 1 && PPU_showBackground)
+
+				if (ppu.showSprites && (!ppu.hideEdgeSprites || x >= 8))
 				{
-					if ((PPU_dataAddress & 0x7000) != 0x7000)
-					{ // next fine y
-						PPU_dataAddress += 0x1000;
-					}
-					else
+					for (int8_t i = 0; i < ppu.scanlineSpriteCount; ++i)
 					{
-						PPU_dataAddress &= ~0x7000;
+						uint8_t sprite = ppu.scanlineSprites[i];
+
+						uint8_t xSpr = ppu.spriteMemory[4 * sprite + 3];
 
-						uint16_t y = (PPU_dataAddress & 0x03E0) >> 5;
-						if (y == 29)
+						if ((int)x - (int)xSpr < 0 || (int)x - (int)xSpr >= 8)
 						{
-							y = 0;
-							PPU_dataAddress ^= 0x0800; // switch vertical nametable
+							continue;
 						}
-						else if (y == 31)
+
+						uint8_t attribute = ppu.spriteMemory[4 * sprite + 2];
+
+						colorSprite = PPU_sprite__fetchPattern(sprite, x, y); // bits 0 and 1
+
+						opaqueSprite = colorSprite ? true : false;
+						if (!opaqueSprite)
 						{
-							y = 0;
+							colorSprite = 0;
+							continue;
 						}
-						else
+
+						colorSprite |= ((attribute & 0x03) << 2) | 0x10; // bits 2, 3 and 4
+						spriteForeground = (attribute & 0x20) ? false : true;
+
+						if (!ppu.spriteZeroHit && ppu.showBackground && sprite == 0 && opaqueSprite && opaqueBackground)
 						{
-							++y;
+							ppu.spriteZeroHit = true;
+							ppu.statusChanged = true;
 						}
 
-						PPU_dataAddress = (PPU_dataAddress & ~0x03E0) | (y << 5);
+						break; // highest priority sprite has been found
 					}
 				}
-				else if (PPU_cycle == PPU__SCANLINE_DOTS + 2 && PPU_showSprites && PPU_showBackground)
+
+				uint8_t paletteAddress = colorBackground;
+				if ((!opaqueBackground && opaqueSprite) || (opaqueBackground && opaqueSprite && spriteForeground))
+				{
+					paletteAddress = colorSprite;
+				}
+				else if (!opaqueBackground && !opaqueSprite)
+				{
+					paletteAddress = 0;
+				}
+
+				uint32_t colorToDisplay = ppu.paletteInUse[MB::readPictureBus((uint16_t)paletteAddress | 0x3F20)];
+				if (ppu.grayscaleMode)
 				{
-					PPU_dataAddress &= ~PPU__BITS_HORIZONTAL;
-					PPU_dataAddress |= PPU_temporaryAddress & PPU__BITS_HORIZONTAL;
+					colorToDisplay = PPU_color__convertToGrayScale(colorToDisplay);
 				}
 
-				if (PPU_cycle >= PPU__SCANLINE_CYCLE_END)
+				RW::setPixel(x, y, colorToDisplay);
+			}
+			else if (ppu.cycle == PPU__SCANLINE_DOTS + 1 && ppu.showBackground)
+			{
+				if ((ppu.dataAddress & 0x7000) != 0x7000)
+				{ // next fine y
+					ppu.dataAddress += 0x1000;
+				}
+				else
 				{
-					PPU_scanlineSpriteCount = 0;
-					uint8_t range = PPU_longSprites ? 16 : 8;
+					ppu.dataAddress &= ~0x7000;
 
-					for (uint8_t i = PPU_spriteDataAddress >> 2; i < 64; ++i)
+					uint16_t y = (ppu.dataAddress & 0x03E0) >> 5;
+					if (y == 29)
 					{
-						int16_t difference = (PPU_scanline - PPU_spriteMemory[4 * i]);
-						if (difference >= 0 && difference < range)
-						{
-							PPU_scanlineSprites[PPU_scanlineSpriteCount] = i;
-							++PPU_scanlineSpriteCount;
-							if (PPU_scanlineSpriteCount >= 8)
-							{
-								break;
-							}
-						}
+						y = 0;
+						ppu.dataAddress ^= 0x0800; // switch vertical nametable
 					}
-
-					if (PPU_scanlineEndCallback)
+					else if (y == 31)
 					{
-						PPU_scanlineEndCallback(false);
+						y = 0;
 					}
+					else
+					{
+						++y;
+					}
+
+					ppu.dataAddress = (ppu.dataAddress & ~0x03E0) | (y << 5);
+				}
+			}
+			else if (ppu.cycle == PPU__SCANLINE_DOTS + 2 && ppu.showSprites && ppu.showBackground)
+			{
+				ppu.dataAddress &= ~PPU__BITS_HORIZONTAL;
+				ppu.dataAddress |= ppu.temporaryAddress & PPU__BITS_HORIZONTAL;
+			}
+
+			if (ppu.cycle >= PPU__SCANLINE_CYCLE_END)
+			{
+				ppu.scanlineSpriteCount = 0;
+				uint8_t range = ppu.longSprites ? 16 : 8;
 
-					++PPU_scanline;
-					PPU_cycle = 0;
+				for (uint8_t i = ppu.spriteDataAddress >> 2; i < 64; ++i)
+				{
+					int16_t difference = (ppu.scanline - ppu.spriteMemory[4 * i]);
+					if (difference >= 0 && difference < range)
+					{
+						ppu.scanlineSprites[ppu.scanlineSpriteCount] = i;
+						++ppu.scanlineSpriteCount;
+						if (ppu.scanlineSpriteCount >= 8)
+						{
+							break;
+						}
+					}
 				}
 
-				if (PPU_scanline >= PPU__SCANLINE_COUNT)
+				if (ppu.scanlineEndCallback)
 				{
-					PPU_pipelineStage = PPU__PIPELINE_POSTRENDER;
+					ppu.scanlineEndCallback(false);
 				}
 
-				break;
+				++ppu.scanline;
+				ppu.cycle = 0;
 			}
 
-			case PPU__PIPELINE_POSTRENDER:
+			if (ppu.scanline >= PPU__SCANLINE_COUNT)
 			{
-				if (PPU_cycle >= PPU__SCANLINE_CYCLE_END)
+				ppu.pipelineStage = PPU__PIPELINE_POSTRENDER;
+			}
+
+			break;
+		}
+
+		case PPU__PIPELINE_POSTRENDER:
+		{
+			if (ppu.cycle >= PPU__SCANLINE_CYCLE_END)
+			{
+				if (ppu.scanlineEndCallback)
 				{
-					if (PPU_scanlineEndCallback)
-					{
-						PPU_scanlineEndCallback(true);
-					}
+					ppu.scanlineEndCallback(true);
+				}
 
-					++PPU_scanline;
-					PPU_cycle = 0;
+				++ppu.scanline;
+				ppu.cycle = 0;
 
-					PPU_pipelineStage = PPU__PIPELINE_VERTICAL_BLANK;
+				ppu.pipelineStage = PPU__PIPELINE_VERTICAL_BLANK;
 
+				++ppu.frameCount;
+				if (!ppu.skipFrame)
+				{
 					RW::redraw(); // it takes 89079 or 89080 cycles between each frame for NTSC
 				}
-
-				break;
 			}
 
-			case PPU__PIPELINE_VERTICAL_BLANK:
+			break;
+		}
+
+		case PPU__PIPELINE_VERTICAL_BLANK:
+		{
+			if (ppu.cycle == 1 && ppu.scanline == PPU__SCANLINE_COUNT + 1)
 			{
-				if (PPU_cycle == 1 && PPU_scanline == PPU__SCANLINE_COUNT + 1)
+				ppu.verticalBlank = true;
+				ppu.statusChanged = true;
+				if (ppu.interruptEnabled)
 				{
-					PPU_verticalBlank = true;
-					if (PPU_interruptEnabled)
-					{
-						CPU::causeInterrupt(INTERRUPT_NMI);
-					}
+					CPU::causeInterrupt(INTERRUPT_NMI);
 				}
+			}
 
-				if (PPU_cycle >= PPU__SCANLINE_CYCLE_END)
+			if (ppu.cycle >= PPU__SCANLINE_CYCLE_END)
+			{
+				if (ppu.scanlineEndCallback)
 				{
-					if (PPU_scanlineEndCallback)
-					{
-						PPU_scanlineEndCallback(true);
-					}
-
-					++PPU_scanline;
-					PPU_cycle = 0;
+					ppu.scanlineEndCallback(true);
 				}
 
-				if (PPU_scanline >= PPU_frameEnd)
-				{
-					PPU_pipelineStage = PPU__PIPELINE_PRERENDER;
-					PPU_scanline = 0;
-					PPU_evenFrame = !PPU_evenFrame;
-				}
+				++ppu.scanline;
+				ppu.cycle = 0;
+			}
 
-				break;
+			if (ppu.scanline >= ppu.frameEnd)
+			{
+				ppu.pipelineStage = PPU__PIPELINE_PRERENDER;
+				ppu.scanline = 0;
+				ppu.evenFrame = !ppu.evenFrame;
 			}
-		}
 
-		++PPU_cycle;
+			break;
+		}
 	}
 
-	void writeRegisterControl(uint8_t value)
-	{
-		PPU_interruptEnabled = value & 0x80 ? true : false;
-		PPU_longSprites = value & 0x20 ? true : false;
-		PPU_spritePage = value & 0x08 ? PPU__CHARACTER_PAGE_HIGH : PPU__CHARACTER_PAGE_LOW;
-		PPU_backgroundPage = value & 0x10 ? PPU__CHARACTER_PAGE_HIGH : PPU__CHARACTER_PAGE_LOW;
-		PPU_dataAddressIncrement = value & 0x04 ? 0x20 : 0x01;
+	++ppu.cycle;
+}
 
-		PPU_temporaryAddress &= ~0x0C00;
-		PPU_temporaryAddress |= (value & 0x03) << 10;
-	}
+/* Visible dot of a skipped frame ... keeps only what the CPU can observe: the scrolling and the sprite zero hit */
+inline void PPU_pipeline__skipDot()
+{
+	PPU_state_t &ppu = CC_console->ppu;
 
-	void writeRegisterMask(uint8_t value)
-	{
-		PPU_grayscaleMode = value & 0x01 ? true : false;
-		PPU_hideEdgeBackground = value & 0x02 ? false : true;
-		PPU_hideEdgeSprites = value & 0x04 ? false : true;
-		PPU_showBackground = value & 0x08 ? true : false;
-		PPU_showSprites = value & 0x10 ? true : false;
-	}
+	uint16_t x = ppu.cycle - 1;
 
-	void writeRegisterSpriteAddress(uint8_t value)
-	{
-		PPU_spriteDataAddress = value;
+	if (!ppu.showBackground)
+	{ // no scrolling and no sprite zero hit without the background
+		return;
 	}
 
-	void writeRegisterSpriteData(uint8_t value)
-	{
-		PPU_spriteMemory[PPU_spriteDataAddress++] = value;
-	}
+	uint16_t xFine = (ppu.fineVerticalScroll + x) % 8;
 
-	void writeRegisterScroll(uint8_t value)
-	{
-		if (PPU_firstWrite)
-		{
-			PPU_temporaryAddress &= ~0x001F;
-			PPU_temporaryAddress |= (value >> 3) & 0x001F;
-			PPU_fineVerticalScroll = value & 0x07;
-			PPU_firstWrite = false;
-		}
-		else
+	if (!ppu.spriteZeroHit && ppu.showSprites && ppu.scanlineSpriteCount > 0 && ppu.scanlineSprites[0] == 0 && ((!ppu.hideEdgeSprites && !ppu.hideEdgeBackground) || x >= 8))
+	{ // sprite zero is always the first one evaluated, so no other sprite can cover it
+		uint8_t xSpr = ppu.spriteMemory[3];
+
+		if (x >= xSpr && x - xSpr < 8 && PPU_sprite__fetchPattern(0, x, ppu.scanline) && PPU_background__fetchPattern(xFine))
 		{
-			PPU_temporaryAddress &= ~0x73E0;
-			PPU_temporaryAddress |= ((value & 0x07) << 12) | ((value & 0xF8) << 2);
-			PPU_firstWrite = true;
+			ppu.spriteZeroHit = true;
+			ppu.statusChanged = true;
 		}
 	}
 
-	void writeRegisterAddress(uint8_t value)
+	if (xFine == 7)
 	{
-		if (PPU_firstWrite)
+		if ((ppu.dataAddress & 0x001F) == 31) // reached end of nametable
 		{
-			PPU_temporaryAddress &= ~0xFF00;
-			PPU_temporaryAddress |= (value & 0x3F) << 8;
-			PPU_firstWrite = false;
+			ppu.dataAddress &= ~0x001F; // reset pointer to the beginning of the nametable
+			ppu.dataAddress ^= 0x0400; // change nametable
 		}
 		else
 		{
-			PPU_temporaryAddress &= ~0x00FF;
-			PPU_temporaryAddress |= value;
-			PPU_dataAddress = PPU_temporaryAddress;
-			PPU_firstWrite = true;
+			++ppu.dataAddress;
 		}
 	}
+}
 
-	void writeRegisterData(uint8_t value)
+/* Two bit color of the background tile under the data address */
+inline uint8_t PPU_background__fetchPattern(uint16_t x_fine)
+{
+	PPU_state_t &ppu = CC_console->ppu;
+
+	uint8_t tile = MB::readPictureBus((ppu.dataAddress & 0x0FFF) | 0x2000);
+	uint16_t address = ((tile << 4) + ((ppu.dataAddress >> 12) & 0x0007)) | (ppu.backgroundPage << 12);
+
+	uint8_t color = (MB::readPictureBus(address) >> (x_fine ^ 0x7)) & 0x01; // bit 0
+	color |= ((MB::readPictureBus(address + 8) >> (x_fine ^ 0x7)) & 0x01) << 1; // bit 1
+
+	return (color);
+}
+
+/* Two bit color of a sprite at the given dot ... the sprite has to cover it */
+inline uint8_t PPU_sprite__fetchPattern(uint8_t sprite, uint16_t x, uint16_t y)
+{
+	PPU_state_t &ppu = CC_console->ppu;
+
+	uint8_t xSpr = ppu.spriteMemory[4 * sprite + 3];
+	uint8_t ySpr = ppu.spriteMemory[4 * sprite + 0] + 1;
+	uint8_t tile = ppu.spriteMemory[4 * sprite + 1];
+	uint8_t attribute = ppu.spriteMemory[4 * sprite + 2];
+
+	uint8_t length = ppu.longSprites ? 16 : 8;
+
+	uint8_t xShift = (x - xSpr) % 8;
+	uint8_t yOffset = (y - ySpr) % length;
+
+	if ((attribute & 0x40) == 0) // if not flipping horizontally
 	{
-		MB::writePictureBus(PPU_dataAddress, value);
-		PPU_dataAddress += PPU_dataAddressIncrement;
+		xShift ^= 0x07;
+	}
+	if (attribute & 0x80) // if flipping vertically
+	{
+		yOffset ^= (length - 1);
 	}
 
-	uint8_t readRegisterControl()
+	uint16_t address = 0;
+	if (ppu.longSprites)
 	{
-		uint8_t control = (PPU_interruptEnabled ? 0x80 : 0x00) | (PPU_longSprites ? 0x20 : 0x00) | (PPU_dataAddressIncrement == 1 ? 0x00 : 0x04) | (PPU_spritePage == PPU__CHARACTER_PAGE_HIGH ? 0x08 : 0x00) | (PPU_backgroundPage == PPU__CHARACTER_PAGE_HIGH ? 0x10 : 0x00) | ((PPU_temporaryAddress >> 10) & 0x03);
-		return (control);
+		yOffset = (yOffset & 0x07) | ((yOffset & 0x08) << 1);
+		address = (((tile & 0xFE) << 4) + yOffset) | ((uint16_t)(tile & 0x01) << 12);
+	}
+	else
+	{
+		address = ((tile << 4) + yOffset) | ((ppu.spritePage == PPU__CHARACTER_PAGE_HIGH) ? 0x1000 : 0x0000);
 	}
 
-	uint8_t readRegisterMask()
+	uint8_t color = (MB::readPictureBus(address) >> xShift) & 0x01; // bit 0
+	color |= ((MB::readPictureBus(address + 8) >> xShift) & 0x01) << 1; // bit 1
+
+	return (color);
+}
+
+/* Number of cycles until the scanline ends, counting the one that ends it */
+inline uint32_t PPU_scanline__cyclesLeft(uint16_t scanline_end)
+{
+	PPU_state_t &ppu = CC_console->ppu;
+
+	if (ppu.cycle >= scanline_end)
 	{
-		uint8_t mask = (PPU_grayscaleMode ? 0x01 : 0x00) | (PPU_hideEdgeBackground ? 0x00 : 0x02) | (PPU_hideEdgeSprites ? 0x00 : 0x04) | (PPU_showBackground ? 0x08 : 0x00) | (PPU_showSprites ? 0x10 : 0x00);
-		return (mask);
+		return (1);
 	}
 
-	uint8_t readRegisterStatus()
+	return (scanline_end - ppu.cycle + 1u);
+}
+
+/* Cycles until the next NMI, scanline callback or frame end ... counting the cycle that produces it */
+inline uint32_t PPU_event__cyclesLeft()
+{
+	PPU_state_t &ppu = CC_console->ppu;
+
+	switch (ppu.pipelineStage)
 	{
-		uint8_t status = (PPU_verticalBlank ? 0x80 : 0x00) | (PPU_spriteZeroHit ? 0x40 : 0x00);
+		case PPU__PIPELINE_PRERENDER:
+		{ // the prerender line may be shortened by one cycle, so the scanline is counted as the short one
+			return (PPU_scanline__cyclesLeft(PPU__SCANLINE_CYCLE_END - 1u));
+		}
 
-		PPU_firstWrite = true;
-		PPU_verticalBlank = false;
+		case PPU__PIPELINE_RENDER:
+		{
+			if (ppu.scanlineEndCallback)
+			{
+				return (PPU_scanline__cyclesLeft(PPU__SCANLINE_CYCLE_END));
+			}
 
-		return (status);
+			return (PPU_scanline__cyclesLeft(PPU__SCANLINE_CYCLE_END) + (PPU__SCANLINE_COUNT - ppu.scanline) * PPU__SCANLINE_CYCLE_END); // up to the end of the frame
+		}
+
+		case PPU__PIPELINE_POSTRENDER:
+		{ // the frame ends on the last cycle of the post-render scanline
+			return (PPU_scanline__cyclesLeft(PPU__SCANLINE_CYCLE_END));
+		}
+
+		case PPU__PIPELINE_VERTICAL_BLANK:
+		{
+			if (ppu.cycle == 1 && ppu.scanline == PPU__SCANLINE_COUNT + 1)
+			{ // the next cycle sets the vertical blank flag and fires the NMI
+				return (1);
+			}
+
+			if (ppu.scanlineEndCallback || ppu.scanline >= ppu.frameEnd)
+			{
+				return (PPU_scanline__cyclesLeft(PPU__SCANLINE_CYCLE_END));
+			}
+
+			return (PPU_scanline__cyclesLeft(PPU__SCANLINE_CYCLE_END) + (ppu.frameEnd - 1u - ppu.scanline) * PPU__SCANLINE_CYCLE_END); // up to the pre-render scanline
+		}
 	}
 
-	uint8_t readRegisterSpriteData()
+	return (1);
+}
+
+/* Scanlines as they are usually numbered: the visible ones from 0, then the post-render one and the vertical blank ... the pre-render one is counted last */
+inline uint16_t PPU_position__scanline()
+{
+	PPU_state_t &ppu = CC_console->ppu;
+
+	return ((ppu.pipelineStage == PPU__PIPELINE_PRERENDER) ? ppu.frameEnd : ppu.scanline);
+}
+
+/* Cycles up to the next scanline breakpoint of the current scanline, counting the cycle of its dot ... or up to the end of the scanline, where the next one is looked for */
+inline uint32_t PPU_debug__cyclesLeft(bool &breakpoint)
+{
+	PPU_state_t &ppu = CC_console->ppu;
+
+	uint16_t dot = DB::getScanlineBreak(PPU_position__scanline(), ppu.cycle);
+
+	breakpoint = (dot != DB_DOT_NONE);
+	if (breakpoint)
 	{
-		return (PPU_spriteMemory[PPU_spriteDataAddress]);
+		return (dot - ppu.cycle + 1u);
 	}
 
-	uint8_t readRegisterData()
+	return (PPU_scanline__cyclesLeft((ppu.pipelineStage == PPU__PIPELINE_PRERENDER) ? PPU__SCANLINE_CYCLE_END - 1u : PPU__SCANLINE_CYCLE_END));
+}
+
+/* PPU::run while there are scanline breakpoints ... they are only looked up once per scanline and before the dot of each */
+inline void PPU_debug__run(uint32_t cycles)
+{
+	PPU_state_t &ppu = CC_console->ppu;
+
+	while (cycles)
 	{
-		uint8_t data = MB::readPictureBus(PPU_dataAddress);
-		PPU_dataAddress += PPU_dataAddressIncrement;
+		bool breakpoint = false;
+		uint32_t steps = PPU_debug__cyclesLeft(breakpoint);
 
-		if (PPU_dataAddress < 0x3F00)
-		{ // reads are delayed in this address space
-			PPU_dataBuffer ^= data;
-			data ^= PPU_dataBuffer;
-			PPU_dataBuffer ^= data;
+		if (steps > cycles)
+		{
+			steps = cycles;
+			breakpoint = false;
 		}
 
-		return (data);
-	}
+		cycles -= steps;
 
-	void executeDMA(uint8_t *page_pointer)
-	{
-		if (page_pointer)
+		while (--steps)
 		{
-			memcpy(PPU_spriteMemory + PPU_spriteDataAddress, page_pointer, 256u - PPU_spriteDataAddress);
-			if (PPU_spriteDataAddress)
-			{
-				memcpy(PPU_spriteMemory, page_pointer + (256u - PPU_spriteDataAddress), PPU_spriteDataAddress);
-			}
+			PPU_pipeline__step();
 		}
+
+		if (breakpoint)
+		{ // the dot might not be the one expected, if the pre-render scanline was the long one
+			DB::scanline(PPU_position__scanline(), ppu.cycle);
+		}
+
+		PPU_pipeline__step();
 	}
 }
 
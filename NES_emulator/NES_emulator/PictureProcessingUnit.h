@@ -6,7 +6,15 @@ namespace PPU
 {
 	void reset();
 	void registerScanlineCallback(void(*callback)(bool vblank));
-	void step();
+	void run(uint32_t cycles);
+	uint32_t getFrameCount(); // frames completed since reset
+	void setFrameSkip(uint8_t frames); // renders one frame, then only emulates the timing of the next frames
+	uint8_t getFrameSkip();
+	void suppressOutput(bool suppress); // frames starting from now on are only emulated, like skipped ones
+	uint32_t getCyclesUntilEvent(); // cycles until the next NMI, scanline callback or frame end ... or DB scanline breakpoint
+	uint16_t getScanline(); // 0-239 visible, then the post-render one and the vertical blank, the pre-render one last
+	uint16_t getDot(); // the next one the PPU runs
+	bool isStatusSteady(); // the status register reads the same as it last did, up to the next event
 	void writeRegisterControl(uint8_t value);
 	void writeRegisterMask(uint8_t value);
 	void writeRegisterSpriteAddress(uint8_t value);
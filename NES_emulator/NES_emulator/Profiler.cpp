@@ -0,0 +1,414 @@
+#include "Profiler.h"
+
+#include "CartridgeReader.h"
+#include "CentralProcessingUnit.h"
+#include "MemoryMapper.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+#define PF__RAM_LOCATIONS (0x8000u) // everything below the cartridge ROM is counted by its address
+#define PF__PRG_BANK_SIZE (0x4000u) // as PRG ROM is sized in the header
+#define PF__REPORT_BANK_SIZE (0x2000u) // banks in the report ... no mapper switches smaller ones
+#define PF__MAXIMUM_DEPTH (64u) // frames deeper than this are counted in the one above
+#define PF__ENTRY_CYCLES (7u) // taken by the CPU to jump to an interrupt handler
+
+#define PF__FRAME_MAIN (0u) // code that was not called, from the reset vector on
+#define PF__FRAME_SUBROUTINE (1u)
+#define PF__FRAME_NMI (2u)
+#define PF__FRAME_IRQ (3u)
+#define PF__FRAME_BRK (4u)
+
+typedef struct
+{
+	uint64_t instructions;
+	uint64_t cycles;
+	uint16_t address; // CPU address the location was last executed from
+}PF_counter_t;
+
+typedef struct
+{
+	uint32_t parent;
+	uint32_t location; // of the first instruction of the frame
+	uint16_t address;
+	uint8_t kind;
+	uint64_t cycles; // spent in the frame itself, not in the ones it called
+}PF_node_t;
+
+typedef struct
+{
+	uint32_t node;
+	uint8_t stackPointer; // after the return address was pushed ... the frame is left once the stack is pulled above it
+	uint64_t startCycles;
+}PF_frame_t;
+
+typedef struct
+{
+	uint32_t node; // first one seen, for its location and kind
+	uint64_t entries;
+	uint64_t cycles; // from the jump to the handler to its RTI, including what it called and what interrupted it
+}PF_handler_t;
+
+typedef struct
+{
+	std::vector<PF_counter_t> counters; // RAM locations first, then PRG ROM
+	std::vector<PF_node_t> nodes; // call tree ... the first one is the main frame
+	std::unordered_map<uint64_t, uint32_t> children; // parent node, kind and location to node
+	std::vector<PF_frame_t> frames; // call stack the CPU is in
+	std::unordered_map<uint64_t, PF_handler_t> handlers; // kind and location to handler
+	uint64_t totalCycles;
+	uint64_t totalInstructions;
+
+	bool interruptPending; // jumped to a handler, the frame is entered by the next PF::instruction
+	uint8_t pendingKind;
+	uint16_t pendingAddress;
+	uint8_t pendingStackPointer;
+}PF_state_t;
+
+#define PF_state (*(PF_state_t*)CC_console->profilerData)
+
+inline uint32_t PF_location__of(uint16_t address);
+inline void PF_location__label(const PF_state_t &pf, uint32_t location, char *label, std::size_t size);
+inline void PF_frame__enter(PF_state_t &pf, uint8_t kind, uint16_t address, uint8_t stack_pointer);
+inline void PF_frame__leave(PF_state_t &pf, uint8_t stack_pointer);
+inline void PF_frame__name(const PF_state_t &pf, uint32_t node, std::string &name);
+
+namespace PF
+{
+	bool init()
+	{
+		clean();
+
+		PF_state_t *pf = new PF_state_t();
+
+		pf->counters.resize(PF__RAM_LOCATIONS + (std::size_t)CR::getROMBankCount() * PF__PRG_BANK_SIZE);
+
+		PF_node_t main = {};
+		main.kind = PF__FRAME_MAIN;
+		pf->nodes.push_back(main);
+
+		PF_frame_t frame = {};
+		frame.stackPointer = 0xFF; // never left
+		pf->frames.push_back(frame);
+
+		CC_console->profilerData = pf;
+
+		return (true);
+	}
+
+	void instruction(uint16_t address, uint8_t opcode, const CPU_state_t &cpu)
+	{
+		PF_state_t &pf = PF_state;
+
+		uint32_t cycles = cpu.cyclesToSkip;
+
+		/* A handler jumped to before the instruction is entered before it is counted ... one jumped to during it (BRK, NMI raised by a register write) after, and the jump is not counted in the instruction */
+		bool interruptedNow = pf.interruptPending && (address != pf.pendingAddress);
+
+		if (pf.interruptPending && !interruptedNow)
+		{
+			pf.interruptPending = false;
+			PF_frame__enter(pf, pf.pendingKind, pf.pendingAddress, pf.pendingStackPointer);
+		}
+
+		if (interruptedNow && cycles >= PF__ENTRY_CYCLES)
+		{
+			cycles -= PF__ENTRY_CYCLES;
+		}
+
+		uint32_t location = PF_location__of(address);
+		if (location < pf.counters.size())
+		{
+			PF_counter_t &counter = pf.counters[location];
+
+			++counter.instructions;
+			counter.cycles += cycles;
+			counter.address = address;
+		}
+
+		pf.nodes[pf.frames.back().node].cycles += cycles;
+		pf.totalCycles += cycles;
+		++pf.totalInstructions;
+
+		switch (opcode)
+		{
+			case 0x20: // JSR
+			{
+				if (!interruptedNow)
+				{
+					PF_frame__enter(pf, PF__FRAME_SUBROUTINE, cpu.registerPC, cpu.registerSP);
+				}
+
+				break;
+			}
+
+			case 0x40: // RTI
+			case 0x60: // RTS
+			{
+				PF_frame__leave(pf, cpu.registerSP);
+
+				break;
+			}
+		}
+
+		if (interruptedNow)
+		{
+			pf.interruptPending = false;
+			PF_frame__enter(pf, pf.pendingKind, pf.pendingAddress, pf.pendingStackPointer);
+		}
+	}
+
+	void interrupt(uint8_t interrupt, const CPU_state_t &cpu)
+	{
+		PF_state_t &pf = PF_state;
+
+		if (pf.interruptPending)
+		{ // an NMI on top of an IRQ before either handler started ... the NMI one is the one that runs first
+			PF_frame__enter(pf, pf.pendingKind, pf.pendingAddress, pf.pendingStackPointer);
+		}
+
+		pf.interruptPending = true;
+		pf.pendingKind = (interrupt == INTERRUPT_NMI) ? PF__FRAME_NMI : ((interrupt == INTERRUPT_BRK) ? PF__FRAME_BRK : PF__FRAME_IRQ);
+		pf.pendingAddress = cpu.registerPC;
+		pf.pendingStackPointer = cpu.registerSP;
+	}
+
+	uint8_t writeReport(std::string file_name)
+	{
+		if (!CC_console->profilerData)
+		{
+			return (STATUS_PF_NOT_PROFILING);
+		}
+
+		const PF_state_t &pf = PF_state;
+
+		FILE *file = fopen(file_name.c_str(), "w");
+		if (!file)
+		{
+			return (STATUS_PF_FILE_PROTECTED_OR_NONEXISTENT);
+		}
+
+		std::vector<uint32_t> locations;
+		for (uint32_t location = 0; location < pf.counters.size(); ++location)
+		{
+			if (pf.counters[location].instructions)
+			{
+				locations.push_back(location);
+			}
+		}
+
+		std::sort(locations.begin(), locations.end(), [&pf](uint32_t a, uint32_t b) { return (pf.counters[a].cycles > pf.counters[b].cycles); });
+
+		double total = pf.totalCycles ? (double)pf.totalCycles : 1.0;
+		char label[32];
+
+		fprintf(file, "%" PRIu64 " instructions, %" PRIu64 " cycles ... PRG ROM locations are <8K bank>:<address>\n\n", pf.totalInstructions, pf.totalCycles);
+		fprintf(file, "%14s %7s %14s  %s\n", "cycles", "share", "instructions", "location");
+
+		for (std::size_t i = 0; i < locations.size(); ++i)
+		{
+			const PF_counter_t &counter = pf.counters[locations[i]];
+
+			PF_location__label(pf, locations[i], label, sizeof(label));
+			fprintf(file, "%14" PRIu64 " %6.2f%% %14" PRIu64 "  %s\n", counter.cycles, 100.0 * counter.cycles / total, counter.instructions, label);
+		}
+
+		std::vector<const PF_handler_t*> handlers;
+		for (std::unordered_map<uint64_t, PF_handler_t>::const_iterator handler = pf.handlers.begin(); handler != pf.handlers.end(); ++handler)
+		{
+			handlers.push_back(&handler->second);
+		}
+
+		std::sort(handlers.begin(), handlers.end(), [](const PF_handler_t *a, const PF_handler_t *b) { return (a->cycles > b->cycles); });
+
+		fprintf(file, "\nInterrupt handlers\n");
+		fprintf(file, "%14s %7s %10s %10s  %s\n", "cycles", "share", "entries", "per entry", "handler");
+
+		for (std::size_t i = 0; i < handlers.size(); ++i)
+		{
+			const PF_node_t &node = pf.nodes[handlers[i]->node];
+			const char *kind = (node.kind == PF__FRAME_NMI) ? "NMI" : ((node.kind == PF__FRAME_BRK) ? "BRK" : "IRQ");
+
+			PF_location__label(pf, node.location, label, sizeof(label));
+			fprintf(file, "%14" PRIu64 " %6.2f%% %10" PRIu64 " %10" PRIu64 "  %s %s\n", handlers[i]->cycles, 100.0 * handlers[i]->cycles / total, handlers[i]->entries, handlers[i]->cycles / handlers[i]->entries, kind, label);
+		}
+
+		if (fclose(file))
+		{
+			return (STATUS_PF_UNABLE_TO_ACCESS_FILE);
+		}
+
+		return (STATUS_PF_SUCCESS);
+	}
+
+	uint8_t writeFoldedStacks(std::string file_name)
+	{
+		if (!CC_console->profilerData)
+		{
+			return (STATUS_PF_NOT_PROFILING);
+		}
+
+		const PF_state_t &pf = PF_state;
+
+		FILE *file = fopen(file_name.c_str(), "w");
+		if (!file)
+		{
+			return (STATUS_PF_FILE_PROTECTED_OR_NONEXISTENT);
+		}
+
+		std::string name;
+
+		for (uint32_t node = 0; node < pf.nodes.size(); ++node)
+		{
+			if (!pf.nodes[node].cycles)
+			{
+				continue;
+			}
+
+			name.clear();
+			PF_frame__name(pf, node, name);
+
+			fprintf(file, "%s %" PRIu64 "\n", name.c_str(), pf.nodes[node].cycles);
+		}
+
+		if (fclose(file))
+		{
+			return (STATUS_PF_UNABLE_TO_ACCESS_FILE);
+		}
+
+		return (STATUS_PF_SUCCESS);
+	}
+
+	void clean()
+	{
+		delete (PF_state_t*)CC_console->profilerData;
+		CC_console->profilerData = nullptr;
+	}
+}
+
+/* Index of the counter of an address ... PRG ROM by the offset it is mapped to, so the same address in two banks is counted apart */
+inline uint32_t PF_location__of(uint16_t address)
+{
+	if (address < PF__RAM_LOCATIONS)
+	{
+		return (address);
+	}
+
+	return (PF__RAM_LOCATIONS + MM::mapPRG(address));
+}
+
+inline void PF_location__label(const PF_state_t &pf, uint32_t location, char *label, std::size_t size)
+{
+	if (location < PF__RAM_LOCATIONS)
+	{
+		snprintf(label, size, "RAM:%04X", (unsigned)location);
+
+		return;
+	}
+
+	uint16_t address = (location < pf.counters.size()) ? pf.counters[location].address : 0;
+
+	snprintf(label, size, "%02X:%04X", (unsigned)((location - PF__RAM_LOCATIONS) / PF__REPORT_BANK_SIZE), (unsigned)address);
+}
+
+/* Moves into a child of the current frame, creating it the first time it is called from there */
+inline void PF_frame__enter(PF_state_t &pf, uint8_t kind, uint16_t address, uint8_t stack_pointer)
+{
+	uint32_t location = PF_location__of(address);
+
+	if (location < pf.counters.size())
+	{ // known before the first instruction of the frame executes, for its label
+		pf.counters[location].address = address;
+	}
+
+	if (pf.frames.size() >= PF__MAXIMUM_DEPTH)
+	{
+		return;
+	}
+
+	uint32_t parent = pf.frames.back().node;
+	uint64_t key = ((uint64_t)parent << 40) | ((uint64_t)kind << 32) | location;
+
+	std::unordered_map<uint64_t, uint32_t>::iterator child = pf.children.find(key);
+	uint32_t node;
+
+	if (child == pf.children.end())
+	{
+		PF_node_t created = {};
+		created.parent = parent;
+		created.location = location;
+		created.address = address;
+		created.kind = kind;
+
+		node = (uint32_t)pf.nodes.size();
+		pf.nodes.push_back(created);
+		pf.children[key] = node;
+	}
+	else
+	{
+		node = child->second;
+	}
+
+	PF_frame_t frame;
+	frame.node = node;
+	frame.stackPointer = stack_pointer;
+	frame.startCycles = pf.totalCycles;
+	pf.frames.push_back(frame);
+
+	if (kind != PF__FRAME_SUBROUTINE)
+	{
+		PF_handler_t &handler = pf.handlers[((uint64_t)kind << 32) | location];
+
+		if (!handler.entries)
+		{
+			handler.node = node;
+		}
+
+		++handler.entries;
+
+		pf.nodes[node].cycles += PF__ENTRY_CYCLES;
+		pf.totalCycles += PF__ENTRY_CYCLES;
+	}
+}
+
+/* Leaves every frame whose return address was pulled ... games that drop a return address and return from the caller leave both */
+inline void PF_frame__leave(PF_state_t &pf, uint8_t stack_pointer)
+{
+	while (pf.frames.size() > 1 && pf.frames.back().stackPointer < stack_pointer)
+	{
+		const PF_frame_t &frame = pf.frames.back();
+		const PF_node_t &node = pf.nodes[frame.node];
+
+		if (node.kind != PF__FRAME_SUBROUTINE)
+		{
+			pf.handlers[((uint64_t)node.kind << 32) | node.location].cycles += pf.totalCycles - frame.startCycles;
+		}
+
+		pf.frames.pop_back();
+	}
+}
+
+/* "main;NMI@07:C123;07:C456", from the outermost frame in */
+inline void PF_frame__name(const PF_state_t &pf, uint32_t node, std::string &name)
+{
+	const PF_node_t &frame = pf.nodes[node];
+
+	if (frame.kind == PF__FRAME_MAIN)
+	{
+		name += "main";
+
+		return;
+	}
+
+	PF_frame__name(pf, frame.parent, name);
+
+	char label[32];
+	PF_location__label(pf, frame.location, label, sizeof(label));
+
+	name += ';';
+	name += (frame.kind == PF__FRAME_NMI) ? "NMI@" : ((frame.kind == PF__FRAME_IRQ) ? "IRQ@" : ((frame.kind == PF__FRAME_BRK) ? "BRK@" : ""));
+	name += label;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ConsoleContext.h"
+
+#include <cstdint>
+#include <string>
+
+#define STATUS_PF_SUCCESS (0x00u)
+#define STATUS_PF_FILE_PROTECTED_OR_NONEXISTENT (0x01u)
+#define STATUS_PF_UNABLE_TO_ACCESS_FILE (0x02u)
+#define STATUS_PF_NOT_PROFILING (0x04u)
+
+/* Instructions and cycles spent at every address of the selected console, PRG ROM code counted by its place in the ROM so banks are kept apart ... CPU::run only uses its profiled core while PF is initialized */
+namespace PF
+{
+	bool init(); // after the cartridge was loaded and the console reset
+	void instruction(uint16_t address, uint8_t opcode, const CPU_state_t &cpu); // by the profiled core, after each instruction ... cyclesToSkip still holds what the instruction took
+	void interrupt(uint8_t interrupt, const CPU_state_t &cpu); // after the CPU jumped to the handler
+	uint8_t writeReport(std::string file_name); // hottest addresses first, then the interrupt handlers
+	uint8_t writeFoldedStacks(std::string file_name); // "frame;frame;frame cycles" lines, as flamegraph.pl takes them
+	void clean(); // must be called before destroying the console
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <SFML/Graphics.hpp>
 
 #include <chrono>
+#include <cstring>
 #include <thread>
 #include <mutex>
 #include <queue>
@@ -16,8 +17,12 @@
 
 #define RW__MINIMUM_FRAME_TIME (std::chrono::microseconds(10000))
 
+#define RW__KEY_TURBO (sf::Keyboard::Tab)
+#define RW__KEY_REWIND (sf::Keyboard::BackSpace) // held down
+#define RW__KEY_RECORD (sf::Keyboard::F5)
+#define RW__KEY_PLAYBACK (sf::Keyboard::F6)
+
 #define RW__COMMNAD_NONE (0u)
-#define RW__COMMAND_SET_PIXEL (1u)
 #define RW__COMMAND_PUSH_FRAME (2u)
 #define RW__COMMAND_SHUT_DOWN (3u)
 
@@ -31,18 +36,7 @@ public:
 typedef struct
 {
 	uint8_t commandType;
-
-	union
-	{
-		struct
-		{
-			std::size_t pixelX;
-			std::size_t pixelY;
-			uint32_t pixelColor;
-		};
-
-		bool forceFrame;
-	};
+	bool forceFrame;
 }RW_command_t;
 
 static std::chrono::high_resolution_clock::time_point RW_previousFrameTimePoint;
@@ -50,6 +44,10 @@ static bool RW_firstRender = false;
 
 static std::thread *RW_windowOwner = nullptr;
 
+static uint32_t RW_backBuffer[RW__NES_WINDOW_WIDTH * RW__NES_WINDOW_HEIGHT]; // written by the emulation
+static uint32_t RW_frontBuffer[RW__NES_WINDOW_WIDTH * RW__NES_WINDOW_HEIGHT]; // last complete frame, guarded by the command mutex
+static bool RW_framePending = false;
+
 static std::queue<RW_command_t> RW_commandQueue;
 static std::queue<uint8_t> RW_eventQueue;
 
@@ -69,15 +67,10 @@ namespace RW
 
 	void setPixel(std::size_t x_coordinate, std::size_t y_coordinate, uint32_t color)
 	{
-		std::lock_guard<std::mutex> mutexGuard(RW_commandMutex);
-
-		RW_command_t command;
-		command.commandType = RW__COMMAND_SET_PIXEL;
-		command.pixelX = x_coordinate;
-		command.pixelY = y_coordinate;
-		command.pixelColor = color;
-
-		RW_commandQueue.push(command);
+		if (x_coordinate < RW__NES_WINDOW_WIDTH && y_coordinate < RW__NES_WINDOW_HEIGHT)
+		{
+			RW_backBuffer[y_coordinate * RW__NES_WINDOW_WIDTH + x_coordinate] = color;
+		}
 	}
 
 	uint8_t pollWindowEvent()
@@ -99,11 +92,19 @@ namespace RW
 	{
 		std::lock_guard<std::mutex> mutexGuard(RW_commandMutex);
 
+		memcpy(RW_frontBuffer, RW_backBuffer, sizeof(RW_frontBuffer));
+
+		if (RW_framePending && !forced)
+		{ // the window did not get to present the previous frame ... it will show this one instead
+			return;
+		}
+
 		RW_command_t command;
 		command.commandType = RW__COMMAND_PUSH_FRAME;
 		command.forceFrame = forced;
 
 		RW_commandQueue.push(command);
+		RW_framePending = true;
 	}
 
 	void dispose()
@@ -112,6 +113,7 @@ namespace RW
 
 		RW_command_t command;
 		command.commandType = RW__COMMAND_SHUT_DOWN;
+		command.forceFrame = false;
 
 		RW_commandQueue.push(command);
 	}
@@ -133,6 +135,7 @@ void RW_windowOwner__loop()
 	/* Creating a window to display the virtual screen in */
 	window.create(sf::VideoMode((unsigned int)(RW__NES_WINDOW_WIDTH * RW__SCREEN_SCALE), (unsigned int)(RW__NES_WINDOW_HEIGHT * RW__SCREEN_SCALE)), "NES emulator", sf::Style::Titlebar | sf::Style::Close);
 	window.setVerticalSyncEnabled(true);
+	window.setKeyRepeatEnabled(false); // a held key is one KeyPressed, so the toggles only flip once ... the controllers read the keyboard state directly
 
 	/* Creating a virtual screen to write visual data to */
 	virtualScreen.vertices.resize(RW__NES_WINDOW_WIDTH * RW__NES_WINDOW_HEIGHT * 6); // 6 vertices per pixel
@@ -197,27 +200,31 @@ void RW_windowOwner__loop()
 					break;
 				}
 
-				case RW__COMMAND_SET_PIXEL:
+				case RW__COMMAND_PUSH_FRAME:
 				{
-					std::size_t i = (command.pixelX * RW__NES_WINDOW_HEIGHT + command.pixelY) * 6;
-					if (i < virtualScreen.vertices.getVertexCount())
+					if (command.forceFrame || (!RW_firstRender) || (std::chrono::high_resolution_clock::now() - RW_previousFrameTimePoint >= RW__MINIMUM_FRAME_TIME))
 					{
-						sf::Color color(command.pixelColor);
-
-						for (std::size_t index = i; index < i + 6; ++index)
 						{
-							virtualScreen.vertices[index].color = color;
+							std::lock_guard<std::mutex> mutexGuard(RW_commandMutex);
+
+							for (std::size_t x = 0; x < RW__NES_WINDOW_WIDTH; ++x)
+							{
+								for (std::size_t y = 0; y < RW__NES_WINDOW_HEIGHT; ++y)
+								{
+									std::size_t i = (x * RW__NES_WINDOW_HEIGHT + y) * 6;
+									sf::Color color(RW_frontBuffer[y * RW__NES_WINDOW_WIDTH + x]);
+
+									for (std::size_t index = i; index < i + 6; ++index)
+									{
+										virtualScreen.vertices[index].color = color;
+									}
+								}
+							}
+
+							RW_framePending = false;
 						}
-					}
-
-					break;
-				}
 
-				case RW__COMMAND_PUSH_FRAME:
-				{
-					if (command.forceFrame || (!RW_firstRender) || (std::chrono::high_resolution_clock::now() - RW_previousFrameTimePoint >= RW__MINIMUM_FRAME_TIME))
-					{
-						window.draw(virtualScreen);
+						window.draw(virtualScreen); // vertical sync limits this to one frame per refresh
 						window.display();
 
 						RW_firstRender = true;
@@ -225,6 +232,12 @@ void RW_windowOwner__loop()
 
 						commandsAvailable = false; // makes sure the thread polls events after each frame
 					}
+					else
+					{ // too soon after the previous one
+						std::lock_guard<std::mutex> mutexGuard(RW_commandMutex);
+
+						RW_framePending = false;
+					}
 
 					break;
 				}
@@ -244,6 +257,36 @@ void RW_windowOwner__loop()
 
 				RW_eventQueue.push(EVENT_BUTTON_CLOSE_PRESSED);
 			}
+			else if (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == RW__KEY_TURBO)
+			{
+				std::lock_guard<std::mutex> mutexGuard(RW_eventMutex);
+
+				RW_eventQueue.push(EVENT_KEY_TURBO_PRESSED);
+			}
+			else if (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == RW__KEY_REWIND)
+			{
+				std::lock_guard<std::mutex> mutexGuard(RW_eventMutex);
+
+				RW_eventQueue.push(EVENT_KEY_REWIND_PRESSED);
+			}
+			else if (windowEvent.type == sf::Event::KeyReleased && windowEvent.key.code == RW__KEY_REWIND)
+			{
+				std::lock_guard<std::mutex> mutexGuard(RW_eventMutex);
+
+				RW_eventQueue.push(EVENT_KEY_REWIND_RELEASED);
+			}
+			else if (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == RW__KEY_RECORD)
+			{
+				std::lock_guard<std::mutex> mutexGuard(RW_eventMutex);
+
+				RW_eventQueue.push(EVENT_KEY_RECORD_PRESSED);
+			}
+			else if (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == RW__KEY_PLAYBACK)
+			{
+				std::lock_guard<std::mutex> mutexGuard(RW_eventMutex);
+
+				RW_eventQueue.push(EVENT_KEY_PLAYBACK_PRESSED);
+			}
 		}
 	}
 }
\ No newline at end of file
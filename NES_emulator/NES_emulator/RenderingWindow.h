@@ -1,9 +1,15 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #define EVENT_NONE (0u)
 #define EVENT_BUTTON_CLOSE_PRESSED (1u)
+#define EVENT_KEY_TURBO_PRESSED (2u)
+#define EVENT_KEY_REWIND_PRESSED (3u)
+#define EVENT_KEY_REWIND_RELEASED (4u)
+#define EVENT_KEY_RECORD_PRESSED (5u)
+#define EVENT_KEY_PLAYBACK_PRESSED (6u)
 
 namespace RW
 {
@@ -0,0 +1,341 @@
+#include "RewindBuffer.h"
+
+#include "ConsoleContext.h"
+#include "SaveState.h"
+
+#include <cstring>
+
+#define RB__BYTES_PER_ENTRY (64u) // sizes the entry table ... snapshots are rarely smaller than this
+#define RB__MINIMUM_EQUAL_RUN (4u) // shorter runs of unchanged bytes are cheaper to keep in the literals
+#define RB__MAXIMUM_RUN (0xFFFFu)
+
+typedef struct
+{
+	uint32_t offset;
+	uint32_t size;
+	uint32_t keyframe; // sequence number of the keyframe it is coded against, its own if it is one
+}RB_entry_t;
+
+typedef struct
+{
+	uint8_t *buffer;
+	std::size_t capacity;
+	std::size_t usedSize;
+	uint16_t keyframeInterval;
+
+	RB_entry_t *entries;
+	uint32_t maximumEntries;
+	uint32_t oldest; // sequence numbers ... the entry table is indexed modulo its size
+	uint32_t next;
+
+	uint8_t *snapshot; // being coded or decoded
+	uint8_t *coded;
+	std::size_t stateSize;
+}RB_state_t;
+
+#define RB_state (*(RB_state_t*)CC_console->rewindData)
+
+inline RB_entry_t& RB_ring__entry(RB_state_t &rb, uint32_t sequence);
+inline uint32_t RB_ring__reserve(RB_state_t &rb, std::size_t size);
+inline void RB_ring__dropOldest(RB_state_t &rb);
+inline std::size_t RB_delta__encode(const uint8_t *state, const uint8_t *keyframe, uint8_t *coded, std::size_t state_size);
+inline void RB_delta__decode(const uint8_t *coded, std::size_t size, const uint8_t *keyframe, uint8_t *state, std::size_t state_size);
+
+namespace RB
+{
+	bool init(std::size_t capacity, uint16_t keyframe_interval)
+	{
+		clean();
+
+		RB_state_t *rb = new RB_state_t();
+
+		rb->stateSize = SS::getStateSize();
+		rb->capacity = capacity;
+		rb->keyframeInterval = keyframe_interval ? keyframe_interval : 1;
+		rb->maximumEntries = (uint32_t)(capacity / RB__BYTES_PER_ENTRY) + 1;
+
+		rb->buffer = new uint8_t[rb->capacity];
+		rb->entries = new RB_entry_t[rb->maximumEntries];
+		rb->snapshot = new uint8_t[rb->stateSize];
+		rb->coded = new uint8_t[rb->stateSize]; // deltas that do not fit are stored as keyframes
+
+		CC_console->rewindData = rb;
+
+		clear();
+
+		return (rb->buffer && rb->entries && rb->snapshot && rb->coded);
+	}
+
+	bool push()
+	{
+		if (!CC_console->rewindData)
+		{
+			return (false);
+		}
+
+		RB_state_t &rb = RB_state;
+
+		if (rb.stateSize > rb.capacity)
+		{
+			return (false);
+		}
+
+		SS::saveState(rb.snapshot);
+
+		const uint8_t *data = rb.snapshot;
+		std::size_t size = rb.stateSize;
+		uint32_t keyframe = rb.next;
+
+		if (rb.next != rb.oldest && rb.next - RB_ring__entry(rb, rb.next - 1).keyframe < rb.keyframeInterval)
+		{
+			uint32_t previousKeyframe = RB_ring__entry(rb, rb.next - 1).keyframe;
+			std::size_t codedSize = RB_delta__encode(rb.snapshot, rb.buffer + RB_ring__entry(rb, previousKeyframe).offset, rb.coded, rb.stateSize);
+
+			if (codedSize)
+			{
+				data = rb.coded;
+				size = codedSize;
+				keyframe = previousKeyframe;
+			}
+		}
+
+		uint32_t offset = RB_ring__reserve(rb, size);
+
+		if (keyframe != rb.next && (int32_t)(keyframe - rb.oldest) < 0)
+		{ // making room dropped the keyframe the delta was coded against
+			data = rb.snapshot;
+			size = rb.stateSize;
+			keyframe = rb.next;
+
+			offset = RB_ring__reserve(rb, size);
+		}
+
+		memcpy(rb.buffer + offset, data, size);
+
+		RB_entry_t &entry = RB_ring__entry(rb, rb.next);
+		entry.offset = offset;
+		entry.size = (uint32_t)size;
+		entry.keyframe = keyframe;
+
+		rb.usedSize += size;
+		++rb.next;
+
+		return (true);
+	}
+
+	bool rewind()
+	{
+		if (getSnapshotCount() < 2)
+		{
+			return (false);
+		}
+
+		RB_state_t &rb = RB_state;
+
+		--rb.next;
+		rb.usedSize -= RB_ring__entry(rb, rb.next).size;
+
+		RB_entry_t &entry = RB_ring__entry(rb, rb.next - 1);
+		if (entry.keyframe == rb.next - 1)
+		{
+			return (SS::loadState(rb.buffer + entry.offset) == STATUS_SS_LOAD_SUCCESS);
+		}
+
+		RB_delta__decode(rb.buffer + entry.offset, entry.size, rb.buffer + RB_ring__entry(rb, entry.keyframe).offset, rb.snapshot, rb.stateSize);
+
+		return (SS::loadState(rb.snapshot) == STATUS_SS_LOAD_SUCCESS);
+	}
+
+	uint32_t getSnapshotCount()
+	{
+		if (!CC_console->rewindData)
+		{
+			return (0);
+		}
+
+		RB_state_t &rb = RB_state;
+
+		return (rb.next - rb.oldest);
+	}
+
+	std::size_t getUsedSize()
+	{
+		if (!CC_console->rewindData)
+		{
+			return (0);
+		}
+
+		RB_state_t &rb = RB_state;
+
+		return (rb.usedSize);
+	}
+
+	void clear()
+	{
+		if (!CC_console->rewindData)
+		{
+			return;
+		}
+
+		RB_state_t &rb = RB_state;
+
+		rb.oldest = 0;
+		rb.next = 0;
+		rb.usedSize = 0;
+	}
+
+	void clean()
+	{
+		RB_state_t *rb = (RB_state_t*)CC_console->rewindData;
+		if (!rb)
+		{
+			return;
+		}
+
+		delete[] rb->buffer;
+		delete[] rb->entries;
+		delete[] rb->snapshot;
+		delete[] rb->coded;
+		delete rb;
+
+		CC_console->rewindData = nullptr;
+	}
+}
+
+inline RB_entry_t& RB_ring__entry(RB_state_t &rb, uint32_t sequence)
+{
+	return (rb.entries[sequence % rb.maximumEntries]);
+}
+
+/* Drops the oldest snapshots until the given size fits right after the newest one ... returns where it fits */
+inline uint32_t RB_ring__reserve(RB_state_t &rb, std::size_t size)
+{
+	if (rb.next == rb.oldest)
+	{
+		return (0);
+	}
+
+	RB_entry_t &newest = RB_ring__entry(rb, rb.next - 1);
+	uint32_t end = newest.offset + newest.size;
+	uint32_t offset = end;
+
+	if (offset + size > rb.capacity)
+	{ // wraps around ... whatever is stored after the newest snapshot is older and gets dropped
+		offset = 0;
+
+		while (rb.next != rb.oldest && RB_ring__entry(rb, rb.oldest).offset >= end)
+		{
+			RB_ring__dropOldest(rb);
+		}
+	}
+
+	while (rb.next != rb.oldest)
+	{
+		RB_entry_t &oldest = RB_ring__entry(rb, rb.oldest);
+
+		bool overlapping = (oldest.offset < offset + size) && (offset < oldest.offset + oldest.size);
+		if (!overlapping && rb.next - rb.oldest < rb.maximumEntries)
+		{
+			break;
+		}
+
+		RB_ring__dropOldest(rb);
+	}
+
+	return (rb.next == rb.oldest ? 0 : offset);
+}
+
+/* Deltas can not be decoded without their keyframe, so they go with it */
+inline void RB_ring__dropOldest(RB_state_t &rb)
+{
+	rb.usedSize -= RB_ring__entry(rb, rb.oldest).size;
+	++rb.oldest;
+
+	while (rb.next != rb.oldest && RB_ring__entry(rb, rb.oldest).keyframe != rb.oldest)
+	{
+		rb.usedSize -= RB_ring__entry(rb, rb.oldest).size;
+		++rb.oldest;
+	}
+}
+
+/* Runs of unchanged bytes followed by the changed ones XORed with the keyframe ... returns 0 if that is not smaller than the snapshot */
+inline std::size_t RB_delta__encode(const uint8_t *state, const uint8_t *keyframe, uint8_t *coded, std::size_t state_size)
+{
+	std::size_t position = 0;
+	std::size_t i = 0;
+
+	while (i < state_size)
+	{
+		uint16_t equal = 0;
+		while (i < state_size && equal < RB__MAXIMUM_RUN && state[i] == keyframe[i])
+		{
+			++equal;
+			++i;
+		}
+
+		std::size_t literalStart = i;
+		uint16_t literals = 0;
+		while (i < state_size && literals < RB__MAXIMUM_RUN)
+		{
+			if (state[i] == keyframe[i])
+			{ // ends the literals only if enough unchanged bytes follow
+				std::size_t run = 1;
+				while (i + run < state_size && run < RB__MINIMUM_EQUAL_RUN && state[i + run] == keyframe[i + run])
+				{
+					++run;
+				}
+
+				if (run >= RB__MINIMUM_EQUAL_RUN || i + run >= state_size)
+				{
+					break;
+				}
+			}
+
+			++literals;
+			++i;
+		}
+
+		if (position + 2 * sizeof(uint16_t) + literals >= state_size)
+		{
+			return (0);
+		}
+
+		memcpy(coded + position, &equal, sizeof(uint16_t));
+		position += sizeof(uint16_t);
+		memcpy(coded + position, &literals, sizeof(uint16_t));
+		position += sizeof(uint16_t);
+
+		for (std::size_t j = 0; j < literals; ++j)
+		{
+			coded[position++] = state[literalStart + j] ^ keyframe[literalStart + j];
+		}
+	}
+
+	return (position);
+}
+
+inline void RB_delta__decode(const uint8_t *coded, std::size_t size, const uint8_t *keyframe, uint8_t *state, std::size_t state_size)
+{
+	memcpy(state, keyframe, state_size);
+
+	std::size_t position = 0;
+	std::size_t i = 0;
+
+	while (position < size)
+	{
+		uint16_t equal;
+		uint16_t literals;
+
+		memcpy(&equal, coded + position, sizeof(uint16_t));
+		position += sizeof(uint16_t);
+		memcpy(&literals, coded + position, sizeof(uint16_t));
+		position += sizeof(uint16_t);
+
+		i += equal;
+
+		for (uint16_t j = 0; j < literals; ++j)
+		{
+			state[i++] ^= coded[position++];
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* Last snapshots of the selected console, each one XOR/RLE coded against the keyframe before it ... the oldest are dropped when the buffer is full */
+namespace RB
+{
+	bool init(std::size_t capacity, uint16_t keyframe_interval); // capacity in bytes, every keyframe_interval snapshot is stored whole
+	bool push(); // snapshots the selected console, between MC calls
+	bool rewind(); // drops the newest snapshot and loads the one before it ... false once there is nothing left to go back to
+	uint32_t getSnapshotCount();
+	std::size_t getUsedSize(); // bytes taken by the stored snapshots
+	void clear();
+	void clean(); // must be called before destroying the console
+}
\ No newline at end of file
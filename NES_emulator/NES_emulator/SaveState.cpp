@@ -0,0 +1,435 @@
+#include "SaveState.h"
+
+#include "CartridgeReader.h"
+#include "ConsoleContext.h"
+#include "MemoryBus.h"
+#include "MemoryMapper.h"
+
+#include <cstring>
+
+#define SS__MAGIC (0x5353454Eu) // "NESS"
+#define SS__VERSION (10u) // has to change whenever one of the saved structures does
+
+#define SS__FLAG_EXTERNAL_RAM (0x01u)
+#define SS__FLAG_CHARACTER_RAM (0x02u)
+
+#define SS__EXTERNAL_RAM_SIZE (0x2000u)
+#define SS__CHARACTER_RAM_SIZE (0x2000u)
+
+#define SS__MAXIMUM_BANK_POINTERS (10u)
+
+#define SS__REGION_NONE (0u) // bank pointers are saved as a region and an offset inside it
+#define SS__REGION_PRG_ROM (1u)
+#define SS__REGION_CHR_ROM (2u)
+#define SS__REGION_CHR_RAM (3u)
+#define SS__REGION_SHIFT (30u)
+#define SS__OFFSET_MASK (0x3FFFFFFFu)
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t mapper;
+	uint8_t systemType;
+	uint8_t PRGBankCount;
+	uint8_t CHRBankCount;
+	uint8_t flags;
+	uint32_t size; // of the whole state, header included
+}SS_header_t;
+
+typedef struct
+{
+	MM_parameters_t parameters; // with the pointers cleared
+	uint32_t bankPointers[SS__MAXIMUM_BANK_POINTERS];
+	uint8_t nameTableMirroring;
+}SS_mapper_t;
+
+inline uint8_t SS_header__flags();
+inline uint8_t** SS_mapper__characterRAM(MM_parameters_t &parameters, uint16_t mapper);
+inline std::size_t SS_mapper__bankPointers(MM_parameters_t &parameters, uint16_t mapper, uint8_t **pointers[SS__MAXIMUM_BANK_POINTERS]);
+inline uint32_t SS_pointer__toOffset(const uint8_t *pointer, uint8_t *character_RAM);
+inline bool SS_pointer__fromOffset(uint32_t offset, uint8_t *character_RAM, uint8_t *&pointer);
+
+namespace SS
+{
+	std::size_t getStateSize()
+	{
+		uint8_t flags = SS_header__flags();
+
+		std::size_t size = sizeof(SS_header_t) + sizeof(CPU_state_t) + sizeof(PPU_state_t) + sizeof(APU_state_t) + sizeof(MB_state_t) + sizeof(SS_mapper_t) + sizeof(MC_state_t);
+		size += (flags & SS__FLAG_EXTERNAL_RAM) ? SS__EXTERNAL_RAM_SIZE : 0;
+		size += (flags & SS__FLAG_CHARACTER_RAM) ? SS__CHARACTER_RAM_SIZE : 0;
+
+		return (size);
+	}
+
+	std::size_t saveState(uint8_t *buffer)
+	{
+		CC_console_t &console = *CC_console;
+		uint8_t *position = buffer;
+
+		SS_header_t header;
+		memset(&header, 0, sizeof(header));
+
+		header.magic = SS__MAGIC;
+		header.version = SS__VERSION;
+		header.mapper = console.mm.currentMapper;
+		header.systemType = CR::getSystemType();
+		header.PRGBankCount = CR::getROMBankCount();
+		header.CHRBankCount = CR::getVROMBankCount();
+		header.flags = SS_header__flags();
+		header.size = (uint32_t)getStateSize();
+
+		memcpy(position, &header, sizeof(header));
+		position += sizeof(header);
+
+		/* The processing units are copied whole ... pointers to tables and callbacks are cleared, the loading console already has them */
+		CPU_state_t cpu;
+		memcpy(&cpu, &console.cpu, sizeof(cpu));
+		cpu.pages = nullptr;
+		cpu.RAM = nullptr;
+		memcpy(position, &cpu, sizeof(cpu));
+		position += sizeof(cpu);
+
+		PPU_state_t ppu;
+		memcpy(&ppu, &console.ppu, sizeof(ppu));
+		ppu.paletteInUse = nullptr;
+		ppu.scanlineEndCallback = nullptr;
+		memcpy(position, &ppu, sizeof(ppu));
+		position += sizeof(ppu);
+
+		APU_state_t apu;
+		memcpy(&apu, &console.apu, sizeof(apu));
+		apu.gaussFilterInUse = nullptr;
+		apu.noisePeriods = nullptr;
+		apu.dmcRates = nullptr;
+		memcpy(position, &apu, sizeof(apu));
+		position += sizeof(apu);
+
+		MB_state_t mb;
+		memcpy(&mb, &console.mb, sizeof(mb));
+		mb.externalRAM = nullptr;
+		memcpy(position, &mb, sizeof(mb));
+		position += sizeof(mb);
+
+		/* Bank pointers point into the cartridge, so they are stored as offsets */
+		SS_mapper_t mapper;
+		memset(&mapper, 0, sizeof(mapper));
+		memcpy(&mapper.parameters, &console.mm.parameters, sizeof(MM_parameters_t));
+		mapper.nameTableMirroring = console.mm.nameTableMirroring;
+
+		uint8_t **characterRAM = SS_mapper__characterRAM(console.mm.parameters, console.mm.currentMapper);
+		uint8_t **savedCharacterRAM = SS_mapper__characterRAM(mapper.parameters, console.mm.currentMapper);
+		if (savedCharacterRAM)
+		{
+			*savedCharacterRAM = nullptr;
+		}
+
+		uint8_t **bankPointers[SS__MAXIMUM_BANK_POINTERS];
+		uint8_t **savedBankPointers[SS__MAXIMUM_BANK_POINTERS];
+		std::size_t bankPointerCount = SS_mapper__bankPointers(console.mm.parameters, console.mm.currentMapper, bankPointers);
+		SS_mapper__bankPointers(mapper.parameters, console.mm.currentMapper, savedBankPointers);
+
+		for (std::size_t i = 0; i < bankPointerCount; ++i)
+		{
+			mapper.bankPointers[i] = SS_pointer__toOffset(*bankPointers[i], characterRAM ? *characterRAM : nullptr);
+			*savedBankPointers[i] = nullptr;
+		}
+
+		memcpy(position, &mapper, sizeof(mapper));
+		position += sizeof(mapper);
+
+		memcpy(position, &console.mc, sizeof(MC_state_t));
+		position += sizeof(MC_state_t);
+
+		if (header.flags & SS__FLAG_EXTERNAL_RAM)
+		{
+			memcpy(position, console.mb.externalRAM, SS__EXTERNAL_RAM_SIZE);
+			position += SS__EXTERNAL_RAM_SIZE;
+		}
+
+		if (header.flags & SS__FLAG_CHARACTER_RAM)
+		{
+			memcpy(position, *characterRAM, SS__CHARACTER_RAM_SIZE);
+			position += SS__CHARACTER_RAM_SIZE;
+		}
+
+		return (position - buffer);
+	}
+
+	uint8_t loadState(const uint8_t *buffer)
+	{
+		CC_console_t &console = *CC_console;
+		const uint8_t *position = buffer;
+
+		SS_header_t header;
+		memcpy(&header, position, sizeof(header));
+		position += sizeof(header);
+
+		if (header.magic != SS__MAGIC)
+		{
+			return (STATUS_SS_LOAD_WRONG_FORMAT);
+		}
+
+		if (header.version != SS__VERSION || header.size != getStateSize())
+		{
+			return (STATUS_SS_LOAD_WRONG_VERSION);
+		}
+
+		if (header.mapper != console.mm.currentMapper || header.systemType != CR::getSystemType() || header.PRGBankCount != CR::getROMBankCount() || header.CHRBankCount != CR::getVROMBankCount() || header.flags != SS_header__flags())
+		{
+			return (STATUS_SS_LOAD_DIFFERENT_CARTRIDGE);
+		}
+
+		/* The bank pointers are checked before anything is overwritten */
+		SS_mapper_t mapper;
+		memcpy(&mapper, position + sizeof(CPU_state_t) + sizeof(PPU_state_t) + sizeof(APU_state_t) + sizeof(MB_state_t), sizeof(mapper));
+
+		uint8_t **characterRAM = SS_mapper__characterRAM(console.mm.parameters, console.mm.currentMapper);
+		uint8_t *characterRAMPointer = characterRAM ? *characterRAM : nullptr;
+
+		uint8_t *bankPointerValues[SS__MAXIMUM_BANK_POINTERS];
+		uint8_t **bankPointers[SS__MAXIMUM_BANK_POINTERS];
+		std::size_t bankPointerCount = SS_mapper__bankPointers(console.mm.parameters, console.mm.currentMapper, bankPointers);
+
+		for (std::size_t i = 0; i < bankPointerCount; ++i)
+		{
+			if (!SS_pointer__fromOffset(mapper.bankPointers[i], characterRAMPointer, bankPointerValues[i]))
+			{
+				return (STATUS_SS_LOAD_CORRUPTED);
+			}
+		}
+
+		MB_pages_t *pages = console.cpu.pages;
+		uint8_t *RAM = console.cpu.RAM;
+		memcpy(&console.cpu, position, sizeof(CPU_state_t));
+		console.cpu.pages = pages;
+		console.cpu.RAM = RAM;
+		position += sizeof(CPU_state_t);
+
+		const uint32_t *paletteInUse = console.ppu.paletteInUse;
+		void(*scanlineEndCallback)(bool vblank) = console.ppu.scanlineEndCallback;
+		uint8_t frameSkip = console.ppu.frameSkip; // settings of the front-end, not part of the state
+		bool videoSuppressed = console.ppu.outputSuppressed;
+		memcpy(&console.ppu, position, sizeof(PPU_state_t));
+		console.ppu.paletteInUse = paletteInUse;
+		console.ppu.scanlineEndCallback = scanlineEndCallback;
+		console.ppu.frameSkip = frameSkip;
+		console.ppu.outputSuppressed = videoSuppressed;
+		position += sizeof(PPU_state_t);
+
+		const float *gaussFilterInUse = console.apu.gaussFilterInUse;
+		const uint16_t *noisePeriods = console.apu.noisePeriods;
+		const uint16_t *dmcRates = console.apu.dmcRates;
+		bool audioSuppressed = console.apu.outputSuppressed;
+		memcpy(&console.apu, position, sizeof(APU_state_t));
+		console.apu.gaussFilterInUse = gaussFilterInUse;
+		console.apu.noisePeriods = noisePeriods;
+		console.apu.dmcRates = dmcRates;
+		console.apu.outputSuppressed = audioSuppressed;
+		position += sizeof(APU_state_t);
+
+		uint8_t *externalRAM = console.mb.externalRAM;
+		memcpy(&console.mb, position, sizeof(MB_state_t));
+		console.mb.externalRAM = externalRAM;
+		position += sizeof(MB_state_t);
+
+		memcpy(&console.mm.parameters, &mapper.parameters, sizeof(MM_parameters_t));
+		console.mm.nameTableMirroring = mapper.nameTableMirroring;
+		if (characterRAM)
+		{
+			*characterRAM = characterRAMPointer;
+		}
+		for (std::size_t i = 0; i < bankPointerCount; ++i)
+		{
+			*bankPointers[i] = bankPointerValues[i];
+		}
+		position += sizeof(SS_mapper_t);
+
+		MB::updatePages();
+
+		memcpy(&console.mc, position, sizeof(MC_state_t));
+		position += sizeof(MC_state_t);
+
+		if (header.flags & SS__FLAG_EXTERNAL_RAM)
+		{
+			memcpy(console.mb.externalRAM, position, SS__EXTERNAL_RAM_SIZE);
+			position += SS__EXTERNAL_RAM_SIZE;
+		}
+
+		if (header.flags & SS__FLAG_CHARACTER_RAM)
+		{
+			memcpy(characterRAMPointer, position, SS__CHARACTER_RAM_SIZE);
+			position += SS__CHARACTER_RAM_SIZE;
+		}
+
+		return (STATUS_SS_LOAD_SUCCESS);
+	}
+}
+
+/* Which of the optional memories the loaded cartridge uses */
+inline uint8_t SS_header__flags()
+{
+	CC_console_t &console = *CC_console;
+
+	uint8_t flags = 0;
+
+	if (console.mb.externalRAM)
+	{
+		flags |= SS__FLAG_EXTERNAL_RAM;
+	}
+
+	uint8_t **characterRAM = SS_mapper__characterRAM(console.mm.parameters, console.mm.currentMapper);
+	if (characterRAM && *characterRAM)
+	{
+		flags |= SS__FLAG_CHARACTER_RAM;
+	}
+
+	return (flags);
+}
+
+/* Address of the character RAM pointer in the parameters of the given mapper, nullptr if it has none */
+inline uint8_t** SS_mapper__characterRAM(MM_parameters_t &parameters, uint16_t mapper)
+{
+	switch (mapper)
+	{
+		case MAPPER_NONE:
+		{
+			return (&parameters.MapperNone.characterRAM);
+		}
+
+		case MAPPER_MMC1:
+		{
+			return (&parameters.MapperMMC1.characterRAM);
+		}
+
+		case MAPPER_UNROM:
+		{
+			return (&parameters.MapperUNROM.characterRAM);
+		}
+	}
+
+	return (nullptr);
+}
+
+/* Addresses of the bank pointers in the parameters of the given mapper ... returns how many there are */
+inline std::size_t SS_mapper__bankPointers(MM_parameters_t &parameters, uint16_t mapper, uint8_t **pointers[SS__MAXIMUM_BANK_POINTERS])
+{
+	std::size_t count = 0;
+
+	switch (mapper)
+	{
+		case MAPPER_MMC1:
+		{
+			pointers[count++] = &parameters.MapperMMC1.firstBankPRG;
+			pointers[count++] = &parameters.MapperMMC1.secondBankPRG;
+			pointers[count++] = &parameters.MapperMMC1.firstBankCHR;
+			pointers[count++] = &parameters.MapperMMC1.secondBankCHR;
+
+			break;
+		}
+
+		case MAPPER_UNROM:
+		{
+			pointers[count++] = &parameters.MapperUNROM.lastBank;
+
+			break;
+		}
+
+		case MAPPER_MMC3:
+		{
+			pointers[count++] = &parameters.MapperMMC3.PRGbankFixed0;
+			pointers[count++] = &parameters.MapperMMC3.PRGbankFixed1;
+			pointers[count++] = &parameters.MapperMMC3.PRGbank0;
+			pointers[count++] = &parameters.MapperMMC3.PRGbank1;
+			pointers[count++] = &parameters.MapperMMC3.CHR2k0;
+			pointers[count++] = &parameters.MapperMMC3.CHR2k1;
+			pointers[count++] = &parameters.MapperMMC3.CHR1k0;
+			pointers[count++] = &parameters.MapperMMC3.CHR1k1;
+			pointers[count++] = &parameters.MapperMMC3.CHR1k2;
+			pointers[count++] = &parameters.MapperMMC3.CHR1k3;
+
+			break;
+		}
+	}
+
+	return (count);
+}
+
+inline uint32_t SS_pointer__toOffset(const uint8_t *pointer, uint8_t *character_RAM)
+{
+	const uint8_t *PRGROM = CR::getROM();
+	const uint8_t *CHRROM = CR::getVideoROM();
+
+	if (pointer == nullptr)
+	{
+		return (SS__REGION_NONE << SS__REGION_SHIFT);
+	}
+	else if (PRGROM && pointer >= PRGROM && pointer < PRGROM + CR::getROMBankCount() * 0x4000)
+	{
+		return ((SS__REGION_PRG_ROM << SS__REGION_SHIFT) | (uint32_t)(pointer - PRGROM));
+	}
+	else if (CHRROM && pointer >= CHRROM && pointer < CHRROM + CR::getVROMBankCount() * 0x2000)
+	{
+		return ((SS__REGION_CHR_ROM << SS__REGION_SHIFT) | (uint32_t)(pointer - CHRROM));
+	}
+	else if (character_RAM && pointer >= character_RAM && pointer < character_RAM + SS__CHARACTER_RAM_SIZE)
+	{
+		return ((SS__REGION_CHR_RAM << SS__REGION_SHIFT) | (uint32_t)(pointer - character_RAM));
+	}
+
+	return (SS__REGION_NONE << SS__REGION_SHIFT); // never set by the mapper
+}
+
+inline bool SS_pointer__fromOffset(uint32_t offset, uint8_t *character_RAM, uint8_t *&pointer)
+{
+	uint32_t address = offset & SS__OFFSET_MASK;
+
+	switch (offset >> SS__REGION_SHIFT)
+	{
+		case SS__REGION_NONE:
+		{
+			pointer = nullptr;
+
+			return (address == 0);
+		}
+
+		case SS__REGION_PRG_ROM:
+		{
+			if (!CR::getROM() || address >= CR::getROMBankCount() * 0x4000u)
+			{
+				return (false);
+			}
+
+			pointer = CR::getROM() + address;
+
+			return (true);
+		}
+
+		case SS__REGION_CHR_ROM:
+		{
+			if (!CR::getVideoROM() || address >= CR::getVROMBankCount() * 0x2000u)
+			{
+				return (false);
+			}
+
+			pointer = CR::getVideoROM() + address;
+
+			return (true);
+		}
+
+		case SS__REGION_CHR_RAM:
+		{
+			if (!character_RAM || address >= SS__CHARACTER_RAM_SIZE)
+			{
+				return (false);
+			}
+
+			pointer = character_RAM + address;
+
+			return (true);
+		}
+	}
+
+	return (false);
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define STATUS_SS_LOAD_SUCCESS (0x00u)
+#define STATUS_SS_LOAD_WRONG_FORMAT (0x01u)
+#define STATUS_SS_LOAD_WRONG_VERSION (0x02u)
+#define STATUS_SS_LOAD_DIFFERENT_CARTRIDGE (0x04u)
+#define STATUS_SS_LOAD_CORRUPTED (0x08u)
+
+/* Snapshots of the selected console ... only between MC calls, and only into a console running the same cartridge */
+namespace SS
+{
+	std::size_t getStateSize(); // bytes written by saveState for the loaded cartridge
+	std::size_t saveState(uint8_t *buffer); // returns the number of bytes written
+	uint8_t loadState(const uint8_t *buffer);
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "Tracer.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#define MODE_IMP (0u) // implied
+#define MODE_ACC (1u)
+#define MODE_IMM (2u)
+#define MODE_ZP (3u)
+#define MODE_ZPX (4u)
+#define MODE_ZPY (5u)
+#define MODE_ABS (6u)
+#define MODE_ABX (7u)
+#define MODE_ABY (8u)
+#define MODE_IND (9u)
+#define MODE_IZX (10u)
+#define MODE_IZY (11u)
+#define MODE_REL (12u)
+
+#define RECORDS_PER_READ (4096u)
+
+typedef struct
+{
+	const char *mnemonic;
+	uint8_t mode;
+}opcode_t;
+
+/* Invalid opcodes are executed as one byte NOPs, so that is how they are shown */
+static const opcode_t opcodes[256] =
+{
+	{ "BRK", MODE_IMP }, { "ORA", MODE_IZX }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "ORA", MODE_ZP }, { "ASL", MODE_ZP }, { "*NOP", MODE_IMP }, { "PHP", MODE_IMP }, { "ORA", MODE_IMM }, { "ASL", MODE_ACC }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "ORA", MODE_ABS }, { "ASL", MODE_ABS }, { "*NOP", MODE_IMP },
+	{ "BPL", MODE_REL }, { "ORA", MODE_IZY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "ORA", MODE_ZPX }, { "ASL", MODE_ZPX }, { "*NOP", MODE_IMP }, { "CLC", MODE_IMP }, { "ORA", MODE_ABY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "ORA", MODE_ABX }, { "ASL", MODE_ABX }, { "*NOP", MODE_IMP },
+	{ "JSR", MODE_ABS }, { "AND", MODE_IZX }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "BIT", MODE_ZP }, { "AND", MODE_ZP }, { "ROL", MODE_ZP }, { "*NOP", MODE_IMP }, { "PLP", MODE_IMP }, { "AND", MODE_IMM }, { "ROL", MODE_ACC }, { "*NOP", MODE_IMP }, { "BIT", MODE_ABS }, { "AND", MODE_ABS }, { "ROL", MODE_ABS }, { "*NOP", MODE_IMP },
+	{ "BMI", MODE_REL }, { "AND", MODE_IZY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "AND", MODE_ZPX }, { "ROL", MODE_ZPX }, { "*NOP", MODE_IMP }, { "SEC", MODE_IMP }, { "AND", MODE_ABY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "AND", MODE_ABX }, { "ROL", MODE_ABX }, { "*NOP", MODE_IMP },
+	{ "RTI", MODE_IMP }, { "EOR", MODE_IZX }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "EOR", MODE_ZP }, { "LSR", MODE_ZP }, { "*NOP", MODE_IMP }, { "PHA", MODE_IMP }, { "EOR", MODE_IMM }, { "LSR", MODE_ACC }, { "*NOP", MODE_IMP }, { "JMP", MODE_ABS }, { "EOR", MODE_ABS }, { "LSR", MODE_ABS }, { "*NOP", MODE_IMP },
+	{ "BVC", MODE_REL }, { "EOR", MODE_IZY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "EOR", MODE_ZPX }, { "LSR", MODE_ZPX }, { "*NOP", MODE_IMP }, { "CLI", MODE_IMP }, { "EOR", MODE_ABY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "EOR", MODE_ABX }, { "LSR", MODE_ABX }, { "*NOP", MODE_IMP },
+	{ "RTS", MODE_IMP }, { "ADC", MODE_IZX }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "ADC", MODE_ZP }, { "ROR", MODE_ZP }, { "*NOP", MODE_IMP }, { "PLA", MODE_IMP }, { "ADC", MODE_IMM }, { "ROR", MODE_ACC }, { "*NOP", MODE_IMP }, { "JMP", MODE_IND }, { "ADC", MODE_ABS }, { "ROR", MODE_ABS }, { "*NOP", MODE_IMP },
+	{ "BVS", MODE_REL }, { "ADC", MODE_IZY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "ADC", MODE_ZPX }, { "ROR", MODE_ZPX }, { "*NOP", MODE_IMP }, { "SEI", MODE_IMP }, { "ADC", MODE_ABY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "ADC", MODE_ABX }, { "ROR", MODE_ABX }, { "*NOP", MODE_IMP },
+	{ "*NOP", MODE_IMP }, { "STA", MODE_IZX }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "STY", MODE_ZP }, { "STA", MODE_ZP }, { "STX", MODE_ZP }, { "*NOP", MODE_IMP }, { "DEY", MODE_IMP }, { "*NOP", MODE_IMP }, { "TXA", MODE_IMP }, { "*NOP", MODE_IMP }, { "STY", MODE_ABS }, { "STA", MODE_ABS }, { "STX", MODE_ABS }, { "*NOP", MODE_IMP },
+	{ "BCC", MODE_REL }, { "STA", MODE_IZY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "STY", MODE_ZPX }, { "STA", MODE_ZPX }, { "STX", MODE_ZPY }, { "*NOP", MODE_IMP }, { "TYA", MODE_IMP }, { "STA", MODE_ABY }, { "TXS", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "STA", MODE_ABX }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP },
+	{ "LDY", MODE_IMM }, { "LDA", MODE_IZX }, { "LDX", MODE_IMM }, { "*NOP", MODE_IMP }, { "LDY", MODE_ZP }, { "LDA", MODE_ZP }, { "LDX", MODE_ZP }, { "*NOP", MODE_IMP }, { "TAY", MODE_IMP }, { "LDA", MODE_IMM }, { "TAX", MODE_IMP }, { "*NOP", MODE_IMP }, { "LDY", MODE_ABS }, { "LDA", MODE_ABS }, { "LDX", MODE_ABS }, { "*NOP", MODE_IMP },
+	{ "BCS", MODE_REL }, { "LDA", MODE_IZY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "LDY", MODE_ZPX }, { "LDA", MODE_ZPX }, { "LDX", MODE_ZPY }, { "*NOP", MODE_IMP }, { "CLV", MODE_IMP }, { "LDA", MODE_ABY }, { "TSX", MODE_IMP }, { "*NOP", MODE_IMP }, { "LDY", MODE_ABX }, { "LDA", MODE_ABX }, { "LDX", MODE_ABY }, { "*NOP", MODE_IMP },
+	{ "CPY", MODE_IMM }, { "CMP", MODE_IZX }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "CPY", MODE_ZP }, { "CMP", MODE_ZP }, { "DEC", MODE_ZP }, { "*NOP", MODE_IMP }, { "INY", MODE_IMP }, { "CMP", MODE_IMM }, { "DEX", MODE_IMP }, { "*NOP", MODE_IMP }, { "CPY", MODE_ABS }, { "CMP", MODE_ABS }, { "DEC", MODE_ABS }, { "*NOP", MODE_IMP },
+	{ "BNE", MODE_REL }, { "CMP", MODE_IZY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "CMP", MODE_ZPX }, { "DEC", MODE_ZPX }, { "*NOP", MODE_IMP }, { "CLD", MODE_IMP }, { "CMP", MODE_ABY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "CMP", MODE_ABX }, { "DEC", MODE_ABX }, { "*NOP", MODE_IMP },
+	{ "CPX", MODE_IMM }, { "SBC", MODE_IZX }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "CPX", MODE_ZP }, { "SBC", MODE_ZP }, { "INC", MODE_ZP }, { "*NOP", MODE_IMP }, { "INX", MODE_IMP }, { "SBC", MODE_IMM }, { "NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "CPX", MODE_ABS }, { "SBC", MODE_ABS }, { "INC", MODE_ABS }, { "*NOP", MODE_IMP },
+	{ "BEQ", MODE_REL }, { "SBC", MODE_IZY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "SBC", MODE_ZPX }, { "INC", MODE_ZPX }, { "*NOP", MODE_IMP }, { "SED", MODE_IMP }, { "SBC", MODE_ABY }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "*NOP", MODE_IMP }, { "SBC", MODE_ABX }, { "INC", MODE_ABX }, { "*NOP", MODE_IMP }
+};
+
+static const uint8_t operandBytes[] = { 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 1, 1, 1 }; // by mode
+
+/* "JMP $C5F5" ... without the memory contents nestest adds, which the trace does not have */
+inline void disassemble(uint16_t address, uint8_t opcode, uint16_t operand, char *text, std::size_t size)
+{
+	const opcode_t &entry = opcodes[opcode];
+	uint8_t low = (uint8_t)operand;
+
+	switch (entry.mode)
+	{
+		case MODE_IMP: snprintf(text, size, "%s", entry.mnemonic); break;
+		case MODE_ACC: snprintf(text, size, "%s A", entry.mnemonic); break;
+		case MODE_IMM: snprintf(text, size, "%s #$%02X", entry.mnemonic, low); break;
+		case MODE_ZP: snprintf(text, size, "%s $%02X", entry.mnemonic, low); break;
+		case MODE_ZPX: snprintf(text, size, "%s $%02X,X", entry.mnemonic, low); break;
+		case MODE_ZPY: snprintf(text, size, "%s $%02X,Y", entry.mnemonic, low); break;
+		case MODE_ABS: snprintf(text, size, "%s $%04X", entry.mnemonic, operand); break;
+		case MODE_ABX: snprintf(text, size, "%s $%04X,X", entry.mnemonic, operand); break;
+		case MODE_ABY: snprintf(text, size, "%s $%04X,Y", entry.mnemonic, operand); break;
+		case MODE_IND: snprintf(text, size, "%s ($%04X)", entry.mnemonic, operand); break;
+		case MODE_IZX: snprintf(text, size, "%s ($%02X,X)", entry.mnemonic, low); break;
+		case MODE_IZY: snprintf(text, size, "%s ($%02X),Y", entry.mnemonic, low); break;
+		case MODE_REL: snprintf(text, size, "%s $%04X", entry.mnemonic, (uint16_t)(address + 2 + (int8_t)low)); break;
+	}
+}
+
+/* One nestest style line per instruction ... interrupts get a line of their own, starting with '#' so they are easy to filter out */
+inline void convert(const uint8_t *record, FILE *output)
+{
+	uint64_t cycle = (uint64_t)record[0] | ((uint64_t)record[1] << 8) | ((uint64_t)record[2] << 16) | ((uint64_t)record[3] << 24) | ((uint64_t)record[4] << 32);
+	uint8_t kind = record[5];
+	uint16_t address = record[6] | (record[7] << 8);
+	uint8_t opcode = record[8];
+	uint16_t operand = record[9] | (record[10] << 8);
+
+	if (kind != TR_RECORD_INSTRUCTION)
+	{
+		fprintf(output, "# %s, returning to %04X  A:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%" PRIu64 "\n", (kind == TR_RECORD_NMI) ? "NMI" : "IRQ", address, record[11], record[12], record[13], record[15], record[14], cycle);
+
+		return;
+	}
+
+	char bytes[16];
+	char text[32];
+
+	switch (operandBytes[opcodes[opcode].mode])
+	{
+		case 0: snprintf(bytes, sizeof(bytes), "%02X", opcode); break;
+		case 1: snprintf(bytes, sizeof(bytes), "%02X %02X", opcode, record[9]); break;
+		default: snprintf(bytes, sizeof(bytes), "%02X %02X %02X", opcode, record[9], record[10]); break;
+	}
+
+	disassemble(address, opcode, operand, text, sizeof(text));
+
+	fprintf(output, "%04X  %-8s  %-32sA:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%" PRIu64 "\n", address, bytes, text, record[11], record[12], record[13], record[15], record[14], cycle);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2 || argc > 3)
+	{
+		std::cout << "Usage: " << argv[0] << " <trace file> [text file, standard output if not given]" << std::endl;
+
+		return (1);
+	}
+
+	FILE *trace = fopen(argv[1], "rb");
+	if (!trace)
+	{
+		std::cout << "Error opening trace file" << std::endl;
+
+		return (1);
+	}
+
+	uint8_t header[TR_HEADER_SIZE];
+	uint32_t magic = 0;
+	uint16_t version = 0;
+	uint16_t recordSize = 0;
+
+	if (fread(header, TR_HEADER_SIZE, 1, trace) == 1)
+	{
+		memcpy(&magic, header, 4);
+		memcpy(&version, header + 4, 2);
+		memcpy(&recordSize, header + 6, 2);
+	}
+
+	if (magic != TR_MAGIC || version != TR_VERSION || recordSize != TR_RECORD_SIZE)
+	{
+		std::cout << "Not a trace file, or one from another version" << std::endl;
+		fclose(trace);
+
+		return (1);
+	}
+
+	FILE *output = (argc == 3) ? fopen(argv[2], "w") : stdout;
+	if (!output)
+	{
+		std::cout << "Error opening text file" << std::endl;
+		fclose(trace);
+
+		return (1);
+	}
+
+	static uint8_t records[RECORDS_PER_READ * TR_RECORD_SIZE];
+	std::size_t count;
+
+	while ((count = fread(records, TR_RECORD_SIZE, RECORDS_PER_READ, trace)) > 0)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			convert(records + i * TR_RECORD_SIZE, output);
+		}
+	}
+
+	fclose(trace);
+
+	int exitCode = 0;
+
+	if (output != stdout && fclose(output))
+	{
+		std::cout << "Error writing text file" << std::endl;
+		exitCode = 1;
+	}
+
+	return (exitCode);
+}
\ No newline at end of file
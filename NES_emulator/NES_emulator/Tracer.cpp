@@ -0,0 +1,230 @@
+#include "Tracer.h"
+
+#include "CentralProcessingUnit.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#define TR__CACHE_LINE (64u) // the two threads each write their own counter, kept apart
+#define TR__WRITER_SLEEP (1u) // milliseconds, when there is nothing to write
+
+typedef struct
+{
+	uint8_t *records;
+	uint32_t capacity; // a power of 2
+	uint64_t cachedTail; // CPU side copy of tail, only read again when the buffer looks full
+	uint64_t runStartCycle; // CPU cycle of the run being traced
+	uint64_t runStartMaster; // master cycle it was worked out from
+	FILE *file;
+	std::thread writer;
+
+	uint8_t padding0[TR__CACHE_LINE];
+	std::atomic<uint64_t> head; // records put in the buffer ... only the CPU changes it
+	uint8_t padding1[TR__CACHE_LINE];
+	std::atomic<uint64_t> tail; // records written to the file ... only the writer thread changes it
+	uint8_t padding2[TR__CACHE_LINE];
+	std::atomic<bool> running;
+	std::atomic<bool> failed; // a write to the file did not go through
+}TR_state_t;
+
+#define TR_state (*(TR_state_t*)CC_console->tracerData)
+
+inline uint64_t TR_cycle__of(TR_state_t &tr, const CPU_state_t &cpu);
+inline uint8_t* TR_ring__reserve(TR_state_t &tr);
+inline void TR_ring__commit(TR_state_t &tr);
+inline void TR_record__fill(uint8_t *record, uint64_t cycle, uint8_t kind, uint16_t address, uint8_t opcode, uint16_t operand, uint8_t flags, const CPU_state_t &cpu);
+void TR_writer__run(TR_state_t *tr);
+
+namespace TR
+{
+	uint8_t start(std::string file_name, uint32_t capacity)
+	{
+		stop();
+
+		FILE *file = fopen(file_name.c_str(), "wb");
+		if (!file)
+		{
+			return (STATUS_TR_FILE_PROTECTED_OR_NONEXISTENT);
+		}
+
+		uint8_t header[TR_HEADER_SIZE] = {};
+		uint32_t magic = TR_MAGIC;
+		uint16_t version = TR_VERSION;
+		uint16_t recordSize = TR_RECORD_SIZE;
+
+		memcpy(header, &magic, 4);
+		memcpy(header + 4, &version, 2);
+		memcpy(header + 6, &recordSize, 2);
+
+		if (fwrite(header, TR_HEADER_SIZE, 1, file) != 1)
+		{
+			fclose(file);
+
+			return (STATUS_TR_UNABLE_TO_ACCESS_FILE);
+		}
+
+		while (capacity & (capacity - 1))
+		{ // down to a power of 2, so the ring is indexed with a mask
+			capacity &= capacity - 1;
+		}
+
+		TR_state_t *tr = new TR_state_t();
+
+		tr->capacity = capacity ? capacity : TR_DEFAULT_CAPACITY;
+		tr->records = new uint8_t[(std::size_t)tr->capacity * TR_RECORD_SIZE];
+		tr->file = file;
+		tr->head.store(0);
+		tr->tail.store(0);
+		tr->running.store(true);
+		tr->failed.store(false);
+		tr->writer = std::thread(TR_writer__run, tr);
+
+		CC_console->tracerData = tr;
+
+		return (STATUS_TR_SUCCESS);
+	}
+
+	void instruction(uint16_t address, uint8_t opcode, uint8_t flags, const CPU_state_t &cpu)
+	{
+		TR_state_t &tr = TR_state;
+
+		TR_record__fill(TR_ring__reserve(tr), TR_cycle__of(tr, cpu), TR_RECORD_INSTRUCTION, address, opcode, cpu.operand, flags, cpu);
+		TR_ring__commit(tr);
+	}
+
+	void interrupt(uint8_t interrupt, uint8_t flags, const CPU_state_t &cpu)
+	{
+		TR_state_t &tr = TR_state;
+
+		TR_record__fill(TR_ring__reserve(tr), TR_cycle__of(tr, cpu), (interrupt == INTERRUPT_NMI) ? TR_RECORD_NMI : TR_RECORD_IRQ, cpu.registerPC, 0x00, 0x0000, flags, cpu);
+		TR_ring__commit(tr);
+	}
+
+	uint8_t stop()
+	{
+		TR_state_t *tr = (TR_state_t*)CC_console->tracerData;
+		if (!tr)
+		{
+			return (STATUS_TR_NOT_TRACING);
+		}
+
+		CC_console->tracerData = nullptr;
+
+		tr->running.store(false, std::memory_order_release);
+		tr->writer.join();
+
+		uint8_t code = tr->failed.load() ? STATUS_TR_UNABLE_TO_ACCESS_FILE : STATUS_TR_SUCCESS;
+		if (fclose(tr->file))
+		{
+			code = STATUS_TR_UNABLE_TO_ACCESS_FILE;
+		}
+
+		delete[] tr->records;
+		delete tr;
+
+		return (code);
+	}
+}
+
+/* CPU cycles since power on, at the start of the current instruction ... the division is only done once per run */
+inline uint64_t TR_cycle__of(TR_state_t &tr, const CPU_state_t &cpu)
+{
+	const MC_state_t &mc = CC_console->mc;
+
+	if (!mc.runStartCycleCPU)
+	{ // outside a run, an NMI raised by the PPU
+		return (mc.nextCycleCPU / mc.dividerCPU - 1);
+	}
+
+	if (mc.runStartCycleCPU != tr.runStartMaster)
+	{
+		tr.runStartMaster = mc.runStartCycleCPU;
+		tr.runStartCycle = mc.runStartCycleCPU / mc.dividerCPU - 1;
+	}
+
+	return (tr.runStartCycle + cpu.runCycles);
+}
+
+/* Space for the next record ... when the writer thread is behind, the CPU waits for it rather than losing records */
+inline uint8_t* TR_ring__reserve(TR_state_t &tr)
+{
+	uint64_t head = tr.head.load(std::memory_order_relaxed);
+
+	while (head - tr.cachedTail >= tr.capacity)
+	{
+		tr.cachedTail = tr.tail.load(std::memory_order_acquire);
+
+		if (head - tr.cachedTail >= tr.capacity)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	return (tr.records + (std::size_t)(head & (tr.capacity - 1)) * TR_RECORD_SIZE);
+}
+
+inline void TR_ring__commit(TR_state_t &tr)
+{
+	tr.head.store(tr.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+inline void TR_record__fill(uint8_t *record, uint64_t cycle, uint8_t kind, uint16_t address, uint8_t opcode, uint16_t operand, uint8_t flags, const CPU_state_t &cpu)
+{
+	record[0] = (uint8_t)cycle;
+	record[1] = (uint8_t)(cycle >> 8);
+	record[2] = (uint8_t)(cycle >> 16);
+	record[3] = (uint8_t)(cycle >> 24);
+	record[4] = (uint8_t)(cycle >> 32);
+	record[5] = kind;
+	record[6] = (uint8_t)address;
+	record[7] = (uint8_t)(address >> 8);
+	record[8] = opcode;
+	record[9] = (uint8_t)operand;
+	record[10] = (uint8_t)(operand >> 8);
+	record[11] = cpu.registerA;
+	record[12] = cpu.registerX;
+	record[13] = cpu.registerY;
+	record[14] = cpu.registerSP;
+	record[15] = flags;
+}
+
+/* Writes out whatever the CPU put in the buffer, in as few writes as the wrap allows, until tracing stops and the buffer is empty */
+void TR_writer__run(TR_state_t *tr)
+{
+	while (true)
+	{
+		bool running = tr->running.load(std::memory_order_acquire);
+		uint64_t head = tr->head.load(std::memory_order_acquire);
+		uint64_t tail = tr->tail.load(std::memory_order_relaxed);
+
+		if (head == tail)
+		{
+			if (!running)
+			{
+				break;
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(TR__WRITER_SLEEP));
+
+			continue;
+		}
+
+		uint32_t start = (uint32_t)(tail & (tr->capacity - 1));
+		uint64_t count = head - tail;
+
+		if (count > tr->capacity - start)
+		{ // up to the end of the buffer now, the rest on the next pass
+			count = tr->capacity - start;
+		}
+
+		if (fwrite(tr->records + (std::size_t)start * TR_RECORD_SIZE, TR_RECORD_SIZE, (std::size_t)count, tr->file) != count)
+		{
+			tr->failed.store(true);
+		}
+
+		tr->tail.store(tail + count, std::memory_order_release);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ConsoleContext.h"
+
+#include <cstdint>
+#include <string>
+
+#define STATUS_TR_SUCCESS (0x00u)
+#define STATUS_TR_FILE_PROTECTED_OR_NONEXISTENT (0x01u)
+#define STATUS_TR_UNABLE_TO_ACCESS_FILE (0x02u)
+#define STATUS_TR_WRONG_FILE_FORMAT (0x04u)
+#define STATUS_TR_NOT_TRACING (0x08u)
+
+#define TR_MAGIC (0x5254454Eu) // "NETR"
+#define TR_VERSION (1u)
+#define TR_HEADER_SIZE (16u) // magic, version, record size, reserved
+
+/* Records are little endian: CPU cycle (5 bytes), kind, PC, opcode, the two bytes after it, A, X, Y, SP, P ... registers as they were before the instruction, or before the jump to the handler */
+#define TR_RECORD_SIZE (16u)
+#define TR_RECORD_INSTRUCTION (0u)
+#define TR_RECORD_NMI (1u) // PC is the return address, opcode and operand are 0
+#define TR_RECORD_IRQ (2u)
+
+#define TR_DEFAULT_CAPACITY (0x10000u) // records
+
+/* Every instruction the selected console executes, written to a file by a thread of its own ... CPU::run only uses its instrumented core while TR is tracing */
+namespace TR
+{
+	uint8_t start(std::string file_name, uint32_t capacity = TR_DEFAULT_CAPACITY); // capacity of the ring buffer in records, a power of 2
+	void instruction(uint16_t address, uint8_t opcode, uint8_t flags, const CPU_state_t &cpu); // by the instrumented core, before the instruction executes ... flags packed
+	void interrupt(uint8_t interrupt, uint8_t flags, const CPU_state_t &cpu); // before the jump to the handler
+	uint8_t stop(); // waits for the writer thread to write what is left ... must be called before destroying the console
+}
\ No newline at end of file
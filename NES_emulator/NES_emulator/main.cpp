@@ -2,29 +2,109 @@
 #include "AudioProcessingUnit.h"
 #include "CartridgeReader.h"
 #include "CentralProcessingUnit.h"
+#include "ConsoleContext.h"
 #include "GameController.h"
+#include "InputMovie.h"
+#include "MasterClock.h"
 #include "MemoryBus.h"
 #include "MemoryMapper.h"
 #include "PictureProcessingUnit.h"
 #include "RenderingWindow.h"
+#include "RewindBuffer.h"
+#include "SaveState.h"
 
+#include <chrono>
 #include <iostream>
+#include <string>
+#include <thread>
 
-#define CLOCK_DIVIDER_CPU_NTSC (12u)
-#define CLOCK_DIVIDER_APU_NTSC (24u)
-#define CLOCK_DIVIDER_PPU_NTSC (4u)
+#define MASTER_CYCLES_PER_SAMPLE_NTSC (456u) // the APU outputs a sample every 19 cycles on NTSC
+#define MASTER_CYCLES_PER_SAMPLE_PAL (576u) // and every 18 cycles on PAL
 
-#define CLOCK_DIVIDER_CPU_PAL (16u)
-#define CLOCK_DIVIDER_APU_PAL (32u)
-#define CLOCK_DIVIDER_PPU_PAL (5u)
+#define FRAME_PERIOD_NTSC (std::chrono::microseconds(16639))
+#define FRAME_PERIOD_PAL (std::chrono::microseconds(19997))
 
-#define min(x1, x2) ((x1) < (x2) ? (x1) : (x2))
+#define TURBO_DEFAULT_MULTIPLIER (4u)
+#define TURBO_UNLIMITED (0u)
+
+#define FRAME_SKIP_AUTO (0xFFu)
+#define FRAME_SKIP_AUTO_MAXIMUM (4u)
+#define FRAME_SKIP_AUTO_WINDOW (30u) // frames between two adjustments
+
+#define REWIND_BUFFER_SIZE (4u * 1024u * 1024u) // a few minutes at a few hundred bytes per frame
+#define REWIND_KEYFRAME_INTERVAL (60u)
+
+#define RUN_AHEAD_MAXIMUM (8u)
+
+/* Emulates one frame, then shows what the next ones would look like if the buttons stayed as they are ... the state goes back to right after the first frame */
+inline void runAheadFrame(uint8_t frames, uint8_t *state)
+{
+	PPU::suppressOutput(true);
+	MC::runFrame(); // only its audio is kept
+
+	SS::saveState(state);
+
+	APU::suppressOutput(true);
+	for (uint8_t frame = 1; frame <= frames; ++frame)
+	{
+		PPU::suppressOutput(frame != frames);
+		MC::runFrame();
+	}
+
+	SS::loadState(state);
+
+	APU::suppressOutput(false);
+	PPU::suppressOutput(false);
+}
+
+/* Sleeps until the next frame is due ... a host that falls behind does not try to catch up later */
+inline void waitForNextFrame(std::chrono::steady_clock::time_point &next_frame, std::chrono::microseconds frame_period)
+{
+	next_frame += frame_period;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (next_frame < now)
+	{
+		next_frame = now;
+	}
+	else
+	{
+		std::this_thread::sleep_until(next_frame);
+	}
+}
 
 int main(int argc, char** argv)
 {
-	if (argc == 2)
+	CC_console_t *console = CC::create();
+	CC::select(console);
+
+	uint32_t turboMultiplier = TURBO_DEFAULT_MULTIPLIER;
+	uint8_t frameSkip = 0;
+	uint8_t runAhead = 0;
+	std::string moviePath;
+
+	if (argc >= 2 && argc <= 5)
 	{
+		if (argc >= 3)
+		{
+			turboMultiplier = (uint32_t)std::stoul(argv[2]); // 0 runs as fast as the host allows
+		}
+
+		if (argc >= 4)
+		{
+			std::string skip = argv[3];
+			frameSkip = (skip == "auto") ? FRAME_SKIP_AUTO : (uint8_t)std::stoul(skip);
+		}
+
+		if (argc == 5)
+		{
+			unsigned long frames = std::stoul(argv[4]);
+			runAhead = (uint8_t)((frames > RUN_AHEAD_MAXIMUM) ? RUN_AHEAD_MAXIMUM : frames);
+		}
+
 		std::string path = argv[1];
+		moviePath = path + ".nesm";
+
 		uint8_t code = 0;
 		if (code = CR::loadFile(path))
 		{
@@ -35,7 +115,7 @@ int main(int argc, char** argv)
 	}
 	else
 	{
-		std::cout << "One argument expected: path to ROM file" << std::endl;
+		std::cout << "Usage: path to ROM file [turbo multiplier, 0 for unlimited] [frame skip, number or auto] [run-ahead frames]" << std::endl;
 
 		getchar();
 		return (1);
@@ -67,25 +147,28 @@ int main(int argc, char** argv)
 	CPU::reset();
 	PPU::reset();
 
-	uint8_t cpuDivider, apuDivider, ppuDivider;
-	uint8_t cpuCountdown, apuCountdown, ppuCountdown;
+	MC::reset();
+
+	PPU::setFrameSkip((frameSkip == FRAME_SKIP_AUTO) ? 0 : frameSkip);
 
-	if (CR::getSystemType() == SYSTEM_NTSC)
+	if (!RB::init(REWIND_BUFFER_SIZE, REWIND_KEYFRAME_INTERVAL))
 	{
-		cpuDivider = CLOCK_DIVIDER_CPU_NTSC;
-		apuDivider = CLOCK_DIVIDER_APU_NTSC;
-		ppuDivider = CLOCK_DIVIDER_PPU_NTSC;
-	}
-	else
-	{ // PAL system
-		cpuDivider = CLOCK_DIVIDER_CPU_PAL;
-		apuDivider = CLOCK_DIVIDER_APU_PAL;
-		ppuDivider = CLOCK_DIVIDER_PPU_PAL;
+		std::cout << "Not enough memory for rewinding" << std::endl;
 	}
 
-	cpuCountdown = cpuDivider;
-	apuCountdown = apuDivider;
-	ppuCountdown = ppuDivider;
+	uint8_t *runAheadState = runAhead ? new uint8_t[SS::getStateSize()] : nullptr;
+
+	uint32_t masterCyclesPerSample = (CR::getSystemType() == SYSTEM_NTSC) ? MASTER_CYCLES_PER_SAMPLE_NTSC : MASTER_CYCLES_PER_SAMPLE_PAL;
+	std::chrono::microseconds framePeriod = (CR::getSystemType() == SYSTEM_NTSC) ? FRAME_PERIOD_NTSC : FRAME_PERIOD_PAL;
+
+	bool turbo = false;
+	bool rewinding = false;
+	uint8_t turboDecimation = (uint8_t)((turboMultiplier > 0xFF) ? 0xFF : turboMultiplier);
+	uint32_t snapshotFrameCount = PPU::getFrameCount();
+	std::chrono::steady_clock::time_point nextFrameTimePoint = std::chrono::steady_clock::now();
+
+	std::chrono::steady_clock::duration emulationTime = std::chrono::steady_clock::duration::zero(); // used by the automatic frame skip
+	uint32_t emulationFrameCount = PPU::getFrameCount();
 
 	for (;;) // program loop
 	{
@@ -94,33 +177,141 @@ int main(int argc, char** argv)
 		{
 			break;
 		}
+		else if (windowEvent == EVENT_KEY_TURBO_PRESSED || windowEvent == EVENT_KEY_REWIND_PRESSED || windowEvent == EVENT_KEY_REWIND_RELEASED)
+		{
+			if (windowEvent == EVENT_KEY_TURBO_PRESSED)
+			{
+				turbo = !turbo;
+			}
+			else
+			{
+				rewinding = (windowEvent == EVENT_KEY_REWIND_PRESSED);
+			}
+
+			/* Audio would otherwise pile up (or play sped up) ... keep only a fraction of the samples, and none while going backwards */
+			AD::setDecimation(rewinding ? 0 : (turbo ? turboDecimation : 1));
+
+			nextFrameTimePoint = std::chrono::steady_clock::now();
+
+			emulationTime = std::chrono::steady_clock::duration::zero();
+			emulationFrameCount = PPU::getFrameCount();
+		}
+		else if (windowEvent == EVENT_KEY_RECORD_PRESSED)
+		{
+			if (IM::getMode() == IM_MODE_RECORDING)
+			{
+				uint8_t code = IM::stopRecording(moviePath);
+				if (code)
+				{
+					std::cout << "Error saving movie. Code: " << (int)code << std::endl;
+				}
+				else
+				{
+					std::cout << "Movie saved to " << moviePath << std::endl;
+				}
+			}
+			else
+			{
+				IM::startRecording();
+				RB::clear(); // rewinding to before the movie starts would leave it without a beginning
 
-		/* The audio device is used to keep track of time */
-		while (AD::bufferFull() == false)
+				std::cout << "Recording movie" << std::endl;
+			}
+		}
+		else if (windowEvent == EVENT_KEY_PLAYBACK_PRESSED)
 		{
-			uint8_t step = min(cpuCountdown, apuCountdown);
-			step = min(step, ppuCountdown);
+			IM::stopRecording(moviePath);
 
-			cpuCountdown -= step;
-			apuCountdown -= step;
-			ppuCountdown -= step;
+			uint8_t code = IM::startPlayback(moviePath);
+			if (code)
+			{
+				std::cout << "Error loading movie. Code: " << (int)code << std::endl;
+			}
+			else
+			{
+				RB::clear();
+				snapshotFrameCount = PPU::getFrameCount();
+
+				std::cout << "Playing movie" << std::endl;
+			}
+		}
 
-			if (cpuCountdown == 0)
+		if (rewinding)
+		{ // loads the snapshot before the newest one and runs it again to have something to show
+			if (RB::rewind())
 			{
-				CPU::step();
-				cpuCountdown = cpuDivider;
+				MC::runFrame();
 			}
 
-			if (apuCountdown == 0)
+			snapshotFrameCount = PPU::getFrameCount();
+
+			waitForNextFrame(nextFrameTimePoint, framePeriod);
+		}
+		else if (turbo)
+		{
+			if (turboMultiplier == TURBO_UNLIMITED)
+			{ // one frame per iteration so the window events are still polled
+				MC::runFrame();
+				RB::push();
+			}
+			else
 			{
-				APU::step();
-				apuCountdown = apuDivider;
+				for (uint32_t frame = 0; frame < turboMultiplier; ++frame)
+				{
+					MC::runFrame();
+					RB::push();
+				}
+
+				/* The audio buffer fills slower than it is drained, so the host clock paces the emulation instead */
+				waitForNextFrame(nextFrameTimePoint, framePeriod);
 			}
 
-			if (ppuCountdown == 0)
+			snapshotFrameCount = PPU::getFrameCount();
+		}
+		else
+		{
+			std::chrono::steady_clock::time_point emulationStart = std::chrono::steady_clock::now();
+
+			/* The audio device is used to keep track of time */
+			while (AD::bufferFull() == false)
 			{
-				PPU::step();
-				ppuCountdown = ppuDivider;
+				if (runAhead)
+				{ // whole frames, each one shown from a few frames later
+					runAheadFrame(runAhead, runAheadState);
+				}
+				else
+				{
+					MC::run(masterCyclesPerSample);
+				}
+			}
+
+			if (PPU::getFrameCount() != snapshotFrameCount)
+			{ // one snapshot per frame, wherever the frame ended
+				RB::push();
+				snapshotFrameCount = PPU::getFrameCount();
+			}
+
+			if (frameSkip == FRAME_SKIP_AUTO)
+			{ // skips more frames while the emulation takes most of the frame period and fewer once it catches up
+				emulationTime += std::chrono::steady_clock::now() - emulationStart;
+
+				uint32_t frames = PPU::getFrameCount() - emulationFrameCount;
+				if (frames >= FRAME_SKIP_AUTO_WINDOW)
+				{
+					uint8_t skip = PPU::getFrameSkip();
+
+					if (emulationTime > frames * framePeriod * 9 / 10 && skip < FRAME_SKIP_AUTO_MAXIMUM)
+					{
+						PPU::setFrameSkip(skip + 1);
+					}
+					else if (emulationTime < frames * framePeriod / 2 && skip > 0)
+					{
+						PPU::setFrameSkip(skip - 1);
+					}
+
+					emulationTime = std::chrono::steady_clock::duration::zero();
+					emulationFrameCount = PPU::getFrameCount();
+				}
 			}
 		}
 	}
@@ -128,8 +319,16 @@ int main(int argc, char** argv)
 	RW::dispose();
 	AD::dispose();
 
+	RB::clean();
+	IM::clean();
+
+	delete[] runAheadState;
+
 	CR::clean();
 	MB::clean();
+	MM::clean();
+
+	CC::destroy(console);
 
 	return (0);
 }
\ No newline at end of file